@@ -23,6 +23,8 @@
 #include "blastsearch.h"
 #include "program/memory.h"
 
+#include <QtConcurrent>
+
 BlastQueries::BlastQueries() :
     m_tempNuclFile(0), m_tempProtFile(0)
 {
@@ -240,8 +242,14 @@ bool BlastQueries::isQueryPresent(BlastQuery * query)
 
 //This function looks at each BLAST query and tries to find a path through
 //the graph which covers the maximal amount of the query.
+//The queries are independent of each other, so they are processed
+//concurrently on the global thread pool. Each query stores its own paths, so
+//the results keep the order of m_queries regardless of scheduling.
 void BlastQueries::findQueryPaths()
 {
-    for (size_t i = 0; i < m_queries.size(); ++i)
-        m_queries[i]->findQueryPaths();
+    const QueryPathSettings settings(*g_settings);
+    QtConcurrent::blockingMap(m_queries,
+                              [&settings](BlastQuery *query) {
+                                  query->findQueryPaths(settings);
+                              });
 }
@@ -21,9 +21,24 @@
 #include "graph/path.h"
 #include "graph/debruijnnode.h"
 #include <limits>
+#include <tuple>
 #include <utility>
 #include <vector>
-#include <utility>
+
+QueryPathSettings::QueryPathSettings(const Settings &settings) :
+    maxHitsForQueryPath(settings.maxHitsForQueryPath),
+    maxQueryPathNodes(settings.maxQueryPathNodes),
+    minQueryCoveredByPath(settings.minQueryCoveredByPath),
+    minQueryCoveredByHits(settings.minQueryCoveredByHits),
+    minMeanHitIdentity(settings.minMeanHitIdentity),
+    maxEValueProduct(settings.maxEValueProduct),
+    minLengthPercentage(settings.minLengthPercentage),
+    maxLengthPercentage(settings.maxLengthPercentage),
+    minLengthBaseDiscrepancy(settings.minLengthBaseDiscrepancy),
+    maxLengthBaseDiscrepancy(settings.maxLengthBaseDiscrepancy)
+{
+}
+
 
 BlastQuery::BlastQuery(QString name, QString sequence) :
     m_name(std::move(name)), m_sequence(std::move(sequence)), m_searchedFor(false), m_shown(true)
@@ -84,14 +99,51 @@ void BlastQuery::clearSearchResults()
 {
     m_searchedFor = false;
     m_hits.clear();
+    m_hitsByNode.clear();
+    m_nodesWithHits.clear();
+}
+
+
+//This function groups the query's hits by node, so path construction can look
+//up the hits on a node directly instead of scanning all of the query's hits.
+//It needs to be called after all hits have been added.
+void BlastQuery::buildHitIndex()
+{
+    m_hitsByNode.clear();
+    m_nodesWithHits.clear();
+
+    for (auto &hit : m_hits)
+    {
+        auto [it, inserted] = m_hitsByNode.try_emplace(hit->m_node);
+        if (inserted)
+            m_nodesWithHits.push_back(hit->m_node);
+        it->second.push_back(hit.get());
+    }
+
+    for (auto &entry : m_hitsByNode)
+    {
+        std::sort(entry.second.begin(), entry.second.end(),
+                  [](const BlastHit * a, const BlastHit * b) {
+                      return std::tie(a->m_queryStart, a->m_nodeStart, a->m_nodeEnd) <
+                             std::tie(b->m_queryStart, b->m_nodeStart, b->m_nodeEnd);
+                  });
+    }
+}
+
+
+const std::vector<BlastHit *> &BlastQuery::getHitsOnNode(const DeBruijnNode * node) const
+{
+    return getFromMapOrDefaultConstructed(m_hitsByNode, node);
 }
 
 
 //This function tries to find the paths through the graph which cover the query.
-void BlastQuery::findQueryPaths()
+//It only reads the graph and the given settings, so it is safe to run for
+//several queries at once.
+void BlastQuery::findQueryPaths(const QueryPathSettings &settings)
 {
     m_paths = QList<BlastQueryPath>();
-    if (m_hits.size() > g_settings->maxHitsForQueryPath)
+    if (m_hits.size() > settings.maxHitsForQueryPath)
         return;
 
     int queryLength = m_sequence.length();
@@ -101,7 +153,7 @@ void BlastQuery::findQueryPaths()
     //Find all possible path starts within an acceptable distance from the query
     //start.
     QList<BlastHit *> possibleStarts;
-    double acceptableStartFraction = 1.0 - g_settings->minQueryCoveredByPath;
+    double acceptableStartFraction = 1.0 - settings.minQueryCoveredByPath;
     for (auto &m_hit : m_hits)
     {
         BlastHit * hit = m_hit.get();
@@ -111,7 +163,7 @@ void BlastQuery::findQueryPaths()
 
     //Find all possible path ends.
     QList<BlastHit *> possibleEnds;
-    double acceptableEndFraction = g_settings->minQueryCoveredByPath;
+    double acceptableEndFraction = settings.minQueryCoveredByPath;
     for (auto &m_hit : m_hits)
     {
         BlastHit * hit = m_hit.get();
@@ -145,28 +197,28 @@ void BlastQuery::findQueryPaths()
 
             //Determine the minimum and maximum lengths allowed for the path.
             int minLength;
-            if (g_settings->minLengthPercentage.on && g_settings->minLengthBaseDiscrepancy.on) //both on
-                minLength = std::max(int(partialQueryLength * g_settings->minLengthPercentage + 0.5), partialQueryLength + g_settings->minLengthBaseDiscrepancy);
-            else if (g_settings->minLengthPercentage.on && !g_settings->minLengthBaseDiscrepancy.on) //just relative
-                minLength = int(partialQueryLength * g_settings->minLengthPercentage + 0.5);
-            else if (!g_settings->minLengthPercentage.on && g_settings->minLengthBaseDiscrepancy.on) //just absolute
-                minLength = partialQueryLength + g_settings->minLengthBaseDiscrepancy;
+            if (settings.minLengthPercentage.on && settings.minLengthBaseDiscrepancy.on) //both on
+                minLength = std::max(int(partialQueryLength * settings.minLengthPercentage + 0.5), partialQueryLength + settings.minLengthBaseDiscrepancy);
+            else if (settings.minLengthPercentage.on && !settings.minLengthBaseDiscrepancy.on) //just relative
+                minLength = int(partialQueryLength * settings.minLengthPercentage + 0.5);
+            else if (!settings.minLengthPercentage.on && settings.minLengthBaseDiscrepancy.on) //just absolute
+                minLength = partialQueryLength + settings.minLengthBaseDiscrepancy;
             else //neither are on
                 minLength = 1;
 
             int maxLength;
-            if (g_settings->maxLengthPercentage.on && g_settings->maxLengthBaseDiscrepancy.on) //both on
-                maxLength = std::min(int(partialQueryLength * g_settings->maxLengthPercentage + 0.5), partialQueryLength + g_settings->maxLengthBaseDiscrepancy);
-            else if (g_settings->maxLengthPercentage.on && !g_settings->maxLengthBaseDiscrepancy.on) //just relative
-                maxLength = int(partialQueryLength * g_settings->maxLengthPercentage + 0.5);
-            else if (!g_settings->maxLengthPercentage.on && g_settings->maxLengthBaseDiscrepancy.on) //just absolute
-                maxLength = partialQueryLength + g_settings->maxLengthBaseDiscrepancy;
+            if (settings.maxLengthPercentage.on && settings.maxLengthBaseDiscrepancy.on) //both on
+                maxLength = std::min(int(partialQueryLength * settings.maxLengthPercentage + 0.5), partialQueryLength + settings.maxLengthBaseDiscrepancy);
+            else if (settings.maxLengthPercentage.on && !settings.maxLengthBaseDiscrepancy.on) //just relative
+                maxLength = int(partialQueryLength * settings.maxLengthPercentage + 0.5);
+            else if (!settings.maxLengthPercentage.on && settings.maxLengthBaseDiscrepancy.on) //just absolute
+                maxLength = partialQueryLength + settings.maxLengthBaseDiscrepancy;
             else //neither are on
                 maxLength = std::numeric_limits<int>::max();
 
             possiblePaths.append(Path::getAllPossiblePaths(startLocation,
                                                            endLocation,
-                                                           g_settings->maxQueryPathNodes - 1,
+                                                           settings.maxQueryPathNodes - 1,
                                                            minLength,
                                                            maxLength));
         }
@@ -183,21 +235,21 @@ void BlastQuery::findQueryPaths()
     QList<BlastQueryPath> sufficientCoveragePaths;
     for (int i = 0; i < blastQueryPaths.size(); ++i)
     {
-        if (blastQueryPaths[i].getPathQueryCoverage() < g_settings->minQueryCoveredByPath)
+        if (blastQueryPaths[i].getPathQueryCoverage() < settings.minQueryCoveredByPath)
             continue;
-        if (g_settings->minQueryCoveredByHits.on && blastQueryPaths[i].getHitsQueryCoverage() < g_settings->minQueryCoveredByHits)
+        if (settings.minQueryCoveredByHits.on && blastQueryPaths[i].getHitsQueryCoverage() < settings.minQueryCoveredByHits)
             continue;
-        if (g_settings->maxEValueProduct.on && blastQueryPaths[i].getEvalueProduct() > g_settings->maxEValueProduct)
+        if (settings.maxEValueProduct.on && blastQueryPaths[i].getEvalueProduct() > settings.maxEValueProduct)
             continue;
-        if (g_settings->minMeanHitIdentity.on && blastQueryPaths[i].getMeanHitPercIdentity() < 100.0 * g_settings->minMeanHitIdentity)
+        if (settings.minMeanHitIdentity.on && blastQueryPaths[i].getMeanHitPercIdentity() < 100.0 * settings.minMeanHitIdentity)
             continue;
-        if (g_settings->minLengthPercentage.on && blastQueryPaths[i].getRelativePathLength() < g_settings->minLengthPercentage)
+        if (settings.minLengthPercentage.on && blastQueryPaths[i].getRelativePathLength() < settings.minLengthPercentage)
             continue;
-        if (g_settings->maxLengthPercentage.on && blastQueryPaths[i].getRelativePathLength() > g_settings->maxLengthPercentage)
+        if (settings.maxLengthPercentage.on && blastQueryPaths[i].getRelativePathLength() > settings.maxLengthPercentage)
             continue;
-        if (g_settings->minLengthBaseDiscrepancy.on && blastQueryPaths[i].getAbsolutePathLengthDifference() < g_settings->minLengthBaseDiscrepancy)
+        if (settings.minLengthBaseDiscrepancy.on && blastQueryPaths[i].getAbsolutePathLengthDifference() < settings.minLengthBaseDiscrepancy)
             continue;
-        if (g_settings->maxLengthBaseDiscrepancy.on && blastQueryPaths[i].getAbsolutePathLengthDifference() > g_settings->maxLengthBaseDiscrepancy)
+        if (settings.maxLengthBaseDiscrepancy.on && blastQueryPaths[i].getAbsolutePathLengthDifference() > settings.maxLengthBaseDiscrepancy)
             continue;
 
         sufficientCoveragePaths.push_back(blastQueryPaths[i]);
@@ -205,22 +257,15 @@ void BlastQuery::findQueryPaths()
 
     //We now want to throw out any paths which are sub-paths of other, larger
     //paths.
+    std::vector<Path> candidatePaths;
+    candidatePaths.reserve(sufficientCoveragePaths.size());
+    for (const auto &sufficientCoveragePath : sufficientCoveragePaths)
+        candidatePaths.push_back(sufficientCoveragePath.getPath());
+
+    std::vector<bool> isSubPath = Path::findSubPaths(candidatePaths);
     for (int i = 0; i < sufficientCoveragePaths.size(); ++i)
     {
-        bool throwOut = false;
-        for (int j = 0; j < sufficientCoveragePaths.size(); ++j)
-        {
-            //No need to compare a path with itself.
-            if (i == j)
-                continue;
-
-            if (sufficientCoveragePaths[i].getPath().hasNodeSubset(sufficientCoveragePaths[j].getPath()))
-            {
-                throwOut = true;
-                break;
-            }
-        }
-        if (!throwOut)
+        if (!isSubPath[i])
             m_paths.push_back(sufficientCoveragePaths[i]);
     }
 
@@ -23,12 +23,33 @@
 #include <QString>
 #include <QColor>
 #include "program/globals.h"
+#include "program/settings.h"
 #include "blasthit.h"
+#include "parallel_hashmap/phmap.h"
 #include <QList>
 #include <QSharedPointer>
 #include <utility>
 #include "blastquerypath.h"
 
+//This is an immutable copy of the settings which control the query path
+//search.  It is taken once before the searches begin, so that queries can be
+//processed concurrently without reading g_settings mid-computation.
+struct QueryPathSettings
+{
+    explicit QueryPathSettings(const Settings &settings);
+
+    IntSetting maxHitsForQueryPath;
+    IntSetting maxQueryPathNodes;
+    FloatSetting minQueryCoveredByPath;
+    FloatSetting minQueryCoveredByHits;
+    FloatSetting minMeanHitIdentity;
+    SciNotSetting maxEValueProduct;
+    FloatSetting minLengthPercentage;
+    FloatSetting maxLengthPercentage;
+    IntSetting minLengthBaseDiscrepancy;
+    IntSetting maxLengthBaseDiscrepancy;
+};
+
 class BlastQuery : public QObject
 {
     Q_OBJECT
@@ -44,6 +65,8 @@ public:
     bool hasHits() const {return !m_hits.empty();}
     int hitCount() const {return m_hits.size();}
     const std::vector<std::shared_ptr<BlastHit>> &getHits() const {return m_hits;}
+    const std::vector<BlastHit *> &getHitsOnNode(const DeBruijnNode * node) const;
+    const std::vector<DeBruijnNode *> &getNodesWithHits() const {return m_nodesWithHits;}
     bool wasSearchedFor() const {return m_searchedFor;}
     QColor getColour() const {return m_colour;}
     SequenceType getSequenceType() const {return m_sequenceType;}
@@ -58,8 +81,9 @@ public:
     void setName(QString newName) {m_name = std::move(newName);}
     void addHit(std::shared_ptr<BlastHit> newHit) {m_hits.emplace_back(std::move(newHit));}
     void clearSearchResults();
+    void buildHitIndex();
     void setAsSearchedFor() {m_searchedFor = true;}
-    void findQueryPaths();
+    void findQueryPaths(const QueryPathSettings &settings);
 
 public slots:
     void setColour(QColor newColour) {m_colour = newColour;}
@@ -69,6 +93,10 @@ private:
     QString m_name;
     QString m_sequence;
     std::vector<std::shared_ptr<BlastHit>> m_hits;
+    //The hits grouped by node (nodes are kept in the order their first hit
+    //was added). Each node's hits are sorted by query and then node position.
+    phmap::flat_hash_map<const DeBruijnNode *, std::vector<BlastHit *>> m_hitsByNode;
+    std::vector<DeBruijnNode *> m_nodesWithHits;
     bool m_searchedFor;
     QColor m_colour;
     SequenceType m_sequenceType;
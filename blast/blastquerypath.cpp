@@ -35,22 +35,12 @@ BlastQueryPath::BlastQueryPath(Path path, BlastQuery * query) :
     //the path begins later in the query than the previous hit.
 
     BlastHit * previousHit = nullptr;
-    QList<DeBruijnNode *> pathNodes = m_path.getNodes();
+    const QList<DeBruijnNode *> &pathNodes = m_path.getNodes();
     for (int i = 0; i < pathNodes.size(); ++i)
     {
-        DeBruijnNode * node = pathNodes[i];
-
-        QList<BlastHit *> hitsThisNode;
-        std::vector<std::shared_ptr<BlastHit>> queryHits = query->getHits();
-        for (auto &queryHit : queryHits)
-        {
-            BlastHit * hit = queryHit.get();
-            if (hit->m_node->getName() == node->getName())
-                hitsThisNode.push_back(hit);
-        }
-
-        std::sort(hitsThisNode.begin(), hitsThisNode.end(),
-                  BlastHit::compareTwoBlastHitPointers);
+        //The query's hit index already has this node's hits sorted by their
+        //position in the query.
+        const std::vector<BlastHit *> &hitsThisNode = query->getHitsOnNode(pathNodes[i]);
 
         for (auto hit : hitsThisNode)
         {
@@ -154,8 +144,11 @@ int BlastQueryPath::getHitOverlap(BlastHit * hit1, BlastHit * hit2) const
 
     // Overlap in connected nodes is a bit more complex - we need to express
     // the second hit's coordinates in terms of the first hit's node.
-    else if (g_assemblyGraph->m_deBruijnGraphEdges.contains(possibleEdge)) {
-        DeBruijnEdge * edge = g_assemblyGraph->m_deBruijnGraphEdges[possibleEdge];
+    // Use find() rather than operator[] so concurrent query path searches only
+    // ever read the edge map.
+    else if (auto it = g_assemblyGraph->m_deBruijnGraphEdges.find(possibleEdge);
+             it != g_assemblyGraph->m_deBruijnGraphEdges.end()) {
+        DeBruijnEdge * edge = it->second;
         int overlap = edge->getOverlap();
         hit1Start = hit1->m_nodeStart;
         hit1End = hit1->m_nodeEnd;
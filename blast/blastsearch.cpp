@@ -29,7 +29,6 @@
 
 #include <QDir>
 #include <QRegularExpression>
-#include <QApplication>
 #include <cmath>
 
 BlastSearch::BlastSearch() :
@@ -45,6 +44,7 @@ BlastSearch::~BlastSearch()
 void BlastSearch::clearBlastHits()
 {
     m_allHits.clear();
+    m_nodesWithHits.clear();
     m_blastQueries.clearSearchResults();
     m_blastOutput = "";
 }
@@ -127,6 +127,25 @@ void BlastSearch::buildHitsFromBlastOutput()
         m_allHits.emplace_back(hit);
         query->addHit(std::move(hit));
     }
+
+    findNodesWithHits();
+    for (auto query : m_blastQueries.m_queries)
+        query->buildHitIndex();
+}
+
+
+//This function lists each node with a hit once, so that the BLAST hits scope
+//does not need to scan every hit.
+void BlastSearch::findNodesWithHits()
+{
+    m_nodesWithHits.clear();
+
+    phmap::flat_hash_set<const DeBruijnNode *> seen;
+    for (auto &hit : m_allHits)
+    {
+        if (seen.insert(hit->m_node).second)
+            m_nodesWithHits.push_back(hit->m_node);
+    }
 }
 
 
@@ -238,6 +257,7 @@ void BlastSearch::clearSomeQueries(std::vector<BlastQuery *> queriesToRemove)
 
     //Now actually delete the queries.
     m_blastQueries.clearSomeQueries(queriesToRemove);
+    findNodesWithHits();
 }
 
 
@@ -298,23 +318,15 @@ int BlastSearch::loadBlastQueriesFromFastaFile(QString fullFileName)
 {
     int queriesBefore = int(g_blastSearch->m_blastQueries.m_queries.size());
 
-    std::vector<QString> queryNames;
-    std::vector<QByteArray> querySequences;
-    utils::readFastaOrFastqFile(std::move(fullFileName), &queryNames, &querySequences);
-
-    for (size_t i = 0; i < queryNames.size(); ++i)
+    utils::readFastx(fullFileName, [](std::string_view name, std::string_view sequence)
     {
-        QApplication::processEvents();
-
         //We only use the part of the query name up to the first space.
-        QStringList queryNameParts = queryNames[i].split(" ");
-        QString queryName;
-        if (!queryNameParts.empty())
-            queryName = cleanQueryName(queryNameParts[0]);
+        name = name.substr(0, name.find(' '));
+        QString queryName = cleanQueryName(QString::fromUtf8(name.data(), qsizetype(name.size())));
 
         g_blastSearch->m_blastQueries.addQuery(new BlastQuery(queryName,
-                                                              querySequences[i]));
-    }
+                                                              QString::fromLatin1(sequence.data(), qsizetype(sequence.size()))));
+    });
 
     int queriesAfter = int(g_blastSearch->m_blastQueries.m_queries.size());
     return queriesAfter - queriesBefore;
@@ -344,12 +356,12 @@ void BlastSearch::blastQueryChanged(const QString &queryName)
 
     //If "all" is selected, then we'll display each of the BLAST queries
     if (queryName == "all")
-        queries = g_blastSearch->m_blastQueries.m_queries;
+        queries = m_blastQueries.m_queries;
 
     //If only one query is selected, then just display that one.
     else
     {
-        BlastQuery * query = g_blastSearch->m_blastQueries.getQueryFromName(queryName);
+        BlastQuery * query = m_blastQueries.getQueryFromName(queryName);
         if (query != nullptr)
             queries.push_back(query);
     }
@@ -378,5 +390,6 @@ void BlastSearch::blastQueryChanged(const QString &queryName)
                                                                           hit->m_queryEndFraction));
             }
         }
+        group.buildIntervalIndex();
     }
 }
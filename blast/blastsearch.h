@@ -26,6 +26,7 @@
 #include <QList>
 #include <QSharedPointer>
 #include "program/scinot.h"
+#include "parallel_hashmap/phmap.h"
 
 //This is a class to hold all BLAST search related stuff.
 //An instance of it is made available to the whole program
@@ -46,6 +47,8 @@ public:
     QString m_tempDirectory;
     std::vector<std::shared_ptr<BlastHit>> m_allHits;
 
+    const std::vector<DeBruijnNode *> &getNodesWithHits() const {return m_nodesWithHits;}
+
     static QString getNodeNameFromString(const QString& nodeString);
     static bool findProgram(const QString& programName, QString * command);
     static int loadBlastQueriesFromFastaFile(QString fullFileName);
@@ -59,6 +62,13 @@ public:
     void clearSomeQueries(std::vector<BlastQuery *> queriesToRemove);
     void emptyTempDirectory() const;
     QString doAutoBlastSearch();
+
+private:
+    //The nodes with any hit, each once. Rebuilt whenever the set of hits
+    //changes.
+    std::vector<DeBruijnNode *> m_nodesWithHits;
+
+    void findNodesWithHits();
 };
 
 #endif // BLASTSEARCH_H
@@ -20,8 +20,6 @@
 #include <QProcess>
 #include "program/globals.h"
 #include "program/settings.h"
-#include <QFile>
-#include <QTextStream>
 #include <QMapIterator>
 #include "graph/debruijnnode.h"
 #include "graph/assemblygraph.h"
@@ -36,21 +34,28 @@ void BuildBlastDatabaseWorker::buildBlastDatabase()
 {
     g_blastSearch->m_cancelBuildBlastDatabase = false;
 
-    QFile file(g_blastSearch->m_tempDirectory + "all_nodes.fasta");
-    file.open(QIODevice::WriteOnly | QIODevice::Text);
-    QTextStream out(&file);
-
+    // Nodes without a sequence are left out of the database
+    std::vector<DeBruijnNode *> nodes;
     for (auto &entry : g_assemblyGraph->m_deBruijnGraphNodes) {
-        if (g_blastSearch->m_cancelBuildBlastDatabase)
-        {
-            emit finishedBuild("Build cancelled.");
-            return;
-        }
-
         DeBruijnNode *node = entry;
-        out << node->getFasta(true, false, false);
+        if (node->getSequence().size() > 0)
+            nodes.push_back(node);
+    }
+
+    QString fastaFilename = g_blastSearch->m_tempDirectory + "all_nodes.fasta";
+    bool saved = AssemblyGraph::saveNodesToFasta(fastaFilename, nodes, true, 0,
+                                                 [] { return g_blastSearch->m_cancelBuildBlastDatabase; });
+    if (g_blastSearch->m_cancelBuildBlastDatabase)
+    {
+        emit finishedBuild("Build cancelled.");
+        return;
+    }
+    if (!saved)
+    {
+        m_error = "Could not write " + fastaFilename;
+        emit finishedBuild(m_error);
+        return;
     }
-    file.close();
 
     // Make sure the graph has sequences to BLAST.
     bool atLeastOneSequence = false;
@@ -70,7 +75,7 @@ void BuildBlastDatabaseWorker::buildBlastDatabase()
     }
 
     QStringList makeBlastdbOptions;
-    makeBlastdbOptions << "-in" << (g_blastSearch->m_tempDirectory + "all_nodes.fasta")
+    makeBlastdbOptions << "-in" << fastaFilename
                        << "-dbtype" << "nucl";
     
     g_blastSearch->m_makeblastdb = new QProcess();
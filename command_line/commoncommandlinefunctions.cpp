@@ -214,7 +214,7 @@ void getGraphScopeOptions(QStringList * text)
 {
     *text << "--scope <scope>     Graph scope, from one of the following options: entire, aroundnodes, aroundblast, depthrange (default: entire)";
     *text << "--nodes <list>      A comma-separated list of starting nodes for the aroundnodes scope (default: none)";
-    *text << "--partial           Use partial node name matching (default: exact node name matching)";
+    *text << "--partial           Use partial node name matching (default: exact node name matching). Names enclosed in slashes are regular expressions";
     *text << "--distance <int>    The number of node steps away to draw for the aroundnodes and aroundblast scopes " + getRangeAndDefault(g_settings->nodeDistance);
     *text << "--mindepth <float>  The minimum allowed depth for the depthrange scope " + getRangeAndDefault(g_settings->minDepthRange);
     *text << "--maxdepth <float>  The maximum allowed depth for the depthrange scope "  + getRangeAndDefault(g_settings->maxDepthRange);
@@ -1340,7 +1340,9 @@ bool isCommand(const QString& text)
             text.startsWith("info   ") ||
             text.startsWith("image   ") ||
             text.startsWith("querypaths   ") ||
-            text.startsWith("reduce   ");
+            text.startsWith("contiguity   ") ||
+            text.startsWith("reduce   ") ||
+            text.startsWith("filter   ");
 }
 
 
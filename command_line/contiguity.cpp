@@ -0,0 +1,124 @@
+// Copyright 2022 Anton Korobeynikov
+
+// This file is part of Bandage
+
+// Bandage is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// Bandage is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "contiguity.h"
+#include "commoncommandlinefunctions.h"
+
+#include "graph/assemblygraph.h"
+#include "graph/contiguity.h"
+#include "graph/debruijnnode.h"
+#include "program/settings.h"
+
+#include <algorithm>
+
+int bandageContiguity(QStringList arguments) {
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    if (checkForHelp(arguments)) {
+        printContiguityUsage(&out, false);
+        return 0;
+    }
+
+    if (checkForHelpAll(arguments)) {
+        printContiguityUsage(&out, true);
+        return 0;
+    }
+
+    if (arguments.size() < 2) {
+        printContiguityUsage(&err, false);
+        return 1;
+    }
+
+    QString graphFilename = arguments.at(0);
+    arguments.pop_front();
+    QString nodesList = arguments.at(0);
+    arguments.pop_front();
+
+    if (!checkIfFileExists(graphFilename)) {
+        outputText("Bandage-NG error: " + graphFilename + " does not exist.", &err);
+        return 1;
+    }
+
+    QString error = checkForInvalidContiguityOptions(arguments);
+    if (error.length() > 0) {
+        outputText("Bandage-NG error: " + error, &err);
+        return 1;
+    }
+
+    int steps = g_settings->contiguitySearchSteps;
+    if (isOptionPresent("--steps", &arguments))
+        steps = getIntOption("--steps", &arguments);
+    parseSettings(arguments);
+
+    bool loadSuccess = g_assemblyGraph->loadGraphFromFile(graphFilename);
+    if (!loadSuccess) {
+        err << "Bandage-NG error: could not load " << graphFilename << Qt::endl;
+        return 1;
+    }
+
+    std::vector<QString> nodesNotInGraph;
+    std::vector<DeBruijnNode *> nodes = g_assemblyGraph->getNodesFromString(nodesList, true, &nodesNotInGraph);
+    if (!nodesNotInGraph.empty()) {
+        outputText("Bandage-NG error: " + AssemblyGraph::generateNodesNotFoundErrorMessage(nodesNotInGraph, true), &err);
+        return 1;
+    }
+
+    ContiguitySearch search(steps);
+    ContiguitySearch::Statuses statuses = search.run(nodes);
+
+    // Most contiguous first, then by name, so the output is stable
+    std::vector<std::pair<ContiguityStatus, QString>> lines;
+    lines.reserve(statuses.size());
+    for (const auto &[node, status] : statuses)
+        lines.emplace_back(status, node->getName());
+    std::sort(lines.begin(), lines.end());
+
+    for (const auto &[status, name] : lines)
+        out << name << "\t" << getContiguityStatusName(status) << "\n";
+
+    return 0;
+}
+
+void printContiguityUsage(QTextStream * out, bool all) {
+    QStringList text;
+
+    text << "Bandage contiguity takes a graph file and a list of starting nodes, and outputs (to stdout) the nodes which may be contiguous with the starting nodes. Each line is tab-delimited and holds the node name and its status: starting, contiguous_strand_specific, contiguous_either_strand or maybe_contiguous. Nodes that are not contiguous are not listed.";
+    text << "";
+    text << "Usage:    Bandage contiguity <graph> <nodes> [options]";
+    text << "";
+    text << "Positional parameters:";
+    text << "<graph>             A graph file of any type supported by Bandage";
+    text << "<nodes>             A comma-separated list of node names. A name without a trailing +/- selects both strands of the node";
+    text << "";
+    text << "Options:  --steps <int>       Number of steps walked from the starting nodes (" + QString::number(g_settings->contiguitySearchSteps.min) + " to " + QString::number(g_settings->contiguitySearchSteps.max) + ", default: " + QString::number(g_settings->contiguitySearchSteps.val) + ")";
+    text << "";
+
+    getCommonHelp(&text);
+    if (all)
+        getSettingsUsage(&text);
+    getOnlineHelpMessage(&text);
+
+    outputText(text, out);
+}
+
+QString checkForInvalidContiguityOptions(QStringList arguments) {
+    QString error = checkOptionForInt("--steps", &arguments, g_settings->contiguitySearchSteps, false);
+    if (error.length() > 0) return error;
+
+    return checkForInvalidOrExcessSettings(&arguments);
+}
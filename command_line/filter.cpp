@@ -0,0 +1,153 @@
+// Copyright 2022 Anton Korobeynikov
+
+// This file is part of Bandage
+
+// Bandage is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// Bandage is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "filter.h"
+#include "commoncommandlinefunctions.h"
+
+#include "graph/assemblygraph.h"
+#include "graph/debruijnnode.h"
+#include "program/settings.h"
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+// Only used to check the ranges of the filter options
+static const FloatSetting depthLimit(0.0, 0.0, std::numeric_limits<double>::max());
+static const IntSetting lengthLimit(0, 0, std::numeric_limits<int>::max());
+
+int bandageFilter(QStringList arguments) {
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    if (checkForHelp(arguments)) {
+        printFilterUsage(&out, false);
+        return 0;
+    }
+
+    if (checkForHelpAll(arguments)) {
+        printFilterUsage(&out, true);
+        return 0;
+    }
+
+    if (arguments.size() < 2) {
+        printFilterUsage(&err, false);
+        return 1;
+    }
+
+    QString inputFilename = arguments.at(0);
+    arguments.pop_front();
+    QString outputFilename = arguments.at(0);
+    arguments.pop_front();
+    if (!outputFilename.endsWith(".gfa") && !outputFilename.endsWith(".gfa.gz"))
+        outputFilename += ".gfa";
+
+    if (!checkIfFileExists(inputFilename)) {
+        outputText("Bandage-NG error: " + inputFilename + " does not exist", &err);
+        return 1;
+    }
+
+    QString error = checkForInvalidFilterOptions(arguments);
+    if (error.length() > 0) {
+        outputText("Bandage-NG error: " + error, &err);
+        return 1;
+    }
+
+    double minDepth = 0.0, maxDepth = std::numeric_limits<double>::max();
+    int minLength = 0, maxLength = std::numeric_limits<int>::max();
+    if (isOptionPresent("--mindepth", &arguments))
+        minDepth = getFloatOption("--mindepth", &arguments);
+    if (isOptionPresent("--maxdepth", &arguments))
+        maxDepth = getFloatOption("--maxdepth", &arguments);
+    if (isOptionPresent("--minlen", &arguments))
+        minLength = getIntOption("--minlen", &arguments);
+    if (isOptionPresent("--maxlen", &arguments))
+        maxLength = getIntOption("--maxlen", &arguments);
+    parseSettings(arguments);
+
+    bool loadSuccess = g_assemblyGraph->loadGraphFromFile(inputFilename);
+    if (!loadSuccess) {
+        outputText("Bandage-NG error: could not load " + inputFilename, &err);
+        return 1;
+    }
+
+    // The nodes outside of the limits are at both ends of the nodes sorted by
+    // depth and by length. Both strands of a node share depth and length, so
+    // only the positive nodes are there and their reverse complements go
+    // along with them.
+    const NodeRangeIndex &index = g_assemblyGraph->getNodeRangeIndex();
+    auto [firstInDepth, lastInDepth] = index.depthRange(minDepth, maxDepth);
+    auto [firstInLength, lastInLength] = index.lengthRange(minLength, maxLength);
+    std::vector<DeBruijnNode *> nodesToDelete;
+    auto addOutside = [&](const std::vector<DeBruijnNode *> &sorted, size_t first, size_t last) {
+        nodesToDelete.insert(nodesToDelete.end(), sorted.begin(), sorted.begin() + first);
+        nodesToDelete.insert(nodesToDelete.end(), sorted.begin() + last, sorted.end());
+    };
+    addOutside(index.byDepth(), firstInDepth, lastInDepth);
+    addOutside(index.byLength(), firstInLength, lastInLength);
+    std::sort(nodesToDelete.begin(), nodesToDelete.end());
+    nodesToDelete.erase(std::unique(nodesToDelete.begin(), nodesToDelete.end()), nodesToDelete.end());
+    g_assemblyGraph->deleteNodes(nodesToDelete);
+
+    if (!g_assemblyGraph->saveEntireGraphToGfa(outputFilename)) {
+        err << "Bandage was unable to save the graph file." << Qt::endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+void printFilterUsage(QTextStream * out, bool all) {
+    QStringList text;
+
+    text << "Bandage filter takes an input graph, removes the nodes whose depth or length is outside of the given limits (along with their edges) and saves the remaining graph in GFA format.";
+    text << "";
+    text << "Usage:    Bandage filter <inputgraph> <outputgraph> [options]";
+    text << "";
+    text << "Positional parameters:";
+    text << "<inputgraph>        A graph file of any type supported by Bandage";
+    text << "<outputgraph>       The filename for the GFA graph to be made (if it does not end in '.gfa', that extension will be added). If it ends in '.gfa.gz', the graph is saved gzip-compressed";
+    text << "";
+
+    int nextLineIndex = text.size();
+    text << "--mindepth <float>  Remove nodes with a lower depth (default: no limit)";
+    text << "--maxdepth <float>  Remove nodes with a higher depth (default: no limit)";
+    text << "--minlen <int>      Remove nodes with a shorter sequence (default: no limit)";
+    text << "--maxlen <int>      Remove nodes with a longer sequence (default: no limit)";
+    getCommonHelp(&text);
+    text[nextLineIndex] = "Options:  " + text[nextLineIndex];
+
+    if (all)
+        getSettingsUsage(&text);
+    text << "";
+    getOnlineHelpMessage(&text);
+
+    outputText(text, out);
+}
+
+QString checkForInvalidFilterOptions(QStringList arguments) {
+    QString error = checkOptionForFloat("--mindepth", &arguments, depthLimit, false);
+    if (error.length() > 0) return error;
+    error = checkOptionForFloat("--maxdepth", &arguments, depthLimit, false);
+    if (error.length() > 0) return error;
+    error = checkOptionForInt("--minlen", &arguments, lengthLimit, false);
+    if (error.length() > 0) return error;
+    error = checkOptionForInt("--maxlen", &arguments, lengthLimit, false);
+    if (error.length() > 0) return error;
+
+    return checkForInvalidOrExcessSettings(&arguments);
+}
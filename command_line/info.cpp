@@ -19,7 +19,9 @@
 #include "info.h"
 #include "commoncommandlinefunctions.h"
 #include "graph/assemblygraph.h"
-#include <QPair>
+#include "graph/graphstats.h"
+#include <QJsonDocument>
+#include <QJsonObject>
 
 
 
@@ -62,86 +64,110 @@ int bandageInfo(QStringList arguments)
         return 1;
     }
 
-    bool tsv;
-    parseInfoOptions(arguments, &tsv);
+    bool tsv, json, stream;
+    parseInfoOptions(arguments, &tsv, &json, &stream);
 
-    bool loadSuccess = g_assemblyGraph->loadGraphFromFile(graphFilename);
-    if (!loadSuccess)
+    GraphStats stats;
+    if (stream)
     {
-        err << "Bandage-NG error: could not load " << graphFilename << Qt::endl;
-        return 1;
+        if (!graphFilename.endsWith(".gfa", Qt::CaseInsensitive) &&
+            !graphFilename.endsWith(".gfa.gz", Qt::CaseInsensitive))
+        {
+            outputText("Bandage-NG error: --stream requires a GFA graph file", &err);
+            return 1;
+        }
+
+        try
+        {
+            stats = GraphStats::computeFromGfa(graphFilename);
+        }
+        catch (...)
+        {
+            err << "Bandage-NG error: could not load " << graphFilename << Qt::endl;
+            return 1;
+        }
+    }
+    else
+    {
+        bool loadSuccess = g_assemblyGraph->loadGraphFromFile(graphFilename);
+        if (!loadSuccess)
+        {
+            err << "Bandage-NG error: could not load " << graphFilename << Qt::endl;
+            return 1;
+        }
+
+        stats = GraphStats::compute(*g_assemblyGraph);
     }
 
-    int nodeCount = g_assemblyGraph->m_nodeCount;
-    int edgeCount = g_assemblyGraph->m_edgeCount;
-    QPair<int, int> overlapRange = g_assemblyGraph->getOverlapRange();
-    int smallestOverlap = overlapRange.first;
-    int largestOverlap = overlapRange.second;
-    int totalLength = g_assemblyGraph->m_totalLength;
-    int totalLengthNoOverlaps = g_assemblyGraph->getTotalLengthMinusEdgeOverlaps();
-    int deadEnds = g_assemblyGraph->getDeadEndCount();
-    double percentageDeadEnds = 100.0 * double(deadEnds) / (2 * nodeCount);
-
-    int n50 = 0;
-    int shortestNode = 0;
-    int firstQuartile = 0;
-    int median = 0;
-    int thirdQuartile = 0;
-    int longestNode = 0;
-    g_assemblyGraph->getNodeStats(&n50, &shortestNode, &firstQuartile, &median, &thirdQuartile, &longestNode);
-
-    int componentCount = 0;
-    int largestComponentLength = 0;
-    g_assemblyGraph->getGraphComponentCountAndLargestComponentSize(&componentCount, &largestComponentLength);
-    long long totalLengthOrphanedNodes = g_assemblyGraph->getTotalLengthOrphanedNodes();
-
-    double medianDepthByBase = g_assemblyGraph->getMedianDepthByBase();
-    long long estimatedSequenceLength = g_assemblyGraph->getEstimatedSequenceLength(medianDepthByBase);
-
-    if (tsv)
+    if (json)
+    {
+        QJsonObject info;
+        info["graph"] = graphFilename;
+        info["node_count"] = stats.nodeCount;
+        info["edge_count"] = stats.edgeCount;
+        info["smallest_edge_overlap"] = stats.smallestOverlap;
+        info["largest_edge_overlap"] = stats.largestOverlap;
+        info["total_length"] = stats.totalLength;
+        info["total_length_no_overlaps"] = stats.totalLengthNoOverlaps;
+        info["dead_ends"] = stats.deadEnds;
+        info["percentage_dead_ends"] = stats.percentageDeadEnds;
+        info["connected_components"] = stats.componentCount;
+        info["largest_component"] = stats.largestComponentLength;
+        info["total_length_orphaned_nodes"] = stats.totalLengthOrphanedNodes;
+        info["n50"] = stats.n50;
+        info["shortest_node"] = stats.shortestNode;
+        info["lower_quartile_node"] = stats.firstQuartile;
+        info["median_node"] = stats.median;
+        info["upper_quartile_node"] = stats.thirdQuartile;
+        info["longest_node"] = stats.longestNode;
+        info["median_depth"] = stats.medianDepthByBase;
+        info["estimated_sequence_length"] = stats.estimatedSequenceLength;
+        out << QJsonDocument(info).toJson(QJsonDocument::Compact) << "\n";
+    }
+    else if (tsv)
     {
         out << graphFilename << "\t";
-        out << nodeCount << "\t";
-        out << edgeCount << "\t";
-        out << smallestOverlap << "\t";
-        out << largestOverlap << "\t";
-        out << totalLength << "\t";
-        out << totalLengthNoOverlaps << "\t";
-        out << deadEnds << "\t";
-        out << percentageDeadEnds << "%\t";
-        out << componentCount << "\t";
-        out << largestComponentLength << "\t";
-        out << totalLengthOrphanedNodes << "\t";
-        out << n50 << "\t";
-        out << shortestNode << "\t";
-        out << firstQuartile << "\t";
-        out << median << "\t";
-        out << thirdQuartile << "\t";
-        out << longestNode << "\t";
-        out << medianDepthByBase << "\t";
-        out << estimatedSequenceLength << "\n";
+        out << stats.nodeCount << "\t";
+        out << stats.edgeCount << "\t";
+        out << stats.smallestOverlap << "\t";
+        out << stats.largestOverlap << "\t";
+        out << stats.totalLength << "\t";
+        out << stats.totalLengthNoOverlaps << "\t";
+        out << stats.deadEnds << "\t";
+        out << stats.percentageDeadEnds << "%\t";
+        out << stats.componentCount << "\t";
+        out << stats.largestComponentLength << "\t";
+        out << stats.totalLengthOrphanedNodes << "\t";
+        out << stats.n50 << "\t";
+        out << stats.shortestNode << "\t";
+        out << stats.firstQuartile << "\t";
+        out << stats.median << "\t";
+        out << stats.thirdQuartile << "\t";
+        out << stats.longestNode << "\t";
+        out << stats.medianDepthByBase << "\t";
+        out << stats.estimatedSequenceLength << "\n";
     }
     else
     {
-        out << "Node count:                       " << nodeCount << "\n";
-        out << "Edge count:                       " << edgeCount << "\n";
-        out << "Smallest edge overlap (bp):       " << smallestOverlap << "\n";
-        out << "Largest edge overlap (bp):        " << largestOverlap << "\n";
-        out << "Total length (bp):                " << totalLength << "\n";
-        out << "Total length no overlaps (bp):    " << totalLengthNoOverlaps << "\n";
-        out << "Dead ends:                        " << deadEnds << "\n";
-        out << "Percentage dead ends:             " << percentageDeadEnds << "%\n";
-        out << "Connected components:             " << componentCount << "\n";
-        out << "Largest component (bp):           " << largestComponentLength << "\n";
-        out << "Total length orphaned nodes (bp): " << totalLengthOrphanedNodes << "\n";
-        out << "N50 (bp):                         " << n50 << "\n";
-        out << "Shortest node (bp):               " << shortestNode << "\n";
-        out << "Lower quartile node (bp):         " << firstQuartile << "\n";
-        out << "Median node (bp):                 " << median << "\n";
-        out << "Upper quartile node (bp):         " << thirdQuartile << "\n";
-        out << "Longest node (bp):                " << longestNode << "\n";
-        out << "Median depth:                     " << medianDepthByBase << "\n";
-        out << "Estimated sequence length (bp):   " << estimatedSequenceLength << "\n";
+        out << "Node count:                       " << stats.nodeCount << "\n";
+        out << "Edge count:                       " << stats.edgeCount << "\n";
+        out << "Smallest edge overlap (bp):       " << stats.smallestOverlap << "\n";
+        out << "Largest edge overlap (bp):        " << stats.largestOverlap << "\n";
+        out << "Total length (bp):                " << stats.totalLength << "\n";
+        out << "Total length no overlaps (bp):    " << stats.totalLengthNoOverlaps << "\n";
+        out << "Dead ends:                        " << stats.deadEnds << "\n";
+        out << "Percentage dead ends:             " << stats.percentageDeadEnds << "%\n";
+        out << "Connected components:             " << stats.componentCount << "\n";
+        out << "Largest component (bp):           " << stats.largestComponentLength << "\n";
+        out << "Total length orphaned nodes (bp): " << stats.totalLengthOrphanedNodes << "\n";
+        out << "N50 (bp):                         " << stats.n50 << "\n";
+        out << "Shortest node (bp):               " << stats.shortestNode << "\n";
+        out << "Lower quartile node (bp):         " << stats.firstQuartile << "\n";
+        out << "Median node (bp):                 " << stats.median << "\n";
+        out << "Upper quartile node (bp):         " << stats.thirdQuartile << "\n";
+        out << "Longest node (bp):                " << stats.longestNode << "\n";
+        out << "Median depth:                     " << stats.medianDepthByBase << "\n";
+        out << "Estimated sequence length (bp):   " << stats.estimatedSequenceLength << "\n";
     }
 
     return 0;
@@ -180,6 +206,8 @@ void printInfoUsage(QTextStream * out, bool all)
     text << "<graph>             A graph file of any type supported by Bandage";
     text << "";
     text << "Options:  --tsv               Output the information in a single tab-delimited line starting with the graph file";
+    text << "          --json              Output the information as a JSON object on a single line";
+    text << "          --stream            Compute the statistics while reading a GFA file, without loading the graph. Uses much less memory for very large graphs";
     text << "";
 
     getCommonHelp(&text);
@@ -195,6 +223,8 @@ void printInfoUsage(QTextStream * out, bool all)
 QString checkForInvalidInfoOptions(QStringList arguments)
 {
     checkOptionWithoutValue("--tsv", &arguments);
+    checkOptionWithoutValue("--json", &arguments);
+    checkOptionWithoutValue("--stream", &arguments);
 
     QString error = checkForInvalidOrExcessSettings(&arguments);
     if (error.length() > 0) return error;
@@ -204,8 +234,14 @@ QString checkForInvalidInfoOptions(QStringList arguments)
 
 
 
-void parseInfoOptions(const QStringList& arguments, bool * tsv)
+void parseInfoOptions(const QStringList& arguments, bool * tsv, bool * json, bool * stream)
 {
     int tsvIndex = arguments.indexOf("--tsv");
     *tsv = (tsvIndex > -1);
+
+    int jsonIndex = arguments.indexOf("--json");
+    *json = (jsonIndex > -1);
+
+    int streamIndex = arguments.indexOf("--stream");
+    *stream = (streamIndex > -1);
 }
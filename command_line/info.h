@@ -26,6 +26,6 @@
 int bandageInfo(QStringList arguments);
 void printInfoUsage(QTextStream * out, bool all);
 QString checkForInvalidInfoOptions(QStringList arguments);
-void parseInfoOptions(const QStringList& arguments, bool * tsv);
+void parseInfoOptions(const QStringList& arguments, bool * tsv, bool * json, bool * stream);
 
 #endif // INFO_H
@@ -0,0 +1,108 @@
+// Copyright 2022 Anton Korobeynikov
+
+// This file is part of Bandage
+
+// Bandage is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// Bandage is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "paths.h"
+#include "commoncommandlinefunctions.h"
+
+#include "graph/assemblygraph.h"
+#include "graph/debruijnnode.h"
+
+int bandagePaths(QStringList arguments) {
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    if (checkForHelp(arguments)) {
+        printPathsUsage(&out, false);
+        return 0;
+    }
+
+    if (checkForHelpAll(arguments)) {
+        printPathsUsage(&out, true);
+        return 0;
+    }
+
+    if (arguments.size() < 2) {
+        printPathsUsage(&err, false);
+        return 1;
+    }
+
+    QString graphFilename = arguments.at(0);
+    arguments.pop_front();
+    QString nodesList = arguments.at(0);
+    arguments.pop_front();
+
+    if (!checkIfFileExists(graphFilename)) {
+        outputText("Bandage-NG error: " + graphFilename + " does not exist.", &err);
+        return 1;
+    }
+
+    QString error = checkForInvalidPathsOptions(arguments);
+    if (error.length() > 0) {
+        outputText("Bandage-NG error: " + error, &err);
+        return 1;
+    }
+
+    parseSettings(arguments);
+
+    bool loadSuccess = g_assemblyGraph->loadGraphFromFile(graphFilename);
+    if (!loadSuccess) {
+        err << "Bandage-NG error: could not load " << graphFilename << Qt::endl;
+        return 1;
+    }
+
+    std::vector<QString> nodesNotInGraph;
+    std::vector<DeBruijnNode *> nodes = g_assemblyGraph->getNodesFromString(nodesList, true, &nodesNotInGraph);
+    if (!nodesNotInGraph.empty()) {
+        outputText("Bandage-NG error: " + AssemblyGraph::generateNodesNotFoundErrorMessage(nodesNotInGraph, true), &err);
+        return 1;
+    }
+
+    const auto &paths = g_assemblyGraph->m_deBruijnGraphPaths;
+    for (const auto *node : nodes) {
+        for (const auto &occurrence : paths.occurrences(node)) {
+            out << node->getName() << "\t"
+                << QString::fromStdString(paths.name(occurrence.path)) << "\t"
+                << occurrence.step + 1 << "\n";
+        }
+    }
+
+    return 0;
+}
+
+void printPathsUsage(QTextStream * out, bool all) {
+    QStringList text;
+
+    text << "Bandage paths takes a graph file with paths (e.g. GFA P-lines) and a list of nodes, and outputs (to stdout) the paths going through each of the nodes. Each line is tab-delimited and holds the node name, the path name and the (1-based) step of the path at which the node is visited.";
+    text << "";
+    text << "Usage:    Bandage paths <graph> <nodes> [options]";
+    text << "";
+    text << "Positional parameters:";
+    text << "<graph>             A graph file of any type supported by Bandage";
+    text << "<nodes>             A comma-separated list of node names. A name without a trailing +/- selects both strands of the node";
+    text << "";
+
+    getCommonHelp(&text);
+    if (all)
+        getSettingsUsage(&text);
+    getOnlineHelpMessage(&text);
+
+    outputText(text, out);
+}
+
+QString checkForInvalidPathsOptions(QStringList arguments) {
+    return checkForInvalidOrExcessSettings(&arguments);
+}
@@ -20,7 +20,7 @@
 #include "commoncommandlinefunctions.h"
 #include "program/settings.h"
 #include "graph/assemblygraph.h"
-#include "graph/sequenceutils.h"
+#include "graph/bufferedwriter.h"
 #include "blast/blastsearch.h"
 #include <QDateTime>
 
@@ -134,9 +134,18 @@ int bandageQueryPaths(QStringList arguments)
     out << "done" << Qt::endl;
     out << "(" << QDateTime::currentDateTime().toString("dd MMM yyyy hh:mm:ss") << ") Saving results...       " << Qt::flush;
 
-    //Create the table file.
+    //Create the table file and, if appropriate, the FASTA files. All of them
+    //are written as the paths are visited, through large buffered writes.
     tableFile.open(QIODevice::WriteOnly | QIODevice::Text);
-    QTextStream tableOut(&tableFile);
+    utils::BufferedWriter tableOut(&tableFile);
+
+    if (pathFasta)
+        pathsFile.open(QIODevice::WriteOnly | QIODevice::Text);
+    utils::BufferedWriter pathsOut(&pathsFile);
+
+    if (hitsFasta)
+        hitsFile.open(QIODevice::WriteOnly | QIODevice::Text);
+    utils::BufferedWriter hitsOut(&hitsFile);
 
     //Write the TSV header line.
     tableOut << "Query\t"
@@ -159,16 +168,6 @@ int bandageQueryPaths(QStringList arguments)
     else
         tableOut << "Sequence\n";
 
-    //If a path sequence FASTA file is used, these will store the sequences
-    //that will go there.
-    QList<QString> pathSequenceIDs;
-    QList<QByteArray> pathSequences;
-
-    //If a hits sequence FASTA file is used, these will store the sequences
-    //that will go there.
-    QList<QString> hitSequenceIDs;
-    QList<QByteArray> hitSequences;
-
     for (auto query : g_blastSearch->m_blastQueries.m_queries)
     {
         QList<BlastQueryPath> queryPaths = query->getPaths();
@@ -178,73 +177,50 @@ int bandageQueryPaths(QStringList arguments)
             BlastQueryPath queryPath = queryPaths[j];
             Path path = queryPath.getPath();
 
-            tableOut << query->getName() << "\t";
-            tableOut << path.getString(true) << "\t";
-            tableOut << QString::number(path.getLength()) << "\t";
-            tableOut << QString::number(100.0 * queryPath.getPathQueryCoverage()) << "%\t";
-            tableOut << QString::number(100.0 * queryPath.getHitsQueryCoverage()) << "%\t";
-            tableOut << QString::number(queryPath.getMeanHitPercIdentity()) << "%\t";
-            tableOut << QString::number(queryPath.getTotalHitMismatches()) << "\t";
-            tableOut << QString::number(queryPath.getTotalHitGapOpens()) << "\t";
-            tableOut << QString::number(100.0 * queryPath.getRelativePathLength()) << "%\t";
-            tableOut << queryPath.getAbsolutePathLengthDifferenceString(false) << "\t";
-            tableOut << queryPath.getEvalueProduct().asString(false) << "\t";
-
-            //If we are using a separate file for the path sequences, save the
-            //sequence along with its ID to save later, and store the ID here.
-            //Otherwise, just include the sequence in this table.
+            tableOut << query->getName() << '\t';
+            tableOut << path.getString(true) << '\t';
+            tableOut << path.getLength() << '\t';
+            tableOut << 100.0 * queryPath.getPathQueryCoverage() << "%\t";
+            tableOut << 100.0 * queryPath.getHitsQueryCoverage() << "%\t";
+            tableOut << queryPath.getMeanHitPercIdentity() << "%\t";
+            tableOut << queryPath.getTotalHitMismatches() << '\t';
+            tableOut << queryPath.getTotalHitGapOpens() << '\t';
+            tableOut << 100.0 * queryPath.getRelativePathLength() << "%\t";
+            tableOut << queryPath.getAbsolutePathLengthDifferenceString(false) << '\t';
+            tableOut << queryPath.getEvalueProduct().asString(false) << '\t';
+
+            //If we are using a separate file for the path sequences, write the
+            //sequence there and store its ID here. Otherwise, just include the
+            //sequence in this table.
             QByteArray sequence = path.getPathSequence();
-            QString pathSequenceID = query->getName() + "_" + QString::number(j+1);
             if (pathFasta)
             {
-                pathSequenceIDs.push_back(pathSequenceID);
-                pathSequences.push_back(sequence);
-                tableOut << pathSequenceID << "\n";
+                tableOut << query->getName() << '_' << j + 1 << '\n';
+                pathsOut << '>' << query->getName() << '_' << j + 1 << '\n';
+                pathsOut.writeSequenceLines(sequence);
             }
             else
-                tableOut << sequence << "\n";
+                tableOut << sequence << '\n';
 
-            //If we are also saving the hit sequences, save the hit sequence
-            //along with its ID to save later.
+            //If we are also saving the hit sequences, write each hit sequence
+            //along with its ID.
             if (hitsFasta)
             {
                 QList<BlastHit *> hits = queryPath.getHits();
                 for (int k = 0; k < hits.size(); ++k)
                 {
-                    BlastHit * hit = hits[k];
-                    QString hitSequenceID = pathSequenceID + "_" + QString::number(k+1);
-                    QByteArray hitSequence = hit->getNodeSequence();
-                    hitSequenceIDs.push_back(hitSequenceID);
-                    hitSequences.push_back(hitSequence);
+                    hitsOut << '>' << query->getName() << '_' << j + 1 << '_' << k + 1 << '\n';
+                    hitsOut.writeSequenceLines(hits[k]->getNodeSequence());
                 }
             }
         }
     }
 
-    //Write the path sequence FASTA file, if appropriate.
-    if (pathFasta)
-    {
-        pathsFile.open(QIODevice::WriteOnly | QIODevice::Text);
-        QTextStream pathsOut(&pathsFile);
-
-        for (int i = 0; i < pathSequenceIDs.size(); ++i)
-        {
-            pathsOut << ">" + pathSequenceIDs[i] + "\n";
-            pathsOut << utils::addNewlinesToSequence(pathSequences[i]);
-        }
-    }
-
-    //Write the hits sequence FASTA file, if appropriate.
-    if (hitsFasta)
+    if (!tableOut.flush() || !pathsOut.flush() || !hitsOut.flush())
     {
-        hitsFile.open(QIODevice::WriteOnly | QIODevice::Text);
-        QTextStream hitsOut(&hitsFile);
-
-        for (int i = 0; i < hitSequenceIDs.size(); ++i)
-        {
-            hitsOut << ">" << hitSequenceIDs[i] << "\n";
-            hitsOut << utils::addNewlinesToSequence(hitSequences[i]);
-        }
+        err << Qt::endl << "Bandage-NG error: could not write the results" << Qt::endl;
+        deleteBlastTempDirectory();
+        return 1;
     }
 
     out << "done" << Qt::endl;
@@ -22,6 +22,7 @@
 #include "ui/mygraphicsscene.h"
 #include "ui/mygraphicsview.h"
 #include "graph/assemblygraph.h"
+#include "graph/debruijnnode.h"
 #include "blast/blastsearch.h"
 #include <QDir>
 #include <QPainter>
@@ -63,7 +64,7 @@ int bandageReduce(QStringList arguments)
 
     QString outputFilename = arguments.at(0);
     arguments.pop_front();
-    if (!outputFilename.endsWith(".gfa"))
+    if (!outputFilename.endsWith(".gfa") && !outputFilename.endsWith(".gfa.gz"))
         outputFilename += ".gfa";
 
     QString error = checkForInvalidReduceOptions(arguments);
@@ -115,7 +116,23 @@ int bandageReduce(QStringList arguments)
 
     g_assemblyGraph->markNodesToDraw(startingNodes, g_settings->nodeDistance);
 
-    bool success = g_assemblyGraph->saveVisibleGraphToGfa(outputFilename);
+    //To merge, the nodes outside of the scope are removed first, so that only
+    //the reduced graph is merged and saved.
+    bool success;
+    if (isOptionPresent("--merge", &arguments))
+    {
+        std::vector<DeBruijnNode *> nodesToDelete;
+        for (auto *node : g_assemblyGraph->m_deBruijnGraphNodes)
+        {
+            if (node->isPositiveNode() && !node->thisNodeOrReverseComplementIsDrawn())
+                nodesToDelete.push_back(node);
+        }
+        g_assemblyGraph->deleteNodes(nodesToDelete);
+        g_assemblyGraph->mergeAllPossible();
+        success = g_assemblyGraph->saveEntireGraphToGfa(outputFilename);
+    }
+    else
+        success = g_assemblyGraph->saveVisibleGraphToGfa(outputFilename);
     if (!success)
     {
         err << "Bandage was unable to save the graph file." << Qt::endl;
@@ -139,10 +156,11 @@ void printReduceUsage(QTextStream * out, bool all)
     text << "";
     text << "Positional parameters:";
     text << "<inputgraph>        A graph file of any type supported by Bandage";
-    text << "<outputgraph>       The filename for the GFA graph to be made (if it does not end in '.gfa', that extension will be added)";
+    text << "<outputgraph>       The filename for the GFA graph to be made (if it does not end in '.gfa', that extension will be added). If it ends in '.gfa.gz', the graph is saved gzip-compressed";
     text << "";
 
     int nextLineIndex = text.size();
+    text << "--merge             Merge all non-branching chains of nodes in the reduced graph into single nodes";
     getCommonHelp(&text);
     text[nextLineIndex] = "Options:  " + text[nextLineIndex];
 
@@ -164,5 +182,6 @@ void printReduceUsage(QTextStream * out, bool all)
 
 QString checkForInvalidReduceOptions(QStringList arguments)
 {
+    checkOptionWithoutValue("--merge", &arguments);
     return checkForInvalidOrExcessSettings(&arguments);
 }
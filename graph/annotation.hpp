@@ -1,6 +1,7 @@
 #ifndef BANDAGE_GRAPH_ANNOTATION_HPP_
 #define BANDAGE_GRAPH_ANNOTATION_HPP_
 
+#include <memory>
 #include <utility>
 
 #include <QColor>
@@ -20,6 +21,15 @@ public:
     drawFigure(QPainter &painter, GraphicsItemNode &graphicsItemNode, bool reverseComplement, int64_t start,
                int64_t end) const = 0;
 
+    // Draws the view over a band of merged annotations that are each shorter
+    // than a pixel, so their parts can not be told apart. By default the view
+    // is drawn over the whole band.
+    virtual void
+    drawBand(QPainter &painter, GraphicsItemNode &graphicsItemNode, bool reverseComplement, int64_t start,
+             int64_t end) const {
+        drawFigure(painter, graphicsItemNode, reverseComplement, start, end);
+    }
+
     [[nodiscard]] virtual QString getTypeName() const = 0;
 
     virtual ~IAnnotationView() = default;
@@ -48,7 +58,7 @@ public:
             fractionStart = 1 - fractionStart;
             fractionEnd = 1 - fractionEnd;
         }
-        painter.drawPath(graphicsItemNode.makePartialPath(fractionStart, fractionEnd));
+        painter.drawPath(graphicsItemNode.getPartialPath(fractionStart, fractionEnd));
     }
 
     [[nodiscard]] QString getTypeName() const override {
@@ -104,7 +114,7 @@ public:
 
             pen.setColor(dotColour);
             painter.setPen(pen);
-            painter.drawPath(graphicsItemNode.makePartialPath(fromFraction, toFraction));
+            painter.drawPath(graphicsItemNode.getPartialPath(fromFraction, toFraction));
 
             nodeFraction = nextFraction;
             rainbowFraction += rainbowSpacing;
@@ -123,12 +133,25 @@ private:
 
 class BedThickView : public SolidView {
 public:
+    // A thick part that spans the whole feature, so the view can be shared
+    BedThickView(double widthMultiplier, const QColor &color) : SolidView(widthMultiplier, color),
+                                                                m_fullSpan(true) {}
+
     BedThickView(double widthMultiplier, const QColor &color, int64_t mThickStart, int64_t mThickEnd) : SolidView(
             widthMultiplier, color), m_thickStart(mThickStart), m_thickEnd(mThickEnd) {}
 
-    void drawFigure(QPainter &painter, GraphicsItemNode &graphicsItemNode, bool reverseComplement, int64_t,
-                    int64_t) const override {
-        SolidView::drawFigure(painter, graphicsItemNode, reverseComplement, m_thickStart, m_thickEnd);
+    void drawFigure(QPainter &painter, GraphicsItemNode &graphicsItemNode, bool reverseComplement, int64_t start,
+                    int64_t end) const override {
+        if (m_fullSpan)
+            SolidView::drawFigure(painter, graphicsItemNode, reverseComplement, start, end);
+        else
+            SolidView::drawFigure(painter, graphicsItemNode, reverseComplement, m_thickStart, m_thickEnd);
+    }
+
+    void drawBand(QPainter &painter, GraphicsItemNode &graphicsItemNode, bool reverseComplement, int64_t start,
+                  int64_t end) const override {
+        if (m_fullSpan || m_thickStart < m_thickEnd)
+            SolidView::drawFigure(painter, graphicsItemNode, reverseComplement, start, end);
     }
 
     [[nodiscard]] QString getTypeName() const override {
@@ -136,8 +159,9 @@ public:
     }
 
 private:
-    int64_t m_thickStart;
-    int64_t m_thickEnd;
+    bool m_fullSpan = false;
+    int64_t m_thickStart = 0;
+    int64_t m_thickEnd = 0;
 };
 
 
@@ -158,6 +182,12 @@ public:
         }
     }
 
+    void drawBand(QPainter &painter, GraphicsItemNode &graphicsItemNode, bool reverseComplement, int64_t start,
+                  int64_t end) const override {
+        if (!m_blocks.empty())
+            SolidView(m_widthMultiplier, m_color).drawFigure(painter, graphicsItemNode, reverseComplement, start, end);
+    }
+
     [[nodiscard]] QString getTypeName() const override {
         return "BED Blocks";
     }
@@ -175,8 +205,15 @@ public:
 
     void drawFigure(QPainter &painter, GraphicsItemNode &graphicsItemNode, bool reverseComplement,
                     const std::set<ViewId> &viewsToShow) const {
+        drawFigure(painter, graphicsItemNode, reverseComplement, viewsToShow, m_start, m_end);
+    }
+
+    // Draws the views of the annotation over a band of merged sub-pixel
+    // annotations instead of its own range.
+    void drawBand(QPainter &painter, GraphicsItemNode &graphicsItemNode, bool reverseComplement,
+                  const std::set<ViewId> &viewsToShow, int64_t start, int64_t end) const {
         for (auto view_id : viewsToShow) {
-            m_views[view_id]->drawFigure(painter, graphicsItemNode, reverseComplement, m_start, m_end);
+            m_views[view_id]->drawBand(painter, graphicsItemNode, reverseComplement, start, end);
         }
     }
 
@@ -195,11 +232,16 @@ public:
         GraphicsItemNode::drawTextPathAtLocation(&painter, textPath, textPoint);
     }
 
-    void addView(std::unique_ptr<IAnnotationView> view) {
+    // Views hold no per-annotation state beyond their parameters, so the same
+    // view can be shared by many annotations.
+    void addView(std::shared_ptr<const IAnnotationView> view) {
         m_views.emplace_back(std::move(view));
     }
 
-    [[nodiscard]] const std::vector<std::unique_ptr<IAnnotationView>> &getViews() const {
+    [[nodiscard]] int64_t getStart() const { return m_start; }
+    [[nodiscard]] int64_t getEnd() const { return m_end; }
+
+    [[nodiscard]] const std::vector<std::shared_ptr<const IAnnotationView>> &getViews() const {
         return m_views;
     }
 
@@ -207,7 +249,7 @@ private:
     int64_t m_start;
     int64_t m_end;
     std::string m_text;
-    std::vector<std::unique_ptr<IAnnotationView>> m_views;
+    std::vector<std::shared_ptr<const IAnnotationView>> m_views;
 };
 
 #endif //BANDAGE_GRAPH_ANNOTATION_HPP_
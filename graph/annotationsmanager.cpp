@@ -1,5 +1,8 @@
 #include "annotationsmanager.h"
 
+#include <algorithm>
+#include <limits>
+
 AnnotationGroup &AnnotationsManager::createAnnotationGroup(QString name) {
     if (name == g_settings->blastAnnotationGroupName) {
         // To be removed when we can set up annotations from CLI properly.
@@ -13,6 +16,25 @@ AnnotationGroup &AnnotationsManager::createAnnotationGroup(QString name) {
 }
 
 
+void AnnotationGroup::buildIntervalIndex() {
+    maxEnds.clear();
+    for (auto &[node, annotations] : annotationMap) {
+        std::stable_sort(annotations.begin(), annotations.end(),
+                         [](const std::unique_ptr<Annotation> &a, const std::unique_ptr<Annotation> &b) {
+                             return a->getStart() < b->getStart();
+                         });
+
+        auto &nodeMaxEnds = maxEnds[node];
+        nodeMaxEnds.reserve(annotations.size());
+        int64_t maxEnd = std::numeric_limits<int64_t>::min();
+        for (const auto &annotation : annotations) {
+            maxEnd = std::max(maxEnd, annotation->getEnd());
+            nodeMaxEnds.push_back(maxEnd);
+        }
+    }
+}
+
+
 const AnnotationsManager::AnnotationGroupVector &AnnotationsManager::getGroups() const {
     return m_annotationGroups;
 }
@@ -4,6 +4,8 @@
 #include <QObject>
 #include "graph/annotation.hpp"
 
+#include <algorithm>
+
 
 struct AnnotationGroup {
     using AnnotationVector = std::vector<std::unique_ptr<Annotation>>;
@@ -13,9 +15,49 @@ struct AnnotationGroup {
     const QString name;
     AnnotationMap annotationMap;
 
+    // For every node, the running maximum of the annotation ends (in the
+    // order of their starts). See buildIntervalIndex().
+    std::unordered_map<const DeBruijnNode *, std::vector<int64_t>> maxEnds;
+
     const AnnotationVector &getAnnotations(const DeBruijnNode *node) const {
         return getFromMapOrDefaultConstructed(annotationMap, node);
     }
+
+    // Sorts the annotations of each node by their start and records the
+    // running maximum of their ends, so that the annotations overlapping a
+    // range can be found with binary searches. To be called once the group
+    // is filled.
+    void buildIntervalIndex();
+
+    // Calls f for every annotation of the node overlapping [start, end], in
+    // the order of their starts.
+    template<class F>
+    void forEachOverlapping(const DeBruijnNode *node, int64_t start, int64_t end, F f) const {
+        const auto &annotations = getAnnotations(node);
+        if (annotations.empty())
+            return;
+
+        auto maxEndsIt = maxEnds.find(node);
+        if (maxEndsIt == maxEnds.end() || maxEndsIt->second.size() != annotations.size()) {
+            // No index, so check them all
+            for (const auto &annotation : annotations) {
+                if (annotation->getStart() <= end && annotation->getEnd() >= start)
+                    f(*annotation);
+            }
+            return;
+        }
+
+        const auto &nodeMaxEnds = maxEndsIt->second;
+        size_t first = std::lower_bound(nodeMaxEnds.begin(), nodeMaxEnds.end(), start) - nodeMaxEnds.begin();
+        size_t last = std::upper_bound(annotations.begin(), annotations.end(), end,
+                                       [](int64_t pos, const std::unique_ptr<Annotation> &annotation) {
+                                           return pos < annotation->getStart();
+                                       }) - annotations.begin();
+        for (size_t i = first; i < last; ++i) {
+            if (annotations[i]->getEnd() >= start)
+                f(*annotations[i]);
+        }
+    }
 };
 
 class AnnotationsManager : public QObject {
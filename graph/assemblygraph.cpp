@@ -20,9 +20,11 @@
 #include "debruijnedge.h"
 #include "path.h"
 #include "assemblygraphbuilder.h"
+#include "bufferedwriter.h"
 #include "graphicsitemedge.h"
 #include "graphicsitemnode.h"
 #include "sequenceutils.h"
+#include "unitigs.h"
 
 #include "blast/blastsearch.h"
 #include "program/globals.h"
@@ -36,8 +38,10 @@
 #include <QQueue>
 #include <QRegularExpression>
 #include <QSet>
+#include <QtConcurrent>
 
 #include <algorithm>
+#include <fstream>
 #include <limits>
 #include <cmath>
 #include <utility>
@@ -51,36 +55,11 @@ AssemblyGraph::AssemblyGraph()
 
 AssemblyGraph::~AssemblyGraph() = default;
 
-
-template<typename T> double getValueUsingFractionalIndex(const std::vector<T> &v, double index) {
-    if (v.size() == 0)
-        return 0.0;
-    if (v.size() == 1)
-        return double(v.front());
-
-    int wholePart = floor(index);
-
-    if (wholePart < 0)
-        return double(v.front());
-    if (wholePart >= int(v.size()) - 1)
-        return double(v.back());
-
-    double fractionalPart = index - wholePart;
-
-    double piece1 = double(v[wholePart]);
-    double piece2 = double(v[wholePart+1]);
-
-    return piece1 * (1.0 - fractionalPart) + piece2 * fractionalPart;
-}
-
 void AssemblyGraph::cleanUp()
 {
-    {
-        for (auto &entry : m_deBruijnGraphPaths) {
-            delete entry;
-        }
-        m_deBruijnGraphPaths.clear();
-    }
+    m_nodeNameIndex.clear();
+    m_nodeRangeIndex.clear();
+    m_deBruijnGraphPaths.clear();
 
 
     {
@@ -102,6 +81,10 @@ void AssemblyGraph::cleanUp()
     m_nodeColors.clear();
     m_nodeLabels.clear();
     m_nodeCSVData.clear();
+
+    m_drawnNodes.clear();
+    m_drawnEdges.clear();
+    m_drawnScopeStale = false;
     
     m_contiguitySearchDone = false;
 
@@ -140,24 +123,42 @@ void AssemblyGraph::createDeBruijnEdge(const QString& node1Name, const QString&
         negNode2 == m_deBruijnGraphNodes.end())
         return;
 
+    createDeBruijnEdge(*node1, *node2, *negNode1, *negNode2, overlap, overlapType);
+}
+
+void AssemblyGraph::createDeBruijnEdge(DeBruijnNode *node1, DeBruijnNode *node2,
+                                       int overlap, EdgeOverlapType overlapType)
+{
+    DeBruijnNode *negNode1 = node1->getReverseComplement();
+    DeBruijnNode *negNode2 = node2->getReverseComplement();
+    if (negNode1 == nullptr || negNode2 == nullptr)
+        return;
+
+    createDeBruijnEdge(node1, node2, negNode1, negNode2, overlap, overlapType);
+}
+
+void AssemblyGraph::createDeBruijnEdge(DeBruijnNode *node1, DeBruijnNode *node2,
+                                       DeBruijnNode *negNode1, DeBruijnNode *negNode2,
+                                       int overlap, EdgeOverlapType overlapType)
+{
     //Quit if the edge already exists
-    for (const auto *edge : (*node1)->edges()) {
-        if (edge->getStartingNode() == *node1 &&
-            edge->getEndingNode() == *node2)
+    for (const auto *edge : node1->edges()) {
+        if (edge->getStartingNode() == node1 &&
+            edge->getEndingNode() == node2)
             return;
     }
 
     //Usually, an edge has a different pair, but it is possible
     //for an edge to be its own pair.
-    bool isOwnPair = (*node1 == *negNode2 && *node2 == *negNode1);
+    bool isOwnPair = (node1 == negNode2 && node2 == negNode1);
 
-    auto * forwardEdge = new DeBruijnEdge(*node1, *node2);
+    auto * forwardEdge = new DeBruijnEdge(node1, node2);
     DeBruijnEdge * backwardEdge;
 
     if (isOwnPair)
         backwardEdge = forwardEdge;
     else
-        backwardEdge = new DeBruijnEdge(*negNode2, *negNode1);
+        backwardEdge = new DeBruijnEdge(negNode2, negNode1);
 
     forwardEdge->setReverseComplement(backwardEdge);
     backwardEdge->setReverseComplement(forwardEdge);
@@ -171,16 +172,17 @@ void AssemblyGraph::createDeBruijnEdge(const QString& node1Name, const QString&
     if (!isOwnPair)
         m_deBruijnGraphEdges.emplace(std::make_pair(backwardEdge->getStartingNode(), backwardEdge->getEndingNode()), backwardEdge);
 
-    (*node1)->addEdge(forwardEdge);
-    (*node2)->addEdge(forwardEdge);
-    (*negNode1)->addEdge(backwardEdge);
-    (*negNode2)->addEdge(backwardEdge);
+    node1->addEdge(forwardEdge);
+    node2->addEdge(forwardEdge);
+    negNode1->addEdge(backwardEdge);
+    negNode2->addEdge(backwardEdge);
 }
 
 void AssemblyGraph::resetNodes()
 {
     for (auto &entry : m_deBruijnGraphNodes)
         entry->resetNode();
+    m_drawnNodes.clear();
 }
 
 //http://www.code10.info/index.php?option=com_content&view=article&id=62:articledna-reverse-complement&catid=49:cat_coding_algorithms_bioinformatics&Itemid=74
@@ -243,6 +245,7 @@ void AssemblyGraph::resetEdges()
     for (auto &entry : m_deBruijnGraphEdges) {
         entry.second->reset();
     }
+    m_drawnEdges.clear();
 }
 
 
@@ -251,14 +254,16 @@ double AssemblyGraph::getMeanDepth(bool drawnNodesOnly)
     long double depthSum = 0.0;
     long long totalLength = 0;
 
-    for (auto &entry : m_deBruijnGraphNodes) {
-        DeBruijnNode * node = entry;
-
-        if (drawnNodesOnly && node->isNotDrawn())
-            continue;
-
+    auto addNode = [&](const DeBruijnNode *node) {
         totalLength += node->getLength();
         depthSum += node->getLength() * node->getDepth();
+    };
+    if (drawnNodesOnly) {
+        for (auto *node : getDrawnNodes())
+            addNode(node);
+    } else {
+        for (auto *node : m_deBruijnGraphNodes)
+            addNode(node);
     }
 
     if (totalLength == 0)
@@ -334,7 +339,6 @@ void AssemblyGraph::determineGraphInfo()
     m_longestContig = 0;
     int nodeCount = 0;
     long long totalLength = 0;
-    std::vector<double> nodeDepths;
 
     for (auto &entry : m_deBruijnGraphNodes) {
         long long nodeLength = entry->getLength();
@@ -350,8 +354,6 @@ void AssemblyGraph::determineGraphInfo()
             totalLength += nodeLength;
             ++nodeCount;
         }
-
-        nodeDepths.push_back(entry->getDepth());
     }
 
     //Count up the edges that will be shown in single mode (i.e. positive
@@ -369,15 +371,16 @@ void AssemblyGraph::determineGraphInfo()
     m_meanDepth = getMeanDepth();
     m_pathCount = m_deBruijnGraphPaths.size();
 
-    std::sort(nodeDepths.begin(), nodeDepths.end());
+    //The depth quartiles count the nodes of both strands.
+    const NodeRangeIndex &index = getNodeRangeIndex();
+    double depthCount = 2.0 * index.size();
+    double firstQuartileIndex = (depthCount - 1) / 4.0;
+    double medianIndex = (depthCount - 1) / 2.0;
+    double thirdQuartileIndex = (depthCount - 1) * 3.0 / 4.0;
 
-    double firstQuartileIndex = (nodeDepths.size() - 1) / 4.0;
-    double medianIndex = (nodeDepths.size() - 1) / 2.0;
-    double thirdQuartileIndex = (nodeDepths.size() - 1) * 3.0 / 4.0;
-
-    m_firstQuartileDepth = getValueUsingFractionalIndex(nodeDepths, firstQuartileIndex);
-    m_medianDepth = getValueUsingFractionalIndex(nodeDepths, medianIndex);
-    m_thirdQuartileDepth = getValueUsingFractionalIndex(nodeDepths, thirdQuartileIndex);
+    m_firstQuartileDepth = index.depthAtFractionalIndexBothStrands(firstQuartileIndex);
+    m_medianDepth = index.depthAtFractionalIndexBothStrands(medianIndex);
+    m_thirdQuartileDepth = index.depthAtFractionalIndexBothStrands(thirdQuartileIndex);
 
     //Set the auto node length setting. This is determined by aiming for a
     //target average node length. But if the graph is small, the value will be
@@ -413,66 +416,80 @@ void AssemblyGraph::clearGraphInfo()
  * @returns         true/false if loading data worked
  */
 bool AssemblyGraph::loadCSV(const QString &filename, QStringList *columns, QString *errormsg, bool *coloursLoaded) {
-    clearAllCsvData();
+    return applyCSV(readCSV(filename), columns, errormsg, coloursLoaded);
+}
 
-    QFile inputFile(filename);
-    if (!inputFile.open(QIODevice::ReadOnly)) {
-        *errormsg = "Unable to read from specified file.";
-        return false;
+CsvLoadResult AssemblyGraph::readCSV(const QString &filename) const {
+    CsvLoadResult res;
+
+    std::ifstream in(filename.toStdString(), std::ios::binary);
+    if (!in) {
+        res.errormsg = "Unable to read from specified file.";
+        return res;
     }
-    QTextStream in(&inputFile);
-    QString line = in.readLine();
+
+    auto readLine = [&](std::string &line) {
+        if (!std::getline(in, line))
+            return false;
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+        return true;
+    };
+
+    std::string line;
+    readLine(line);
 
     // guess at separator; this assumes that any tab in the first line means
     // we have a tab separated file
-    QString sep = "\t";
-    if (line.split(sep).length() == 1) {
-        sep = ",";
-        if (line.split(sep).length() == 1) {
-            *errormsg = "Neither tab nor comma in first line. Please check file format.";
-            return false;
+    char sep = '\t';
+    if (line.find(sep) == std::string::npos) {
+        sep = ',';
+        if (line.find(sep) == std::string::npos) {
+            res.errormsg = "Neither tab nor comma in first line. Please check file format.";
+            return res;
         }
     }
 
     unsigned unmatchedNodes = 0; // keep a counter for lines in file that can't be matched to nodes
 
-    QStringList headers = utils::splitCsv(line, sep);
-    if (headers.size() < 2) {
-        *errormsg = "Not enough CSV headers: at least two required.";
-        return false;
+    std::vector<std::string> cols;
+    size_t headerCount = utils::splitCsv(line, sep, cols);
+    if (headerCount < 2) {
+        res.errormsg = "Not enough CSV headers: at least two required.";
+        return res;
     }
-    headers.pop_front();
+    for (size_t i = 1; i < headerCount; ++i)
+        res.headers << QString::fromStdString(cols[i]);
 
     //Check to see if any of the columns holds colour data.
     int colourCol = -1;
-    for (size_t i = 0; i < headers.size(); ++i) {
-        QString header = headers[i].toLower();
+    for (size_t i = 0; i < res.headers.size(); ++i) {
+        QString header = res.headers[i].toLower();
         if (header == "colour" || header == "color") {
             colourCol = i;
-            *coloursLoaded = true;
+            res.coloursLoaded = true;
             break;
         }
     }
 
-    *columns = m_csvHeaders = headers;
-    size_t columnCount = headers.size();
+    res.data.setColumnCount(res.headers.size());
 
-    QMap<QString, QColor> colourCategories;
+    phmap::flat_hash_map<std::string, QColor> colourCategories;
+    size_t colourCategoryCount = 0;
     std::vector<QColor> presetColours = getPresetColours();
-    while (!in.atEnd()) {
-        QApplication::processEvents();
+    std::vector<DeBruijnNode *> nodes;
+    while (readLine(line)) {
+        if (line.empty())
+            continue;
 
-        QStringList cols = utils::splitCsv(in.readLine(), sep);
-        QString nodeName(cols[0]);
-        
-        std::vector<DeBruijnNode *> nodes;
+        size_t colCount = utils::splitCsv(line, sep, cols);
+        const std::string &nodeName = cols[0];
+
+        nodes.clear();
         // See if this is a path name
         {
-            auto pathIt = m_deBruijnGraphPaths.equal_prefix_range(nodeName.toStdString());
-            for (; pathIt.first != pathIt.second; ++pathIt.first) {
-                const auto &pathNodes = (*pathIt.first)->getNodes();
-
-                for (auto *node: pathNodes) {
+            for (auto pathId : m_deBruijnGraphPaths.findByPrefix(nodeName)) {
+                for (auto *node: m_deBruijnGraphPaths.steps(pathId)) {
                     nodes.emplace_back(node);
                     if (!g_settings->doubleMode)
                         nodes.emplace_back(node->getReverseComplement());
@@ -480,9 +497,15 @@ bool AssemblyGraph::loadCSV(const QString &filename, QStringList *columns, QStri
             }
         }
 
-        // Just node name
+        // Just node name. Check the obvious cases before the more expensive
+        // name parsing.
         if (nodes.empty()) {
-            auto nodeIt = m_deBruijnGraphNodes.find(getNodeNameFromString(nodeName).toStdString());
+            auto nodeIt = m_deBruijnGraphNodes.find(nodeName);
+            if (nodeIt == m_deBruijnGraphNodes.end())
+                nodeIt = m_deBruijnGraphNodes.find(nodeName + "+");
+            if (nodeIt == m_deBruijnGraphNodes.end())
+                nodeIt = m_deBruijnGraphNodes.find(
+                        getNodeNameFromString(QString::fromStdString(nodeName)).toStdString());
             if (nodeIt != m_deBruijnGraphNodes.end())
                 nodes.emplace_back(*nodeIt);
         }
@@ -492,37 +515,53 @@ bool AssemblyGraph::loadCSV(const QString &filename, QStringList *columns, QStri
             continue;
         }
 
-        // Get rid of the node name - no need to save that.
-        cols.pop_front();
-
-        // Get rid of any extra data that doesn't have a header.
-        cols.resize(columnCount);
-
+        // Skip the node name, any extra data that doesn't have a header is ignored.
+        auto row = res.data.addRow(cols, 1, colCount);
         for (auto *node: nodes)
-            setCsvData(node, cols);
+            res.data.setRow(node, row);
 
         // If one of the columns holds colour data, get the colour from that one.
         // Acceptable colour formats: 6-digit hex colour (e.g. #FFB6C1), an 8-digit hex colour (e.g. #7FD2B48C) or a
         // standard colour name (e.g. skyblue).
         // If the colour value is something other than one of these, a colour will be assigned to the value.  That way
         // categorical names can be used and automatically given colours.
-        if (colourCol == -1 || cols.size() <= colourCol)
+        if (colourCol == -1 || colCount <= colourCol + 1)
             continue;
 
-        QString colourString = cols[colourCol];
-        QColor colour(colourString);
-        if (!colour.isValid()) {
-            QColor presetColor = presetColours[colourCategories.size() % presetColours.size()];
-            auto colorCat = colourCategories.insert(colourString, presetColor);
-            colour = colorCat.value();
+        const std::string &colourString = cols[colourCol + 1];
+        auto [colourIt, inserted] = colourCategories.try_emplace(colourString);
+        if (inserted) {
+            QColor colour(QString::fromStdString(colourString));
+            if (!colour.isValid())
+                colour = presetColours[colourCategoryCount++ % presetColours.size()];
+            colourIt->second = colour;
         }
 
         for (auto *node: nodes)
-            setCustomColour(node, colour);
+            res.colours.emplace_back(node, colourIt->second);
     }
 
+    res.data.finalize();
+
     if (unmatchedNodes)
-        *errormsg = "There were " + QString::number(unmatchedNodes) + " unmatched entries in the CSV.";
+        res.errormsg = "There were " + QString::number(unmatchedNodes) + " unmatched entries in the CSV.";
+
+    res.ok = true;
+    return res;
+}
+
+bool AssemblyGraph::applyCSV(CsvLoadResult csv, QStringList *columns, QString *errormsg, bool *coloursLoaded) {
+    clearAllCsvData();
+
+    *errormsg = csv.errormsg;
+    if (!csv.ok)
+        return false;
+
+    *coloursLoaded = csv.coloursLoaded;
+    *columns = m_csvHeaders = csv.headers;
+    m_nodeCSVData = std::move(csv.data);
+    for (const auto &[node, colour] : csv.colours)
+        setCustomColour(node, colour);
 
     return true;
 }
@@ -615,13 +654,16 @@ bool AssemblyGraph::loadGraphFromFile(const QString& filename) {
 //is not WHOLE_GRAPH.
 void AssemblyGraph::markNodesToDraw(const std::vector<DeBruijnNode *>& startingNodes, int nodeDistance)
 {
+    // Only the previously drawn nodes and edges need to be cleared
+    clearDrawnScope();
+
     if (g_settings->graphScope == WHOLE_GRAPH)
     {
         for (auto &entry : m_deBruijnGraphNodes) {
             //If double mode is off, only positive nodes are drawn.  If it's
             //on, all nodes are drawn.
             if (entry->isPositiveNode() || g_settings->doubleMode)
-                entry->setAsDrawn();
+                addDrawnNode(entry);
         }
     }
     else //The scope is either around specified nodes, around nodes with BLAST hits or a depth range.
@@ -631,21 +673,169 @@ void AssemblyGraph::markNodesToDraw(const std::vector<DeBruijnNode *>& startingN
         if (g_settings->graphScope == DEPTH_RANGE)
             nodeDistance = 0;
 
+        // Breadth-first search from all starting nodes at once, one level per
+        // step, so every node is expanded once at its smallest distance.
+        uint32_t epoch = nextVisitEpoch();
+        std::vector<DeBruijnNode *> frontier, next;
         for (auto *node : startingNodes)
         {
             //If we are in single mode, make sure that each node is positive.
             if (!g_settings->doubleMode && node->isNegativeNode())
                 node = node->getReverseComplement();
 
-            node->setAsDrawn();
+            addDrawnNode(node);
             node->setAsSpecial();
-            node->labelNeighbouringNodesAsDrawn(nodeDistance, nullptr);
+            if (node->markVisited(epoch))
+                frontier.push_back(node);
+        }
+
+        for (int distance = 0; distance < nodeDistance && !frontier.empty(); ++distance)
+        {
+            for (auto *node : frontier)
+            {
+                for (auto *edge : node->edges())
+                {
+                    DeBruijnNode * otherNode = edge->getOtherNode(node);
+
+                    //In single mode the positive node is drawn, but the
+                    //search carries on along the strand it arrived on.
+                    if (g_settings->doubleMode || otherNode->isPositiveNode())
+                        addDrawnNode(otherNode);
+                    else
+                        addDrawnNode(otherNode->getReverseComplement());
+
+                    if (otherNode->markVisited(epoch))
+                        next.push_back(otherNode);
+                }
+            }
+            frontier.swap(next);
+            next.clear();
+        }
+    }
+
+    // Then determine the drawn status of the edges around the drawn nodes
+    determineDrawnEdges();
+}
+
+
+void AssemblyGraph::setDrawnNodes(const std::vector<DeBruijnNode *> &nodes)
+{
+    clearDrawnScope();
+    for (auto *node : nodes)
+        addDrawnNode(node);
+    determineDrawnEdges();
+}
+
+
+void AssemblyGraph::addDrawnNodes(const std::vector<DeBruijnNode *> &nodes)
+{
+    refreshDrawnScope();
+    size_t firstNew = m_drawnNodes.size();
+    for (auto *node : nodes)
+        addDrawnNode(node);
+    determineDrawnEdges(firstNew);
+}
+
+
+const std::vector<DeBruijnNode *> &AssemblyGraph::getDrawnNodes()
+{
+    refreshDrawnScope();
+    return m_drawnNodes;
+}
+
+
+const std::vector<DeBruijnEdge *> &AssemblyGraph::getDrawnEdges()
+{
+    refreshDrawnScope();
+    return m_drawnEdges;
+}
+
+
+void AssemblyGraph::clearDrawnScope()
+{
+    refreshDrawnScope();
+
+    for (auto *node : m_drawnNodes)
+    {
+        node->setAsNotDrawn();
+        node->setAsNotSpecial();
+    }
+    for (auto *edge : m_drawnEdges)
+        edge->setAsNotDrawn();
+
+    m_drawnNodes.clear();
+    m_drawnEdges.clear();
+}
+
+
+void AssemblyGraph::addDrawnNode(DeBruijnNode *node)
+{
+    if (node->isDrawn())
+        return;
+
+    node->setAsDrawn();
+    m_drawnNodes.push_back(node);
+}
+
+
+//Every drawn edge touches a drawn node: in double mode both of its ends are
+//drawn, in single mode each end or its reverse complement is. Only the edges
+//of the drawn nodes from firstNode on are checked.
+void AssemblyGraph::determineDrawnEdges(size_t firstNode)
+{
+    auto checkEdges = [this](const DeBruijnNode *node) {
+        for (auto *edge : node->edges())
+        {
+            if (!edge->isDrawn() && edge->determineIfDrawn())
+                m_drawnEdges.push_back(edge);
         }
+    };
+
+    for (size_t i = firstNode; i < m_drawnNodes.size(); ++i)
+    {
+        DeBruijnNode *node = m_drawnNodes[i];
+        checkEdges(node);
+        if (!g_settings->doubleMode)
+            checkEdges(node->getReverseComplement());
     }
+}
+
+
+//After nodes or edges were deleted or merged the lists may point at freed
+//objects, so they are rebuilt from the drawn flags.
+void AssemblyGraph::refreshDrawnScope()
+{
+    if (!m_drawnScopeStale)
+        return;
 
-    // Then loop through each edge determining its drawn status
+    m_drawnNodes.clear();
+    for (auto *node : m_deBruijnGraphNodes)
+    {
+        if (node->isDrawn())
+            m_drawnNodes.push_back(node);
+    }
+
+    m_drawnEdges.clear();
     for (auto &entry : m_deBruijnGraphEdges)
-        entry.second->determineIfDrawn();
+    {
+        if (entry.second->isDrawn())
+            m_drawnEdges.push_back(entry.second);
+    }
+
+    m_drawnScopeStale = false;
+}
+
+
+uint32_t AssemblyGraph::nextVisitEpoch()
+{
+    //On wraparound old stamps could look current, so clear them all
+    if (++m_visitEpoch == 0)
+    {
+        for (auto *node : m_deBruijnGraphNodes)
+            node->clearVisited();
+        m_visitEpoch = 1;
+    }
+    return m_visitEpoch;
 }
 
 // FIXME: this does not belong here
@@ -656,25 +846,14 @@ static std::vector<DeBruijnNode *> getNodesFromBlastHits(const QString& queryNam
     if (g_blastSearch->m_blastQueries.m_queries.empty())
         return returnVector;
 
-    std::vector<BlastQuery *> queries;
-
     //If "all" is selected, then we'll display nodes with hits from any query
     if (queryName == "all")
-        queries = g_blastSearch->m_blastQueries.m_queries;
+        return g_blastSearch->getNodesWithHits();
 
-        //If only one query is selected, then we just display nodes with hits from that query
-    else
-        queries.push_back(g_blastSearch->m_blastQueries.getQueryFromName(queryName));
-
-    //Add pointers to nodes that have a hit for the selected target(s).
-    for (auto currentQuery : queries)
-    {
-        for (auto & m_allHit : g_blastSearch->m_allHits)
-        {
-            if (m_allHit->m_query == currentQuery)
-                returnVector.push_back(m_allHit->m_node);
-        }
-    }
+    //If only one query is selected, then we just display nodes with hits from that query
+    BlastQuery * query = g_blastSearch->m_blastQueries.getQueryFromName(queryName);
+    if (query != nullptr)
+        returnVector = query->getNodesWithHits();
 
     return returnVector;
 }
@@ -744,7 +923,7 @@ std::vector<DeBruijnNode *> AssemblyGraph::getStartingNodes(QString * errorTitle
 
     else if (g_settings->graphScope == AROUND_PATHS)
     {
-        if (m_deBruijnGraphPaths.count(pathName.toStdString()) == 0)
+        if (!m_deBruijnGraphPaths.contains(pathName.toStdString()))
         {
             *errorTitle = "Invalid path";
             *errorMessage = "No path with such name is loaded";
@@ -762,9 +941,8 @@ std::vector<DeBruijnNode *> AssemblyGraph::getStartingNodes(QString * errorTitle
         startingNodes = getNodesInDepthRange(g_settings->minDepthRange,
                                                  g_settings->maxDepthRange);
     else if (g_settings->graphScope == AROUND_PATHS) {
-        QList<DeBruijnNode *> nodes = m_deBruijnGraphPaths.at(pathName.toStdString())->getNodes();
-
-        for (auto & node : nodes)
+        auto pathId = m_deBruijnGraphPaths.find(pathName.toStdString());
+        for (auto *node : m_deBruijnGraphPaths.steps(pathId))
             startingNodes.push_back(node);
     }
 
@@ -875,10 +1053,25 @@ std::vector<DeBruijnNode *> AssemblyGraph::getNodesFromListExact(const QStringLi
     return returnVector;
 }
 
+void AssemblyGraph::buildNodeNameIndexInBackground()
+{
+    m_nodeNameIndex.buildInBackground(m_deBruijnGraphNodes);
+}
+
+const NodeNameIndex &AssemblyGraph::getNodeNameIndex() const
+{
+    if (!m_nodeNameIndex.isBuilt() || m_nodeNameIndex.size() != m_deBruijnGraphNodes.size())
+        m_nodeNameIndex.build(m_deBruijnGraphNodes);
+    return m_nodeNameIndex;
+}
+
+//Partial matching finds all nodes whose names contain the query.  A query
+//enclosed in slashes, like /^NODE_1[0-9]_/, is a regular expression instead.
 std::vector<DeBruijnNode *> AssemblyGraph::getNodesFromListPartial(const QStringList& nodesList,
                                                                    std::vector<QString> * nodesNotInGraph) const
 {
     std::vector<DeBruijnNode *> returnVector;
+    const NodeNameIndex &index = getNodeNameIndex();
 
     for (const auto & i : nodesList)
     {
@@ -886,31 +1079,41 @@ std::vector<DeBruijnNode *> AssemblyGraph::getNodesFromListPartial(const QString
         if (queryName == "")
             continue;
 
-        bool found = false;
-        for (auto &entry : m_deBruijnGraphNodes) {
-            QString nodeName = entry->getName();
-
-            if (nodeName.contains(queryName))
-            {
-                found = true;
-                returnVector.push_back(entry);
-            }
-        }
+        std::vector<DeBruijnNode *> matches;
+        if (queryName.length() > 2 && queryName.startsWith('/') && queryName.endsWith('/'))
+            matches = index.findMatching(QRegularExpression(queryName.mid(1, queryName.length() - 2)));
+        else
+            matches = index.findSubstring(queryName.toStdString());
 
-        if (!found && nodesNotInGraph != nullptr)
+        if (matches.empty() && nodesNotInGraph != nullptr)
             nodesNotInGraph->push_back(queryName.trimmed());
+        returnVector.insert(returnVector.end(), matches.begin(), matches.end());
     }
 
     return returnVector;
 }
 
+const NodeRangeIndex &AssemblyGraph::getNodeRangeIndex() const
+{
+    if (!m_nodeRangeIndex.isBuilt() || 2 * m_nodeRangeIndex.size() != m_deBruijnGraphNodes.size())
+        m_nodeRangeIndex.build(m_deBruijnGraphNodes);
+    return m_nodeRangeIndex;
+}
+
+//The nodes in the range are found with a binary search over the nodes sorted
+//by depth.  Both strands of a node share its depth, so the reverse complement
+//of every positive node found is in the range too.
 std::vector<DeBruijnNode *> AssemblyGraph::getNodesInDepthRange(double min, double max) const
 {
-    std::vector<DeBruijnNode *> returnVector;
+    const NodeRangeIndex &index = getNodeRangeIndex();
+    auto [first, last] = index.depthRange(min, max);
 
-    for (auto *node : m_deBruijnGraphNodes) {
-        if (node->isInDepthRange(min, max))
-            returnVector.push_back(node);
+    std::vector<DeBruijnNode *> returnVector;
+    returnVector.reserve(2 * (last - first));
+    for (size_t i = first; i < last; ++i) {
+        DeBruijnNode *node = index.byDepth()[i];
+        returnVector.push_back(node);
+        returnVector.push_back(node->getReverseComplement());
     }
     return returnVector;
 }
@@ -924,16 +1127,75 @@ void AssemblyGraph::setAllEdgesExactOverlap(int overlap)
 
 
 
+//This function determines the overlap of each edge, trying each overlap
+//size between the min and the max (in settings).  Every size is tested for
+//every edge, which is cheap as the sequences are compared a packed word at
+//a time, and the edges are handled in parallel.  An edge and its reverse
+//complement always get the same overlap, so only one of them is tested.
 void AssemblyGraph::autoDetermineAllEdgesExactOverlap()
 {
     int edgeCount = int(m_deBruijnGraphEdges.size());
     if (edgeCount == 0)
         return;
 
-    //Determine the overlap for each edge.
+    std::vector<DeBruijnEdge *> edges;
+    edges.reserve(m_deBruijnGraphEdges.size() / 2 + 1);
     for (auto &entry : m_deBruijnGraphEdges) {
-        entry.second->autoDetermineExactOverlap();
-    }
+        DeBruijnEdge * edge = entry.second;
+        DeBruijnEdge * rcEdge = edge->getReverseComplement();
+        if (rcEdge == nullptr || edge <= rcEdge)
+            edges.push_back(edge);
+    }
+
+    //For each edge, a bit for each overlap size in the range that works.
+    const int minOverlap = g_settings->minAutoFindEdgeOverlap;
+    const int maxOverlap = std::max(minOverlap, g_settings->maxAutoFindEdgeOverlap);
+    const size_t wordsPerEdge = size_t(maxOverlap - minOverlap) / 64 + 1;
+    std::vector<uint64_t> workingOverlaps(edges.size() * wordsPerEdge, 0);
+    auto edgeMaxOverlap = [&](const DeBruijnEdge * edge) {
+        return std::min({edge->getStartingNode()->getLength(), edge->getEndingNode()->getLength(), maxOverlap});
+    };
+    auto overlapWorks = [&](size_t i, int overlap) {
+        size_t bit = size_t(overlap - minOverlap);
+        return (workingOverlaps[i * wordsPerEdge + bit / 64] >> (bit % 64)) & 1;
+    };
+
+    //The edges are processed in chunks, each in one go.
+    struct Chunk {
+        size_t begin, end;
+    };
+    const size_t chunkSize = 1024;
+    std::vector<Chunk> chunks;
+    for (size_t begin = 0; begin < edges.size(); begin += chunkSize)
+        chunks.push_back({begin, std::min(begin + chunkSize, edges.size())});
+
+    //Use the largest overlap that works for each edge: a long exact match
+    //is the least likely to be there by chance.
+    QtConcurrent::blockingMap(chunks, [&](const Chunk &chunk) {
+        for (size_t i = chunk.begin; i < chunk.end; ++i) {
+            DeBruijnEdge * edge = edges[i];
+            int bestOverlap = 0;
+            for (int overlap = minOverlap; overlap <= edgeMaxOverlap(edge); ++overlap) {
+                if (edge->testExactOverlap(overlap)) {
+                    size_t bit = size_t(overlap - minOverlap);
+                    workingOverlaps[i * wordsPerEdge + bit / 64] |= uint64_t(1) << (bit % 64);
+                    bestOverlap = overlap;
+                }
+            }
+            edge->setOverlap(bestOverlap);
+            edge->setOverlapType(AUTO_DETERMINED_EXACT_OVERLAP);
+        }
+    });
+    auto copyToReverseComplements = [&]() {
+        for (DeBruijnEdge * edge : edges) {
+            DeBruijnEdge * rcEdge = edge->getReverseComplement();
+            if (rcEdge != nullptr && rcEdge != edge) {
+                rcEdge->setOverlap(edge->getOverlap());
+                rcEdge->setOverlapType(edge->getOverlapType());
+            }
+        }
+    };
+    copyToReverseComplements();
 
     //The expectation here is that most overlaps will be
     //the same or from a small subset of possible sizes.
@@ -946,7 +1208,7 @@ void AssemblyGraph::autoDetermineAllEdgesExactOverlap()
     //Sort the overlaps in order of decreasing numbers of edges.
     //I.e. the first overlap size in the vector will be the most
     //common overlap, the second will be the second most common,
-    //etc.
+    //etc.  Ties go to the smaller overlap.
     std::vector<int> sortedOverlaps;
     int overlapsSoFar = 0;
     double fractionOverlapsFound = 0.0;
@@ -973,20 +1235,27 @@ void AssemblyGraph::autoDetermineAllEdgesExactOverlap()
     }
 
     //For each edge, see if one of the more common overlaps also works.
-    //If so, use that instead.
-    for (auto &entry : m_deBruijnGraphEdges) {
-        DeBruijnEdge * edge = entry.second;
-        for (int sortedOverlap : sortedOverlaps)
-        {
-            if (edge->getOverlap() == sortedOverlap)
-                break;
-            else if (edge->testExactOverlap(sortedOverlap))
+    //If so, use that instead.  Overlaps in the searched range were all
+    //tested above, others are tested now.
+    QtConcurrent::blockingMap(chunks, [&](const Chunk &chunk) {
+        for (size_t i = chunk.begin; i < chunk.end; ++i) {
+            DeBruijnEdge * edge = edges[i];
+            for (int sortedOverlap : sortedOverlaps)
             {
-                edge->setOverlap(sortedOverlap);
-                break;
+                if (edge->getOverlap() == sortedOverlap)
+                    break;
+
+                bool works = sortedOverlap >= minOverlap && sortedOverlap <= edgeMaxOverlap(edge) ?
+                             overlapWorks(i, sortedOverlap) : edge->testExactOverlap(sortedOverlap);
+                if (works)
+                {
+                    edge->setOverlap(sortedOverlap);
+                    break;
+                }
             }
         }
-    }
+    });
+    copyToReverseComplements();
 }
 
 
@@ -1053,6 +1322,9 @@ void AssemblyGraph::recalculateAllNodeWidths()
 
 int AssemblyGraph::getDrawnNodeCount() const
 {
+    if (!m_drawnScopeStale)
+        return int(m_drawnNodes.size());
+
     int nodeCount = 0;
     for (auto *node : m_deBruijnGraphNodes)
         nodeCount += node->isDrawn();
@@ -1063,54 +1335,114 @@ int AssemblyGraph::getDrawnNodeCount() const
 
 void AssemblyGraph::deleteNodes(const std::vector<DeBruijnNode *> &nodes)
 {
-    //Build a list of nodes to delete.
-    QSet<DeBruijnNode *> nodesToDelete;
-    for (auto *node : nodes) {
-        nodesToDelete.insert(node);
-        nodesToDelete.insert(node->getReverseComplement());
-    }
-
-    //Build a list of edges to delete.
-    std::vector<DeBruijnEdge *> edgesToDelete;
-    for (auto *node : nodesToDelete) {
-        for (auto *edge : node->edges()) {
-            bool alreadyAdded = std::find(edgesToDelete.begin(), edgesToDelete.end(), edge) != edgesToDelete.end();
-            if (!alreadyAdded)
-                edgesToDelete.push_back(edge);
-        }
-    }
-
-    // Remove the edges from the graph,
-    deleteEdges(edgesToDelete);
-
-    // Remove the nodes from the graph.
-    for (auto *node : nodesToDelete)
-        m_deBruijnGraphNodes.erase(node->getName().toStdString());
-
-    for (auto *node : nodesToDelete)
-        delete node;
+    deleteNodesAndEdges(nodes, {});
 }
 
 void AssemblyGraph::deleteEdges(const std::vector<DeBruijnEdge *> &edges)
 {
-    //Build a list of edges to delete.
-    QSet<DeBruijnEdge *> edgesToDelete;
+    deleteNodesAndEdges({}, edges);
+}
+
+//Deletes the nodes and edges, along with their reverse complements and the
+//edges of the deleted nodes.  Everything is first marked for deletion, so
+//that the edge lists of the remaining nodes are compacted once each and the
+//graphics items are removed from the scene in one go.
+void AssemblyGraph::deleteNodesAndEdges(const std::vector<DeBruijnNode *> &nodes,
+                                        const std::vector<DeBruijnEdge *> &edges,
+                                        MyGraphicsScene * scene)
+{
+    //Mark: collect every node and edge exactly once.
+    std::vector<DeBruijnNode *> nodesToDelete;
+    std::vector<DeBruijnEdge *> edgesToDelete;
+    auto markNode = [&](DeBruijnNode * node) {
+        if (!node->isMarkedForDeletion()) {
+            node->markForDeletion();
+            nodesToDelete.push_back(node);
+        }
+    };
+    auto markEdge = [&](DeBruijnEdge * edge) {
+        if (!edge->isMarkedForDeletion()) {
+            edge->markForDeletion();
+            edgesToDelete.push_back(edge);
+        }
+    };
+
+    for (auto *node : nodes) {
+        markNode(node);
+        markNode(node->getReverseComplement());
+    }
+    for (auto *node : nodesToDelete) {
+        for (auto *edge : node->edges())
+            markEdge(edge);
+    }
     for (auto *edge : edges) {
-        edgesToDelete.insert(edge);
-        edgesToDelete.insert(edge->getReverseComplement());
+        markEdge(edge);
+        markEdge(edge->getReverseComplement());
     }
 
-    //Remove the edges from the graph,
-    for (auto edge : edgesToDelete) {
-        DeBruijnNode * startingNode = edge->getStartingNode();
-        DeBruijnNode * endingNode = edge->getEndingNode();
+    if (nodesToDelete.empty() && edgesToDelete.empty())
+        return;
 
-        m_deBruijnGraphEdges.erase(QPair<DeBruijnNode*, DeBruijnNode*>(startingNode, endingNode));
-        startingNode->removeEdge(edge);
-        endingNode->removeEdge(edge);
+    if (scene != nullptr) {
+        std::unordered_set<GraphicsItemNode *> graphicsItemNodes;
+        std::unordered_set<GraphicsItemEdge *> graphicsItemEdges;
+        for (auto *node : nodesToDelete) {
+            if (auto *graphicsItemNode = node->getGraphicsItemNode())
+                graphicsItemNodes.insert(graphicsItemNode);
+            node->setGraphicsItemNode(nullptr);
+        }
+        for (auto *edge : edgesToDelete) {
+            if (auto *graphicsItemEdge = edge->getGraphicsItemEdge())
+                graphicsItemEdges.insert(graphicsItemEdge);
+            edge->setGraphicsItemEdge(nullptr);
+        }
+        scene->removeGraphicsItems(graphicsItemNodes, graphicsItemEdges);
+    }
 
-        delete edge;
+    //Sweep the edges: every remaining node that loses an edge compacts its
+    //edge list once.
+    uint32_t epoch = nextVisitEpoch();
+    for (auto *edge : edgesToDelete) {
+        for (auto *node : {edge->getStartingNode(), edge->getEndingNode()}) {
+            if (!node->isMarkedForDeletion() && node->markVisited(epoch))
+                node->removeMarkedEdges();
+        }
+        m_deBruijnGraphEdges.erase(DeBruijnLink(edge->getStartingNode(), edge->getEndingNode()));
+        m_edgeColors.erase(edge);
+        m_edgeStyles.erase(edge);
+        m_edgeTags.erase(edge);
+    }
+
+    //Sweep the nodes.  When many nodes go, one pass over the name trie is
+    //cheaper than looking up each name.
+    if (!nodesToDelete.empty()) {
+        m_nodeNameIndex.clear();
+        m_nodeRangeIndex.clear();
+        if (nodesToDelete.size() * 8 > m_deBruijnGraphNodes.size()) {
+            for (auto it = m_deBruijnGraphNodes.begin(); it != m_deBruijnGraphNodes.end(); ) {
+                if (it.value()->isMarkedForDeletion())
+                    it = m_deBruijnGraphNodes.erase(it);
+                else
+                    ++it;
+            }
+        } else {
+            for (auto *node : nodesToDelete)
+                m_deBruijnGraphNodes.erase(node->getName().toStdString());
+        }
+        for (auto *node : nodesToDelete) {
+            m_nodeColors.erase(node);
+            m_nodeLabels.erase(node);
+            m_nodeTags.erase(node);
+            m_nodeCSVData.removeNode(node);
+        }
     }
+
+    for (auto *edge : edgesToDelete)
+        delete edge;
+    for (auto *node : nodesToDelete)
+        delete node;
+
+    m_drawnScopeStale = true;
 }
 
 //This function assumes it is receiving a positive node.  It will duplicate both
@@ -1141,6 +1473,8 @@ void AssemblyGraph::duplicateNodePair(DeBruijnNode * node, MyGraphicsScene * sce
     setCsvData(newPosNode, getAllCsvData(originalPosNode));
     setCsvData(newNegNode, getAllCsvData(originalNegNode));
 
+    m_nodeNameIndex.clear();
+    m_nodeRangeIndex.clear();
     m_deBruijnGraphNodes.emplace(newPosNodeName.toStdString(), newPosNode);
     m_deBruijnGraphNodes.emplace(newNegNodeName.toStdString(), newNegNode);
 
@@ -1322,6 +1656,8 @@ bool AssemblyGraph::mergeNodes(QList<DeBruijnNode *> nodes, MyGraphicsScene * sc
     newPosNode->setReverseComplement(newNegNode);
     newNegNode->setReverseComplement(newPosNode);
 
+    m_nodeNameIndex.clear();
+    m_nodeRangeIndex.clear();
     m_deBruijnGraphNodes.emplace(newPosNodeName.toStdString(), newPosNode);
     m_deBruijnGraphNodes.emplace(newNegNodeName.toStdString(), newNegNode);
 
@@ -1420,7 +1756,14 @@ static bool mergeGraphicsNodes2(QList<DeBruijnNode *> * originalNodes,
 
         scene->addItem(newGraphicsItemNode);
 
+        //An edge to a node without a graphics item yet gets its own when
+        //that node is merged.
         for (auto *newEdge : newNode->edges()) {
+            DeBruijnNode * otherNode = newEdge->getOtherNode(newNode);
+            if (newEdge->getGraphicsItemEdge() != nullptr ||
+                (!otherNode->hasGraphicsItem() && !otherNode->getReverseComplement()->hasGraphicsItem()))
+                continue;
+
             auto * graphicsItemEdge = new GraphicsItemEdge(newEdge);
             graphicsItemEdge->setZValue(-1.0);
             newEdge->setGraphicsItemEdge(graphicsItemEdge);
@@ -1458,206 +1801,286 @@ static void mergeGraphicsNodes(QList<DeBruijnNode *> * originalNodes,
 //line.  It returns the number of merges that it did.
 //It gets a pointer to the progress dialog as well so it can check to see if the
 //user has cancelled the merge.
+//The chains are found in one pass and their merged nodes are built in
+//parallel.  The graph is then changed in one go: all new nodes, then all new
+//edges, then the old nodes are deleted together.
 int AssemblyGraph::mergeAllPossible(MyGraphicsScene * scene,
                                     MyProgressDialog * progressDialog)
 {
-    //Create a set of all nodes.
-    QSet<DeBruijnNode *> uncheckedNodes;
-    for (auto &entry : m_deBruijnGraphNodes) {
-        uncheckedNodes.insert(entry);
-    }
-
-    //Create a list of all merges to be done.
-    QList< QList<DeBruijnNode *> > allMerges;
-    for (auto &entry : m_deBruijnGraphNodes) {
-        DeBruijnNode * node = entry;
+    std::vector<Unitig> unitigs = Unitig::find(*this);
+    emit setMergeTotalCount(int(unitigs.size()));
+    QApplication::processEvents();
+    Unitig::buildMergedNodes(unitigs);
+
+    //Where edges of the old nodes now attach: edges entering the first node
+    //or leaving the last node of a chain go to the merged node (and likewise
+    //for the reverse complement strand).
+    phmap::flat_hash_map<DeBruijnNode *, DeBruijnNode *> edgeTargets, edgeSources;
+    std::vector<DeBruijnNode *> mergedNodes, nodesToDelete;
+    mergedNodes.reserve(unitigs.size());
+    m_nodeNameIndex.clear();
+    m_nodeRangeIndex.clear();
+
+    size_t merges = 0;
+    for (; merges < unitigs.size(); ++merges)
+    {
+        if (progressDialog != nullptr && progressDialog->wasCancelled())
+            break;
 
-        //If the current node isn't checked, then we will find the longest
-        //possible mergable sequence containing this node.
-        if (uncheckedNodes.contains(node))
+        const Unitig &unitig = unitigs[merges];
+        QString newNodeBaseName;
+        for (size_t i = 0; i < unitig.nodes.size(); ++i)
         {
-            QList<DeBruijnNode *> nodesToMerge;
-            nodesToMerge.push_back(node);
-
-            uncheckedNodes.remove(node);
-            uncheckedNodes.remove(node->getReverseComplement());
-
-            //Extend forward as much as possible.
-            bool extended;
-            do
-            {
-                extended = false;
-                DeBruijnNode * last = nodesToMerge.back();
-                std::vector<DeBruijnEdge *> outgoingEdges = last->getLeavingEdges();
-                if (outgoingEdges.size() == 1)
-                {
-                    DeBruijnEdge * potentialEdge = outgoingEdges[0];
-                    DeBruijnNode * potentialNode = potentialEdge->getEndingNode();
-                    std::vector<DeBruijnEdge *> edgesEnteringPotentialNode = potentialNode->getEnteringEdges();
-                    if (edgesEnteringPotentialNode.size() == 1 &&
-                            edgesEnteringPotentialNode[0] == potentialEdge &&
-                            !nodesToMerge.contains(potentialNode) &&
-                            uncheckedNodes.contains(potentialNode))
-                    {
-                        nodesToMerge.push_back(potentialNode);
-                        uncheckedNodes.remove(potentialNode);
-                        uncheckedNodes.remove(potentialNode->getReverseComplement());
-                        extended = true;
-                    }
-                }
-            } while (extended);
+            newNodeBaseName += unitig.nodes[i]->getNameWithoutSign();
+            if (i < unitig.nodes.size() - 1)
+                newNodeBaseName += "_";
+        }
+        newNodeBaseName = getUniqueNodeName(newNodeBaseName);
+        QString newPosNodeName = newNodeBaseName + "+";
+        QString newNegNodeName = newNodeBaseName + "-";
+
+        auto newPosNode = new DeBruijnNode(newPosNodeName, unitig.depth, unitig.sequence);
+        auto newNegNode = new DeBruijnNode(newNegNodeName, unitig.depth, unitig.sequence.GetReverseComplement());
+        newPosNode->setReverseComplement(newNegNode);
+        newNegNode->setReverseComplement(newPosNode);
+        newPosNode->setDepthRelativeToMeanDrawnDepth(1.0);
+        newNegNode->setDepthRelativeToMeanDrawnDepth(1.0);
+        m_deBruijnGraphNodes.emplace(newPosNodeName.toStdString(), newPosNode);
+        m_deBruijnGraphNodes.emplace(newNegNodeName.toStdString(), newNegNode);
+        mergedNodes.push_back(newPosNode);
 
-            //Extend backward as much as possible.
-            do
-            {
-                extended = false;
-                DeBruijnNode * first = nodesToMerge.front();
-                std::vector<DeBruijnEdge *> incomingEdges = first->getEnteringEdges();
-                if (incomingEdges.size() == 1)
-                {
-                    DeBruijnEdge * potentialEdge = incomingEdges[0];
-                    DeBruijnNode * potentialNode = potentialEdge->getStartingNode();
-                    std::vector<DeBruijnEdge *> edgesLeavingPotentialNode = potentialNode->getLeavingEdges();
-                    if (edgesLeavingPotentialNode.size() == 1 &&
-                            edgesLeavingPotentialNode[0] == potentialEdge &&
-                            !nodesToMerge.contains(potentialNode) &&
-                            uncheckedNodes.contains(potentialNode))
-                    {
-                        nodesToMerge.push_front(potentialNode);
-                        uncheckedNodes.remove(potentialNode);
-                        uncheckedNodes.remove(potentialNode->getReverseComplement());
-                        extended = true;
-                    }
-                }
-            } while (extended);
+        edgeTargets[unitig.nodes.front()] = newPosNode;
+        edgeTargets[unitig.nodes.back()->getReverseComplement()] = newNegNode;
+        edgeSources[unitig.nodes.back()] = newPosNode;
+        edgeSources[unitig.nodes.front()->getReverseComplement()] = newNegNode;
+        nodesToDelete.insert(nodesToDelete.end(), unitig.nodes.begin(), unitig.nodes.end());
 
-            if (nodesToMerge.size() > 1)
-                allMerges.push_back(nodesToMerge);
+        if ((merges + 1) % 1024 == 0)
+        {
+            emit setMergeCompletedCount(int(merges + 1));
+            QApplication::processEvents();
         }
     }
 
-    //Now do the actual merges.
-    QApplication::processEvents();
-    emit setMergeTotalCount(allMerges.size());
-    for (int i = 0; i < allMerges.size(); ++i)
+    //Edges into or out of the middle of a chain can only come from the chain
+    //itself, so they are not carried over.
+    phmap::flat_hash_set<DeBruijnNode *> deleted(nodesToDelete.begin(), nodesToDelete.end());
+    auto mapNode = [&deleted](const phmap::flat_hash_map<DeBruijnNode *, DeBruijnNode *> &map,
+                              DeBruijnNode * node) -> DeBruijnNode * {
+        auto it = map.find(node);
+        if (it != map.end())
+            return it->second;
+        if (deleted.contains(node) || deleted.contains(node->getReverseComplement()))
+            return nullptr;
+        return node;
+    };
+    for (size_t i = 0; i < merges; ++i)
     {
-        if (progressDialog != nullptr && progressDialog->wasCancelled())
-            break;
+        const Unitig &unitig = unitigs[i];
+        DeBruijnNode * newPosNode = mergedNodes[i];
+        for (auto *edge : unitig.nodes.back()->getLeavingEdges())
+        {
+            if (DeBruijnNode * target = mapNode(edgeTargets, edge->getEndingNode()))
+                createDeBruijnEdge(newPosNode->getName(), target->getName(), edge->getOverlap(), edge->getOverlapType());
+        }
+        for (auto *edge : unitig.nodes.front()->getEnteringEdges())
+        {
+            if (DeBruijnNode * source = mapNode(edgeSources, edge->getStartingNode()))
+                createDeBruijnEdge(source->getName(), newPosNode->getName(), edge->getOverlap(), edge->getOverlapType());
+        }
+    }
 
-        mergeNodes(allMerges[i], scene, false);
-        emit setMergeCompletedCount(i+1);
-        QApplication::processEvents();
+    if (scene != nullptr)
+    {
+        for (size_t i = 0; i < merges; ++i)
+        {
+            QList<DeBruijnNode *> orderedList(unitigs[i].nodes.begin(), unitigs[i].nodes.end());
+            QList<DeBruijnNode *> revCompOrderedList;
+            for (auto *node : orderedList)
+                revCompOrderedList.push_front(node->getReverseComplement());
+            mergeGraphicsNodes(&orderedList, &revCompOrderedList, mergedNodes[i], scene);
+        }
     }
 
+    deleteNodes(nodesToDelete);
+    emit setMergeCompletedCount(int(merges));
+
     recalculateAllDepthsRelativeToDrawnMean();
     recalculateAllNodeWidths();
 
-    return allMerges.size();
+    return int(merges);
 }
 
-void AssemblyGraph::saveEntireGraphToFasta(const QString& filename)
+bool AssemblyGraph::saveEntireGraphToFasta(const QString& filename)
 {
-    QFile file(filename);
-    file.open(QIODevice::WriteOnly | QIODevice::Text);
-    QTextStream out(&file);
+    std::vector<DeBruijnNode *> nodes;
+    nodes.reserve(m_deBruijnGraphNodes.size());
+    for (auto *node : m_deBruijnGraphNodes)
+        nodes.push_back(node);
+    return saveNodesToFasta(filename, nodes, true);
+}
 
+bool AssemblyGraph::saveEntireGraphToFastaOnlyPositiveNodes(const QString& filename)
+{
+    std::vector<DeBruijnNode *> nodes;
     for (auto &entry : m_deBruijnGraphNodes) {
-        out <<entry->getFasta(true);
+        DeBruijnNode * node = entry;
+        if (node->isPositiveNode())
+            nodes.push_back(node);
     }
+    return saveNodesToFasta(filename, nodes, false);
 }
 
-void AssemblyGraph::saveEntireGraphToFastaOnlyPositiveNodes(const QString& filename)
+bool AssemblyGraph::saveNodesToFasta(const QString &filename, const std::vector<DeBruijnNode *> &nodes,
+                                     bool sign, size_t lineWidth, const std::function<bool()> &cancelled)
 {
+    bool compress = filename.endsWith(".gz");
     QFile file(filename);
-    file.open(QIODevice::WriteOnly | QIODevice::Text);
-    QTextStream out(&file);
+    if (!file.open(compress ? QIODevice::WriteOnly : QIODevice::WriteOnly | QIODevice::Text))
+        return false;
 
-    for (auto &entry : m_deBruijnGraphNodes) {
-        DeBruijnNode * node = entry;
-        if (node->isPositiveNode())
-            out << node->getFasta(false);
-    }
+    bool written = utils::writeRecordsInParallel(&file, nodes.size(), [&](utils::BufferedWriter &out, size_t i) {
+        nodes[i]->writeFasta(out, sign, lineWidth);
+    }, compress, cancelled);
+
+    //Write errors may only show up once the last buffered data is written
+    return written && file.flush() && file.error() == QFileDevice::NoError;
 }
 
-QString AssemblyGraph::getGfaSegmentLine(const DeBruijnNode *node, const QString& depthTag) const {
-    QByteArray gfaSequence = node->getSequenceForGfa();
+void AssemblyGraph::writeGfaSegmentLine(utils::BufferedWriter &out, const DeBruijnNode *node, const QString& depthTag) const {
+    QString name = node->getName();
+    out << "S\t" << QStringView(name).left(name.length() - 1) << '\t';
 
-    QByteArray gfaSegmentLine = "S";
-    gfaSegmentLine += "\t" + node->getNameWithoutSign().toLatin1();
-    gfaSegmentLine += "\t" + gfaSequence;
-    gfaSegmentLine += "\tLN:i:" + QString::number(gfaSequence.length()).toLatin1();
+    //Sequences that need no changes for GFA are decoded straight into the
+    //output.
+    qsizetype gfaSequenceLength;
+    if (node->sequenceIsMissing() || m_graphFileType == LAST_GRAPH) {
+        QByteArray gfaSequence = node->getSequenceForGfa();
+        out << gfaSequence;
+        gfaSequenceLength = gfaSequence.length();
+    } else {
+        out.writeSequence(node->getSequence());
+        gfaSequenceLength = qsizetype(node->getSequence().size());
+    }
+    out << "\tLN:i:" << gfaSequenceLength;
 
     //We use the depthTag to guide how we save the node depth.
     //If it is empty, that implies that the loaded graph did not have depth
     //information and so we don't save depth.
     if (depthTag == "DP")
-        gfaSegmentLine += "\tDP:f:" + QString::number(node->getDepth()).toLatin1();
+        out << "\tDP:f:" << node->getDepth();
     else if (depthTag == "KC" || depthTag == "RC" || depthTag == "FC")
-        gfaSegmentLine += "\t" + depthTag.toLatin1() + ":i:" + QString::number(int(node->getDepth() * gfaSequence.length() + 0.5)).toLatin1();
+        out << '\t' << depthTag << ":i:" << int(node->getDepth() * gfaSequenceLength + 0.5);
 
     //If the user has included custom labels or colours, include those.
     QString label = getCustomLabel(node);
     if (!label.isEmpty())
-        gfaSegmentLine += "\tLB:z:" + label.toLatin1();
+        out << "\tLB:z:" << label;
 
     QString rcLabel = getCustomLabel(node->getReverseComplement());
     if (!rcLabel.isEmpty())
-        gfaSegmentLine += "\tL2:z:" + rcLabel.toLatin1();
+        out << "\tL2:z:" << rcLabel;
     if (hasCustomColour(node))
-        gfaSegmentLine += "\tCL:z:" + getColourName(getCustomColour(node)).toLatin1();
+        out << "\tCL:z:" << getColourName(getCustomColour(node));
     if (hasCustomColour(node->getReverseComplement()))
-        gfaSegmentLine += "\tC2:z:" + getColourName(getCustomColour(node->getReverseComplement())).toLatin1();
+        out << "\tC2:z:" << getColourName(getCustomColour(node->getReverseComplement()));
 
-    return gfaSegmentLine;
+    out << '\n';
 }
 
 
-bool AssemblyGraph::saveEntireGraphToGfa(const QString& filename)
+//Sorts edges for saving in the same order as DeBruijnEdge::compareEdgePointers,
+//but parses every node name only once instead of on every comparison.
+static void sortEdgesForGfa(std::vector<DeBruijnEdge *> &edges)
+{
+    struct EdgeSortKey {
+        QString start;
+        bool numeric;
+        long long startNumber, endNumber;
+        DeBruijnEdge *edge;
+    };
+
+    auto parseNameNumber = [](const QString &name, bool *ok) {
+        *ok = false;
+        return name.isEmpty() ? 0 : QStringView(name).chopped(1).toLongLong(ok);
+    };
+
+    std::vector<EdgeSortKey> keys(edges.size());
+    QtConcurrent::blockingMap(keys, [&](EdgeSortKey &key) {
+        size_t i = &key - keys.data();
+        key.edge = edges[i];
+        key.start = key.edge->getStartingNode()->getName();
+        bool startOk, endOk;
+        key.startNumber = parseNameNumber(key.start, &startOk);
+        key.endNumber = parseNameNumber(key.edge->getEndingNode()->getName(), &endOk);
+        key.numeric = startOk && endOk;
+    });
+
+    std::sort(keys.begin(), keys.end(), [](const EdgeSortKey &a, const EdgeSortKey &b) {
+        if (a.numeric && b.numeric) {
+            if (a.startNumber != b.startNumber)
+                return a.startNumber < b.startNumber;
+            return a.endNumber < b.endNumber;
+        }
+        return a.start < b.start;
+    });
+
+    for (size_t i = 0; i < keys.size(); ++i)
+        edges[i] = keys[i].edge;
+}
+
+bool AssemblyGraph::saveGfa(const QString &filename,
+                            const std::vector<DeBruijnNode *> &nodes,
+                            std::vector<DeBruijnEdge *> edges) const
 {
+    bool compress = filename.endsWith(".gz");
     QFile file(filename);
-    bool success = file.open(QIODevice::WriteOnly | QIODevice::Text);
+    bool success = file.open(compress ? QIODevice::WriteOnly : QIODevice::WriteOnly | QIODevice::Text);
     if (!success)
         return false;
 
-    QTextStream out(&file);
+    sortEdgesForGfa(edges);
 
+    //Segment and link records are formatted (and compressed) in parallel
+    bool written = utils::writeRecordsInParallel(&file, nodes.size() + edges.size(), [&](utils::BufferedWriter &out, size_t i) {
+        if (i < nodes.size())
+            writeGfaSegmentLine(out, nodes[i], m_depthTag);
+        else
+            edges[i - nodes.size()]->writeGfaLinkLine(out);
+    }, compress);
+
+    return written && file.flush() && file.error() == QFileDevice::NoError;
+}
+
+bool AssemblyGraph::saveEntireGraphToGfa(const QString& filename)
+{
+    std::vector<DeBruijnNode *> nodesToSave;
     for (auto &entry : m_deBruijnGraphNodes) {
         DeBruijnNode * node = entry;
         if (node->isPositiveNode())
-            out << getGfaSegmentLine(node, m_depthTag) << '\n';
+            nodesToSave.push_back(node);
     }
 
-    QList<DeBruijnEdge*> edgesToSave;
+    std::vector<DeBruijnEdge *> edgesToSave;
     for (auto &entry : m_deBruijnGraphEdges) {
         DeBruijnEdge * edge = entry.second;
         if (edge->isPositiveEdge())
             edgesToSave.push_back(edge);
     }
 
-    std::sort(edgesToSave.begin(), edgesToSave.end(), DeBruijnEdge::compareEdgePointers);
-
-    for (auto & i : edgesToSave)
-        out << i->getGfaLinkLine();
-
-    return true;
+    return saveGfa(filename, nodesToSave, std::move(edgesToSave));
 }
 
 bool AssemblyGraph::saveVisibleGraphToGfa(const QString& filename)
 {
-    QFile file(filename);
-    bool success = file.open(QIODevice::WriteOnly | QIODevice::Text);
-    if (!success)
-        return false;
-
-    QTextStream out(&file);
-
+    std::vector<DeBruijnNode *> nodesToSave;
     for (auto &entry : m_deBruijnGraphNodes) {
         DeBruijnNode * node = entry;
         if (node->thisNodeOrReverseComplementIsDrawn() && node->isPositiveNode())
-            out << getGfaSegmentLine(node, m_depthTag) << '\n';
+            nodesToSave.push_back(node);
     }
 
-    QList<DeBruijnEdge*> edgesToSave;
+    std::vector<DeBruijnEdge *> edgesToSave;
     for (auto &entry : m_deBruijnGraphEdges) {
         DeBruijnEdge * edge = entry.second;
         if (edge->getStartingNode()->thisNodeOrReverseComplementIsDrawn() &&
@@ -1666,12 +2089,7 @@ bool AssemblyGraph::saveVisibleGraphToGfa(const QString& filename)
             edgesToSave.push_back(edge);
     }
 
-    std::sort(edgesToSave.begin(), edgesToSave.end(), DeBruijnEdge::compareEdgePointers);
-
-    for (auto & i : edgesToSave)
-        out << i->getGfaLinkLine();
-
-    return true;
+    return saveGfa(filename, nodesToSave, std::move(edgesToSave));
 }
 
 bool AssemblyGraph::hasCustomColour(const DeBruijnNode* node) const {
@@ -1733,36 +2151,47 @@ void AssemblyGraph::setCustomLabel(const DeBruijnNode* node, QString newLabel) {
 
 void AssemblyGraph::clearAllCsvData() {
     m_csvHeaders.clear();
-    for (auto &entry : m_deBruijnGraphNodes) {
-        clearCsvData(entry);
-    }
+    m_nodeCSVData.clear();
 }
 
 bool AssemblyGraph::hasCsvData(const DeBruijnNode* node) const {
-    auto it = m_nodeCSVData.find(node);
-    return it != m_nodeCSVData.end() && !it->second.isEmpty();
+    return m_nodeCSVData.hasRow(node);
 }
 
 QStringList AssemblyGraph::getAllCsvData(const DeBruijnNode *node) const {
-    auto it = m_nodeCSVData.find(node);
-    return it == m_nodeCSVData.end() ? QStringList() : it->second;
+    QStringList res;
+    auto row = m_nodeCSVData.row(node);
+    if (row < 0)
+        return res;
+
+    for (size_t i = 0; i < m_nodeCSVData.columnCount(); ++i)
+        res << QString::fromStdString(m_nodeCSVData.column(i).text(row));
+    return res;
 }
 
 std::optional<QString> AssemblyGraph::getCsvLine(const DeBruijnNode *node, int i) const {
-    auto it = m_nodeCSVData.find(node);
-    if (it == m_nodeCSVData.end() ||
-        i >= it->second.length())
+    auto row = m_nodeCSVData.row(node);
+    if (row < 0 || i < 0 || i >= m_nodeCSVData.columnCount())
         return "";
 
-    return it->second[i];
+    return QString::fromStdString(m_nodeCSVData.column(i).text(row));
 }
 
 void AssemblyGraph::setCsvData(const DeBruijnNode* node, QStringList csvData) {
-    m_nodeCSVData[node] = std::move(csvData);
+    if (csvData.isEmpty()) {
+        clearCsvData(node);
+        return;
+    }
+
+    std::vector<std::string> values;
+    values.reserve(csvData.size());
+    for (const auto &value : csvData)
+        values.emplace_back(value.toStdString());
+    m_nodeCSVData.setRow(node, m_nodeCSVData.addRow(values));
 }
 
 void AssemblyGraph::clearCsvData(const DeBruijnNode* node) {
-    m_nodeCSVData[node].clear();
+    m_nodeCSVData.removeNode(node);
 }
 
 //This function changes the name of a node pair.  The new and old names are
@@ -1783,6 +2212,7 @@ void AssemblyGraph::changeNodeName(const QString& oldName, const QString& newNam
     DeBruijnNode * posNode = m_deBruijnGraphNodes[posOldNodeName.toStdString()];
     DeBruijnNode * negNode = m_deBruijnGraphNodes[negOldNodeName.toStdString()];
 
+    m_nodeNameIndex.clear();
     m_deBruijnGraphNodes.erase(posOldNodeName.toStdString());
     m_deBruijnGraphNodes.erase(negOldNodeName.toStdString());
 
@@ -1832,6 +2262,7 @@ void AssemblyGraph::changeNodeDepth(const std::vector<DeBruijnNode *> &nodes,
         node->setDepth(newDepth);
         node->getReverseComplement()->setDepth(newDepth);
     }
+    m_nodeRangeIndex.clear();
 
     //If this graph does not already have a depthTag, give it a depthTag of KC
     //so the depth info will be saved.
@@ -1840,258 +2271,6 @@ void AssemblyGraph::changeNodeDepth(const std::vector<DeBruijnNode *> &nodes,
 }
 
 
-//This function returns the number of dead ends in the graph.
-//It looks only at positive nodes, which can have 0, 1 or 2 dead ends each.
-//This value therefore varies between zero and twice the node count (specifically
-//the positive node count).
-unsigned AssemblyGraph::getDeadEndCount() const
-{
-    int deadEndCount = 0;
-
-    for (auto &entry : m_deBruijnGraphNodes) {
-        DeBruijnNode * node = entry;
-        if (node->isPositiveNode())
-            deadEndCount += node->getDeadEndCount();
-    }
-
-    return deadEndCount;
-}
-
-
-
-void AssemblyGraph::getNodeStats(int * n50, int * shortestNode, int * firstQuartile, int * median, int * thirdQuartile, int * longestNode) const
-{
-    if (m_totalLength == 0.0)
-        return;
-
-    std::vector<int> nodeLengths;
-    for (auto &entry : m_deBruijnGraphNodes) {
-        DeBruijnNode * node = entry;
-        if (node->isPositiveNode())
-            nodeLengths.push_back(node->getLength());
-    }
-
-    if (nodeLengths.empty())
-        return;
-
-    std::sort(nodeLengths.begin(), nodeLengths.end());
-
-    *shortestNode = nodeLengths.front();
-    *longestNode = nodeLengths.back();
-
-    double firstQuartileIndex = (nodeLengths.size() - 1) / 4.0;
-    double medianIndex = (nodeLengths.size() - 1) / 2.0;
-    double thirdQuartileIndex = (nodeLengths.size() - 1) * 3.0 / 4.0;
-
-    *firstQuartile = round(getValueUsingFractionalIndex(nodeLengths, firstQuartileIndex));
-    *median = round(getValueUsingFractionalIndex(nodeLengths, medianIndex));
-    *thirdQuartile = round(getValueUsingFractionalIndex(nodeLengths, thirdQuartileIndex));
-
-    double halfTotalLength = m_totalLength / 2.0;
-    long long totalSoFar = 0;
-    for (int i = int(nodeLengths.size()) - 1; i >= 0 ; --i)
-    {
-        totalSoFar += nodeLengths[i];
-        if (totalSoFar >= halfTotalLength)
-        {
-            *n50 = nodeLengths[i];
-            break;
-        }
-    }
-}
-
-
-
-//This function uses an algorithm adapted from: http://math.hws.edu/eck/cs327_s04/chapter9.pdf
-void AssemblyGraph::getGraphComponentCountAndLargestComponentSize(int * componentCount, int * largestComponentLength) const
-{
-    *componentCount = 0;
-    *largestComponentLength = 0;
-
-    QSet<DeBruijnNode *> visitedNodes;
-    QList< QList<DeBruijnNode *> > connectedComponents;
-
-    //Loop through all positive nodes.
-    for (auto &entry : m_deBruijnGraphNodes) {
-        DeBruijnNode * v = entry;
-        if (v->isNegativeNode())
-            continue;
-
-        //If the node has not yet been visited, then it must be the start of a new connected component.
-        if (!visitedNodes.contains(v))
-        {
-            QList<DeBruijnNode *> connectedComponent;
-
-            QQueue<DeBruijnNode *> q;
-            q.enqueue(v);
-            visitedNodes.insert(v);
-
-            while (!q.isEmpty())
-            {
-                DeBruijnNode * w = q.dequeue();
-                connectedComponent.push_back(w);
-
-                std::vector<DeBruijnNode *> connectedNodes = w->getAllConnectedPositiveNodes();
-                for (auto k : connectedNodes)
-                {
-                    if (!visitedNodes.contains(k))
-                    {
-                        visitedNodes.insert(k);
-                        q.enqueue(k);
-                    }
-                }
-            }
-
-            connectedComponents.push_back(connectedComponent);
-        }
-    }
-
-    //Now that the list of connected components is built, we look for the
-    //largest one (as measured by total node length).
-    *componentCount = connectedComponents.size();
-    for (int i = 0; i < *componentCount; ++i)
-    {
-        int componentLength = 0;
-        for (auto & j : connectedComponents[i])
-            componentLength += j->getLength();
-
-        if (componentLength > *largestComponentLength)
-            *largestComponentLength = componentLength;
-    }
-}
-
-bool compareNodeDepth(DeBruijnNode * a, DeBruijnNode * b) {return (a->getDepth() < b->getDepth());}
-
-//This function takes a node list sorted by depth and a target index (in terms of
-//the whole sequence length).  It returns the depth at that index.
-static double findDepthAtIndex(QList<DeBruijnNode *> * nodeList, long long targetIndex)
-{
-    long long lengthSoFar = 0;
-    for (auto node : *nodeList)
-    {
-        lengthSoFar += node->getLength();
-        long long currentIndex = lengthSoFar - 1;
-
-        if (currentIndex >= targetIndex)
-            return node->getDepth();
-    }
-    return 0.0;
-}
-
-
-double AssemblyGraph::getMedianDepthByBase() const
-{
-    if (m_totalLength == 0)
-        return 0.0;
-
-    //Make a list of all nodes.
-    long long totalLength = 0;
-    QList<DeBruijnNode *> nodeList;
-    for (auto &entry : m_deBruijnGraphNodes) {
-        DeBruijnNode * node = entry;
-        if (node->isPositiveNode())
-        {
-            nodeList.push_back(node);
-            totalLength += node->getLength();
-        }
-    }
-
-    //If there is only one node, then its depth is the median.
-    if (nodeList.size() == 1)
-        return nodeList[0]->getDepth();
-
-    //Sort the node list from low to high depth.
-    std::sort(nodeList.begin(), nodeList.end(), compareNodeDepth);
-
-    if (totalLength % 2 == 0) //Even total length
-    {
-        long long medianIndex2 = totalLength / 2;
-        long long medianIndex1 = medianIndex2 - 1;
-        double depth1 = findDepthAtIndex(&nodeList, medianIndex1);
-        double depth2 = findDepthAtIndex(&nodeList, medianIndex2);
-        return (depth1 + depth2) / 2.0;
-    }
-    else //Odd total length
-    {
-        long long medianIndex = (totalLength - 1) / 2;
-        return findDepthAtIndex(&nodeList, medianIndex);
-    }
-}
-
-
-long long AssemblyGraph::getEstimatedSequenceLength(double medianDepthByBase) const
-{
-    long long estimatedSequenceLength = 0;
-    if (medianDepthByBase == 0.0)
-        return 0;
-
-    for (auto &entry : m_deBruijnGraphNodes) {
-        DeBruijnNode * node = entry;
-
-        if (node->isPositiveNode())
-        {
-            int nodeLength = node->getLengthWithoutTrailingOverlap();
-            double relativeDepth = node->getDepth() / medianDepthByBase;
-
-            int closestIntegerDepth = round(relativeDepth);
-            int lengthAdjustedForDepth = nodeLength * closestIntegerDepth;
-
-            estimatedSequenceLength += lengthAdjustedForDepth;
-        }
-    }
-
-    return estimatedSequenceLength;
-}
-
-
-
-long long AssemblyGraph::getTotalLengthMinusEdgeOverlaps() const
-{
-    long long totalLength = 0;
-    for (auto &entry : m_deBruijnGraphNodes) {
-        DeBruijnNode * node = entry;
-        if (node->isPositiveNode())
-        {
-            totalLength += node->getLength();
-            int maxOverlap = 0;
-            for (const auto* edge : node->edges()) {
-                int edgeOverlap = edge->getOverlap();
-                maxOverlap = std::max(maxOverlap, edgeOverlap);
-            }
-            totalLength -= maxOverlap;
-        }
-    }
-
-    return totalLength;
-}
-
-
-QPair<int, int> AssemblyGraph::getOverlapRange() const
-{
-    int smallestOverlap = std::numeric_limits<int>::max();
-    int largestOverlap = 0;
-    for (auto &entry : m_deBruijnGraphEdges) {
-        int overlap = entry.second->getOverlap();
-        if (overlap < smallestOverlap)
-            smallestOverlap = overlap;
-        if (overlap > largestOverlap)
-            largestOverlap = overlap;
-    }
-    if (smallestOverlap == std::numeric_limits<int>::max())
-        smallestOverlap = 0;
-    return { smallestOverlap, largestOverlap };
-}
-
-long long AssemblyGraph::getTotalLengthOrphanedNodes() const {
-    long long total = 0;
-    for (auto &entry : m_deBruijnGraphNodes) {
-        DeBruijnNode * node = entry;
-        if (node->isPositiveNode() && node->getDeadEndCount() == 2)
-            total += node->getLength();
-    }
-    return total;
-}
-
 QStringList AssemblyGraph::getCustomLabelForDisplay(const DeBruijnNode *node) const {
     QStringList customLabelLines;
     QString label = getCustomLabel(node);
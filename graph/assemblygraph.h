@@ -22,6 +22,10 @@
 
 #include "gfa.h"
 #include "path.h"
+#include "graphpaths.h"
+#include "nodenameindex.h"
+#include "noderangeindex.h"
+#include "csvdata.h"
 #include "annotation.hpp"
 
 #include "ui/mygraphicsscene.h"
@@ -33,12 +37,18 @@
 #include <QString>
 #include <QPair>
 #include <QObject>
+
+#include <functional>
 #include <vector>
 
 class DeBruijnNode;
 class DeBruijnEdge;
 class MyProgressDialog;
 
+namespace utils {
+    class BufferedWriter;
+}
+
 class AssemblyGraphError : public std::runtime_error {
   public:
     using std::runtime_error::runtime_error;
@@ -46,13 +56,24 @@ class AssemblyGraphError : public std::runtime_error {
 
 class AssemblyGraphBuilder;
 
+// The contents of a CSV file matched against the graph, ready to be set with
+// AssemblyGraph::applyCSV.
+struct CsvLoadResult {
+    bool ok = false;
+    QString errormsg;
+    QStringList headers;
+    CsvData data;
+    bool coloursLoaded = false;
+    std::vector<std::pair<const DeBruijnNode *, QColor>> colours;
+};
+
 
 class AssemblyGraph : public QObject
 {
     Q_OBJECT
 
     friend class AssemblyGraphBuilder;
-    
+
 public:
     AssemblyGraph();
     ~AssemblyGraph() override;
@@ -76,13 +97,14 @@ public:
     phmap::parallel_flat_hash_map<const DeBruijnEdge*, QColor> m_edgeColors;
 
     // CSV data
-    phmap::parallel_flat_hash_map<const DeBruijnNode*, QStringList> m_nodeCSVData;
+    CsvData m_nodeCSVData;
     QStringList m_csvHeaders;
     // Tags
     phmap::parallel_flat_hash_map<const DeBruijnNode*, std::vector<gfa::tag>> m_nodeTags;
     phmap::parallel_flat_hash_map<const DeBruijnEdge*, std::vector<gfa::tag>> m_edgeTags;
 
-    tsl::htrie_map<char, Path*> m_deBruijnGraphPaths;
+    // Named paths (GFA P-lines) with an index of the paths through each node
+    GraphPaths m_deBruijnGraphPaths;
 
     int m_kmer;
     int m_nodeCount;
@@ -105,6 +127,11 @@ public:
     void createDeBruijnEdge(const QString& node1Name, const QString& node2Name,
                             int overlap = 0,
                             EdgeOverlapType overlapType = UNKNOWN_OVERLAP);
+    // The same for nodes already paired with their reverse complements,
+    // without looking up any names
+    void createDeBruijnEdge(DeBruijnNode *node1, DeBruijnNode *node2,
+                            int overlap = 0,
+                            EdgeOverlapType overlapType = UNKNOWN_OVERLAP);
     void resetNodes();
     static QByteArray getReverseComplement(const QByteArray& forwardSequence);
     void resetEdges();
@@ -120,8 +147,17 @@ public:
     bool loadGraphFromFile(const QString& filename);
     void markNodesToDraw(const std::vector<DeBruijnNode *>& startingNodes,
                          int nodeDistance);
+    void setDrawnNodes(const std::vector<DeBruijnNode *> &nodes);
+    // Adds nodes to the drawn scope, along with their edges to drawn nodes
+    void addDrawnNodes(const std::vector<DeBruijnNode *> &nodes);
+    const std::vector<DeBruijnNode *> &getDrawnNodes();
+    const std::vector<DeBruijnEdge *> &getDrawnEdges();
 
     bool loadCSV(const QString& filename, QStringList * columns, QString * errormsg, bool * coloursLoaded);
+    // Reads the CSV file without changing the graph, so this part of loadCSV
+    // can be run in a background thread.
+    CsvLoadResult readCSV(const QString& filename) const;
+    bool applyCSV(CsvLoadResult csv, QStringList * columns, QString * errormsg, bool * coloursLoaded);
     std::vector<DeBruijnNode *> getStartingNodes(QString * errorTitle,
                                                  QString * errorMessage,
                                                  bool doubleMode,
@@ -132,6 +168,12 @@ public:
     static bool checkIfStringHasNodes(QString nodesString);
     static QString generateNodesNotFoundErrorMessage(std::vector<QString> nodesNotInGraph,
                                               bool exact);
+    // Starts building the node name index for partial name searches in a
+    // background thread. Without this, it is built on first use.
+    void buildNodeNameIndexInBackground();
+    const NodeNameIndex &getNodeNameIndex() const;
+    // Nodes sorted by depth and by length, built on first use
+    const NodeRangeIndex &getNodeRangeIndex() const;
     std::vector<DeBruijnNode *> getNodesFromString(QString nodeNamesString,
                                                    bool exactMatch,
                                                    std::vector<QString> * nodesNotInGraph = nullptr) const;
@@ -142,6 +184,9 @@ public:
     int getDrawnNodeCount() const;
     void deleteNodes(const std::vector<DeBruijnNode *> &nodes);
     void deleteEdges(const std::vector<DeBruijnEdge *> &edges);
+    void deleteNodesAndEdges(const std::vector<DeBruijnNode *> &nodes,
+                             const std::vector<DeBruijnEdge *> &edges,
+                             MyGraphicsScene * scene = nullptr);
     void duplicateNodePair(DeBruijnNode * node, MyGraphicsScene * scene);
     bool mergeNodes(QList<DeBruijnNode *> nodes, MyGraphicsScene * scene,
                     bool recalulateDepth);
@@ -149,8 +194,13 @@ public:
     int mergeAllPossible(MyGraphicsScene * scene = 0,
                          MyProgressDialog * progressDialog = 0);
 
-    void saveEntireGraphToFasta(const QString& filename);
-    void saveEntireGraphToFastaOnlyPositiveNodes(const QString& filename);
+    bool saveEntireGraphToFasta(const QString& filename);
+    bool saveEntireGraphToFastaOnlyPositiveNodes(const QString& filename);
+    // Writes the nodes as FASTA records, formatted in parallel and written in
+    // order. A file name ending in .gz gives gzip-compressed output.
+    static bool saveNodesToFasta(const QString &filename, const std::vector<DeBruijnNode *> &nodes,
+                                 bool sign, size_t lineWidth = 70,
+                                 const std::function<bool()> &cancelled = {});
     bool saveEntireGraphToGfa(const QString& filename);
     bool saveVisibleGraphToGfa(const QString& filename);
     void changeNodeName(const QString& oldName, const QString& newName);
@@ -158,16 +208,6 @@ public:
     void changeNodeDepth(const std::vector<DeBruijnNode *> &nodes,
                          double newDepth);
 
-    unsigned int getDeadEndCount() const;
-    void getNodeStats(int * n50, int * shortestNode, int * firstQuartile, int * median, int * thirdQuartile, int * longestNode) const;
-    void getGraphComponentCountAndLargestComponentSize(int * componentCount, int * largestComponentLength) const;
-    double getMedianDepthByBase() const;
-
-    long long getEstimatedSequenceLength(double medianDepthByBase) const;
-    long long getTotalLengthMinusEdgeOverlaps() const;
-    QPair<int, int> getOverlapRange() const;
-    long long getTotalLengthOrphanedNodes() const;
-
     bool hasCustomColour(const DeBruijnNode* node) const;
     bool hasCustomColour(const DeBruijnEdge* edge) const;
     QColor getCustomColour(const DeBruijnNode* node) const;
@@ -191,7 +231,7 @@ public:
     QColor getCustomColourForDisplay(const DeBruijnNode *node) const;
     QStringList getCustomLabelForDisplay(const DeBruijnNode *node) const;
 
-    QString getGfaSegmentLine(const DeBruijnNode *node, const QString& depthTag) const;
+    void writeGfaSegmentLine(utils::BufferedWriter &out, const DeBruijnNode *node, const QString& depthTag) const;
 
     QString getUniqueNodeName(QString baseName) const;
     QString getNodeNameFromString(QString string) const;
@@ -201,7 +241,31 @@ private:
     std::vector<DeBruijnNode *> getNodesInDepthRange(double min, double max) const;
     std::vector<int> makeOverlapCountVector();
     void clearAllCsvData();
+    bool saveGfa(const QString &filename,
+                 const std::vector<DeBruijnNode *> &nodes,
+                 std::vector<DeBruijnEdge *> edges) const;
     QString getNewNodeName(QString oldNodeName) const;
+    void clearDrawnScope();
+    void addDrawnNode(DeBruijnNode *node);
+    void determineDrawnEdges(size_t firstNode = 0);
+    void refreshDrawnScope();
+    uint32_t nextVisitEpoch();
+    void createDeBruijnEdge(DeBruijnNode *node1, DeBruijnNode *node2,
+                            DeBruijnNode *negNode1, DeBruijnNode *negNode2,
+                            int overlap, EdgeOverlapType overlapType);
+
+    // The nodes and edges currently drawn, so that a new scope only has to
+    // touch the old and new scope rather than the whole graph. Deleting or
+    // merging nodes marks the lists stale and they are rebuilt on next use.
+    std::vector<DeBruijnNode *> m_drawnNodes;
+    std::vector<DeBruijnEdge *> m_drawnEdges;
+    bool m_drawnScopeStale = false;
+    uint32_t m_visitEpoch = 0;
+
+    // Cleared whenever nodes are added, removed or renamed
+    mutable NodeNameIndex m_nodeNameIndex;
+    // Cleared whenever nodes are added or removed, or their depths change
+    mutable NodeRangeIndex m_nodeRangeIndex;
 
 signals:
     void setMergeTotalCount(int totalCount);
@@ -32,6 +32,9 @@
 #include <QString>
 #include <QRegularExpression>
 #include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
 
 #include <zlib.h>
 
@@ -151,40 +154,23 @@ static bool attemptToLoadSequencesFromFasta(AssemblyGraph &graph) {
 
     graph.m_sequencesLoadedFromFasta = TRIED;
 
-    QFileInfo gfaFileInfo(graph.m_filename);
-    QString baseName = gfaFileInfo.completeBaseName();
-    QString fastaName = gfaFileInfo.dir().filePath(baseName + ".fa");
-    QFileInfo fastaFileInfo(fastaName);
-    if (!fastaFileInfo.exists()) {
-        fastaName = gfaFileInfo.dir().filePath(baseName + ".fasta");
-        fastaFileInfo = QFileInfo(fastaName);
-    }
-    if (!fastaFileInfo.exists()) {
-        fastaName = gfaFileInfo.dir().filePath(baseName + ".contigs.fasta");
-        fastaFileInfo = QFileInfo(fastaName);
-    }
-    if (!fastaFileInfo.exists())
+    QString fastaName = utils::findFastaForGraph(graph.m_filename);
+    if (fastaName.isEmpty())
         return false;
 
     bool atLeastOneNodeSequenceLoaded = false;
-    std::vector<QString> names;
-    std::vector<QByteArray> sequences;
-    utils::readFastaFile(fastaName, &names, &sequences);
-
-    for (size_t i = 0; i < names.size(); ++i) {
-        QString name = names[i];
-        name = name.split(QRegularExpression("\\s+"))[0];
-        if (graph.m_deBruijnGraphNodes.count((name + "+").toStdString())) {
-            DeBruijnNode * posNode = graph.m_deBruijnGraphNodes[(name + "+").toStdString()];
-            if (posNode->sequenceIsMissing()) {
-                Sequence sequence{sequences[i]};
-                atLeastOneNodeSequenceLoaded = true;
-                posNode->setSequence(sequence);
-                DeBruijnNode * negNode = graph.m_deBruijnGraphNodes[(name + "-").toStdString()];
-                negNode->setSequence(sequence.GetReverseComplement());
-            }
-        }
-    }
+    std::string name;
+    utils::readFastxSequences(fastaName, [&](std::string_view header, const Sequence &sequence) {
+        name = header.substr(0, header.find_first_of(" \t\v\f\r"));
+        auto posNode = graph.m_deBruijnGraphNodes.find(name + '+');
+        if (posNode == graph.m_deBruijnGraphNodes.end() || !posNode.value()->sequenceIsMissing())
+            return;
+
+        atLeastOneNodeSequenceLoaded = true;
+        posNode.value()->setSequence(sequence);
+        DeBruijnNode * negNode = graph.m_deBruijnGraphNodes[name + '-'];
+        negNode->setSequence(sequence.GetReverseComplement());
+    });
 
     return atLeastOneNodeSequenceLoaded;
 }
@@ -474,14 +460,19 @@ class GFAAssemblyGraphBuilder : public AssemblyGraphBuilder {
 
     void handlePath(const gfa::path &record,
                     AssemblyGraph &graph) {
-        QList<DeBruijnNode *> pathNodes;
-        pathNodes.reserve(record.segments.size());
+        if (graph.m_deBruijnGraphPaths.contains(record.name))
+            throw AssemblyGraphError("Duplicate path named: " + std::string(record.name));
 
+        // Paths might come before the segments they use, so create placeholders
+        // as we do for links
+        pathSteps_.clear();
         for (const auto &node : record.segments)
-            pathNodes.push_back(graph.m_deBruijnGraphNodes.at(node));
-        graph.m_deBruijnGraphPaths[record.name] = new Path(Path::makeFromOrderedNodes(pathNodes, false));
+            pathSteps_.push_back(getNode(std::string(node), graph));
+        graph.m_deBruijnGraphPaths.add(record.name, pathSteps_);
     }
 
+    std::vector<DeBruijnNode *> pathSteps_;
+
 
   public:
     using AssemblyGraphBuilder::AssemblyGraphBuilder;
@@ -524,6 +515,8 @@ class GFAAssemblyGraphBuilder : public AssemblyGraphBuilder {
                 *result);
         }
 
+        graph.m_deBruijnGraphPaths.buildNodeIndex();
+
         graph.m_sequencesLoadedFromFasta = NOT_TRIED;
         if (sequencesAreMissing)
             attemptToLoadSequencesFromFasta(graph);
@@ -559,6 +552,57 @@ static void makeReverseComplementNodeIfNecessary(AssemblyGraph &graph, DeBruijnN
     }
 }
 
+//Pairs up reverse complements, creating them if necessary.
+static void makeMissingReverseComplements(AssemblyGraph &graph) {
+    std::vector<DeBruijnNode*> nodes;
+    for (const auto &entry : graph.m_deBruijnGraphNodes) {
+        DeBruijnNode *node = entry;
+        if (!graph.m_deBruijnGraphNodes.count(getOppositeNodeName(node->getName().toStdString())))
+            nodes.emplace_back(node);
+    }
+
+    for (auto &entry : nodes)
+        makeReverseComplementNodeIfNecessary(graph, entry);
+    pointEachNodeToItsReverseComplement(graph);
+}
+
+// The name includes the sign of the node
+static DeBruijnNode *addNode(AssemblyGraph &graph, const std::string &name, double depth,
+                             const Sequence &sequence, int length = 0) {
+    auto node = new DeBruijnNode(QString::fromStdString(name), depth, sequence, length);
+    graph.m_deBruijnGraphNodes.emplace(name, node);
+    return node;
+}
+
+static bool startsWith(std::string_view s, std::string_view prefix) {
+    return s.substr(0, prefix.size()) == prefix;
+}
+
+static void appendWithoutWhitespace(std::string &sequence, std::string_view line) {
+    for (char c : line) {
+        if (c != ' ' && c != '\t' && c != '\r' && c != '\n' && c != '\v' && c != '\f')
+            sequence.push_back(c);
+    }
+}
+
+// An edge between nodes that may not exist yet when it is read
+struct NamedEdge {
+    std::string startingNodeName;
+    std::string endingNodeName;
+    int overlap = 0;
+};
+
+// Edges between nodes that don't exist are skipped
+static void createNamedEdges(AssemblyGraph &graph, const std::vector<NamedEdge> &edges,
+                             EdgeOverlapType overlapType) {
+    for (const auto &edge : edges) {
+        auto node1 = graph.m_deBruijnGraphNodes.find(edge.startingNodeName);
+        auto node2 = graph.m_deBruijnGraphNodes.find(edge.endingNodeName);
+        if (node1 != graph.m_deBruijnGraphNodes.end() && node2 != graph.m_deBruijnGraphNodes.end())
+            graph.createDeBruijnEdge(*node1, *node2, edge.overlap, overlapType);
+    }
+}
+
 class FastaAssemblyGraphBuilder : public AssemblyGraphBuilder {
     using AssemblyGraphBuilder::AssemblyGraphBuilder;
 
@@ -582,16 +626,11 @@ class FastaAssemblyGraphBuilder : public AssemblyGraphBuilder {
         graph.m_filename = fileName_;
         graph.m_depthTag = "";
 
-        std::vector<QString> names;
-        std::vector<QByteArray> sequences;
-        utils::readFastaFile(fileName_, &names, &sequences);
-
         std::vector<QString> circularNodeNames;
-        for (size_t i = 0; i < names.size(); ++i) {
-            QString name = names[i];
+        bool opened = utils::readFastxSequences(fileName_, [&](std::string_view header, const Sequence &sequence) {
+            QString name = QString::fromUtf8(header.data(), qsizetype(header.size()));
             QString lowerName = name.toLower();
             double depth = 1.0;
-            Sequence sequence{sequences[i]};
 
             // Check to see if the node name matches the Velvet/SPAdes contig
             // format.  If so, we can get the depth and node number.
@@ -647,7 +686,9 @@ class FastaAssemblyGraphBuilder : public AssemblyGraphBuilder {
             auto node = new DeBruijnNode(name, depth, sequence);
             graph.m_deBruijnGraphNodes.emplace(name.toStdString(), node);
             makeReverseComplementNodeIfNecessary(graph, node);
-        }
+        }, progress_);
+        if (!opened)
+            throw AssemblyGraphError("failed to open file: " + fileName_.toStdString());
         pointEachNodeToItsReverseComplement(graph);
 
         // For any circular nodes, make an edge connecting them to themselves.
@@ -667,123 +708,81 @@ class FastgAssemblyGraphBuilder : public AssemblyGraphBuilder {
         graph.m_filename = fileName_;
         graph.m_depthTag = "KC";
 
-        QFile inputFile(fileName_);
-        if (inputFile.open(QIODevice::ReadOnly)) {
-            std::vector<QString> edgeStartingNodeNames;
-            std::vector<QString> edgeEndingNodeNames;
+        utils::LineReader in(fileName_, progress_);
+        if (in.isOpen()) {
+            std::vector<NamedEdge> edges;
             DeBruijnNode * node = nullptr;
-            QByteArray sequenceBytes;
-
-            QTextStream in(&inputFile);
-            while (!in.atEnd()) {
-                QString nodeName;
-                double nodeDepth;
-
-                QString line = in.readLine();
+            std::string sequence;
 
+            std::string_view line;
+            while (in.nextLine(line)) {
                 //If the line starts with a '>', then we are beginning a new node.
-                if (line.startsWith(">")) {
+                if (startsWith(line, ">")) {
                     if (node != nullptr) {
-                        node->setSequence(sequenceBytes);
-                        sequenceBytes.clear();
+                        node->setSequence(Sequence(sequence));
+                        sequence.clear();
                     }
-                    line.remove(0, 1); //Remove '>' from start
-                    line.chop(1); //Remove ';' from end
-                    QStringList nodeDetails = line.split(":");
+                    line.remove_prefix(1); //Remove '>' from start
+                    if (!line.empty())
+                        line.remove_suffix(1); //Remove ';' from end
+                    std::string_view nodeDetails[2];
+                    size_t nodeDetailsCount = utils::splitInto(line, ':', nodeDetails, 2);
 
-                    const QString& thisNode = nodeDetails.at(0);
+                    std::string_view thisNode = nodeDetails[0];
 
                     //A single quote as the last character indicates a negative node.
-                    bool negativeNode = thisNode.at(thisNode.size() - 1) == '\'';
-
-                    QStringList thisNodeDetails = thisNode.split("_");
+                    bool negativeNode = !thisNode.empty() && thisNode.back() == '\'';
 
-                    if (thisNodeDetails.size() < 6)
+                    std::string_view thisNodeDetails[6];
+                    if (utils::splitInto(thisNode, '_', thisNodeDetails, 6) < 6)
                         throw "load error";
 
-                    nodeName = thisNodeDetails.at(1);
-                    if (negativeNode)
-                        nodeName += "-";
-                    else
-                        nodeName += "+";
-                    if (graph.m_deBruijnGraphNodes.count(nodeName.toStdString()))
+                    std::string nodeName(thisNodeDetails[1]);
+                    nodeName += negativeNode ? '-' : '+';
+                    if (graph.m_deBruijnGraphNodes.count(nodeName))
                         throw "load error";
 
-                    QString nodeDepthString = thisNodeDetails.at(5);
-                    if (negativeNode) {
-                        //It may be necessary to remove a single quote from the end of the depth
-                        if (nodeDepthString.at(nodeDepthString.size() - 1) == '\'')
-                            nodeDepthString.chop(1);
-                    }
-                    nodeDepth = nodeDepthString.toDouble();
+                    std::string_view nodeDepthString = thisNodeDetails[5];
+                    //It may be necessary to remove a single quote from the end of the depth
+                    if (negativeNode && !nodeDepthString.empty() && nodeDepthString.back() == '\'')
+                        nodeDepthString.remove_suffix(1);
 
-                    //Make the node
-                    node = new DeBruijnNode(nodeName, nodeDepth, {}); //Sequence string is currently empty - will be added to on subsequent lines of the fastg file
-                    graph.m_deBruijnGraphNodes.emplace(nodeName.toStdString(), node);
+                    //Make the node. Its sequence is added from the following lines of the fastg file.
+                    node = addNode(graph, nodeName, utils::toDouble(nodeDepthString), {});
 
                     //The second part of nodeDetails is a comma-delimited list of edge nodes.
                     //Edges aren't made right now (because the other node might not yet exist),
-                    //so they are saved into vectors and made after all the nodes have been made.
-                    if (nodeDetails.size() == 1 || nodeDetails.at(1).isEmpty())
+                    //so they are saved and made after all the nodes have been made.
+                    if (nodeDetailsCount == 1 || nodeDetails[1].empty())
                         continue;
-                    QStringList edgeNodes = nodeDetails.at(1).split(",");
-                    for (auto edgeNode : edgeNodes) {
-                        QChar lastChar = edgeNode.at(edgeNode.size() - 1);
-                        bool negativeNode = false;
-                        if (lastChar == '\'') {
-                            negativeNode = true;
-                            edgeNode.chop(1);
-                        }
-                        QStringList edgeNodeDetails = edgeNode.split("_");
-
-                        if (edgeNodeDetails.size() < 2)
-                            throw "load error";
+                    utils::forEachPart(nodeDetails[1], ',', [&](std::string_view edgeNode) {
+                        bool negativeEdgeNode = !edgeNode.empty() && edgeNode.back() == '\'';
+                        if (negativeEdgeNode)
+                            edgeNode.remove_suffix(1);
 
-                        QString edgeNodeName = edgeNodeDetails.at(1);
-                        if (negativeNode)
-                            edgeNodeName += "-";
-                        else
-                            edgeNodeName += "+";
+                        std::string_view edgeNodeDetails[2];
+                        if (utils::splitInto(edgeNode, '_', edgeNodeDetails, 2) < 2)
+                            throw "load error";
 
-                        edgeStartingNodeNames.push_back(nodeName);
-                        edgeEndingNodeNames.push_back(edgeNodeName);
-                    }
+                        std::string edgeNodeName(edgeNodeDetails[1]);
+                        edgeNodeName += negativeEdgeNode ? '-' : '+';
+                        edges.push_back({nodeName, std::move(edgeNodeName)});
+                    });
                 }
 
                 //If the line does not start with a '>', then this line is part of the
                 //sequence for the last node.
                 else {
-                    sequenceBytes.push_back(line.simplified().toLocal8Bit());
+                    appendWithoutWhitespace(sequence, line);
                 }
             }
-            if (node != nullptr) {
-                node->setSequence(sequenceBytes);
-                sequenceBytes.clear();
-            }
-
-            inputFile.close();
+            if (node != nullptr)
+                node->setSequence(Sequence(sequence));
 
             // Add fake reverse-complementary nodes for all self-reverse-complement ones
-            {
-                std::vector<DeBruijnNode*> nodes;
-                for (const auto &entry : graph.m_deBruijnGraphNodes) {
-                    DeBruijnNode *node = entry;
-                    if (!graph.m_deBruijnGraphNodes.count(getOppositeNodeName(node->getName().toStdString())))
-                        nodes.emplace_back(node);
-                }
-
-                for (auto &entry : nodes)
-                    makeReverseComplementNodeIfNecessary(graph,entry);
-            }
-            pointEachNodeToItsReverseComplement(graph);
-
+            makeMissingReverseComplements(graph);
 
-            //Create all of the edges.
-            for (size_t i = 0; i < edgeStartingNodeNames.size(); ++i) {
-                QString node1Name = edgeStartingNodeNames[i];
-                QString node2Name = edgeEndingNodeNames[i];
-                graph.createDeBruijnEdge(node1Name, node2Name);
-            }
+            createNamedEdges(graph, edges, UNKNOWN_OVERLAP);
         }
 
         graph.autoDetermineAllEdgesExactOverlap();
@@ -810,67 +809,61 @@ class AsqgAssemblyGraphBuilder : public AssemblyGraphBuilder {
 
         int badEdgeCount = 0;
 
-        QFile inputFile(fileName_);
-        if (inputFile.open(QIODevice::ReadOnly)) {
-            std::vector<QString> edgeStartingNodeNames;
-            std::vector<QString> edgeEndingNodeNames;
-            std::vector<int> edgeOverlaps;
-
-            QTextStream in(&inputFile);
-            while (!in.atEnd()) {
-                QString line = in.readLine();
+        utils::LineReader in(fileName_, progress_);
+        if (in.isOpen()) {
+            std::vector<NamedEdge> edges;
 
-                QStringList lineParts = line.split(QRegularExpression("\t"));
-                if (lineParts.empty())
-                    continue;
+            std::string_view line;
+            while (in.nextLine(line)) {
+                std::string_view lineParts[3];
+                size_t linePartCount = utils::splitInto(line, '\t', lineParts, 3);
 
                 // Lines beginning with "VT" are sequence (node) lines
-                if (lineParts.at(0) == "VT") {
-                    if (lineParts.size() < 3)
+                if (lineParts[0] == "VT") {
+                    if (linePartCount < 3)
                         throw "load error";
 
                     // We treat all nodes in this file as positive nodes and add "+" to the end of their names.
-                    QString nodeName = lineParts.at(1);
-                    if (nodeName.isEmpty())
+                    std::string nodeName(lineParts[1]);
+                    if (nodeName.empty())
                         nodeName = "node";
-                    nodeName += "+";
+                    nodeName += '+';
 
-                    Sequence sequence{lineParts.at(2).toLocal8Bit()};
+                    Sequence sequence{lineParts[2]};
                     int length = static_cast<int>(sequence.size());
 
                     // ASQG files don't seem to include depth, so just set this to one for every node.
                     double nodeDepth = 1.0;
 
-                    auto node = new DeBruijnNode(nodeName, nodeDepth, sequence, length);
-                    graph.m_deBruijnGraphNodes.emplace(nodeName.toStdString(), node);
+                    addNode(graph, nodeName, nodeDepth, sequence, length);
                 }
                 // Lines beginning with "ED" are edge lines
-                else if (lineParts.at(0) == "ED") {
+                else if (lineParts[0] == "ED") {
                     // Edges aren't made now, in case their sequence hasn't yet been specified.
                     // Instead, we save the starting and ending nodes and make the edges after
                     // we're done looking at the file.
-                    if (lineParts.size() < 2)
+                    if (linePartCount < 2)
                         throw "load error";
 
-                    QStringList edgeParts = lineParts[1].split(" ");
-                    if (edgeParts.size() < 8)
+                    std::string_view edgeParts[8];
+                    if (utils::splitInto(lineParts[1], ' ', edgeParts, 8) < 8)
                         throw "load error";
 
-                    QString s1Name = edgeParts.at(0);
-                    QString s2Name = edgeParts.at(1);
-                    int s1OverlapStart = edgeParts.at(2).toInt();
-                    int s1OverlapEnd = edgeParts.at(3).toInt();
-                    int s1Length = edgeParts.at(4).toInt();
-                    int s2OverlapStart = edgeParts.at(5).toInt();
-                    int s2OverlapEnd = edgeParts.at(6).toInt();
-                    int s2Length = edgeParts.at(7).toInt();
+                    std::string s1Name(edgeParts[0]);
+                    std::string s2Name(edgeParts[1]);
+                    int s1OverlapStart = utils::toInt(edgeParts[2]);
+                    int s1OverlapEnd = utils::toInt(edgeParts[3]);
+                    int s1Length = utils::toInt(edgeParts[4]);
+                    int s2OverlapStart = utils::toInt(edgeParts[5]);
+                    int s2OverlapEnd = utils::toInt(edgeParts[6]);
+                    int s2Length = utils::toInt(edgeParts[7]);
 
                     //We want the overlap region of s1 to be at the end of the node sequence.  If it isn't, we use the
                     //negative node and flip the overlap coordinates.
                     if (s1OverlapEnd == s1Length - 1)
-                        s1Name += "+";
+                        s1Name += '+';
                     else {
-                        s1Name += "-";
+                        s1Name += '-';
                         int newOverlapStart = s1Length - s1OverlapEnd - 1;
                         int newOverlapEnd = s1Length - s1OverlapStart - 1;
                         s1OverlapStart = newOverlapStart;
@@ -880,9 +873,9 @@ class AsqgAssemblyGraphBuilder : public AssemblyGraphBuilder {
                     //We want the overlap region of s2 to be at the start of the node sequence.  If it isn't, we use the
                     //negative node and flip the overlap coordinates.
                     if (s2OverlapStart == 0)
-                        s2Name += "+";
+                        s2Name += '+';
                     else {
-                        s2Name += "-";
+                        s2Name += '-';
                         int newOverlapStart = s2Length - s2OverlapEnd - 1;
                         int newOverlapEnd = s2Length - s2OverlapStart - 1;
                         s2OverlapStart = newOverlapStart;
@@ -894,38 +887,17 @@ class AsqgAssemblyGraphBuilder : public AssemblyGraphBuilder {
 
                     //If the overlap between the two nodes is in agreement and the overlap regions extend to the ends of the
                     //nodes, then we will make the edge.
-                    if (s1OverlapLength == s2OverlapLength && s1OverlapEnd == s1Length - 1 && s2OverlapStart == 0) {
-                        edgeStartingNodeNames.push_back(s1Name);
-                        edgeEndingNodeNames.push_back(s2Name);
-                        edgeOverlaps.push_back(s1OverlapLength);
-                    }
+                    if (s1OverlapLength == s2OverlapLength && s1OverlapEnd == s1Length - 1 && s2OverlapStart == 0)
+                        edges.push_back({std::move(s1Name), std::move(s2Name), s1OverlapLength});
                     else
                         ++badEdgeCount;
                 }
             }
 
             //Pair up reverse complements, creating them if necessary.
-            {
-                std::vector<DeBruijnNode*> nodes;
-                for (const auto &entry : graph.m_deBruijnGraphNodes) {
-                    DeBruijnNode *node = entry;
-                    if (!graph.m_deBruijnGraphNodes.count(getOppositeNodeName(node->getName().toStdString())))
-                        nodes.emplace_back(node);
-                }
+            makeMissingReverseComplements(graph);
 
-                for (auto &entry : nodes)
-                    makeReverseComplementNodeIfNecessary(graph, entry);
-            }
-            pointEachNodeToItsReverseComplement(graph);
-
-            //Create all of the edges.
-            for (size_t i = 0; i < edgeStartingNodeNames.size(); ++i)
-            {
-                QString node1Name = edgeStartingNodeNames[i];
-                QString node2Name = edgeEndingNodeNames[i];
-                int overlap = edgeOverlaps[i];
-                graph.createDeBruijnEdge(node1Name, node2Name, overlap, EXACT_OVERLAP);
-            }
+            createNamedEdges(graph, edges, EXACT_OVERLAP);
         }
 
         if (graph.m_deBruijnGraphNodes.empty())
@@ -938,22 +910,28 @@ class AsqgAssemblyGraphBuilder : public AssemblyGraphBuilder {
 class TrinityAssemblyGraphBuilder : public AssemblyGraphBuilder {
     using AssemblyGraphBuilder::AssemblyGraphBuilder;
 
+    // The position of the '_' after the component number (e.g. "c0_") in a
+    // Trinity name, or npos if there is none
+    [[nodiscard]] static size_t findComponentEnd(std::string_view name) {
+        for (size_t c = name.find('c'); c != std::string_view::npos; c = name.find('c', c + 1)) {
+            size_t end = c + 1;
+            while (end < name.size() && name[end] >= '0' && name[end] <= '9')
+                ++end;
+            if (end > c + 1 && end < name.size() && name[end] == '_')
+                return end;
+        }
+        return std::string_view::npos;
+    }
+
     bool build(AssemblyGraph &graph) override {
         graph.m_graphFileType = TRINITY;
         graph.m_filename = fileName_;
         graph.m_depthTag = "";
 
-        std::vector<QString> names;
-        std::vector<QByteArray> sequences;
-        utils::readFastaFile(fileName_, &names, &sequences);
-
-        std::vector<QString> edgeStartingNodeNames;
-        std::vector<QString> edgeEndingNodeNames;
-
-        for (size_t i = 0; i < names.size(); ++i) {
-            QString name = names[i];
-            Sequence sequence{sequences[i]};
+        std::vector<std::pair<DeBruijnNode *, DeBruijnNode *>> edges;
+        std::string nodeName;
 
+        bool opened = utils::readFastxSequences(fileName_, [&](std::string_view name, const Sequence &sequence) {
             //The header can come in a few different formats:
             // TR1|c0_g1_i1 len=280 path=[274:0-228 275:229-279] [-1, 274, 275, -2]
             // TRINITY_DN31_c1_g1_i1 len=301 path=[279:0-300] [-1, 279, -2]
@@ -966,100 +944,84 @@ class TrinityAssemblyGraphBuilder : public AssemblyGraphBuilder {
             //in the Trinity.fasta file.  If the node name begins with "TRINITY_DN"
             //or "TRINITY_GG", "TR" or "GG", then that will be trimmed off.
 
-            if (name.length() < 4)
+            if (name.size() < 4)
                 throw "load error";
 
-            int componentStartIndex = name.indexOf(QRegularExpression("c\\d+_"));
-            int componentEndIndex = name.indexOf("_", componentStartIndex);
-
-            if (componentStartIndex < 0 || componentEndIndex < 0)
+            size_t componentEndIndex = findComponentEnd(name);
+            if (componentEndIndex == std::string_view::npos)
                 throw "load error";
 
-            QString component = name.left(componentEndIndex);
-            if (component.startsWith("TRINITY_DN") || component.startsWith("TRINITY_GG"))
-                component = component.remove(0, 10);
-            else if (component.startsWith("TR") || component.startsWith("GG"))
-                component = component.remove(0, 2);
+            std::string_view component = name.substr(0, componentEndIndex);
+            if (startsWith(component, "TRINITY_DN") || startsWith(component, "TRINITY_GG"))
+                component.remove_prefix(10);
+            else if (startsWith(component, "TR") || startsWith(component, "GG"))
+                component.remove_prefix(2);
 
-            if (component.length() < 2)
+            if (component.size() < 2)
                 throw "load error";
 
-            int pathStartIndex = name.indexOf("path=[") + 6;
-            int pathEndIndex = name.indexOf("]", pathStartIndex);
-            if (pathStartIndex < 0 || pathEndIndex < 0)
+            size_t pathStartIndex = name.find("path=[");
+            if (pathStartIndex == std::string_view::npos)
                 throw "load error";
-            int pathLength = pathEndIndex - pathStartIndex;
-            QString path = name.mid(pathStartIndex, pathLength);
-            if (path.size() == 0)
+            pathStartIndex += 6;
+            size_t pathEndIndex = name.find(']', pathStartIndex);
+            if (pathEndIndex == std::string_view::npos)
+                throw "load error";
+            std::string_view path = name.substr(pathStartIndex, pathEndIndex - pathStartIndex);
+            if (path.empty())
                 throw "load error";
-
-            QStringList pathParts = path.split(" ");
 
             //Each path part is a node
-            QString previousNodeName;
-            for (int i = 0; i < pathParts.length(); ++i) {
-                const QString& pathPart = pathParts.at(i);
-                QStringList nodeParts = pathPart.split(":");
-                if (nodeParts.size() < 2)
+            DeBruijnNode *previousNode = nullptr;
+            utils::forEachPart(path, ' ', [&](std::string_view pathPart) {
+                std::string_view nodeParts[2];
+                if (utils::splitInto(pathPart, ':', nodeParts, 2) < 2)
                     throw "load error";
 
                 //Most node numbers will be formatted simply as the number, but some
                 //(I don't know why) have '@' and the start and '@!' at the end.  In
                 //these cases, we must strip those extra characters off.
-                QString nodeNumberString = nodeParts.at(0);
-                if (nodeNumberString.at(0) == '@')
-                    nodeNumberString = nodeNumberString.mid(1, nodeNumberString.length() - 3);
+                std::string_view nodeNumberString = nodeParts[0];
+                if (startsWith(nodeNumberString, "@"))
+                    nodeNumberString = nodeNumberString.substr(1, nodeNumberString.size() >= 3 ?
+                                                                  nodeNumberString.size() - 3 :
+                                                                  std::string_view::npos);
 
-                QString nodeName = component + "_" + nodeNumberString + "+";
+                nodeName.assign(component).append("_").append(nodeNumberString).append("+");
 
                 //If the node doesn't yet exist, make it now.
-                if (!graph.m_deBruijnGraphNodes.count(nodeName.toStdString())) {
-                    const QString& nodeRange = nodeParts.at(1);
-                    QStringList nodeRangeParts = nodeRange.split("-");
-
-                    if (nodeRangeParts.size() < 2)
+                DeBruijnNode *node;
+                auto existing = graph.m_deBruijnGraphNodes.find(nodeName);
+                if (existing != graph.m_deBruijnGraphNodes.end())
+                    node = *existing;
+                else {
+                    std::string_view nodeRangeParts[2];
+                    if (utils::splitInto(nodeParts[1], '-', nodeRangeParts, 2) < 2)
                         throw "load error";
 
-                    int nodeRangeStart = nodeRangeParts.at(0).toInt();
-                    int nodeRangeEnd = nodeRangeParts.at(1).toInt();
+                    int nodeRangeStart = utils::toInt(nodeRangeParts[0]);
+                    int nodeRangeEnd = utils::toInt(nodeRangeParts[1]);
 
-                    Sequence nodeSequence = sequence.Subseq(nodeRangeStart, nodeRangeEnd + 1);
-
-                    auto node = new DeBruijnNode(nodeName, 1.0, nodeSequence);
-                    graph.m_deBruijnGraphNodes.emplace(nodeName.toStdString(), node);
+                    node = addNode(graph, nodeName, 1.0, sequence.Subseq(nodeRangeStart, nodeRangeEnd + 1));
                 }
 
                 //Remember to make an edge for the previous node to this one.
-                if (i > 0) {
-                    edgeStartingNodeNames.push_back(previousNodeName);
-                    edgeEndingNodeNames.push_back(nodeName);
-                }
-                previousNodeName = nodeName;
-            }
-        }
+                if (previousNode != nullptr)
+                    edges.emplace_back(previousNode, node);
+                previousNode = node;
+            });
+        }, progress_);
+        if (!opened)
+            throw AssemblyGraphError("failed to open file: " + fileName_.toStdString());
 
         //Even though the Trinity.fasta file only contains positive nodes, Bandage
         //expects negative reverse complements nodes, so make them now.
-        {
-            std::vector<DeBruijnNode*> nodes;
-            for (const auto &entry :graph. m_deBruijnGraphNodes) {
-                DeBruijnNode *node = entry;
-                if (!graph.m_deBruijnGraphNodes.count(getOppositeNodeName(node->getName().toStdString())))
-                    nodes.emplace_back(node);
-        }
-
-            for (auto &entry : nodes)
-                makeReverseComplementNodeIfNecessary(graph, entry);
-        }
-        pointEachNodeToItsReverseComplement(graph);
+        makeMissingReverseComplements(graph);
 
         //Create all of the edges.  The createDeBruijnEdge function checks for
         //duplicates, so it's okay if we try to add the same edge multiple times.
-        for (size_t i = 0; i < edgeStartingNodeNames.size(); ++i) {
-            QString node1Name = edgeStartingNodeNames[i];
-            QString node2Name = edgeEndingNodeNames[i];
-            graph.createDeBruijnEdge(node1Name, node2Name);
-        }
+        for (const auto &[node1, node2] : edges)
+            graph.createDeBruijnEdge(node1, node2);
 
         graph.setAllEdgesExactOverlap(0);
 
@@ -1075,13 +1037,11 @@ class LastGraphAssemblyGraphBuilder : public AssemblyGraphBuilder {
 
     // This function takes a normal number string like "5" or "-6" and changes
     // it to "5+" or "6-" - the format of Bandage node names.
-    [[nodiscard]] static QString convertNormalNumberStringToBandageNodeName(QString number) {
-        if (number.at(0) == '-') {
-            number.remove(0, 1);
-            return number + "-";
-        }
+    [[nodiscard]] static std::string convertNormalNumberStringToBandageNodeName(std::string_view number) {
+        if (startsWith(number, "-"))
+            return std::string(number.substr(1)) + '-';
 
-        return number + "+";
+        return std::string(number) + '+';
     }
 
     bool build(AssemblyGraph &graph) override {
@@ -1090,70 +1050,62 @@ class LastGraphAssemblyGraphBuilder : public AssemblyGraphBuilder {
         graph.m_depthTag = "KC";
 
         bool firstLine = true;
-        QFile inputFile(fileName_);
-        if (inputFile.open(QIODevice::ReadOnly)) {
-            QTextStream in(&inputFile);
-            while (!in.atEnd()) {
-                QString line = in.readLine();
-
+        utils::LineReader in(fileName_, progress_);
+        if (in.isOpen()) {
+            std::string_view line;
+            std::string_view fields[4];
+            while (in.nextLine(line)) {
                 if (firstLine) {
-                    QStringList firstLineParts = line.split(QRegularExpression("\\s+"));
-                    if (firstLineParts.size() > 2)
-                        graph.m_kmer = firstLineParts[2].toInt();
+                    if (utils::splitWords(line, fields, 3) > 2)
+                        graph.m_kmer = utils::toInt(fields[2]);
                     firstLine = false;
                 }
 
-                if (line.startsWith("NODE")) {
-                    QStringList nodeDetails = line.split(QRegularExpression("\\s+"));
-
-                    if (nodeDetails.size() < 4)
+                if (startsWith(line, "NODE")) {
+                    if (utils::splitWords(line, fields, 4) < 4)
                         throw "load error";
 
-                    const QString& nodeName = nodeDetails.at(1);
-                    QString posNodeName = nodeName + "+";
-                    QString negNodeName = nodeName + "-";
+                    std::string posNodeName = std::string(fields[1]) + '+';
+                    std::string negNodeName = std::string(fields[1]) + '-';
 
-                    int nodeLength = nodeDetails.at(2).toInt();
+                    int nodeLength = utils::toInt(fields[2]);
 
                     double nodeDepth;
                     if (nodeLength > 0)
-                        nodeDepth = double(nodeDetails.at(3).toInt()) / nodeLength; //IS THIS COLUMN ($COV_SHORT1) THE BEST ONE TO USE?
+                        nodeDepth = double(utils::toInt(fields[3])) / nodeLength; //IS THIS COLUMN ($COV_SHORT1) THE BEST ONE TO USE?
                     else
-                        nodeDepth = double(nodeDetails.at(3).toInt());
+                        nodeDepth = double(utils::toInt(fields[3]));
 
-                    Sequence sequence{in.readLine().toLocal8Bit()};
-                    Sequence revCompSequence{in.readLine().toLocal8Bit()};
+                    // The fields are only valid until the next line is read
+                    std::string_view sequenceLine;
+                    Sequence sequence{in.nextLine(sequenceLine) ? sequenceLine : std::string_view()};
+                    Sequence revCompSequence{in.nextLine(sequenceLine) ? sequenceLine : std::string_view()};
 
                     if (sequence.GetReverseComplement() != revCompSequence) {
                         throw AssemblyGraphError{"Invalid reverse-complement sequence in file."};
                     }
 
-                    auto node = new DeBruijnNode(posNodeName, nodeDepth, sequence);
-                    auto reverseComplementNode = new DeBruijnNode(negNodeName, nodeDepth, revCompSequence);
+                    auto node = addNode(graph, posNodeName, nodeDepth, sequence);
+                    auto reverseComplementNode = addNode(graph, negNodeName, nodeDepth, revCompSequence);
                     node->setReverseComplement(reverseComplementNode);
                     reverseComplementNode->setReverseComplement(node);
-                    graph.m_deBruijnGraphNodes.emplace(posNodeName.toStdString(), node);
-                    graph.m_deBruijnGraphNodes.emplace(negNodeName.toStdString(), reverseComplementNode);
                 }
 
                 //ARC lines contain edges.
-                else if (line.startsWith("ARC")) {
-                    QStringList arcDetails = line.split(QRegularExpression("\\s+"));
-
-                    if (arcDetails.size() < 3)
+                else if (startsWith(line, "ARC")) {
+                    if (utils::splitWords(line, fields, 3) < 3)
                         throw "load error";
 
-                    QString node1Name = convertNormalNumberStringToBandageNodeName(arcDetails.at(1));
-                    QString node2Name = convertNormalNumberStringToBandageNodeName(arcDetails.at(2));
-
-                    graph.createDeBruijnEdge(node1Name, node2Name);
+                    auto node1 = graph.m_deBruijnGraphNodes.find(convertNormalNumberStringToBandageNodeName(fields[1]));
+                    auto node2 = graph.m_deBruijnGraphNodes.find(convertNormalNumberStringToBandageNodeName(fields[2]));
+                    if (node1 != graph.m_deBruijnGraphNodes.end() && node2 != graph.m_deBruijnGraphNodes.end())
+                        graph.createDeBruijnEdge(*node1, *node2);
                 }
 
                 //NR lines occur after ARC lines, so we can quit looking when we see one.
-                else if (line.startsWith("NR"))
+                else if (startsWith(line, "NR"))
                     break;
             }
-            inputFile.close();
 
             graph.setAllEdgesExactOverlap(0);
         }
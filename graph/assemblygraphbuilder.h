@@ -19,6 +19,7 @@
 
 #include "assemblygraph.h"
 #include <QString>
+#include <functional>
 #include <utility>
 
 class AssemblyGraphBuilder {
@@ -31,12 +32,17 @@ class AssemblyGraphBuilder {
     [[nodiscard]] bool hasCustomLables() const { return hasCustomLabels_; }
     [[nodiscard]] bool hasCustomColours() const { return hasCustomColours_; }
     [[nodiscard]] bool hasComplexOverlaps() const { return hasComplexOverlaps_; }
+
+    // Called from the building thread with the percentage of the file read
+    // so far, by the builders that can tell
+    void setProgressCallback(std::function<void(int percent)> progress) { progress_ = std::move(progress); }
     
   protected:
     explicit AssemblyGraphBuilder(QString fileName)
             : fileName_(std::move(fileName)) {}
 
     QString fileName_;
+    std::function<void(int percent)> progress_;
     bool hasCustomLabels_ = false;
     bool hasCustomColours_ = false;
     bool hasComplexOverlaps_ = false;
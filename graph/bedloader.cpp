@@ -17,126 +17,212 @@
 
 #include "bedloader.hpp"
 
-#include <exception>
-#include <ostream>
-#include <sstream>
+#include <QtConcurrent>
 
-#include <csv/csv.hpp>
+#include <algorithm>
+#include <charconv>
+#include <exception>
+#include <fstream>
+#include <stdexcept>
+#include <thread>
 
 namespace bed {
 
-std::vector<int64_t> parseIntArray(const std::string &intArrayString) {
-    std::stringstream ss{intArrayString};
-    std::string intString;
+// Size of the chunks of whole lines that are parsed by a single task
+static constexpr size_t CHUNK_SIZE = 1 << 20;
+
+static std::string_view trimLineEnd(std::string_view line) {
+    if (!line.empty() && line.back() == '\r')
+        line.remove_suffix(1);
+    return line;
+}
+
+template<typename T>
+static bool parseInt(std::string_view str, T &value) {
+    auto res = std::from_chars(str.data(), str.data() + str.size(), value);
+    return res.ec == std::errc() && res.ptr == str.data() + str.size();
+}
+
+template<typename T>
+static T parseMandatoryInt(std::string_view str, const char *column) {
+    T value;
+    if (!parseInt(str, value))
+        throw std::logic_error(std::string("Invalid ") + column + " value: " + std::string(str));
+    return value;
+}
+
+std::vector<int64_t> parseIntArray(std::string_view intArrayString) {
     std::vector<int64_t> res;
-    while (std::getline(ss, intString, ',')) {
-        if (intString.empty()) {
+    while (!intArrayString.empty()) {
+        size_t comma = intArrayString.find(',');
+        auto intString = intArrayString.substr(0, comma);
+        if (intString.empty())
             break;
-        }
-        res.push_back(std::stoll(intString));
+        res.push_back(parseMandatoryInt<int64_t>(intString, "integer list"));
+        if (comma == std::string_view::npos)
+            break;
+        intArrayString.remove_prefix(comma + 1);
     }
     return res;
 }
 
-std::vector<Line> load(const std::filesystem::path &path) {
-    csv::CSVFormat format;
-    format.delimiter('\t')
-          .quote('"')
-          .no_header();  // Parse TSVs without a header row
-    format.column_names({
-            "chrom", "chromStart", "chromEnd",
-            "name", "score", "strand",
-            "thickStart", "thinkEnd",
-            "itemRgb", "blockCount",
-            "blockSizes", "blockStarts"
-        });
-    csv::CSVReader csvReader(path.native(), format);
-
-    csv::CSVRow row;
-    std::vector<Line> res;
-    while (csvReader.read_row(row)) {
-        // At least 3 columns are mandatory
-        if (row.size() < 3)
-            throw std::logic_error("Mandatory columns were not found");
+bool parseLine(std::string_view line, Line &bedLine) {
+    line = trimLineEnd(line);
+    if (line.empty() || line.front() == '#' ||
+        line.substr(0, 5) == "track" || line.substr(0, 7) == "browser")
+        return false;
+
+    // Split the line into (at most 12) tab-separated columns by hand
+    std::string_view cols[12];
+    size_t colCount = 0;
+    for (size_t pos = 0; colCount < 12; ) {
+        size_t tab = line.find('\t', pos);
+        cols[colCount++] = line.substr(pos, tab == std::string_view::npos ? tab : tab - pos);
+        if (tab == std::string_view::npos)
+            break;
+        pos = tab + 1;
+    }
 
-        Line bedLine;
-        std::string itemRgbString = "0";
-        int64_t blockCount = 0;
-        std::string blockSizesString;
-        std::string blockStartsString;
-        for (size_t i = 0; i < row.size(); ++i) {
-            auto cell = row[i];
-            switch (i) {
-            default:
-                break;
-            case 0:
-                bedLine.chrom = cell.get();
-                break;
-            case 1:
-                bedLine.chromStart = cell.get<int64_t>();
-                break;
-            case 2:
-                bedLine.chromEnd = cell.get<int64_t>();
-                break;
-            case 3:
-                bedLine.name = cell.get();
-                break;
-            case 4:
-                bedLine.score = cell.is_int() ? cell.get<int>() : 0;
-                break;
-            case 5:
-                bedLine.strand = Strand{cell.get()[0]};
-                break;
-            case 6:
-                bedLine.thickStart = cell.get<int64_t>();
-                break;
-            case 7:
-                bedLine.thickEnd = cell.get<int64_t>();
-                break;
-            case 8:
-                itemRgbString = cell.get();
-                break;
-            case 9:
-                blockCount = cell.get<int64_t>();
-                break;
-            case 10:
-                blockSizesString = cell.get();
-                break;
-            case 11:
-                blockStartsString = cell.get();
-                break;
-            }
+    // At least 3 columns are mandatory
+    if (colCount < 3)
+        throw std::logic_error("Mandatory columns were not found");
+
+    bedLine = Line{};
+    bedLine.chrom = cols[0];
+    bedLine.chromStart = parseMandatoryInt<int64_t>(cols[1], "chromStart");
+    bedLine.chromEnd = parseMandatoryInt<int64_t>(cols[2], "chromEnd");
+    if (colCount > 3)
+        bedLine.name = cols[3];
+    if (colCount > 4 && !parseInt(cols[4], bedLine.score))
+        bedLine.score = 0;
+    if (colCount > 5 && !cols[5].empty())
+        bedLine.strand = Strand{cols[5][0]};
+    if (colCount > 6)
+        bedLine.thickStart = parseMandatoryInt<int64_t>(cols[6], "thickStart");
+    if (colCount > 7)
+        bedLine.thickEnd = parseMandatoryInt<int64_t>(cols[7], "thickEnd");
+
+    if (bedLine.thickStart == -1 || bedLine.thickEnd == -1) {
+        bedLine.thickStart = bedLine.chromStart;
+        bedLine.thickEnd = bedLine.chromEnd;
+    }
+
+    std::string_view itemRgbString = colCount > 8 ? cols[8] : "0";
+    if (itemRgbString != "0") {
+        auto rgbArray = parseIntArray(itemRgbString);
+        if (rgbArray.size() < 3)
+            throw std::logic_error("Invalid itemRgb value: " + std::string(itemRgbString));
+        bedLine.itemRgb.r = rgbArray[0];
+        bedLine.itemRgb.g = rgbArray[1];
+        bedLine.itemRgb.b = rgbArray[2];
+    } else {
+        // Lines are parsed concurrently, so derive the "random" colour from
+        // the line itself rather than from a shared generator.
+        size_t hash = std::hash<std::string_view>{}(line);
+        bedLine.itemRgb.r = hash & 0xFF;
+        bedLine.itemRgb.g = (hash >> 8) & 0xFF;
+        bedLine.itemRgb.b = (hash >> 16) & 0xFF;
+    }
+
+    int64_t blockCount = colCount > 9 ? parseMandatoryInt<int64_t>(cols[9], "blockCount") : 0;
+    if (blockCount != 0) {
+        auto blockSizes = parseIntArray(colCount > 10 ? cols[10] : "");
+        auto blockStarts = parseIntArray(colCount > 11 ? cols[11] : "");
+        if (blockCount < 0 || blockSizes.size() < size_t(blockCount) || blockStarts.size() < size_t(blockCount))
+            throw std::logic_error("Block lists are shorter than blockCount");
+        bedLine.blocks.reserve(blockCount);
+        for (int64_t i = 0; i < blockCount; i++) {
+            auto blockStart = bedLine.chromStart + blockStarts[i];
+            auto blockEnd = blockStart + blockSizes[i];
+            bedLine.blocks.push_back(Block{.start = blockStart, .end = blockEnd});
         }
+    }
+
+    return true;
+}
 
-        if (bedLine.thickStart == -1 || bedLine.thickEnd == -1) {
-            bedLine.thickStart = bedLine.chromStart;
-            bedLine.thickEnd = bedLine.chromEnd;
+namespace {
+struct Chunk {
+    std::string text;
+    std::vector<Line> lines;
+    std::exception_ptr error;
+};
+}
+
+static void parseChunk(Chunk &chunk) {
+    try {
+        std::string_view text = chunk.text;
+        Line bedLine;
+        while (!text.empty()) {
+            size_t eol = text.find('\n');
+            if (parseLine(text.substr(0, eol), bedLine))
+                chunk.lines.emplace_back(std::move(bedLine));
+            if (eol == std::string_view::npos)
+                break;
+            text.remove_prefix(eol + 1);
         }
+    } catch (...) {
+        chunk.error = std::current_exception();
+    }
+    chunk.text = std::string();
+}
 
-        {
-            std::vector<int64_t> rgbArray;
-            if (itemRgbString != "0") {
-                rgbArray = parseIntArray(itemRgbString);
-            } else {
-                rgbArray = { rand() & 0xFF, rand() & 0xFF, rand() & 0xFF };
+void load(const std::filesystem::path &path,
+          const LinesCallback &onLines,
+          const ProgressCallback &onProgress) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in)
+        throw std::logic_error("Cannot open file: " + path.string());
+
+    uint64_t totalBytes = std::filesystem::file_size(path), bytesRead = 0;
+    size_t batchSize = std::max(1u, std::thread::hardware_concurrency());
+
+    std::string carry;
+    std::vector<Chunk> batch;
+    while (in) {
+        // Read a batch of chunks, each ending at a line boundary. The
+        // incomplete line at the end of a chunk is carried over to the next one.
+        batch.clear();
+        while (batch.size() < batchSize && in) {
+            Chunk &chunk = batch.emplace_back();
+            chunk.text = std::move(carry);
+            size_t eol = std::string::npos;
+            do {
+                size_t prefix = chunk.text.size();
+                chunk.text.resize(prefix + CHUNK_SIZE);
+                in.read(chunk.text.data() + prefix, CHUNK_SIZE);
+                size_t read = in.gcount();
+                bytesRead += read;
+                chunk.text.resize(prefix + read);
+                eol = chunk.text.rfind('\n');
+            } while (in && eol == std::string::npos);
+
+            carry.clear();
+            if (in) {
+                carry.assign(chunk.text, eol + 1);
+                chunk.text.resize(eol + 1);
             }
-            bedLine.itemRgb.r = rgbArray[0];
-            bedLine.itemRgb.g = rgbArray[1];
-            bedLine.itemRgb.b = rgbArray[2];
         }
 
-        if (blockCount != 0) {
-            auto blockSizes = parseIntArray(blockSizesString);
-            auto blockStarts = parseIntArray(blockStartsString);
-            for (int i = 0; i < blockCount; i++) {
-                auto blockStart = bedLine.chromStart + blockStarts[i];
-                auto blockEnd = blockStart + blockSizes[i];
-                bedLine.blocks.push_back(Block{.start = blockStart, .end = blockEnd});
-            }
+        QtConcurrent::blockingMap(batch, parseChunk);
+
+        for (auto &chunk : batch) {
+            if (chunk.error)
+                std::rethrow_exception(chunk.error);
+            onLines(std::move(chunk.lines));
         }
-        res.emplace_back(bedLine);
+
+        if (onProgress)
+            onProgress(bytesRead, totalBytes);
     }
+}
 
+std::vector<Line> load(const std::filesystem::path &path) {
+    std::vector<Line> res;
+    load(path, [&](std::vector<Line> &&lines) {
+        res.insert(res.end(),
+                   std::make_move_iterator(lines.begin()), std::make_move_iterator(lines.end()));
+    });
     return res;
 }
 
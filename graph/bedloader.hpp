@@ -17,9 +17,12 @@
 
 #pragma once
 
+#include <cstdint>
+#include <filesystem>
+#include <functional>
 #include <string>
+#include <string_view>
 #include <vector>
-#include <filesystem>
 
 #include <QColor>
 
@@ -58,7 +61,22 @@ struct Line {
     std::vector<Block> blocks{};
 };
 
-std::vector<int64_t> parseIntArray(const std::string &intArrayString);
+std::vector<int64_t> parseIntArray(std::string_view intArrayString);
+
+// Parses a single (tab-separated) BED line into bedLine. Returns false for
+// lines that do not hold a feature (empty lines, comments, track and browser
+// lines). Throws std::logic_error on malformed lines.
+bool parseLine(std::string_view line, Line &bedLine);
+
+using LinesCallback = std::function<void(std::vector<Line> &&lines)>;
+using ProgressCallback = std::function<void(uint64_t bytesRead, uint64_t totalBytes)>;
+
+// Streams the file in large chunks of whole lines which are parsed in
+// parallel. The parsed lines are passed to onLines batch by batch, in file
+// order, from the calling thread, so the whole file is never held in memory.
+void load(const std::filesystem::path &path,
+          const LinesCallback &onLines,
+          const ProgressCallback &onProgress = {});
 
 std::vector<Line> load(const std::filesystem::path &path);
 
@@ -0,0 +1,217 @@
+// Copyright 2022 Anton Korobeynikov
+
+// This file is part of Bandage
+
+// Bandage is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// Bandage is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "bufferedwriter.h"
+
+#include "seq/sequence.hpp"
+
+#include <QByteArray>
+#include <QIODevice>
+#include <QThread>
+#include <QtConcurrent>
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <limits>
+
+#include <zlib.h>
+
+namespace utils {
+    BufferedWriter::BufferedWriter(QIODevice *device, size_t capacity)
+        : m_device(device), m_buffer(std::max(capacity, size_t(64))) {}
+
+    BufferedWriter::~BufferedWriter() {
+        flush();
+    }
+
+    BufferedWriter &BufferedWriter::operator<<(QStringView str) {
+        // Names and tags are nearly always ASCII, which needs no conversion
+        const QChar *chars = str.constData();
+        size_t size = size_t(str.size());
+        if (std::all_of(chars, chars + size, [](QChar c) { return c.unicode() < 0x80; })) {
+            reserve(size);
+            for (size_t i = 0; i < size; ++i)
+                m_buffer[m_size + i] = char(chars[i].unicode());
+            m_size += size;
+            return *this;
+        }
+
+        return *this << str.toUtf8();
+    }
+
+    BufferedWriter &BufferedWriter::operator<<(long long value) {
+        reserve(24);
+        auto res = std::to_chars(m_buffer.data() + m_size, m_buffer.data() + m_buffer.size(), value);
+        m_size = res.ptr - m_buffer.data();
+        return *this;
+    }
+
+    BufferedWriter &BufferedWriter::operator<<(unsigned long long value) {
+        reserve(24);
+        auto res = std::to_chars(m_buffer.data() + m_size, m_buffer.data() + m_buffer.size(), value);
+        m_size = res.ptr - m_buffer.data();
+        return *this;
+    }
+
+    BufferedWriter &BufferedWriter::operator<<(double value) {
+        // The same text as QByteArray::number, which the exporters used
+        // before: "%g", with a decimal point in every locale
+        QByteArray number = QByteArray::number(value);
+        return write(number.constData(), size_t(number.size()));
+    }
+
+    BufferedWriter &BufferedWriter::write(const char *data, size_t size) {
+        reserve(size);
+        memcpy(m_buffer.data() + m_size, data, size);
+        m_size += size;
+        return *this;
+    }
+
+    BufferedWriter &BufferedWriter::writeSequence(const Sequence &sequence, size_t lineWidth) {
+        // Decode in chunks that hold whole lines, so that huge sequences do not
+        // need a huge buffer
+        const size_t length = sequence.size();
+        const size_t chunkSize = lineWidth ? lineWidth * 4096 : size_t(1) << 20;
+        for (size_t pos = 0; pos < length; pos += chunkSize) {
+            size_t size = std::min(chunkSize, length - pos);
+            Sequence chunk = sequence.Subseq(pos, pos + size);
+            size_t lines = lineWidth ? size / lineWidth : 0;
+            reserve(size + lines);
+
+            // Decode behind the space needed for the newlines, then move the
+            // lines into place. The write position never passes the read one.
+            char *out = m_buffer.data() + m_size;
+            const char *in = out + lines;
+            chunk.decode(out + lines);
+            for (size_t line = 0; line < lines; ++line, in += lineWidth) {
+                memmove(out, in, lineWidth);
+                out += lineWidth;
+                *out++ = '\n';
+            }
+            memmove(out, in, size - lines * lineWidth);
+            m_size += size + lines;
+        }
+        return *this;
+    }
+
+    BufferedWriter &BufferedWriter::writeSequenceLines(const Sequence &sequence, size_t lineWidth) {
+        writeSequence(sequence, lineWidth);
+        if (sequence.size() == 0 || lineWidth == 0 || sequence.size() % lineWidth != 0)
+            *this << '\n';
+        return *this;
+    }
+
+    BufferedWriter &BufferedWriter::writeSequenceLines(const QByteArray &sequence, size_t lineWidth) {
+        const char *data = sequence.constData();
+        size_t length = size_t(sequence.size());
+        size_t pos = 0;
+        while (lineWidth > 0 && length - pos > lineWidth) {
+            write(data + pos, lineWidth) << '\n';
+            pos += lineWidth;
+        }
+        return write(data + pos, length - pos) << '\n';
+    }
+
+    bool BufferedWriter::flush() {
+        if (m_device && m_size > 0) {
+            m_ok &= m_device->write(m_buffer.data(), qint64(m_size)) == qint64(m_size);
+            m_size = 0;
+        }
+        return m_ok;
+    }
+
+    void BufferedWriter::makeRoom(size_t size) {
+        if (m_device)
+            flush();
+        if (m_size + size > m_buffer.size())
+            m_buffer.resize(std::max(m_buffer.size() * 2, m_size + size));
+    }
+
+    //Compresses the data as a complete gzip member. Concatenated members form a
+    //valid gzip file, so chunks of the output can be compressed independently.
+    static QByteArray gzipChunk(const char *data, size_t size) {
+        z_stream stream{};
+        if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+            return {};
+
+        //zlib counts bytes in uInt, so the input is given in slices and the
+        //output is taken a buffer at a time
+        const size_t maxSlice = std::numeric_limits<uInt>::max();
+        std::vector<char> buffer(1 << 20);
+        QByteArray compressed;
+        size_t remaining = size;
+        int result;
+        do {
+            if (stream.avail_in == 0 && remaining > 0) {
+                size_t slice = std::min(remaining, maxSlice);
+                stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data + (size - remaining)));
+                stream.avail_in = uInt(slice);
+                remaining -= slice;
+            }
+            stream.next_out = reinterpret_cast<Bytef *>(buffer.data());
+            stream.avail_out = uInt(buffer.size());
+            result = deflate(&stream, remaining == 0 ? Z_FINISH : Z_NO_FLUSH);
+            compressed.append(buffer.data(), qsizetype(buffer.size() - stream.avail_out));
+        } while (result == Z_OK);
+        deflateEnd(&stream);
+
+        return result == Z_STREAM_END ? compressed : QByteArray();
+    }
+
+    bool writeRecordsInParallel(QIODevice *device, size_t recordCount, const RecordWriter &writeRecord,
+                                bool compress, const std::function<bool()> &cancelled) {
+        struct Chunk {
+            size_t begin, end;
+            BufferedWriter out{nullptr, 1 << 16};
+            QByteArray compressed;
+        };
+
+        const size_t chunkSize = 1024;
+        const size_t batchSize = chunkSize * 4 * std::max(QThread::idealThreadCount(), 1);
+        for (size_t batchBegin = 0; batchBegin < recordCount; batchBegin += batchSize) {
+            if (cancelled && cancelled())
+                return false;
+
+            size_t batchEnd = std::min(batchBegin + batchSize, recordCount);
+            std::vector<Chunk> chunks((batchEnd - batchBegin + chunkSize - 1) / chunkSize);
+            for (size_t i = 0; i < chunks.size(); ++i) {
+                chunks[i].begin = batchBegin + i * chunkSize;
+                chunks[i].end = std::min(chunks[i].begin + chunkSize, batchEnd);
+            }
+
+            QtConcurrent::blockingMap(chunks, [&](Chunk &chunk) {
+                for (size_t i = chunk.begin; i < chunk.end; ++i)
+                    writeRecord(chunk.out, i);
+                if (compress)
+                    chunk.compressed = gzipChunk(chunk.out.data(), chunk.out.size());
+            });
+
+            for (const auto &chunk : chunks) {
+                if (compress && chunk.compressed.isEmpty())
+                    return false;
+
+                qint64 size = compress ? chunk.compressed.size() : qint64(chunk.out.size());
+                const char *data = compress ? chunk.compressed.constData() : chunk.out.data();
+                if (device->write(data, size) != size)
+                    return false;
+            }
+        }
+
+        return true;
+    }
+}
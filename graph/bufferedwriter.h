@@ -0,0 +1,105 @@
+// Copyright 2022 Anton Korobeynikov
+
+// This file is part of Bandage
+
+// Bandage is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// Bandage is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+#include <QStringView>
+
+#include <cstddef>
+#include <functional>
+#include <string_view>
+#include <vector>
+
+class QIODevice;
+class Sequence;
+
+namespace utils {
+    // Formats text output straight into a large byte buffer, which is written
+    // to the device whenever it fills up. Numbers are formatted in place, so
+    // writing a record does not allocate. Without a device the buffer just
+    // grows and its contents can be taken with data().
+    class BufferedWriter {
+      public:
+        explicit BufferedWriter(QIODevice *device = nullptr, size_t capacity = 1 << 20);
+        ~BufferedWriter();
+
+        BufferedWriter(const BufferedWriter &) = delete;
+        BufferedWriter &operator=(const BufferedWriter &) = delete;
+
+        BufferedWriter &operator<<(char c) {
+            reserve(1);
+            m_buffer[m_size++] = c;
+            return *this;
+        }
+        BufferedWriter &operator<<(std::string_view str) { return write(str.data(), str.size()); }
+        BufferedWriter &operator<<(const char *str) { return *this << std::string_view(str); }
+        BufferedWriter &operator<<(const QByteArray &str) { return write(str.constData(), size_t(str.size())); }
+        BufferedWriter &operator<<(QStringView str);
+        BufferedWriter &operator<<(int value) { return *this << (long long)value; }
+        BufferedWriter &operator<<(unsigned value) { return *this << (unsigned long long)value; }
+        BufferedWriter &operator<<(long value) { return *this << (long long)value; }
+        BufferedWriter &operator<<(unsigned long value) { return *this << (unsigned long long)value; }
+        BufferedWriter &operator<<(long long value);
+        BufferedWriter &operator<<(unsigned long long value);
+        // Formatted like QString::number(value), i.e. %g with 6 digits
+        BufferedWriter &operator<<(double value);
+
+        BufferedWriter &write(const char *data, size_t size);
+
+        // Decodes the sequence into the buffer. With a line width, a newline
+        // is put after every lineWidth characters.
+        BufferedWriter &writeSequence(const Sequence &sequence, size_t lineWidth = 0);
+        // Writes a newline separated sequence, as in a FASTA file. Like
+        // addNewlinesToSequence, the output always ends in a newline.
+        BufferedWriter &writeSequenceLines(const Sequence &sequence, size_t lineWidth = 70);
+        BufferedWriter &writeSequenceLines(const QByteArray &sequence, size_t lineWidth = 70);
+
+        // Writes out the buffer, returns false if any write failed.
+        bool flush();
+        bool ok() const { return m_ok; }
+
+        const char *data() const { return m_buffer.data(); }
+        size_t size() const { return m_size; }
+        void clear() { m_size = 0; }
+
+      private:
+        // Makes room for size more bytes, flushing or growing the buffer
+        void reserve(size_t size) {
+            if (m_size + size > m_buffer.size())
+                makeRoom(size);
+        }
+        void makeRoom(size_t size);
+
+        QIODevice *m_device;
+        std::vector<char> m_buffer;
+        size_t m_size = 0;
+        bool m_ok = true;
+    };
+
+    using RecordWriter = std::function<void(BufferedWriter &out, size_t record)>;
+
+    // Writes records [0, recordCount) to the device, formatting them in
+    // parallel: the records are split into chunks with a buffer each, and
+    // the chunks are written in record order a batch at a time, so only a
+    // part of the output is in memory. With compress every chunk becomes a
+    // gzip member; concatenated members form a valid gzip file. Returns false
+    // if a write failed, or if cancelled returned true between batches.
+    bool writeRecordsInParallel(QIODevice *device, size_t recordCount, const RecordWriter &writeRecord,
+                                bool compress = false, const std::function<bool()> &cancelled = {});
+}
@@ -0,0 +1,582 @@
+// Copyright 2022 Anton Korobeynikov
+
+// This file is part of Bandage
+
+// Bandage is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// Bandage is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "coarsening.h"
+
+#include "assemblygraph.h"
+#include "debruijnedge.h"
+#include "debruijnnode.h"
+#include "graphicsitemedge.h"
+#include "graphicsitemnode.h"
+
+#include "program/settings.h"
+#include "ui/mygraphicsscene.h"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+
+namespace {
+// Edges between displayed clusters, keyed by one strand of each pair
+using OverviewEdges = phmap::flat_hash_map<uint64_t, std::pair<int, EdgeOverlapType>>;
+
+uint64_t edgeKey(uint32_t from, uint32_t to) {
+    // The reverse complement of from -> to is to^1 -> from^1
+    uint64_t key = uint64_t(from) << 32 | to, rcKey = uint64_t(to ^ 1) << 32 | (from ^ 1);
+    return std::min(key, rcKey);
+}
+
+// Cuts the polyline into consecutive pieces, with lengths proportional to
+// the weights
+std::vector<std::vector<QPointF>> splitPolyline(const std::vector<QPointF> &points,
+                                                const std::vector<double> &weights) {
+    std::vector<double> along(points.size(), 0.0);
+    for (size_t i = 1; i < points.size(); ++i) {
+        QPointF d = points[i] - points[i - 1];
+        along[i] = along[i - 1] + std::sqrt(d.x() * d.x() + d.y() * d.y());
+    }
+    double totalWeight = 0.0;
+    for (double weight : weights)
+        totalWeight += weight;
+
+    auto pointAt = [&](double distance) {
+        auto next = std::lower_bound(along.begin(), along.end(), distance);
+        if (next == along.begin())
+            return points.front();
+        if (next == along.end())
+            return points.back();
+        size_t i = next - along.begin();
+        double segment = along[i] - along[i - 1];
+        double t = segment > 0.0 ? (distance - along[i - 1]) / segment : 0.0;
+        return points[i - 1] + t * (points[i] - points[i - 1]);
+    };
+
+    std::vector<std::vector<QPointF>> pieces;
+    double start = 0.0, weightSoFar = 0.0;
+    for (double weight : weights) {
+        weightSoFar += weight;
+        double end = along.back() * weightSoFar / totalWeight;
+        std::vector<QPointF> piece{pointAt(start)};
+        for (size_t i = 0; i < points.size(); ++i) {
+            if (along[i] > start && along[i] < end)
+                piece.push_back(points[i]);
+        }
+        piece.push_back(pointAt(end));
+        pieces.push_back(std::move(piece));
+        start = end;
+    }
+    return pieces;
+}
+
+// Arms of a bubble are drawn side by side along the whole polyline
+std::vector<std::vector<QPointF>> spreadPolyline(const std::vector<QPointF> &points, size_t count) {
+    QPointF direction = points.back() - points.front();
+    double length = std::sqrt(direction.x() * direction.x() + direction.y() * direction.y());
+    QPointF normal = length > 0.0 ? QPointF(-direction.y(), direction.x()) / length : QPointF(0.0, 1.0);
+    double spacing = 2.0 * g_settings->averageNodeWidth;
+
+    std::vector<std::vector<QPointF>> pieces;
+    for (size_t i = 0; i < count; ++i) {
+        QPointF shift = normal * spacing * (double(i) - double(count - 1) / 2.0);
+        std::vector<QPointF> piece;
+        for (auto point : points)
+            piece.push_back(point + shift);
+        pieces.push_back(std::move(piece));
+    }
+    return pieces;
+}
+
+// Returns the node that was drawn, or nullptr if it already was
+DeBruijnNode *addGraphicsItemNode(DeBruijnNode *node, std::vector<QPointF> points, MyGraphicsScene *scene) {
+    // In single mode only positive nodes are drawn
+    if (!g_settings->doubleMode && node->isNegativeNode()) {
+        node = node->getReverseComplement();
+        std::reverse(points.begin(), points.end());
+    }
+    if (node->hasGraphicsItem())
+        return nullptr;
+
+    auto *graphicsItemNode = new GraphicsItemNode(node, points);
+    node->setGraphicsItemNode(graphicsItemNode);
+    graphicsItemNode->setFlag(QGraphicsItem::ItemIsSelectable);
+    graphicsItemNode->setFlag(QGraphicsItem::ItemIsMovable);
+    graphicsItemNode->setFlag(QGraphicsItem::ItemUsesExtendedStyleOption);
+    graphicsItemNode->setNodeColour(g_settings->nodeColorer->get(graphicsItemNode));
+    scene->addItem(graphicsItemNode);
+    return node;
+}
+
+// Draws the edges of the node that are in the drawn scope
+void addGraphicsItemEdges(DeBruijnNode *node, MyGraphicsScene *scene) {
+    for (auto *edge : node->edges()) {
+        if (!edge->isDrawn() || edge->getGraphicsItemEdge() != nullptr)
+            continue;
+
+        auto *graphicsItemEdge = new GraphicsItemEdge(edge);
+        graphicsItemEdge->setZValue(-1.0);
+        edge->setGraphicsItemEdge(graphicsItemEdge);
+        graphicsItemEdge->setFlag(QGraphicsItem::ItemIsSelectable);
+        scene->addItem(graphicsItemEdge);
+    }
+}
+
+const char *clusterKindName(GraphCoarsening::ClusterKind kind) {
+    switch (kind) {
+        case GraphCoarsening::UNITIG_CLUSTER: return "unitig";
+        case GraphCoarsening::BUBBLE_CLUSTER: return "bubble";
+        case GraphCoarsening::TIP_CLUSTER: return "tip";
+        case GraphCoarsening::SINGLE_NODE: break;
+    }
+    return "node";
+}
+}
+
+GraphCoarsening::GraphCoarsening(const AssemblyGraph &graph)
+    : m_graph(graph) {
+    for (auto *node : m_graph.m_deBruijnGraphNodes) {
+        if (!node->isPositiveNode())
+            continue;
+
+        uint32_t id = uint32_t(m_clusters.size());
+        Cluster &cluster = m_clusters.emplace_back();
+        cluster.node = node;
+        cluster.length = node->getLength();
+        cluster.depth = node->getDepth();
+        m_originalClusters[node] = id;
+        m_active.push_back(id);
+    }
+
+    m_out.resize(2 * m_clusters.size());
+    for (const auto &entry : m_graph.m_deBruijnGraphEdges) {
+        const DeBruijnEdge *edge = entry.second;
+        auto orientedOriginal = [this](const DeBruijnNode *node) {
+            bool reversed = !node->isPositiveNode();
+            return oriented(m_originalClusters.at(reversed ? node->getReverseComplement() : node), reversed);
+        };
+        m_out[orientedOriginal(edge->getStartingNode())].push_back(orientedOriginal(edge->getEndingNode()));
+    }
+    for (auto &successors : m_out) {
+        std::sort(successors.begin(), successors.end());
+        successors.erase(std::unique(successors.begin(), successors.end()), successors.end());
+    }
+}
+
+int GraphCoarsening::coarsen(size_t targetClusters, int maxRounds) {
+    int rounds = 0;
+    while (m_active.size() > targetClusters && rounds < maxRounds && coarsenOnce())
+        ++rounds;
+    return rounds;
+}
+
+uint32_t GraphCoarsening::addCluster(ClusterKind kind, std::vector<Member> members) {
+    uint32_t id = uint32_t(m_clusters.size());
+    Cluster cluster;
+    cluster.kind = kind;
+    cluster.nodeCount = 0;
+
+    double depthSum = 0.0, lengthWeightedDepthSum = 0.0;
+    for (const auto &member : members) {
+        Cluster &child = m_clusters[member.cluster];
+        child.parent = id;
+        child.reversedInParent = member.reversed;
+        cluster.length += child.length;
+        cluster.nodeCount += child.nodeCount;
+        depthSum += child.depth;
+        lengthWeightedDepthSum += child.depth * double(child.length);
+    }
+    cluster.depth = cluster.length > 0 ? lengthWeightedDepthSum / double(cluster.length)
+                                       : depthSum / double(members.size());
+    cluster.members = std::move(members);
+    m_clusters.push_back(std::move(cluster));
+    return id;
+}
+
+bool GraphCoarsening::coarsenOnce() {
+    struct Group {
+        ClusterKind kind;
+        std::vector<Member> members;
+    };
+    std::vector<Group> groups;
+    std::vector<uint8_t> claimed(m_clusters.size(), 0);
+    auto inDegree = [this](uint32_t x) { return m_out[x ^ 1].size(); };
+
+    // Tips: an end with nothing entering and a single edge leaving, into a
+    // node that other edges enter as well.
+    phmap::flat_hash_map<uint32_t, size_t> tipGroups;
+    for (uint32_t c : m_active) {
+        for (bool reversed : {false, true}) {
+            uint32_t x = oriented(c, reversed);
+            if (claimed[c] || inDegree(x) != 0 || m_out[x].size() != 1)
+                continue;
+            uint32_t y = m_out[x].front(), target = y >> 1;
+            if (target == c || inDegree(y) < 2)
+                continue;
+
+            auto [it, inserted] = tipGroups.try_emplace(target, groups.size());
+            if (inserted) {
+                groups.push_back({TIP_CLUSTER, {{target, bool(y & 1)}}});
+                claimed[target] = 1;
+            }
+            Group &group = groups[it->second];
+            bool flipped = bool(y & 1) != group.members.front().reversed;
+            group.members.push_back({c, reversed != flipped});
+            claimed[c] = 1;
+        }
+    }
+
+    // Simple bubbles: two or more arms from the same source to the same sink,
+    // each with a single edge in and a single edge out.
+    std::vector<std::pair<uint32_t, uint32_t>> arms;
+    for (uint32_t c : m_active) {
+        for (bool reversed : {false, true}) {
+            uint32_t x = oriented(c, reversed);
+            if (m_out[x].size() < 2)
+                continue;
+
+            arms.clear();
+            for (uint32_t a : m_out[x]) {
+                if ((a >> 1) == c || claimed[a >> 1] || inDegree(a) != 1 || m_out[a].size() != 1)
+                    continue;
+                uint32_t sink = m_out[a].front();
+                if ((sink >> 1) != (a >> 1))
+                    arms.emplace_back(sink, a);
+            }
+            std::sort(arms.begin(), arms.end());
+
+            for (size_t i = 0, j = 0; i < arms.size(); i = j) {
+                while (j < arms.size() && arms[j].first == arms[i].first)
+                    ++j;
+                if (j - i < 2)
+                    continue;
+
+                // Both strands of one node can be arms of the same bubble
+                std::vector<Member> members;
+                for (size_t k = i; k < j; ++k) {
+                    uint32_t a = arms[k].second;
+                    if (!claimed[a >> 1]) {
+                        claimed[a >> 1] = 1;
+                        members.push_back({a >> 1, bool(a & 1)});
+                    }
+                }
+                if (members.size() >= 2)
+                    groups.push_back({BUBBLE_CLUSTER, std::move(members)});
+                else
+                    claimed[members.front().cluster] = 0;
+            }
+        }
+    }
+
+    // Unitigs among the rest
+    auto next = [&](uint32_t x) {
+        if (m_out[x].size() != 1)
+            return NONE;
+        uint32_t y = m_out[x].front();
+        if ((y >> 1) == (x >> 1) || inDegree(y) != 1 || claimed[y >> 1])
+            return NONE;
+        return y;
+    };
+    std::vector<uint32_t> seen(m_clusters.size(), NONE);
+    for (uint32_t c : m_active) {
+        if (claimed[c])
+            continue;
+
+        // Walk back to the start of the chain. A circular chain starts at c.
+        uint32_t start = oriented(c, false);
+        seen[c] = c;
+        for (uint32_t previous; (previous = next(start ^ 1)) != NONE; ) {
+            previous ^= 1;
+            if (seen[previous >> 1] == c)
+                break;
+            seen[previous >> 1] = c;
+            start = previous;
+        }
+
+        std::vector<Member> members{{start >> 1, bool(start & 1)}};
+        claimed[start >> 1] = 1;
+        for (uint32_t x = start, y; (y = next(x)) != NONE; x = y) {
+            members.push_back({y >> 1, bool(y & 1)});
+            claimed[y >> 1] = 1;
+        }
+        if (members.size() >= 2)
+            groups.push_back({UNITIG_CLUSTER, std::move(members)});
+    }
+
+    if (groups.empty())
+        return false;
+
+    // Group the clusters and contract the edges between them
+    size_t firstNewCluster = m_clusters.size();
+    for (auto &group : groups)
+        addCluster(group.kind, std::move(group.members));
+
+    auto map = [this](uint32_t x) {
+        const Cluster &cluster = m_clusters[x >> 1];
+        if (cluster.parent == NONE)
+            return x;
+        return oriented(cluster.parent, bool(x & 1) != cluster.reversedInParent);
+    };
+    auto sortSuccessors = [this](uint32_t x) {
+        auto &successors = m_out[x];
+        std::sort(successors.begin(), successors.end());
+        successors.erase(std::unique(successors.begin(), successors.end()), successors.end());
+    };
+
+    m_out.resize(2 * m_clusters.size());
+    std::vector<uint32_t> active;
+    for (uint32_t c : m_active) {
+        if (m_clusters[c].parent != NONE)
+            continue;
+        active.push_back(c);
+        for (bool reversed : {false, true}) {
+            uint32_t x = oriented(c, reversed);
+            for (auto &y : m_out[x])
+                y = map(y);
+            sortSuccessors(x);
+        }
+    }
+    for (size_t c = firstNewCluster; c < m_clusters.size(); ++c) {
+        active.push_back(uint32_t(c));
+        for (const auto &member : m_clusters[c].members) {
+            for (bool reversed : {false, true}) {
+                uint32_t x = oriented(member.cluster, reversed), from = map(x);
+                for (uint32_t y : m_out[x]) {
+                    uint32_t to = map(y);
+                    if ((to >> 1) != c)
+                        m_out[from].push_back(to);
+                }
+                std::vector<uint32_t>().swap(m_out[x]);
+            }
+        }
+        sortSuccessors(oriented(uint32_t(c), false));
+        sortSuccessors(oriented(uint32_t(c), true));
+    }
+    m_active.swap(active);
+    return true;
+}
+
+uint32_t GraphCoarsening::displayedClusterOf(const DeBruijnNode *originalNode) const {
+    bool reversed = !originalNode->isPositiveNode();
+    auto it = m_originalClusters.find(reversed ? originalNode->getReverseComplement() : originalNode);
+    if (it == m_originalClusters.end())
+        return NONE;
+
+    uint32_t c = it->second;
+    while (!m_clusters[c].displayed) {
+        reversed ^= m_clusters[c].reversedInParent;
+        c = m_clusters[c].parent;
+        if (c == NONE)
+            return NONE;
+    }
+    return oriented(c, reversed);
+}
+
+QString GraphCoarsening::overviewName(uint32_t orientedCluster) const {
+    const Cluster &cluster = m_clusters[orientedCluster >> 1];
+    bool reversed = orientedCluster & 1;
+    if (cluster.kind == SINGLE_NODE)
+        return reversed ? cluster.node->getReverseComplement()->getName() : cluster.node->getName();
+    return cluster.name + (reversed ? "-" : "+");
+}
+
+DeBruijnNode *GraphCoarsening::addToOverview(uint32_t c) {
+    Cluster &cluster = m_clusters[c];
+    cluster.displayed = true;
+
+    DeBruijnNode *positive, *negative;
+    if (cluster.kind == SINGLE_NODE) {
+        const DeBruijnNode *node = cluster.node, *rc = node->getReverseComplement();
+        positive = new DeBruijnNode(node->getName(), node->getDepth(), node->getSequence(), node->getLength());
+        negative = new DeBruijnNode(rc->getName(), rc->getDepth(), rc->getSequence(), rc->getLength());
+    } else {
+        // Super-nodes have no sequence, only a length
+        if (cluster.name.isEmpty()) {
+            QString name = QString(clusterKindName(cluster.kind)) + "_" + QString::number(c);
+            while (m_graph.m_deBruijnGraphNodes.count((name + "+").toStdString()) ||
+                   m_overview->m_deBruijnGraphNodes.count((name + "+").toStdString()))
+                name += "_";
+            cluster.name = name;
+        }
+        int length = int(std::min<long long>(cluster.length, INT_MAX));
+        positive = new DeBruijnNode(cluster.name + "+", cluster.depth, Sequence(), length);
+        negative = new DeBruijnNode(cluster.name + "-", cluster.depth, Sequence(), length);
+    }
+    positive->setReverseComplement(negative);
+    negative->setReverseComplement(positive);
+
+    for (auto *node : {positive, negative}) {
+        std::string name = node->getName().toStdString();
+        m_overview->m_deBruijnGraphNodes.emplace(name, node);
+        m_overviewClusters[name] = c;
+    }
+    return positive;
+}
+
+void GraphCoarsening::collectOriginalNodes(uint32_t c, std::vector<const DeBruijnNode *> &nodes) const {
+    std::vector<uint32_t> stack{c};
+    while (!stack.empty()) {
+        const Cluster &cluster = m_clusters[stack.back()];
+        stack.pop_back();
+        if (cluster.kind == SINGLE_NODE)
+            nodes.push_back(cluster.node);
+        for (const auto &member : cluster.members)
+            stack.push_back(member.cluster);
+    }
+}
+
+// An edge of the overview for every edge of the original nodes between two
+// displayed clusters. Only edges between original nodes keep their overlap.
+void GraphCoarsening::addOverviewEdges(const std::vector<const DeBruijnNode *> &originalNodes) {
+    OverviewEdges edges;
+    for (const auto *node : originalNodes) {
+        for (const auto *edge : node->edges()) {
+            uint32_t from = displayedClusterOf(edge->getStartingNode()), to = displayedClusterOf(edge->getEndingNode());
+            if (from == NONE || to == NONE)
+                continue;
+            bool exact = m_clusters[from >> 1].kind == SINGLE_NODE && m_clusters[to >> 1].kind == SINGLE_NODE;
+            if ((from >> 1) == (to >> 1) && !exact)
+                continue;
+            edges.try_emplace(edgeKey(from, to),
+                              exact ? edge->getOverlap() : 0,
+                              exact ? edge->getOverlapType() : UNKNOWN_OVERLAP);
+        }
+    }
+    for (const auto &[key, overlap] : edges)
+        m_overview->createDeBruijnEdge(overviewName(uint32_t(key >> 32)), overviewName(uint32_t(key)),
+                                       overlap.first, overlap.second);
+}
+
+QSharedPointer<AssemblyGraph> GraphCoarsening::buildOverview() {
+    m_overview.reset(new AssemblyGraph());
+    m_overviewClusters.clear();
+    for (auto &cluster : m_clusters)
+        cluster.displayed = false;
+
+    for (uint32_t c : m_active)
+        addToOverview(c);
+
+    std::vector<const DeBruijnNode *> originalNodes;
+    for (const auto &cluster : m_clusters) {
+        if (cluster.kind == SINGLE_NODE)
+            originalNodes.push_back(cluster.node);
+    }
+    addOverviewEdges(originalNodes);
+
+    m_overview->m_kmer = m_graph.m_kmer;
+    m_overview->m_graphFileType = m_graph.m_graphFileType;
+    m_overview->m_filename = m_graph.m_filename;
+    m_overview->determineGraphInfo();
+    return m_overview;
+}
+
+uint32_t GraphCoarsening::clusterOf(const DeBruijnNode *overviewNode) const {
+    auto it = m_overviewClusters.find(overviewNode->getName().toStdString());
+    return it == m_overviewClusters.end() ? NONE : it->second;
+}
+
+bool GraphCoarsening::isSuperNode(const DeBruijnNode *overviewNode) const {
+    uint32_t c = clusterOf(overviewNode);
+    return c != NONE && m_clusters[c].kind != SINGLE_NODE;
+}
+
+std::vector<DeBruijnNode *> GraphCoarsening::expand(const QString &superNodeName, MyGraphicsScene *scene) {
+    if (!m_overview)
+        return {};
+
+    auto it = m_overview->m_deBruijnGraphNodes.find(superNodeName.toStdString());
+    if (it == m_overview->m_deBruijnGraphNodes.end())
+        return {};
+    return expand(it.value(), scene);
+}
+
+std::vector<DeBruijnNode *> GraphCoarsening::expand(DeBruijnNode *superNode, MyGraphicsScene *scene) {
+    uint32_t c = clusterOf(superNode);
+    if (c == NONE || m_clusters[c].kind == SINGLE_NODE || !m_clusters[c].displayed)
+        return {};
+
+    // Remember where each strand of the super-node was drawn
+    DeBruijnNode *strands[2] = {superNode->isPositiveNode() ? superNode : superNode->getReverseComplement(), nullptr};
+    strands[1] = strands[0]->getReverseComplement();
+    std::vector<QPointF> drawnAt[2];
+    for (int s = 0; s < 2; ++s) {
+        if (auto *graphicsItemNode = strands[s]->getGraphicsItemNode())
+            drawnAt[s].assign(graphicsItemNode->m_linePoints.begin(), graphicsItemNode->m_linePoints.end());
+    }
+
+    m_overview->deleteNodesAndEdges({strands[0]}, {}, scene);
+    for (const QString &name : {m_clusters[c].name + "+", m_clusters[c].name + "-"})
+        m_overviewClusters.erase(name.toStdString());
+    m_clusters[c].displayed = false;
+
+    const std::vector<Member> members = m_clusters[c].members;
+    std::vector<DeBruijnNode *> added;
+    for (const auto &member : members)
+        added.push_back(addToOverview(member.cluster));
+
+    // The members' edges: between each other and out to the rest of the
+    // overview
+    std::vector<const DeBruijnNode *> originalNodes;
+    collectOriginalNodes(c, originalNodes);
+    addOverviewEdges(originalNodes);
+
+    if (scene == nullptr || (drawnAt[0].empty() && drawnAt[1].empty()))
+        return added;
+
+    // Draw the members where the super-node was: a chain along its line, the
+    // arms of a bubble side by side.
+    double meanDrawnDepth = m_overview->getMeanDepth(true);
+    for (auto *node : added) {
+        double relativeDepth = meanDrawnDepth == 0.0 ? 1.0 : node->getDepth() / meanDrawnDepth;
+        node->setDepthRelativeToMeanDrawnDepth(relativeDepth);
+        node->getReverseComplement()->setDepthRelativeToMeanDrawnDepth(relativeDepth);
+    }
+
+    std::vector<DeBruijnNode *> drawnNodes;
+    std::vector<double> weights;
+    for (const auto &member : members)
+        weights.push_back(std::max(double(m_clusters[member.cluster].length), 1.0));
+    for (int s = 0; s < 2; ++s) {
+        if (drawnAt[s].empty())
+            continue;
+
+        // Along the reverse strand the members come in reverse order
+        std::vector<DeBruijnNode *> nodes;
+        std::vector<double> strandWeights = weights;
+        for (size_t i = 0; i < members.size(); ++i)
+            nodes.push_back(members[i].reversed != bool(s) ? added[i]->getReverseComplement() : added[i]);
+        if (s == 1) {
+            std::reverse(nodes.begin(), nodes.end());
+            std::reverse(strandWeights.begin(), strandWeights.end());
+        }
+
+        auto pieces = m_clusters[c].kind == BUBBLE_CLUSTER ? spreadPolyline(drawnAt[s], nodes.size())
+                                                           : splitPolyline(drawnAt[s], strandWeights);
+        for (size_t i = 0; i < nodes.size(); ++i) {
+            if (auto *drawnNode = addGraphicsItemNode(nodes[i], std::move(pieces[i]), scene))
+                drawnNodes.push_back(drawnNode);
+        }
+    }
+
+    // The drawn flags go through the overview's drawn scope, so that its
+    // drawn nodes and edges include the members
+    m_overview->addDrawnNodes(drawnNodes);
+    for (auto *node : added) {
+        addGraphicsItemEdges(node, scene);
+        addGraphicsItemEdges(node->getReverseComplement(), scene);
+    }
+
+    return added;
+}
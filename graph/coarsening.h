@@ -0,0 +1,130 @@
+// Copyright 2022 Anton Korobeynikov
+
+// This file is part of Bandage
+
+// Bandage is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// Bandage is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "parallel_hashmap/phmap.h"
+
+#include <QSharedPointer>
+#include <QString>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class AssemblyGraph;
+class DeBruijnNode;
+class MyGraphicsScene;
+
+// A hierarchical summary of an assembly graph for drawing very large graphs.
+//
+// Every node pair of the graph starts out as its own cluster. Each round of
+// coarsening then groups clusters into new ones:
+//  - tips (dead ends hanging off a branching node) join that node,
+//  - the arms of simple bubbles (same source, same sink) are grouped,
+//  - non-branching chains (unitigs) are grouped.
+// Rounds repeat on the grouped graph, so a cluster holds clusters of the
+// previous round, down to the original nodes. Clusters are oriented: a member
+// is either in the cluster's forward direction or reversed.
+//
+// The overview is a separate AssemblyGraph with one node pair per displayed
+// cluster: super-nodes carry the total length and the length weighted depth
+// of their members. Expanding a super-node replaces it in the overview by its
+// members, so the cost of navigating depends on what is shown, not on the
+// size of the whole graph.
+//
+// The overview refers to the original graph, which must outlive it and stay
+// unchanged. Overview nodes are tracked by name.
+class GraphCoarsening {
+  public:
+    static constexpr uint32_t NONE = UINT32_MAX;
+
+    enum ClusterKind : uint8_t { SINGLE_NODE, UNITIG_CLUSTER, BUBBLE_CLUSTER, TIP_CLUSTER };
+
+    struct Member {
+        uint32_t cluster;
+        bool reversed;
+    };
+
+    struct Cluster {
+        ClusterKind kind = SINGLE_NODE;
+        uint32_t parent = NONE;
+        bool reversedInParent = false;
+        bool displayed = false;
+        std::vector<Member> members;
+        // The positive original node of a SINGLE_NODE cluster
+        DeBruijnNode *node = nullptr;
+        // The overview name of a super-node, without the sign
+        QString name;
+        long long length = 0;
+        double depth = 0.0;
+        size_t nodeCount = 1;
+    };
+
+    explicit GraphCoarsening(const AssemblyGraph &graph);
+
+    // Coarsens round by round until at most targetClusters clusters are left,
+    // nothing more can be grouped, or maxRounds rounds were done. Returns the
+    // number of rounds.
+    int coarsen(size_t targetClusters, int maxRounds = 64);
+    // The clusters left after coarsening
+    const std::vector<uint32_t> &topClusters() const { return m_active; }
+    const Cluster &cluster(uint32_t id) const { return m_clusters[id]; }
+    size_t clusterCount() const { return m_clusters.size(); }
+
+    // Builds the overview graph of the top clusters.
+    QSharedPointer<AssemblyGraph> buildOverview();
+    const QSharedPointer<AssemblyGraph> &overview() const { return m_overview; }
+
+    // The cluster shown by an overview node, or NONE
+    uint32_t clusterOf(const DeBruijnNode *overviewNode) const;
+    bool isSuperNode(const DeBruijnNode *overviewNode) const;
+
+    // Replaces a super-node of the overview (both strands) by its members and
+    // returns their positive nodes. If the super-node was drawn in the scene,
+    // the members are drawn in its place.
+    std::vector<DeBruijnNode *> expand(DeBruijnNode *superNode, MyGraphicsScene *scene = nullptr);
+    // The same for the overview node with this name, if it is still there
+    std::vector<DeBruijnNode *> expand(const QString &superNodeName, MyGraphicsScene *scene = nullptr);
+
+  private:
+    // Oriented cluster ids: 2 * cluster + reversed
+    static uint32_t oriented(uint32_t cluster, bool reversed) { return 2 * cluster + uint32_t(reversed); }
+
+    // One round of grouping; false if nothing could be grouped.
+    bool coarsenOnce();
+    uint32_t addCluster(ClusterKind kind, std::vector<Member> members);
+
+    // The displayed cluster (oriented) holding the oriented original node
+    uint32_t displayedClusterOf(const DeBruijnNode *originalNode) const;
+    QString overviewName(uint32_t orientedCluster) const;
+    DeBruijnNode *addToOverview(uint32_t cluster);
+    void addOverviewEdges(const std::vector<const DeBruijnNode *> &originalNodes);
+    void collectOriginalNodes(uint32_t cluster, std::vector<const DeBruijnNode *> &nodes) const;
+
+    const AssemblyGraph &m_graph;
+    std::vector<Cluster> m_clusters;
+    std::vector<uint32_t> m_active;
+    // Successors of each oriented cluster of the current round. An edge
+    // x -> y always comes with its reverse complement y^1 -> x^1, so the
+    // predecessors of x are the reverse complements of the successors of x^1.
+    std::vector<std::vector<uint32_t>> m_out;
+    phmap::flat_hash_map<const DeBruijnNode *, uint32_t> m_originalClusters;
+
+    QSharedPointer<AssemblyGraph> m_overview;
+    phmap::flat_hash_map<std::string, uint32_t> m_overviewClusters;
+};
@@ -0,0 +1,302 @@
+// Copyright 2022 Anton Korobeynikov
+
+// This file is part of Bandage
+
+// Bandage is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// Bandage is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "contiguity.h"
+
+#include "debruijnedge.h"
+#include "debruijnnode.h"
+
+#include <QtConcurrent>
+
+#include <algorithm>
+
+namespace {
+using NodeSet = phmap::flat_hash_set<DeBruijnNode *>;
+
+// Calls f for every node one step further in the direction of the search
+template<class F>
+void forEachNextNode(const DeBruijnNode *node, bool forward, F f) {
+    for (const auto *edge : node->edges()) {
+        if (forward && edge->getStartingNode() == node)
+            f(edge->getEndingNode());
+        else if (!forward && edge->getEndingNode() == node)
+            f(edge->getStartingNode());
+    }
+}
+
+// The first node of a walk along the edge, away from the given node
+DeBruijnNode *firstNodeAlong(const DeBruijnEdge *edge, const DeBruijnNode *from, bool *forward) {
+    *forward = edge->getStartingNode() == from;
+    return *forward ? edge->getEndingNode() : edge->getStartingNode();
+}
+
+// The walks leaving one edge of the starting node. A walk stops after the
+// given number of steps, at a dead end, or just before it would return to
+// the starting node. Layer k holds the nodes reachable in exactly k + 1 steps.
+class WalksFromEdge {
+  public:
+    WalksFromEdge(DeBruijnNode *start, DeBruijnNode *first, bool forward, int steps)
+        : m_start(start), m_forward(forward) {
+        m_layers.push_back({first});
+        NodeSet next;
+        for (int k = 1; k < steps; ++k) {
+            next.clear();
+            for (auto *node : m_layers.back()) {
+                forEachNextNode(node, forward, [&](DeBruijnNode *nextNode) {
+                    if (nextNode != start)
+                        next.insert(nextNode);
+                });
+            }
+            if (next.empty())
+                break;
+            m_layers.emplace_back(next.begin(), next.end());
+        }
+    }
+
+    const std::vector<std::vector<DeBruijnNode *>> &layers() const { return m_layers; }
+
+    // Whether a walk can stop at the node after k + 1 steps
+    bool canStop(const DeBruijnNode *node, size_t k, size_t steps) const {
+        if (k + 1 == steps)
+            return true;
+        bool hasNext = false, returns = false;
+        forEachNextNode(node, m_forward, [&](const DeBruijnNode *nextNode) {
+            hasNext = true;
+            returns |= nextNode == m_start;
+        });
+        return !hasNext || returns;
+    }
+
+    // Any one complete walk
+    std::vector<DeBruijnNode *> anyWalk(size_t steps) const {
+        std::vector<DeBruijnNode *> walk;
+        DeBruijnNode *node = m_layers.front().front();
+        for (size_t k = 0; ; ++k) {
+            walk.push_back(node);
+            if (canStop(node, k, steps))
+                break;
+
+            // A walk that cannot stop has a next node other than the start
+            DeBruijnNode *nextNode = nullptr;
+            forEachNextNode(node, m_forward, [&](DeBruijnNode *candidate) {
+                if (nextNode == nullptr && candidate != m_start)
+                    nextNode = candidate;
+            });
+            node = nextNode;
+        }
+        return walk;
+    }
+
+    // Whether a complete walk exists that avoids both nodes. If none does,
+    // every walk goes through one of them.
+    bool walkAvoids(const DeBruijnNode *a, const DeBruijnNode *b, size_t steps) const {
+        DeBruijnNode *first = m_layers.front().front();
+        if (first == a || first == b)
+            return false;
+
+        NodeSet current{first}, next;
+        for (size_t k = 0; !current.empty(); ++k) {
+            next.clear();
+            for (auto *node : current) {
+                if (canStop(node, k, steps))
+                    return true;
+                forEachNextNode(node, m_forward, [&](DeBruijnNode *nextNode) {
+                    if (nextNode != m_start && nextNode != a && nextNode != b)
+                        next.insert(nextNode);
+                });
+            }
+            current.swap(next);
+        }
+        return false;
+    }
+
+  private:
+    DeBruijnNode *m_start;
+    bool m_forward;
+    std::vector<std::vector<DeBruijnNode *>> m_layers;
+};
+
+// Whether every walk of up to the given number of steps along the edge
+// reaches the target (or its reverse complement) before it stops at a dead
+// end, runs out of steps or comes back to the node it left.
+bool walksLeadOnlyTo(DeBruijnNode *from, const DeBruijnEdge *edge, const DeBruijnNode *target,
+                     bool includeReverseComplement, int steps) {
+    bool forward;
+    NodeSet current{firstNodeAlong(edge, from, &forward)}, next;
+    for (int k = 0; !current.empty(); ++k) {
+        next.clear();
+        for (auto *node : current) {
+            if (node == from)
+                return false;
+            if (node == target || (includeReverseComplement && node->getReverseComplement() == target))
+                continue;
+            if (k + 1 == steps)
+                return false;
+
+            bool hasNext = false;
+            forEachNextNode(node, forward, [&](DeBruijnNode *nextNode) {
+                hasNext = true;
+                next.insert(nextNode);
+            });
+            if (!hasNext)
+                return false;
+        }
+        current.swap(next);
+    }
+    return true;
+}
+
+bool anyEdgeLeadsOnlyTo(DeBruijnNode *from, const DeBruijnNode *target, bool includeReverseComplement, int steps) {
+    for (const auto *edge : from->edges()) {
+        if (walksLeadOnlyTo(from, edge, target, includeReverseComplement, steps))
+            return true;
+    }
+    return false;
+}
+
+ContiguityStatus statusOf(const ContiguitySearch::Statuses &statuses, DeBruijnNode *node) {
+    auto it = statuses.find(node);
+    return it == statuses.end() ? NOT_CONTIGUOUS : it->second;
+}
+
+// Statuses are only ever upgraded, never downgraded
+void upgrade(ContiguitySearch::Statuses &statuses, DeBruijnNode *node, ContiguityStatus status) {
+    auto [it, inserted] = statuses.try_emplace(node, status);
+    if (!inserted && status < it->second)
+        it->second = status;
+}
+}
+
+ContiguitySearch::ContiguitySearch(int searchSteps)
+    : m_searchSteps(std::max(searchSteps, 1)) {}
+
+ContiguitySearch::Statuses ContiguitySearch::run(const std::vector<DeBruijnNode *> &startingNodes) {
+    Statuses statuses;
+    m_progressMax = 0;
+    m_progress = 0;
+    for (auto *node : startingNodes) {
+        if (m_cancelled)
+            break;
+        searchFromNode(node, statuses);
+    }
+
+    if (m_cancelled)
+        return {};
+    return statuses;
+}
+
+void ContiguitySearch::searchFromNode(DeBruijnNode *startingNode, Statuses &statuses) {
+    upgrade(statuses, startingNode, STARTING);
+
+    const size_t steps = size_t(m_searchSteps);
+    NodeSet checkedNodes;
+    for (const auto *edge : startingNode->edges()) {
+        if (m_cancelled)
+            return;
+
+        bool forward;
+        DeBruijnNode *first = firstNodeAlong(edge, startingNode, &forward);
+        WalksFromEdge walks(startingNode, first, forward, m_searchSteps);
+
+        // Everything reachable is on some walk
+        for (const auto &layer : walks.layers()) {
+            for (auto *node : layer) {
+                upgrade(statuses, node, MAYBE_CONTIGUOUS);
+                checkedNodes.insert(node);
+            }
+        }
+
+        // A node on every walk must be on one particular walk, so only the
+        // nodes of that walk need testing. For either strand, a walk must
+        // contain the node or its reverse complement.
+        std::vector<DeBruijnNode *> walk = walks.anyWalk(steps);
+        std::sort(walk.begin(), walk.end());
+        walk.erase(std::unique(walk.begin(), walk.end()), walk.end());
+        for (auto *node : walk) {
+            if (!walks.walkAvoids(node, node, steps))
+                upgrade(statuses, node, CONTIGUOUS_STRAND_SPECIFIC);
+            if (!walks.walkAvoids(node, node->getReverseComplement(), steps)) {
+                upgrade(statuses, node, CONTIGUOUS_EITHER_STRAND);
+                upgrade(statuses, node->getReverseComplement(), CONTIGUOUS_EITHER_STRAND);
+            }
+        }
+    }
+
+    // Then check whether any walk from the nodes found leads unambiguously
+    // back to the starting node. The checks only read the graph, so they run
+    // in parallel; the statuses are updated afterwards in node order.
+    struct Check {
+        DeBruijnNode *node;
+        ContiguityStatus status;
+        bool strandSpecific = false;
+        bool eitherStrand = false;
+    };
+    std::vector<Check> checks;
+    checks.reserve(checkedNodes.size());
+    for (auto *node : checkedNodes)
+        checks.push_back({node, statusOf(statuses, node)});
+    std::sort(checks.begin(), checks.end(),
+              [](const Check &a, const Check &b) { return a.node < b.node; });
+
+    m_progressMax += int(checks.size());
+    emit setMaxValue(m_progressMax);
+
+    QtConcurrent::blockingMap(checks, [&](Check &check) {
+        if (m_cancelled)
+            return;
+
+        if (check.status != CONTIGUOUS_STRAND_SPECIFIC)
+            check.strandSpecific = anyEdgeLeadsOnlyTo(check.node, startingNode, false, m_searchSteps);
+        if (check.status != CONTIGUOUS_STRAND_SPECIFIC && check.status != CONTIGUOUS_EITHER_STRAND)
+            check.eitherStrand = anyEdgeLeadsOnlyTo(check.node, startingNode, true, m_searchSteps);
+
+        int progress = ++m_progress;
+        if (progress % 64 == 0)
+            emit setValue(progress);
+    });
+    if (m_cancelled)
+        return;
+    emit setValue(m_progress);
+
+    // The status is read again, as the reverse complement of an earlier node
+    // may have upgraded it
+    for (const auto &check : checks) {
+        ContiguityStatus status = statusOf(statuses, check.node);
+        if (status != CONTIGUOUS_STRAND_SPECIFIC && check.strandSpecific)
+            upgrade(statuses, check.node, CONTIGUOUS_STRAND_SPECIFIC);
+        if (status != CONTIGUOUS_STRAND_SPECIFIC && status != CONTIGUOUS_EITHER_STRAND && check.eitherStrand) {
+            upgrade(statuses, check.node, CONTIGUOUS_EITHER_STRAND);
+            upgrade(statuses, check.node->getReverseComplement(), CONTIGUOUS_EITHER_STRAND);
+        }
+    }
+}
+
+void ContiguitySearch::apply(const Statuses &statuses) {
+    for (const auto &[node, status] : statuses)
+        node->upgradeContiguityStatus(status);
+}
+
+const char *getContiguityStatusName(ContiguityStatus status) {
+    switch (status) {
+        case STARTING: return "starting";
+        case CONTIGUOUS_STRAND_SPECIFIC: return "contiguous_strand_specific";
+        case CONTIGUOUS_EITHER_STRAND: return "contiguous_either_strand";
+        case MAYBE_CONTIGUOUS: return "maybe_contiguous";
+        case NOT_CONTIGUOUS: return "not_contiguous";
+    }
+    return "not_contiguous";
+}
@@ -0,0 +1,79 @@
+// Copyright 2022 Anton Korobeynikov
+
+// This file is part of Bandage
+
+// Bandage is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// Bandage is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "program/globals.h"
+
+#include "parallel_hashmap/phmap.h"
+
+#include <QObject>
+
+#include <atomic>
+#include <vector>
+
+class DeBruijnNode;
+
+// Determines which nodes are contiguous with the starting nodes, i.e. which
+// nodes must, or may, be part of the same sequence.
+//
+// The search looks at all walks of up to searchSteps nodes leaving each edge
+// of a starting node. Rather than listing these walks, it works on the nodes
+// reachable in exactly k steps for each k, which is polynomial in the size of
+// the region:
+//  - Nodes reachable from an edge are MAYBE_CONTIGUOUS.
+//  - A node is on every walk from an edge (and so CONTIGUOUS) if no walk can
+//    be completed without it, which is checked with one reachability sweep
+//    per node of a single walk, like a dominator test.
+//  - A node that was reached is also CONTIGUOUS if all walks from one of its
+//    edges end up at the starting node before they stop.
+//
+// The graph is only read, so the search can run in a worker thread while the
+// graph is left alone. The resulting statuses are applied with apply().
+class ContiguitySearch : public QObject {
+    Q_OBJECT
+
+public:
+    using Statuses = phmap::flat_hash_map<DeBruijnNode *, ContiguityStatus>;
+
+    explicit ContiguitySearch(int searchSteps);
+
+    // Statuses of all nodes reached from the starting nodes, or nothing if
+    // the search was cancelled
+    Statuses run(const std::vector<DeBruijnNode *> &startingNodes);
+    bool wasCancelled() const { return m_cancelled; }
+
+    // Upgrades the contiguity statuses of the nodes
+    static void apply(const Statuses &statuses);
+
+public slots:
+    void cancel() { m_cancelled = true; }
+
+signals:
+    void setMaxValue(int max);
+    void setValue(int value);
+
+private:
+    void searchFromNode(DeBruijnNode *startingNode, Statuses &statuses);
+
+    int m_searchSteps;
+    int m_progressMax = 0;
+    std::atomic<int> m_progress = 0;
+    std::atomic<bool> m_cancelled = false;
+};
+
+const char *getContiguityStatusName(ContiguityStatus status);
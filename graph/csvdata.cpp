@@ -0,0 +1,224 @@
+// Copyright 2022 Anton Korobeynikov
+
+// This file is part of Bandage
+
+// Bandage is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// Bandage is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "csvdata.h"
+
+#include <QByteArray>
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <limits>
+#include <string>
+
+// Missing values of integer columns
+static constexpr int64_t MISSING_INTEGER = std::numeric_limits<int64_t>::min();
+
+static bool parseInteger(std::string_view str, int64_t &value) {
+    auto res = std::from_chars(str.data(), str.data() + str.size(), value);
+    if (res.ec != std::errc() || res.ptr != str.data() + str.size() || value == MISSING_INTEGER)
+        return false;
+
+    // Only accept the canonical form, so the value prints back as it was written
+    char buf[24];
+    auto printed = std::to_chars(buf, buf + sizeof(buf), value);
+    return std::string_view(buf, printed.ptr - buf) == str;
+}
+
+// Parsed in the C locale, as the user's locale may use a decimal comma
+static bool parseDouble(std::string_view str, double &value) {
+    // Only plain decimal numbers, without surrounding whitespace or a plus sign
+    if (str.empty() || std::isspace((unsigned char)str.front()) || std::isspace((unsigned char)str.back()) ||
+        str.front() == '+' || str.find_first_of("xX") != str.npos)
+        return false;
+
+    bool ok = false;
+    value = QByteArray::fromRawData(str.data(), qsizetype(str.size())).toDouble(&ok);
+    return ok && std::isfinite(value);
+}
+
+bool CsvData::Column::hasValue(RowId row) const {
+    switch (m_type) {
+        case ColumnType::Integer:
+            return m_integers[row] != MISSING_INTEGER;
+        case ColumnType::Double:
+            return !std::isnan(m_doubles[row]);
+        case ColumnType::Category:
+            return !m_categories[m_codes[row]].empty();
+    }
+    return false;
+}
+
+double CsvData::Column::number(RowId row) const {
+    switch (m_type) {
+        case ColumnType::Integer:
+            return m_integers[row] == MISSING_INTEGER ? NAN : double(m_integers[row]);
+        case ColumnType::Double:
+            return m_doubles[row];
+        case ColumnType::Category:
+            break;
+    }
+    return NAN;
+}
+
+std::string CsvData::Column::text(RowId row) const {
+    char buf[64];
+    switch (m_type) {
+        case ColumnType::Integer: {
+            if (m_integers[row] == MISSING_INTEGER)
+                return {};
+            auto res = std::to_chars(buf, buf + sizeof(buf), m_integers[row]);
+            return {buf, res.ptr};
+        }
+        case ColumnType::Double:
+        case ColumnType::Category:
+            return m_categories[m_codes[row]];
+    }
+    return {};
+}
+
+uint32_t CsvData::Column::intern(std::string_view value) {
+    if (m_categoryIds.empty()) {
+        for (uint32_t i = 0; i < m_categories.size(); ++i)
+            m_categoryIds.emplace(m_categories[i], i);
+    }
+
+    auto [it, inserted] = m_categoryIds.try_emplace(std::string(value), uint32_t(m_categories.size()));
+    if (inserted)
+        m_categories.emplace_back(value);
+    return it->second;
+}
+
+void CsvData::Column::append(std::string_view value) {
+    switch (m_type) {
+        case ColumnType::Integer: {
+            int64_t integer = MISSING_INTEGER;
+            if (value.empty() || parseInteger(value, integer)) {
+                m_integers.push_back(integer);
+                return;
+            }
+            break;
+        }
+        case ColumnType::Double: {
+            double number = NAN;
+            if (value.empty() || parseDouble(value, number)) {
+                m_doubles.push_back(number);
+                m_codes.push_back(intern(value));
+                return;
+            }
+            break;
+        }
+        case ColumnType::Category:
+            m_codes.push_back(intern(value));
+            return;
+    }
+
+    demoteToCategories();
+    m_codes.push_back(intern(value));
+}
+
+void CsvData::Column::demoteToCategories() {
+    // Double columns keep the text of their values already
+    if (m_type == ColumnType::Integer) {
+        m_codes.clear();
+        m_codes.reserve(m_integers.size());
+        for (RowId row = 0; row < m_integers.size(); ++row)
+            m_codes.push_back(intern(text(row)));
+    }
+
+    m_type = ColumnType::Category;
+    m_integers = {};
+    m_doubles = {};
+}
+
+void CsvData::Column::finalize() {
+    m_categoryIds = {};
+    if (m_type != ColumnType::Category)
+        return;
+
+    // Every distinct value is only parsed once
+    std::vector<int64_t> integers(m_categories.size(), MISSING_INTEGER);
+    std::vector<double> doubles(m_categories.size(), NAN);
+    bool allIntegers = true, allDoubles = true, anyValue = false;
+    for (size_t i = 0; i < m_categories.size() && allDoubles; ++i) {
+        const auto &value = m_categories[i];
+        if (value.empty())
+            continue;
+        anyValue = true;
+        allIntegers = allIntegers && parseInteger(value, integers[i]);
+        allDoubles = parseDouble(value, doubles[i]);
+    }
+    if (!anyValue || !allDoubles)
+        return;
+
+    m_type = allIntegers ? ColumnType::Integer : ColumnType::Double;
+    if (allIntegers) {
+        m_integers.reserve(m_codes.size());
+        for (auto code : m_codes)
+            m_integers.push_back(integers[code]);
+    } else {
+        m_doubles.reserve(m_codes.size());
+        for (auto code : m_codes)
+            m_doubles.push_back(doubles[code]);
+    }
+
+    m_min = std::numeric_limits<double>::infinity();
+    m_max = -std::numeric_limits<double>::infinity();
+    for (double value : doubles) {
+        if (std::isnan(value))
+            continue;
+        m_min = std::min(m_min, value);
+        m_max = std::max(m_max, value);
+    }
+
+    // Integers print back as they were written. Other numbers keep their
+    // text, so that they are shown as written ("0.10", "1e3").
+    if (allIntegers) {
+        m_codes = {};
+        m_categories = {};
+    }
+}
+
+void CsvData::setColumnCount(size_t count) {
+    clear();
+    m_columns.resize(count);
+}
+
+CsvData::RowId CsvData::addRow(const std::vector<std::string> &values, size_t first, size_t last) {
+    for (size_t i = 0; i < m_columns.size(); ++i) {
+        size_t idx = first + i;
+        m_columns[i].append(idx < last ? std::string_view(values[idx]) : std::string_view());
+    }
+    return RowId(m_rowCount++);
+}
+
+void CsvData::finalize() {
+    for (auto &column : m_columns)
+        column.finalize();
+}
+
+void CsvData::clear() {
+    m_columns.clear();
+    m_rowCount = 0;
+    m_rows.clear();
+}
+
+int64_t CsvData::row(const DeBruijnNode *node) const {
+    auto it = m_rows.find(node);
+    return it == m_rows.end() ? -1 : it->second;
+}
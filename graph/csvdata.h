@@ -0,0 +1,100 @@
+// Copyright 2022 Anton Korobeynikov
+
+// This file is part of Bandage
+
+// Bandage is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// Bandage is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "parallel_hashmap/phmap.h"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class DeBruijnNode;
+
+// Per-node attributes loaded from a CSV file, stored column by column. Each
+// row holds the values of one CSV line and any number of nodes may refer to
+// the same row. Columns are typed once loading is finished: columns where
+// every value is an integer or a number are stored as such, all other columns
+// are dictionary encoded, so consumers can read values without parsing text.
+// Columns of non-integer numbers also keep the dictionary of their values as
+// written, for display.
+class CsvData {
+  public:
+    using RowId = uint32_t;
+
+    enum class ColumnType { Integer, Double, Category };
+
+    class Column {
+      public:
+        ColumnType type() const { return m_type; }
+        bool isNumeric() const { return m_type != ColumnType::Category; }
+
+        bool hasValue(RowId row) const;
+        // The value of a numeric column, NaN if missing.
+        double number(RowId row) const;
+        // The index of the value in categories() for category columns.
+        uint32_t category(RowId row) const { return m_codes[row]; }
+        const std::vector<std::string> &categories() const { return m_categories; }
+        // Minimum and maximum of the values of a numeric column.
+        double min() const { return m_min; }
+        double max() const { return m_max; }
+
+        std::string text(RowId row) const;
+
+      private:
+        friend class CsvData;
+
+        void append(std::string_view value);
+        void finalize();
+        void demoteToCategories();
+        uint32_t intern(std::string_view value);
+
+        ColumnType m_type = ColumnType::Category;
+        std::vector<int64_t> m_integers;
+        std::vector<double> m_doubles;
+        std::vector<uint32_t> m_codes;
+        std::vector<std::string> m_categories;
+        // Only used while loading
+        phmap::flat_hash_map<std::string, uint32_t> m_categoryIds;
+        double m_min = 0, m_max = 0;
+    };
+
+    void setColumnCount(size_t count);
+    size_t columnCount() const { return m_columns.size(); }
+    size_t rowCount() const { return m_rowCount; }
+    const Column &column(size_t idx) const { return m_columns[idx]; }
+
+    // Adds a row from values [first, last). Missing values are left empty
+    // and extra ones are ignored.
+    RowId addRow(const std::vector<std::string> &values, size_t first, size_t last);
+    RowId addRow(const std::vector<std::string> &values) { return addRow(values, 0, values.size()); }
+    // Types the columns. Rows may still be added afterwards.
+    void finalize();
+    void clear();
+
+    void setRow(const DeBruijnNode *node, RowId row) { m_rows[node] = row; }
+    void removeNode(const DeBruijnNode *node) { m_rows.erase(node); }
+    // The row of the node, or -1 if it has no data.
+    int64_t row(const DeBruijnNode *node) const;
+    bool hasRow(const DeBruijnNode *node) const { return row(node) >= 0; }
+
+  private:
+    std::vector<Column> m_columns;
+    size_t m_rowCount = 0;
+    phmap::flat_hash_map<const DeBruijnNode *, RowId> m_rows;
+};
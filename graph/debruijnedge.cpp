@@ -18,15 +18,15 @@
 
 #include "debruijnedge.h"
 #include "assemblygraph.h"
+#include "bufferedwriter.h"
 
 #include "program/globals.h"
 
 #include <cmath>
-#include <QApplication>
 
 DeBruijnEdge::DeBruijnEdge(DeBruijnNode *startingNode, DeBruijnNode *endingNode) :
     m_startingNode(startingNode), m_endingNode(endingNode), m_graphicsItemEdge(nullptr), m_reverseComplement(nullptr),
-    m_drawn(false), m_overlapType(UNKNOWN_OVERLAP), m_overlap(0)
+    m_drawn(false), m_markedForDeletion(false), m_overlapType(UNKNOWN_OVERLAP), m_overlap(0)
 {
 }
 
@@ -95,266 +95,61 @@ bool DeBruijnEdge::isPositiveEdge() const
 }
 
 
-//This function traces all possible paths from this edge.
-//It proceeds a number of steps, as determined by a setting.
-//If forward is true, it looks in a forward direction (starting nodes to
-//ending nodes).  If forward is false, it looks in a backward direction
-//(ending nodes to starting nodes).
-void DeBruijnEdge::tracePaths(bool forward,
-                              int stepsRemaining,
-                              std::vector< std::vector <DeBruijnNode *> > * allPaths,
-                              DeBruijnNode * startingNode,
-                              std::vector<DeBruijnNode *> pathSoFar) const
-{
-    //This can go for a while, so keep the UI responsive.
-    QApplication::processEvents();
-
-    //Find the node in the direction we are tracing.
-    DeBruijnNode * nextNode;
-    if (forward)
-        nextNode = m_endingNode;
-    else
-        nextNode = m_startingNode;
-
-    //Add that node to the path so far.
-    pathSoFar.push_back(nextNode);
-
-    //If there are no steps left, then the path so far is done.
-    --stepsRemaining;
-    if (stepsRemaining == 0)
-    {
-        allPaths->push_back(pathSoFar);
-        return;
-    }
-
-    //If the code got here, then more steps remain.
-    //Find the edges that are in the correct direction.
-    std::vector<DeBruijnEdge *> nextEdges = findNextEdgesInPath(nextNode, forward);
-
-    //If there are no next edges, then we are finished with the
-    //path search, even though steps remain.
-    if (nextEdges.empty())
-    {
-        allPaths->push_back(pathSoFar);
-        return;
-    }
-
-    //Call this function on all of the next edges.
-    //However, we also need to check to see if we are tracing a loop
-    //and stop if that is the case.
-    for (auto nextEdge : nextEdges)
-    {
-        //Determine the node that this next edge leads to.
-        DeBruijnNode * nextNextNode;
-        if (forward)
-            nextNextNode = nextEdge->m_endingNode;
-        else
-            nextNextNode = nextEdge->m_startingNode;
-
-        //If that node is the starting node, then we've made
-        //a full loop and the path should be considered complete.
-        if (nextNextNode == startingNode)
-        {
-            allPaths->push_back(pathSoFar);
-            continue;
-        }
-
-        //If that node is already in the path TWICE so far, that means
-        //we're caught in a loop, and we should throw this path out.
-        //If it appears 0 or 1 times, then continue the path search.
-        if (timesNodeInPath(nextNextNode, &pathSoFar) < 2)
-            nextEdge->tracePaths(forward, stepsRemaining, allPaths, startingNode, pathSoFar);
-    }
-}
-
-
-//This function counts how many times a node appears in a path
-int DeBruijnEdge::timesNodeInPath(DeBruijnNode * node, std::vector<DeBruijnNode *> * path)
-{
-    int count = 0;
-    for (auto & i : *path)
-    {
-        if ( i == node)
-            ++count;
-    }
-
-    return count;
-}
-
-
-
-bool DeBruijnEdge::leadsOnlyToNode(bool forward,
-                                   int stepsRemaining,
-                                   DeBruijnNode * target,
-                                   std::vector<DeBruijnNode *> pathSoFar,
-                                   bool includeReverseComplement) const
-{
-    //This can go for a while, so keep the UI responsive.
-    QApplication::processEvents();
-
-    //Find the node in the direction we are tracing.
-    DeBruijnNode * nextNode;
-    if (forward)
-        nextNode = m_endingNode;
-    else
-        nextNode = m_startingNode;
-
-    //Add that node to the path so far.
-    pathSoFar.push_back(nextNode);
-
-    //If this path has landed on the node from which the search began,
-    //that means we've followed a loop around.  The search has therefore
-    //failed because this path could represent circular DNA that does
-    //not contain the target.
-    if (nextNode == pathSoFar[0])
-        return false;
-
-    //If the next node is the target, the search succeeded!
-    if (nextNode == target)
-        return true;
-
-    //If we are including reverse complements and the next node is
-    //the reverse complement of the target, the search succeeded!
-    if (includeReverseComplement && nextNode->getReverseComplement() == target)
-        return true;
-
-    //If there are no steps left, then the search failed.
-    --stepsRemaining;
-    if (stepsRemaining == 0)
-        return false;
-
-    //If the code got here, then more steps remain.
-    //Find the edges that are in the correct direction.
-    std::vector<DeBruijnEdge *> nextEdges = findNextEdgesInPath(nextNode, forward);
-
-    //If there are no next edges, then the search failed, even
-    //though steps remain.
-    if (nextEdges.empty())
-        return false;
-
-    //In order for the search to succeed, this function needs to return true
-    //for all of the nextEdges.
-    //However, we also need to check to see if we are tracing a loop
-    //and stop if that is the case.
-    for (auto nextEdge : nextEdges)
-    {
-        //Determine the node that this next edge leads to.
-        DeBruijnNode * nextNextNode;
-        if (forward)
-            nextNextNode = nextEdge->m_endingNode;
-        else
-            nextNextNode = nextEdge->m_startingNode;
-
-        //If that node is already in the path TWICE so far, that means
-        //we're caught in a loop, and we should throw this path out.
-        //If it appears 0 or 1 times, then continue the path search.
-        if (timesNodeInPath(nextNextNode, &pathSoFar) < 2)
-        {
-            if ( !nextEdge->leadsOnlyToNode(forward, stepsRemaining, target, pathSoFar, includeReverseComplement) )
-                return false;
-        }
-    }
-
-    //If the code got here, then the search succeeded!
-    return true;
-}
-
-
-std::vector<DeBruijnEdge *> DeBruijnEdge::findNextEdgesInPath(DeBruijnNode * nextNode,
-                                                              bool forward)
-{
-    std::vector<DeBruijnEdge *> nextEdges;
-    for (DeBruijnEdge * edge : nextNode->edges()) {
-        //If forward, we're looking for edges that lead away from
-        //nextNode.  If backward, we're looking for edges that lead
-        //into nextNode.
-        if ((forward && edge->m_startingNode == nextNode) ||
-            (!forward && edge->m_endingNode == nextNode))
-            nextEdges.push_back(edge);
-    }
-
-    return nextEdges;
-}
-
-
-//This function tries to automatically determine the overlap size
-//between the two nodes.  It tries each overlap size between the min
-//to the max (in settings), assigning the first one it finds.
-void DeBruijnEdge::autoDetermineExactOverlap()
-{
-    m_overlap = 0;
-    m_overlapType = AUTO_DETERMINED_EXACT_OVERLAP;
-
-    //Find an appropriate search range
-    int minPossibleOverlap = std::min(m_startingNode->getLength(), m_endingNode->getLength());
-    if (minPossibleOverlap < g_settings->minAutoFindEdgeOverlap)
-        return;
-    int min = std::min(minPossibleOverlap, g_settings->minAutoFindEdgeOverlap);
-    int max = std::min(minPossibleOverlap, g_settings->maxAutoFindEdgeOverlap);
-
-    //Try each overlap in the range and set the first one found.
-    //However, we don't want the search to be biased towards larger
-    //or smaller overlaps, so start with a pseudorandom value and loop.
-    int testOverlap = min + (rand() % (max - min + 1));
-    for (int i = min; i <= max; ++i)
-    {
-        if (testExactOverlap(testOverlap))
-        {
-            m_overlap = testOverlap;
-            return;
-        }
-
-        ++testOverlap;
-        if (testOverlap > max)
-            testOverlap = min;
-    }
-}
-
-
-
-
 //This function tries the given overlap between the two nodes.
 //If the overlap works perfectly, it returns true.
 bool DeBruijnEdge::testExactOverlap(int overlap) const
 {
-    bool mismatchFound = false;
-
+    const Sequence &seq1 = m_startingNode->getSequence();
+    const Sequence &seq2 = m_endingNode->getSequence();
     int seq1Offset = m_startingNode->getLength() - overlap;
 
-    //Look at each position in the overlap
-    for (int j = 0; j < overlap && !mismatchFound; ++j)
+    //Usually the overlap lies within both sequences and they can be
+    //compared a packed word at a time.
+    if (overlap > 0 && seq1Offset >= 0 && size_t(m_startingNode->getLength()) == seq1.size() &&
+        size_t(overlap) <= seq2.size())
+        return seq1.rangeEquals(size_t(seq1Offset), seq2, 0, size_t(overlap));
+
+    //Otherwise look at each position in the overlap, where positions
+    //outside of a sequence have no base.
+    for (int j = 0; j < overlap; ++j)
     {
         char a = m_startingNode->getBaseAt(seq1Offset + j);
         char b = m_endingNode->getBaseAt(j);
         if (a != b)
-            mismatchFound = true;
+            return false;
     }
 
-    return !mismatchFound;
+    return true;
 }
 
 
-QByteArray DeBruijnEdge::getGfaLinkLine() const
+//Writes the node name and sign as GFA link fields, without copying the name.
+static void writeGfaLinkNode(utils::BufferedWriter &out, const DeBruijnNode *node)
 {
-    DeBruijnNode * startingNode = getStartingNode();
-    DeBruijnNode * endingNode = getEndingNode();
+    QString name = node->getName();
+    if (name.isEmpty())
+    {
+        out << "\t+\t";
+        return;
+    }
 
-    QByteArray gfaLinkLine = "L\t";
-    gfaLinkLine += startingNode->getNameWithoutSign().toLatin1() + "\t";
-    gfaLinkLine += startingNode->getSign().toLatin1() + "\t";
-    gfaLinkLine += endingNode->getNameWithoutSign().toLatin1() + "\t";
-    gfaLinkLine += endingNode->getSign().toLatin1() + "\t";
+    QStringView nameView(name);
+    out << nameView.chopped(1) << '\t' << nameView.right(1) << '\t';
+}
+
+void DeBruijnEdge::writeGfaLinkLine(utils::BufferedWriter &out) const
+{
+    out << "L\t";
+    writeGfaLinkNode(out, getStartingNode());
+    writeGfaLinkNode(out, getEndingNode());
 
     //When Velvet graphs are saved to GFA, the sequences are extended to include
     //the overlap.  So even though this edge might have no overlap, the GFA link
     //line should.
     if (g_assemblyGraph->m_graphFileType == LAST_GRAPH)
-        gfaLinkLine += QString::number(g_assemblyGraph->m_kmer - 1).toLatin1() + "M";
+        out << g_assemblyGraph->m_kmer - 1 << "M\n";
     else
-        gfaLinkLine += QString::number(getOverlap()).toLatin1() + "M";
-
-    gfaLinkLine += "\n";
-    return gfaLinkLine;
+        out << getOverlap() << "M\n";
 }
 
 bool DeBruijnEdge::compareEdgePointers(DeBruijnEdge * a, DeBruijnEdge * b)
@@ -22,9 +22,13 @@
 
 class GraphicsItemEdge;
 
+namespace utils {
+    class BufferedWriter;
+}
+
 class DeBruijnEdge
 {
-    static constexpr unsigned OVERLAP_BITS = 29;
+    static constexpr unsigned OVERLAP_BITS = 28;
 public:
     //CREATORS
     DeBruijnEdge(DeBruijnNode * startingNode, DeBruijnNode * endingNode);
@@ -36,6 +40,7 @@ public:
     GraphicsItemEdge * getGraphicsItemEdge() const {return m_graphicsItemEdge;}
     DeBruijnEdge * getReverseComplement() const {return m_reverseComplement;}
     bool isDrawn() const {return m_drawn;}
+    bool isMarkedForDeletion() const {return m_markedForDeletion;}
     int getOverlap() const {
         unsigned m = CHAR_BIT * sizeof(decltype(m_overlap)) - OVERLAP_BITS;
         return (m_overlap << m) >> m;
@@ -43,17 +48,7 @@ public:
     EdgeOverlapType getOverlapType() const {return m_overlapType;}
     DeBruijnNode * getOtherNode(const DeBruijnNode * node) const;
     bool testExactOverlap(int overlap) const;
-    void tracePaths(bool forward,
-                    int stepsRemaining,
-                    std::vector<std::vector<DeBruijnNode *> > * allPaths,
-                    DeBruijnNode * startingNode,
-                    std::vector<DeBruijnNode *> pathSoFar = std::vector<DeBruijnNode *>()) const;
-    bool leadsOnlyToNode(bool forward,
-                         int stepsRemaining,
-                         DeBruijnNode * target,
-                         std::vector<DeBruijnNode *> pathSoFar,
-                         bool includeReverseComplement) const;
-    QByteArray getGfaLinkLine() const;
+    void writeGfaLinkLine(utils::BufferedWriter &out) const;
     bool isPositiveEdge() const;
     bool isNegativeEdge() const {return !isPositiveEdge();}
     bool isOwnReverseComplement() const {return this == getReverseComplement();}
@@ -66,8 +61,9 @@ public:
     void setOverlapType(EdgeOverlapType olt) {m_overlapType = olt;}
     void reset() {m_graphicsItemEdge = nullptr; m_drawn = false;}
     bool determineIfDrawn() { return (m_drawn = edgeIsVisible());}
+    void setAsNotDrawn() {m_drawn = false;}
+    void markForDeletion() {m_markedForDeletion = true;}
     void setExactOverlap(int overlap) {m_overlap = overlap; m_overlapType = EXACT_OVERLAP;}
-    void autoDetermineExactOverlap();
 
 private:
     DeBruijnNode * m_startingNode;
@@ -75,11 +71,9 @@ private:
     GraphicsItemEdge * m_graphicsItemEdge;
     DeBruijnEdge * m_reverseComplement;
     bool m_drawn : 1;
+    bool m_markedForDeletion : 1;
     EdgeOverlapType m_overlapType : 2;
     int m_overlap : OVERLAP_BITS;
 
     bool edgeIsVisible() const;
-    static int timesNodeInPath(DeBruijnNode * node, std::vector<DeBruijnNode *> * path) ;
-    static std::vector<DeBruijnEdge *> findNextEdgesInPath(DeBruijnNode * nextNode,
-                                                    bool forward) ;
 };
\ No newline at end of file
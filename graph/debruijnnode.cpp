@@ -19,14 +19,14 @@
 #include "debruijnnode.h"
 #include "debruijnedge.h"
 #include "assemblygraph.h"
+#include "bufferedwriter.h"
 #include "sequenceutils.h"
 
 #include "blast/blasthit.h"
 
+#include <algorithm>
 #include <cmath>
 
-#include <set>
-#include <QApplication>
 #include <QSet>
 
 
@@ -38,12 +38,14 @@ DeBruijnNode::DeBruijnNode(QString name, double depth, const Sequence& sequence,
     m_depthRelativeToMeanDrawnDepth(1.0),
     m_sequence(sequence),
     m_length(sequence.size()),
+    m_visitEpoch(0),
     m_contiguityStatus(NOT_CONTIGUOUS),
     m_reverseComplement(nullptr),
     m_graphicsItemNode(nullptr),
     m_specialNode(false),
     m_drawn(false),
-    m_highestDistanceInNeighbourSearch(0)
+    m_markedForDeletion(false),
+    m_composition(NO_COMPOSITION)
 {
     if (length > 0)
         m_length = length;
@@ -65,6 +67,13 @@ void DeBruijnNode::removeEdge(DeBruijnEdge * edge)
     m_edges.erase(std::remove(m_edges.begin(), m_edges.end(), edge), m_edges.end());
 }
 
+void DeBruijnNode::removeMarkedEdges()
+{
+    m_edges.erase(std::remove_if(m_edges.begin(), m_edges.end(),
+                                 [](const DeBruijnEdge *edge) { return edge->isMarkedForDeletion(); }),
+                  m_edges.end());
+}
+
 
 //This function resets the node to the state it would be in after a graph
 //file was loaded - no contiguity status and no OGDF nodes.
@@ -74,159 +83,8 @@ void DeBruijnNode::resetNode()
     resetContiguityStatus();
     setAsNotDrawn();
     setAsNotSpecial();
-    m_highestDistanceInNeighbourSearch = 0;
-}
-
-//This function determines the contiguity of nodes relative to this one.
-//It has two steps:
-// -First, for each edge leaving this node, all paths outward are found.
-//  Any nodes in any path are MAYBE_CONTIGUOUS, and nodes in all of the
-//  paths are CONTIGUOUS.
-// -Second, it is necessary to check in the opposite direction - for each
-//  of the MAYBE_CONTIGUOUS nodes, do they have a path that unambiguously
-//  leads to this node?  If so, then they are CONTIGUOUS.
-void DeBruijnNode::determineContiguity()
-{
-    upgradeContiguityStatus(STARTING);
-
-    //A set is used to store all nodes found in the paths, as the nodes
-    //that show up as MAYBE_CONTIGUOUS will have their paths checked
-    //to this node.
-    std::set<DeBruijnNode *> allCheckedNodes;
-
-    //For each path leaving this node, find all possible paths
-    //outward.  Nodes in any of the paths for an edge are
-    //MAYBE_CONTIGUOUS.  Nodes in all of the paths for an edge
-    //are CONTIGUOUS.
-    for (auto edge : m_edges)
-    {
-        bool outgoingEdge = (this == edge->getStartingNode());
-
-        std::vector< std::vector <DeBruijnNode *> > allPaths;
-        edge->tracePaths(outgoingEdge, g_settings->contiguitySearchSteps, &allPaths, this);
-
-        //Set all nodes in the paths as MAYBE_CONTIGUOUS
-        for (auto &path : allPaths)
-        {
-            QApplication::processEvents();
-            for (auto node : path)
-            {
-                node->upgradeContiguityStatus(MAYBE_CONTIGUOUS);
-                allCheckedNodes.insert(node);
-            }
-        }
-
-        //Set all common nodes as CONTIGUOUS_STRAND_SPECIFIC
-        std::vector<DeBruijnNode *> commonNodesStrandSpecific = getNodesCommonToAllPaths(&allPaths, false);
-        for (auto &node : commonNodesStrandSpecific)
-            node->upgradeContiguityStatus(CONTIGUOUS_STRAND_SPECIFIC);
-
-        //Set all common nodes (when including reverse complement nodes)
-        //as CONTIGUOUS_EITHER_STRAND
-        std::vector<DeBruijnNode *> commonNodesEitherStrand = getNodesCommonToAllPaths(&allPaths, true);
-        for (auto node : commonNodesEitherStrand)
-        {
-            node->upgradeContiguityStatus(CONTIGUOUS_EITHER_STRAND);
-            node->getReverseComplement()->upgradeContiguityStatus(CONTIGUOUS_EITHER_STRAND);
-        }
-    }
-
-    //For each node that was checked, then we check to see if any
-    //of its paths leads unambiuously back to the starting node (this node).
-    for (auto node : allCheckedNodes)
-    {
-        QApplication::processEvents();
-        ContiguityStatus status = node->getContiguityStatus();
-
-        //First check without reverse complement target for
-        //strand-specific contiguity.
-        if (status != CONTIGUOUS_STRAND_SPECIFIC &&
-                node->doesPathLeadOnlyToNode(this, false))
-            node->upgradeContiguityStatus(CONTIGUOUS_STRAND_SPECIFIC);
-
-        //Now check including the reverse complement target for
-        //either strand contiguity.
-        if (status != CONTIGUOUS_STRAND_SPECIFIC &&
-                status != CONTIGUOUS_EITHER_STRAND &&
-                node->doesPathLeadOnlyToNode(this, true))
-        {
-            node->upgradeContiguityStatus(CONTIGUOUS_EITHER_STRAND);
-            node->getReverseComplement()->upgradeContiguityStatus(CONTIGUOUS_EITHER_STRAND);
-        }
-    }
 }
 
-
-//This function differs from the above by including all reverse complement
-//nodes in the path search.
-std::vector<DeBruijnNode *> DeBruijnNode::getNodesCommonToAllPaths(std::vector< std::vector <DeBruijnNode *> > * paths,
-                                                                   bool includeReverseComplements)
-{
-    std::vector<DeBruijnNode *> commonNodes;
-
-    //If there are no paths, then return the empty vector.
-    if (paths->empty())
-        return commonNodes;
-
-    //If there is only one path in path, then they are all common nodes
-    commonNodes = (*paths)[0];
-    if (paths->size() == 1)
-        return commonNodes;
-
-    //If there are two or more paths, it's necessary to find the intersection.
-    for (size_t i = 1; i < paths->size(); ++i)
-    {
-        QApplication::processEvents();
-        std::vector <DeBruijnNode *> * path = &((*paths)[i]);
-
-        //If we are including reverse complements in the search,
-        //then it is necessary to build a new vector that includes
-        //reverse complement nodes and then use that vector.
-        std::vector <DeBruijnNode *> pathWithReverseComplements;
-        if (includeReverseComplements)
-        {
-            for (auto node : *path)
-            {
-                pathWithReverseComplements.push_back(node);
-                pathWithReverseComplements.push_back(node->getReverseComplement());
-            }
-            path = &pathWithReverseComplements;
-        }
-
-        //Combine the commonNodes vector with the path vector,
-        //excluding any repeats.
-        std::sort(commonNodes.begin(), commonNodes.end());
-        std::sort(path->begin(), path->end());
-        std::vector<DeBruijnNode *> newCommonNodes;
-        std::set_intersection(commonNodes.begin(), commonNodes.end(), path->begin(), path->end(), std::back_inserter(newCommonNodes));
-        commonNodes = newCommonNodes;
-    }
-
-    return commonNodes;
-}
-
-
-//This function checks whether this node has any path leading outward that
-//unambiguously leads to the given node.
-//It checks a number of steps as set by the contiguitySearchSteps setting.
-//If includeReverseComplement is true, then this function returns true if
-//all paths lead either to the node or its reverse complement node.
-bool DeBruijnNode::doesPathLeadOnlyToNode(DeBruijnNode * node, bool includeReverseComplement)
-{
-    for (auto edge : m_edges)
-    {
-        bool outgoingEdge = (this == edge->getStartingNode());
-
-        std::vector<DeBruijnNode *> pathSoFar;
-        pathSoFar.push_back(this);
-        if (edge->leadsOnlyToNode(outgoingEdge, g_settings->contiguitySearchSteps, node, pathSoFar, includeReverseComplement))
-            return true;
-    }
-
-    return false;
-}
-
-
 //This function only upgrades a node's status, never downgrades.
 void DeBruijnNode::upgradeContiguityStatus(ContiguityStatus newStatus)
 {
@@ -254,20 +112,23 @@ bool DeBruijnNode::isOnlyPathInItsDirection(DeBruijnNode * connectedNode,
 
 QByteArray DeBruijnNode::getFasta(bool sign, bool newLines, bool evenIfEmpty) const
 {
-    QByteArray sequence = utils::sequenceToQByteArray(getSequence());
-    if (sequence.isEmpty() && !evenIfEmpty)
+    if (getSequence().size() == 0 && !evenIfEmpty)
         return {};
 
-    QByteArray fasta = ">";
-    fasta += getNodeNameForFasta(sign).toLatin1();
-    fasta += "\n";
-    if (newLines)
-        fasta += utils::addNewlinesToSequence(sequence);
-    else {
-        fasta += sequence;
-        fasta += "\n";
-    }
-    return fasta;
+    utils::BufferedWriter out;
+    writeFasta(out, sign, newLines ? 70 : 0);
+    return {out.data(), qsizetype(out.size())};
+}
+
+void DeBruijnNode::writeFasta(utils::BufferedWriter &out, bool sign, size_t lineWidth) const
+{
+    out << ">NODE_";
+    if (sign)
+        out << m_name;
+    else
+        out << QStringView(m_name).left(m_name.length() - 1);
+    out << "_length_" << getLength() << "_cov_" << getDepth() << '\n';
+    out.writeSequenceLines(getSequence(), lineWidth);
 }
 
 //This function gets the node's sequence for a GFA file.  It has two main
@@ -405,40 +266,6 @@ QString DeBruijnNode::getNodeNameForFasta(bool sign) const
 }
 
 
-//This function recursively labels all nodes as drawn that are within a
-//certain distance of this node.  Whichever node called this will
-//definitely be drawn, so that one is excluded from the recursive call.
-void DeBruijnNode::labelNeighbouringNodesAsDrawn(int nodeDistance, DeBruijnNode * callingNode)
-{
-    if (m_highestDistanceInNeighbourSearch > nodeDistance)
-        return;
-    m_highestDistanceInNeighbourSearch = nodeDistance;
-
-    if (nodeDistance == 0)
-        return;
-
-    DeBruijnNode * otherNode;
-    for (auto &m_edge : m_edges)
-    {
-        otherNode = m_edge->getOtherNode(this);
-
-        if (otherNode == callingNode)
-            continue;
-
-        if (g_settings->doubleMode)
-            otherNode->m_drawn = true;
-        else //single mode
-        {
-            if (otherNode->isPositiveNode())
-                otherNode->m_drawn = true;
-            else
-                otherNode->getReverseComplement()->m_drawn = true;
-        }
-        otherNode->labelNeighbouringNodesAsDrawn(nodeDistance-1, this);
-    }
-}
-
-
 bool DeBruijnNode::isPositiveNode() const
 {
     QChar lastChar = m_name.at(m_name.length() - 1);
@@ -557,11 +384,6 @@ const Sequence &DeBruijnNode::getSequence() const
     return m_sequence;
 }
 
-Sequence &DeBruijnNode::getSequence()
-{
-    return m_sequence;
-}
-
 //If the node has an edge which leads to itself (creating a loop), this function
 //will return it.  Otherwise, it returns 0.
 DeBruijnEdge * DeBruijnNode::getSelfLoopingEdge() const
@@ -620,11 +442,36 @@ std::vector<DeBruijnNode *> DeBruijnNode::getAllConnectedPositiveNodes() const
 }
 
 float DeBruijnNode::getGC() const {
-    size_t gc = 0;
-    for (size_t i = 0; i < m_sequence.size(); ++i) {
-        char c = m_sequence[i];
-        gc += (c == 'G' || c == 'C');
+    return float(getComposition().gc) / float(m_sequence.size());
+}
+
+Sequence::Composition DeBruijnNode::getComposition() const {
+    //Threads racing here compute and store the same value
+    uint64_t packed = m_composition.load(std::memory_order_relaxed);
+    if (packed == NO_COMPOSITION) {
+        auto composition = m_sequence.composition();
+        packed = uint64_t(uint32_t(composition.gc)) | uint64_t(uint32_t(composition.n)) << 32;
+        m_composition.store(packed, std::memory_order_relaxed);
+    }
+
+    Sequence::Composition composition;
+    composition.gc = uint32_t(packed);
+    composition.n = uint32_t(packed >> 32);
+    composition.at = m_sequence.size() - composition.gc - composition.n;
+    return composition;
+}
+
+std::vector<Sequence::Composition> DeBruijnNode::getWindowComposition(size_t windowSize, size_t step) const {
+    std::vector<Sequence::Composition> windows;
+    if (windowSize == 0 || step == 0)
+        return windows;
+
+    size_t length = m_sequence.size();
+    for (size_t start = 0; start < length; start += step) {
+        windows.push_back(m_sequence.composition(start, windowSize));
+        if (start + windowSize >= length)
+            break;
     }
 
-    return float(gc) / float(m_sequence.size());
+    return windows;
 }
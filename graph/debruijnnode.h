@@ -27,6 +27,8 @@
 
 #include <QColor>
 #include <QByteArray>
+
+#include <atomic>
 #include <vector>
 
 class OgdfNode;
@@ -34,6 +36,10 @@ class DeBruijnEdge;
 class GraphicsItemNode;
 class BlastHit;
 
+namespace utils {
+    class BufferedWriter;
+}
+
 class DeBruijnNode
 {
 public:
@@ -50,15 +56,25 @@ public:
     double getDepthRelativeToMeanDrawnDepth() const {return m_depthRelativeToMeanDrawnDepth;}
 
     float getGC() const;
-
+    //The G/C, A/T and N counts of the whole sequence are computed once and
+    //cached until the sequence changes.  Safe to call from several threads.
+    Sequence::Composition getComposition() const;
+    //Counts for windows of the given size, each starting step bases after
+    //the previous one.  The last window may be shorter.
+    std::vector<Sequence::Composition> getWindowComposition(size_t windowSize, size_t step) const;
+
+    //The sequence can only be changed with setSequence, which also clears the
+    //cached composition.
     const Sequence &getSequence() const;
-    Sequence &getSequence();
 
     int getLength() const {return m_length;}
     QByteArray getSequenceForGfa() const;
     int getFullLength() const;
     int getLengthWithoutTrailingOverlap() const;
     QByteArray getFasta(bool sign, bool newLines = true, bool evenIfEmpty = true) const;
+    //Writes the FASTA record without building it as a string.  With a line
+    //width of 0 the sequence is on a single line.
+    void writeFasta(utils::BufferedWriter &out, bool sign, size_t lineWidth = 70) const;
     char getBaseAt(int i) const {if (i >= 0 && i < m_sequence.size()) return m_sequence[i]; else return '\0';} // NOTE
     ContiguityStatus getContiguityStatus() const {return m_contiguityStatus;}
     DeBruijnNode * getReverseComplement() const {return m_reverseComplement;}
@@ -82,6 +98,7 @@ public:
     bool isDrawn() const {return m_drawn;}
     bool thisNodeOrReverseComplementIsDrawn() const {return isDrawn() || getReverseComplement()->isDrawn();}
     bool isNotDrawn() const {return !m_drawn;}
+    bool isMarkedForDeletion() const {return m_markedForDeletion;}
     bool isPositiveNode() const;
     bool isNegativeNode() const;
 
@@ -95,8 +112,8 @@ public:
 
     //MODIFERS
     void setDepthRelativeToMeanDrawnDepth(double newVal) {m_depthRelativeToMeanDrawnDepth = newVal;}
-    void setSequence(const QByteArray &newSeq) {m_sequence = Sequence(newSeq); m_length = m_sequence.size();}
-    void setSequence(const Sequence &newSeq) {m_sequence = newSeq; m_length = m_sequence.size();}
+    void setSequence(const QByteArray &newSeq) {m_sequence = Sequence(newSeq); m_length = m_sequence.size(); m_composition = NO_COMPOSITION;}
+    void setSequence(const Sequence &newSeq) {m_sequence = newSeq; m_length = m_sequence.size(); m_composition = NO_COMPOSITION;}
     void upgradeContiguityStatus(ContiguityStatus newStatus);
     void resetContiguityStatus() {m_contiguityStatus = NOT_CONTIGUOUS;}
     void setReverseComplement(DeBruijnNode * rc) {m_reverseComplement = rc;}
@@ -105,11 +122,19 @@ public:
     void setAsNotSpecial() {m_specialNode = false;}
     void setAsDrawn() {m_drawn = true;}
     void setAsNotDrawn() {m_drawn = false;}
+    //Tombstone for AssemblyGraph::deleteNodesAndEdges, which sweeps all
+    //marked nodes and edges at once.
+    void markForDeletion() {m_markedForDeletion = true;}
     void resetNode();
     void addEdge(DeBruijnEdge * edge);
     void removeEdge(DeBruijnEdge * edge);
-    void determineContiguity();
-    void labelNeighbouringNodesAsDrawn(int nodeDistance, DeBruijnNode * callingNode);
+    //Removes all edges marked for deletion in a single pass.
+    void removeMarkedEdges();
+    //Stamps the node as visited in the given search, returning false if it
+    //already was.  Searches use increasing epochs, so nothing has to be
+    //cleared between them.
+    bool markVisited(uint32_t epoch) {if (m_visitEpoch == epoch) return false; m_visitEpoch = epoch; return true;}
+    void clearVisited() {m_visitEpoch = 0;}
     void setDepth(double newDepth) {m_depth = newDepth;}
     void setName(QString newName) {m_name = std::move(newName);}
 
@@ -124,10 +149,16 @@ private:
     GraphicsItemNode * m_graphicsItemNode;
 
     int m_length;
-    int m_highestDistanceInNeighbourSearch : 27;
+    uint32_t m_visitEpoch;
     ContiguityStatus m_contiguityStatus : 3;
     bool m_specialNode : 1;
     bool m_drawn : 1;
+    bool m_markedForDeletion : 1;
+    //The G/C count in the low and the N count in the high 32 bits.  It is
+    //filled in lazily, possibly from several threads at once, so it is atomic
+    //and not part of the bitfield above.
+    static constexpr uint64_t NO_COMPOSITION = UINT64_MAX;
+    mutable std::atomic<uint64_t> m_composition;
 
     QString getNodeNameForFasta(bool sign) const;
     QByteArray getUpstreamSequence(int upstreamSequenceLength) const;
@@ -135,7 +166,4 @@ private:
     static bool isOnlyPathInItsDirection(DeBruijnNode * connectedNode,
                                   std::vector<DeBruijnNode *> * incomingNodes,
                                   std::vector<DeBruijnNode *> * outgoingNodes);
-    static std::vector<DeBruijnNode *> getNodesCommonToAllPaths(std::vector< std::vector <DeBruijnNode *> > * paths,
-                                                         bool includeReverseComplements) ;
-    bool doesPathLeadOnlyToNode(DeBruijnNode * node, bool includeReverseComplement);
 };
\ No newline at end of file
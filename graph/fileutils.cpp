@@ -17,94 +17,345 @@
 
 #include "fileutils.h"
 
-#include <QTextStream>
-#include <QFile>
-#include <QChar>
-#include <QApplication>
+#include <QByteArray>
+#include <QDir>
+#include <QFileInfo>
+#include <QtConcurrent>
 
-namespace utils {
-    void readFastaOrFastqFile(const QString &filename, std::vector<QString> *names,
-                              std::vector<QByteArray> *sequences) {
-        QChar firstChar = QChar(0);
-        QFile inputFile(filename);
-        if (inputFile.open(QIODevice::ReadOnly)) {
-            QTextStream in(&inputFile);
-            QString firstLine = in.readLine();
-            firstChar = firstLine.at(0);
-            inputFile.close();
+#include <algorithm>
+#include <charconv>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <zlib.h>
+
+namespace {
+    constexpr size_t BLOCK_SIZE = 4 << 20;
+    // Blocks with less sequence than this are prepared in the calling thread
+    constexpr size_t PARALLEL_MIN_SIZE = 1 << 20;
+
+    using GzFilePtr = std::unique_ptr<std::remove_pointer<gzFile>::type, decltype(&gzclose)>;
+
+    GzFilePtr openFile(const QString &filename) {
+        GzFilePtr fp(gzopen(filename.toStdString().c_str(), "r"), gzclose);
+        if (fp)
+            gzbuffer(fp.get(), 1 << 20);
+        return fp;
+    }
+
+    // Calls progress if the percentage of the file read has changed
+    void reportProgress(gzFile fp, long long fileSize, int &percent, const utils::ProgressCallback &progress) {
+        if (!progress || fileSize <= 0)
+            return;
+        int newPercent = int(std::min(100LL, 100LL * gzoffset(fp) / fileSize));
+        if (newPercent != percent) {
+            percent = newPercent;
+            progress(percent);
         }
-        if (firstChar == '>')
-            readFastaFile(filename, names, sequences);
-        else if (firstChar == '@')
-            readFastqFile(filename, names, sequences);
     }
 
+    // A record as it is in the buffer: the sequence may still be spread over
+    // several lines
+    struct RawRecord {
+        std::string_view name;
+        std::string_view lines;
+        std::string sequence;
+    };
 
-    void readFastaFile(const QString &filename, std::vector<QString> *names,
-                       std::vector<QByteArray> *sequences) {
-        QFile inputFile(filename);
-        if (inputFile.open(QIODevice::ReadOnly)) {
-            QString name = "";
-            QByteArray sequence = "";
+    bool isSpace(char c) {
+        return c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == '\v' || c == '\f';
+    }
 
-            QTextStream in(&inputFile);
-            while (!in.atEnd()) {
-                QApplication::processEvents();
+    std::string_view trimmed(std::string_view s) {
+        while (!s.empty() && isSpace(s.front()))
+            s.remove_prefix(1);
+        while (!s.empty() && isSpace(s.back()))
+            s.remove_suffix(1);
+        return s;
+    }
 
-                QString line = in.readLine();
+    // The line starting at pos, without its line break. At the end of the
+    // file the last line needs no line break; otherwise false is returned if
+    // the line is not complete yet.
+    bool nextLine(std::string_view data, size_t &pos, bool atEnd, std::string_view &line) {
+        size_t end = data.find('\n', pos);
+        if (end == std::string_view::npos) {
+            if (!atEnd)
+                return false;
+            end = data.size();
+        }
+        line = data.substr(pos, end - pos);
+        if (!line.empty() && line.back() == '\r')
+            line.remove_suffix(1);
+        pos = std::min(end + 1, data.size());
+        return true;
+    }
 
-                if (line.length() == 0)
-                    continue;
+    // Splits the complete FASTA records off the start of the data and returns
+    // the number of bytes used. Anything before the first header is skipped.
+    // scanned is how far the start of the data is known to hold no next
+    // header, so that a long record is only scanned once.
+    size_t splitFastaRecords(std::string_view data, bool atEnd, size_t &scanned,
+                             std::vector<RawRecord> &records) {
+        size_t pos = 0;
+        if (!data.empty() && data.front() != '>') {
+            size_t header = data.find("\n>");
+            if (header == std::string_view::npos)
+                return atEnd ? data.size() : data.size() - 1;
+            pos = header + 1;
+            scanned = 0;
+        }
+
+        while (pos < data.size()) {
+            size_t linesBegin = pos;
+            std::string_view name;
+            if (!nextLine(data, linesBegin, atEnd, name))
+                break;
 
-                if (line.at(0) == '>') {
-                    //If there is a current sequence, add it to the vectors now.
-                    if (name.length() > 0) {
-                        names->push_back(name);
-                        sequences->push_back(sequence);
-                    }
-
-                    line.remove(0, 1); //Remove '>' from start
-                    name = line;
-                    sequence = "";
-                } else //It's a sequence line
-                    sequence += line.simplified().toLatin1();
+            // The name line's own line break may start the next header
+            size_t next = data.find("\n>", std::max(linesBegin - 1, pos + scanned));
+            if (next == std::string_view::npos) {
+                if (!atEnd) {
+                    scanned = data.size() - 1 - pos;
+                    break;
+                }
+                next = data.size();
+            } else {
+                next += 1;
             }
 
-            //Add the last target to the results now.
-            if (name.length() > 0) {
-                names->push_back(name);
-                sequences->push_back(sequence);
+            scanned = 0;
+            name.remove_prefix(1);
+            if (!name.empty())
+                records.push_back({name, data.substr(linesBegin, next - linesBegin)});
+            pos = next;
+        }
+        return pos;
+    }
+
+    // Splits the complete FASTQ records (four lines each) off the start of the
+    // data and returns the number of bytes used. Lines that cannot start a
+    // record are skipped.
+    size_t splitFastqRecords(std::string_view data, bool atEnd, std::vector<RawRecord> &records) {
+        size_t pos = 0;
+        while (pos < data.size()) {
+            size_t next = pos;
+            std::string_view header, sequence, separator, qualities;
+            if (!nextLine(data, next, atEnd, header))
+                break;
+            header = trimmed(header);
+            if (header.empty() || header.front() != '@') {
+                pos = next;
+                continue;
             }
+            if (!nextLine(data, next, atEnd, sequence) ||
+                !nextLine(data, next, atEnd, separator) ||
+                !nextLine(data, next, atEnd, qualities))
+                break;
 
-            inputFile.close();
+            header.remove_prefix(1);
+            sequence = trimmed(sequence);
+            if (!header.empty() && !sequence.empty())
+                records.push_back({header, sequence});
+            pos = next;
         }
+        return pos;
     }
 
+    void removeWhitespace(RawRecord &record) {
+        record.sequence.resize(record.lines.size());
+        char *out = record.sequence.data();
+        for (char c : record.lines) {
+            *out = c;
+            out += !isSpace(c);
+        }
+        record.sequence.resize(out - record.sequence.data());
+    }
 
-    void readFastqFile(const QString &filename, std::vector<QString> *names,
-                       std::vector<QByteArray> *sequences) {
-        QFile inputFile(filename);
-        if (inputFile.open(QIODevice::ReadOnly)) {
-            QTextStream in(&inputFile);
-            while (!in.atEnd()) {
-                QApplication::processEvents();
+    // Calls prepare for every record of a block, in parallel if the block is
+    // large enough
+    template<typename F>
+    void prepareRecords(std::vector<RawRecord> &records, F prepare) {
+        size_t size = 0;
+        for (const auto &record : records)
+            size += record.lines.size();
 
-                QString name = in.readLine().simplified();
-                QByteArray sequence = in.readLine().simplified().toLocal8Bit();
-                in.readLine();  // separator
-                in.readLine();  // qualities
+        if (records.size() > 1 && size >= PARALLEL_MIN_SIZE)
+            QtConcurrent::blockingMap(records, prepare);
+        else
+            std::for_each(records.begin(), records.end(), prepare);
+    }
 
-                if (name.length() == 0)
-                    continue;
-                if (sequence.length() == 0)
-                    continue;
-                if (name.at(0) != '@')
+    // Reads the file block by block and hands the records of every block to
+    // handleRecords
+    template<typename F>
+    bool readRecords(const QString &filename, F handleRecords, const utils::ProgressCallback &progress) {
+        GzFilePtr fp = openFile(filename);
+        if (!fp)
+            return false;
+        long long fileSize = QFileInfo(filename).size();
+        int percent = -1;
+
+        std::string buffer;
+        std::vector<RawRecord> records;
+        enum { UNKNOWN, FASTA, FASTQ } format = UNKNOWN;
+        size_t scanned = 0;
+        bool atEnd = false;
+        while (!atEnd) {
+            size_t filled = buffer.size();
+            buffer.resize(filled + BLOCK_SIZE);
+            int read = gzread(fp.get(), buffer.data() + filled, unsigned(BLOCK_SIZE));
+            if (read < 0)
+                return false;
+            buffer.resize(filled + size_t(read));
+            atEnd = read == 0;
+            reportProgress(fp.get(), fileSize, percent, progress);
+
+            // The first character that is not whitespace tells the format
+            if (format == UNKNOWN) {
+                size_t first = 0;
+                while (first < buffer.size() && isSpace(buffer[first]))
+                    ++first;
+                if (first == buffer.size() && !atEnd)
                     continue;
-                name.remove(0, 1); //Remove '@' from start
-                names->push_back(name);
-                sequences->push_back(sequence);
+                format = first < buffer.size() && buffer[first] == '@' ? FASTQ : FASTA;
+            }
+
+            records.clear();
+            std::string_view data(buffer);
+            size_t used = format == FASTA ?
+                          splitFastaRecords(data, atEnd, scanned, records) :
+                          splitFastqRecords(data, atEnd, records);
+            if (!records.empty())
+                handleRecords(records);
+            buffer.erase(0, used);
+        }
+        return true;
+    }
+}
+
+namespace utils {
+    LineReader::LineReader(const QString &filename, ProgressCallback progress)
+            : m_file(openFile(filename).release()),
+              m_fileSize(QFileInfo(filename).size()),
+              m_progress(std::move(progress)) {}
+
+    LineReader::~LineReader() {
+        if (m_file)
+            gzclose(m_file);
+    }
+
+    bool LineReader::readBlock() {
+        m_buffer.erase(0, m_pos);
+        m_pos = 0;
+
+        size_t filled = m_buffer.size();
+        m_buffer.resize(filled + BLOCK_SIZE);
+        int read = gzread(m_file, m_buffer.data() + filled, unsigned(BLOCK_SIZE));
+        m_buffer.resize(filled + size_t(std::max(read, 0)));
+        m_atEnd = read <= 0;
+        reportProgress(m_file, m_fileSize, m_percent, m_progress);
+        return read > 0;
+    }
+
+    bool LineReader::nextLine(std::string_view &line) {
+        if (!m_file)
+            return false;
+
+        size_t end = m_buffer.find('\n', m_pos);
+        while (end == std::string::npos) {
+            // Long lines are only scanned once
+            size_t scanned = m_buffer.size() - m_pos;
+            if (m_atEnd || !readBlock()) {
+                // The last line needs no line break
+                if (m_pos == m_buffer.size())
+                    return false;
+                end = m_buffer.size();
+                break;
             }
-            inputFile.close();
+            end = m_buffer.find('\n', scanned);
+        }
+
+        line = std::string_view(m_buffer).substr(m_pos, end - m_pos);
+        if (!line.empty() && line.back() == '\r')
+            line.remove_suffix(1);
+        m_pos = std::min(end + 1, m_buffer.size());
+        return true;
+    }
+
+    size_t splitInto(std::string_view s, char separator, std::string_view *parts, size_t maxParts) {
+        size_t count = 0;
+        forEachPart(s, separator, [&](std::string_view part) {
+            if (count < maxParts)
+                parts[count] = part;
+            ++count;
+        });
+        return count;
+    }
+
+    size_t splitWords(std::string_view s, std::string_view *words, size_t maxWords) {
+        size_t count = 0;
+        while (!s.empty()) {
+            size_t end = 0;
+            while (end < s.size() && !isSpace(s[end]))
+                ++end;
+            if (count < maxWords)
+                words[count] = s.substr(0, end);
+            ++count;
+            while (end < s.size() && isSpace(s[end]))
+                ++end;
+            s.remove_prefix(end);
+        }
+        return count;
+    }
+
+    int toInt(std::string_view s) {
+        if (!s.empty() && s.front() == '+')
+            s.remove_prefix(1);
+        int value = 0;
+        auto res = std::from_chars(s.data(), s.data() + s.size(), value);
+        return res.ec == std::errc() && res.ptr == s.data() + s.size() ? value : 0;
+    }
+
+    double toDouble(std::string_view s) {
+        // Like QString::toDouble: surrounding whitespace is allowed and the C
+        // locale is used, whatever the user's locale is
+        return QByteArray::fromRawData(s.data(), qsizetype(s.size())).toDouble();
+    }
+
+    bool readFastx(const QString &filename, const FastxCallback &callback) {
+        return readRecords(filename, [&](std::vector<RawRecord> &records) {
+            prepareRecords(records, removeWhitespace);
+            for (const auto &record : records)
+                callback(record.name, record.sequence);
+        }, {});
+    }
+
+    bool readFastxSequences(const QString &filename, const FastxSequenceCallback &callback,
+                            const ProgressCallback &progress) {
+        std::vector<Sequence> sequences;
+        return readRecords(filename, [&](std::vector<RawRecord> &records) {
+            sequences.assign(records.size(), Sequence());
+            prepareRecords(records, [&](RawRecord &record) {
+                removeWhitespace(record);
+                sequences[&record - records.data()] = Sequence(record.sequence);
+                std::string().swap(record.sequence);
+            });
+            for (size_t i = 0; i < records.size(); ++i)
+                callback(records[i].name, std::move(sequences[i]));
+        }, progress);
+    }
+
+    QString findFastaForGraph(const QString &graphFilename) {
+        QFileInfo graphFileInfo(graphFilename);
+        QString baseName = graphFileInfo.completeBaseName();
+        for (const char *extension : {".fa", ".fasta", ".contigs.fasta"}) {
+            QString fastaName = graphFileInfo.dir().filePath(baseName + extension);
+            if (QFileInfo::exists(fastaName))
+                return fastaName;
         }
+        return {};
     }
-}
\ No newline at end of file
+}
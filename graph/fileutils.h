@@ -17,17 +17,83 @@
 
 #pragma once
 
+#include "seq/sequence.hpp"
+
 #include <QString>
-#include <QByteArray>
-#include <vector>
+
+#include <functional>
+#include <string>
+#include <string_view>
+
+struct gzFile_s;
 
 namespace utils {
-    void readFastaOrFastqFile(const QString &filename, std::vector<QString> *names,
-                              std::vector<QByteArray> *sequences);
+    // Called with the percentage of a file read so far
+    using ProgressCallback = std::function<void(int percent)>;
+
+    // Reads a text file, which may be gzip-compressed, in large blocks and
+    // hands it out line by line. Lines are views into the block without their
+    // line break and are only valid until the next call.
+    class LineReader {
+      public:
+        explicit LineReader(const QString &filename, ProgressCallback progress = {});
+        ~LineReader();
+        LineReader(const LineReader &) = delete;
+        LineReader &operator=(const LineReader &) = delete;
+
+        bool isOpen() const { return m_file != nullptr; }
+        // False at the end of the file
+        bool nextLine(std::string_view &line);
+
+      private:
+        bool readBlock();
+
+        gzFile_s *m_file;
+        long long m_fileSize;
+        ProgressCallback m_progress;
+        int m_percent = -1;
+        std::string m_buffer;
+        size_t m_pos = 0;
+        bool m_atEnd = false;
+    };
+
+    // Calls f for every part of s between separators. Empty parts are kept,
+    // like QString::split does.
+    template<typename F>
+    void forEachPart(std::string_view s, char separator, F f) {
+        for (size_t start = 0; ; ) {
+            size_t end = s.find(separator, start);
+            f(s.substr(start, end - start));
+            if (end == std::string_view::npos)
+                return;
+            start = end + 1;
+        }
+    }
+    // Stores the first maxParts parts and returns the number of all parts
+    size_t splitInto(std::string_view s, char separator, std::string_view *parts, size_t maxParts);
+    // The same for words separated by runs of whitespace
+    size_t splitWords(std::string_view s, std::string_view *words, size_t maxWords);
+    // The whole string as a number, or 0 if it is not one
+    int toInt(std::string_view s);
+    double toDouble(std::string_view s);
+
+    using FastxCallback = std::function<void(std::string_view name, std::string_view sequence)>;
+    using FastxSequenceCallback = std::function<void(std::string_view name, Sequence sequence)>;
+
+    // Reads a FASTA or FASTQ file, which may be gzip-compressed, and calls the
+    // callback for every record in file order. The name is the header line
+    // without its '>' or '@'; whitespace is removed from the sequence. The
+    // file is read in large blocks and the records of a block are prepared in
+    // parallel. The views are only valid during the call. Returns false if the
+    // file could not be opened.
+    bool readFastx(const QString &filename, const FastxCallback &callback);
 
-    void readFastaFile(const QString &filename, std::vector<QString> *names,
-                       std::vector<QByteArray> *sequences);
+    // The same, with the sequences packed in parallel as well
+    bool readFastxSequences(const QString &filename, const FastxSequenceCallback &callback,
+                            const ProgressCallback &progress = {});
 
-    void readFastqFile(const QString &filename, std::vector<QString> *names,
-                       std::vector<QByteArray> *sequences);
-}
\ No newline at end of file
+    // A FASTA file (.fa, .fasta or .contigs.fasta) with the same base name as
+    // the graph file, which may hold the sequences a GFA file leaves out, or
+    // an empty string if there is none
+    QString findFastaForGraph(const QString &graphFilename);
+}
@@ -29,6 +29,8 @@
 #include "ui/mygraphicsscene.h"
 #include "ui/mygraphicsview.h"
 
+#include "parallel_hashmap/phmap.h"
+
 #include <QTransform>
 #include <QPainterPathStroker>
 #include <QPainter>
@@ -36,7 +38,9 @@
 #include <QMessageBox>
 #include <QFontMetrics>
 #include <QSize>
+#include <QStyleOptionGraphicsItem>
 
+#include <algorithm>
 #include <set>
 
 #include <cmath>
@@ -83,6 +87,25 @@ GraphicsItemNode::GraphicsItemNode(DeBruijnNode * deBruijnNode,
     remakePath();
 }
 
+//Geometry derived from the line points which is reused between paints.  It is
+//only made for nodes which need it and is dropped when the line points change.
+struct GraphicsItemNode::PathCache
+{
+    //The path length from the first line point to each line point.
+    std::vector<double> cumulativeLengths;
+
+    //Partial paths (e.g. for annotations) keyed by their start and end
+    //fractions.  They are only kept for a single zoom level, as the fractions
+    //requested (e.g. for merged annotation bands) depend on the zoom.
+    double zoom = 0.0;
+    phmap::flat_hash_map<std::pair<double, double>, QPainterPath> partialPaths;
+};
+
+//Nodes with lots of annotations could otherwise keep a lot of paths around.
+static constexpr size_t maxCachedPartialPaths = 4096;
+
+GraphicsItemNode::~GraphicsItemNode() = default;
+
 static double distance(QPointF p1, QPointF p2) {
     auto xDiff = p1.x() - p2.x();
     auto yDiff = p1.y() - p2.y();
@@ -127,10 +150,8 @@ static QPointF getCentre(const Container &linePoints) {
 }
 
 
-void GraphicsItemNode::paint(QPainter * painter, const QStyleOptionGraphicsItem *, QWidget *)
+void GraphicsItemNode::paint(QPainter * painter, const QStyleOptionGraphicsItem * option, QWidget *)
 {
-    static AnnotationGroup::AnnotationVector emptyAnnotations{};
-
     //This code lets me see the node's bounding box.
     //I use it for debugging graphics issues.
 //    painter->setBrush(Qt::NoBrush);
@@ -149,20 +170,17 @@ void GraphicsItemNode::paint(QPainter * painter, const QStyleOptionGraphicsItem
     if (m_hasArrow)
         painter->setClipPath(outlinePath);
 
-    for (const auto &annotationGroup : g_annotationsManager->getGroups()) {
-        auto annotationSettings = g_settings->annotationsSettings[annotationGroup->id];
+    //Only the annotations on the exposed part of the node need to be drawn.
+    auto [visibleStartFraction, visibleEndFraction] = getVisibleFractionRange(option->exposedRect);
 
-        const auto &annotations = annotationGroup->getAnnotations(m_deBruijnNode);
-        const auto &revCompAnnotations = g_settings->doubleMode
-                                         ? emptyAnnotations
-                                         : annotationGroup->getAnnotations(m_deBruijnNode->getReverseComplement());
+    for (const auto &annotationGroup : g_annotationsManager->getGroups()) {
+        const auto &viewsToShow = g_settings->annotationsSettings[annotationGroup->id].viewsToShow;
 
-        for (const auto &annotation : annotations) {
-            annotation->drawFigure(*painter, *this, false, annotationSettings.viewsToShow);
-        }
-        for (const auto &annotation : revCompAnnotations) {
-            annotation->drawFigure(*painter, *this, true, annotationSettings.viewsToShow);
-        }
+        drawAnnotations(painter, *annotationGroup, viewsToShow, false,
+                        visibleStartFraction, visibleEndFraction);
+        if (!g_settings->doubleMode)
+            drawAnnotations(painter, *annotationGroup, viewsToShow, true,
+                            visibleStartFraction, visibleEndFraction);
     }
     painter->setClipping(false);
 
@@ -220,22 +238,112 @@ void GraphicsItemNode::paint(QPainter * painter, const QStyleOptionGraphicsItem
     }
 
     //Draw BLAST hit labels, if appropriate.
+    int64_t nodeLength = m_deBruijnNode->getLength();
+    auto visibleStart = int64_t(std::floor(visibleStartFraction * nodeLength));
+    auto visibleEnd = int64_t(std::ceil(visibleEndFraction * nodeLength));
     for (const auto &annotationGroup : g_annotationsManager->getGroups()) {
         if (!g_settings->annotationsSettings[annotationGroup->id].showText)
             continue;
 
-        const auto &annotations = annotationGroup->getAnnotations(m_deBruijnNode);
-        const auto &revCompAnnotations = g_settings->doubleMode
-                                         ? emptyAnnotations
-                                         : annotationGroup->getAnnotations(m_deBruijnNode->getReverseComplement());
+        annotationGroup->forEachOverlapping(m_deBruijnNode, visibleStart, visibleEnd,
+                                            [&](const Annotation &annotation) {
+                                                annotation.drawDescription(*painter, *this, false);
+                                            });
+        if (!g_settings->doubleMode)
+            annotationGroup->forEachOverlapping(m_deBruijnNode->getReverseComplement(),
+                                                nodeLength - visibleEnd, nodeLength - visibleStart,
+                                                [&](const Annotation &annotation) {
+                                                    annotation.drawDescription(*painter, *this, true);
+                                                });
+    }
+}
+
+
+//This function finds the range of the node's path (as fractions of its
+//length) which intersects the exposed rectangle.  Segments are tested using
+//their bounding boxes grown by the node width, so the range may be slightly
+//larger than what is actually visible.
+std::pair<double, double> GraphicsItemNode::getVisibleFractionRange(const QRectF &exposedRect)
+{
+    const auto &cumulativeLengths = getPathCache().cumulativeLengths;
+    double totalLength = cumulativeLengths.back();
+    if (totalLength <= 0.0 || exposedRect.contains(boundingRect()))
+        return {0.0, 1.0};
+
+    double margin = m_width / 2.0;
+    double startFraction = 1.0, endFraction = 0.0;
+    for (size_t i = 0; i + 1 < m_linePoints.size(); ++i)
+    {
+        QRectF segmentRect = QRectF(m_linePoints[i], m_linePoints[i + 1]).normalized();
+        segmentRect.adjust(-margin, -margin, margin, margin);
+        if (!segmentRect.intersects(exposedRect))
+            continue;
+
+        startFraction = std::min(startFraction, cumulativeLengths[i] / totalLength);
+        endFraction = std::max(endFraction, cumulativeLengths[i + 1] / totalLength);
+    }
+
+    //Nothing but the arrowhead (or the outline) may be exposed, but we still
+    //want to draw the full node then.
+    if (startFraction > endFraction)
+        return {0.0, 1.0};
+
+    return {startFraction, endFraction};
+}
+
+
+//This function draws the annotations of the group which are on the visible
+//part of the node (or its reverse complement).  Annotations shorter than a
+//pixel at the current zoom are merged into bands which are drawn once, so
+//nodes with huge numbers of small features stay fast to paint.
+void GraphicsItemNode::drawAnnotations(QPainter * painter, const AnnotationGroup &annotationGroup,
+                                       const std::set<ViewId> &viewsToShow, bool reverseComplement,
+                                       double visibleStartFraction, double visibleEndFraction)
+{
+    const DeBruijnNode * node = reverseComplement ? m_deBruijnNode->getReverseComplement() : m_deBruijnNode;
+    if (annotationGroup.getAnnotations(node).empty())
+        return;
 
-        for (const auto &annotation : annotations) {
-            annotation->drawDescription(*painter, *this, false);
+    int64_t nodeLength = m_deBruijnNode->getLength();
+    if (reverseComplement)
+    {
+        visibleStartFraction = 1.0 - visibleStartFraction;
+        visibleEndFraction = 1.0 - visibleEndFraction;
+        std::swap(visibleStartFraction, visibleEndFraction);
+    }
+    auto visibleStart = int64_t(std::floor(visibleStartFraction * nodeLength));
+    auto visibleEnd = int64_t(std::ceil(visibleEndFraction * nodeLength));
+
+    double scaledNodeLength = getNodePathLength() * g_absoluteZoom;
+    double basesPerPixel = scaledNodeLength > 0.0 ? nodeLength / scaledNodeLength : 0.0;
+
+    const Annotation * band = nullptr;
+    int64_t bandStart = 0, bandEnd = 0;
+    auto drawBand = [&]() {
+        if (band != nullptr)
+            band->drawBand(*painter, *this, reverseComplement, viewsToShow, bandStart, bandEnd);
+        band = nullptr;
+    };
+
+    annotationGroup.forEachOverlapping(node, visibleStart, visibleEnd, [&](const Annotation &annotation) {
+        if (double(annotation.getEnd() - annotation.getStart() + 1) >= basesPerPixel)
+        {
+            annotation.drawFigure(*painter, *this, reverseComplement, viewsToShow);
+            return;
         }
-        for (const auto &annotation : revCompAnnotations) {
-            annotation->drawDescription(*painter, *this, true);
+
+        if (band != nullptr && double(annotation.getStart()) <= bandEnd + basesPerPixel)
+        {
+            bandEnd = std::max(bandEnd, annotation.getEnd());
+            return;
         }
-    }
+
+        drawBand();
+        band = &annotation;
+        bandStart = annotation.getStart();
+        bandEnd = annotation.getEnd();
+    });
+    drawBand();
 }
 
 
@@ -473,6 +581,43 @@ void GraphicsItemNode::remakePath()
         path.lineTo(m_linePoints[i]);
 
     m_path = path;
+    m_pathCache.reset();
+}
+
+
+GraphicsItemNode::PathCache &GraphicsItemNode::getPathCache()
+{
+    if (m_pathCache == nullptr)
+    {
+        m_pathCache = std::make_unique<PathCache>();
+        auto &cumulativeLengths = m_pathCache->cumulativeLengths;
+        cumulativeLengths.reserve(m_linePoints.size());
+        double lengthSoFar = 0.0;
+        cumulativeLengths.push_back(lengthSoFar);
+        for (size_t i = 0; i + 1 < m_linePoints.size(); ++i)
+        {
+            lengthSoFar += QLineF(m_linePoints[i], m_linePoints[i + 1]).length();
+            cumulativeLengths.push_back(lengthSoFar);
+        }
+    }
+
+    return *m_pathCache;
+}
+
+
+const QPainterPath &GraphicsItemNode::getPartialPath(double startFraction, double endFraction)
+{
+    auto &cache = getPathCache();
+    if (cache.zoom != g_absoluteZoom || cache.partialPaths.size() >= maxCachedPartialPaths)
+    {
+        cache.partialPaths.clear();
+        cache.zoom = g_absoluteZoom;
+    }
+
+    auto [it, inserted] = cache.partialPaths.try_emplace({startFraction, endFraction});
+    if (inserted)
+        it->second = makePartialPath(startFraction, endFraction);
+    return it->second;
 }
 
 static QPointF findIntermediatePoint(QPointF p1, QPointF p2, double p1Value, double p2Value, double targetValue) {
@@ -486,20 +631,24 @@ QPainterPath GraphicsItemNode::makePartialPath(double startFraction, double endF
     if (endFraction < startFraction)
         std::swap(startFraction, endFraction);
 
-    double totalLength = getNodePathLength();
+    const auto &cumulativeLengths = getPathCache().cumulativeLengths;
+    double totalLength = cumulativeLengths.back();
+
+    //Skip straight to the segment in which the path starts.
+    size_t firstSegment = std::lower_bound(cumulativeLengths.begin() + 1, cumulativeLengths.end(),
+                                           startFraction * totalLength) - cumulativeLengths.begin() - 1;
+    if (firstSegment > 0)
+        --firstSegment;
 
     QPainterPath path;
     bool pathStarted = false;
-    double lengthSoFar = 0.0;
-    for (size_t i = 0; i < m_linePoints.size() - 1; ++i)
+    for (size_t i = firstSegment; i + 1 < m_linePoints.size(); ++i)
     {
         QPointF point1 = m_linePoints[i];
         QPointF point2 = m_linePoints[i + 1];
-        QLineF line(point1, point2);
 
-        double point1Fraction = lengthSoFar / totalLength;
-        lengthSoFar += line.length();
-        double point2Fraction = lengthSoFar / totalLength;
+        double point1Fraction = cumulativeLengths[i] / totalLength;
+        double point2Fraction = cumulativeLengths[i + 1] / totalLength;
 
         //If the path hasn't yet begun and this segment is before
         //the starting fraction, do nothing.
@@ -533,13 +682,7 @@ QPainterPath GraphicsItemNode::makePartialPath(double startFraction, double endF
 
 double GraphicsItemNode::getNodePathLength()
 {
-    double totalLength = 0.0;
-    for (size_t i = 0; i < m_linePoints.size() - 1; ++i)
-    {
-        QLineF line(m_linePoints[i], m_linePoints[i + 1]);
-        totalLength += line.length();
-    }
-    return totalLength;
+    return getPathCache().cumulativeLengths.back();
 }
 
 //This function will find the point that is a certain fraction of the way along the node's path.
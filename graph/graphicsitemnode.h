@@ -18,6 +18,7 @@
 
 #pragma once
 
+#include "program/globals.h"
 #include "small_vector/small_pod_vector.hpp"
 
 #include <QPointF>
@@ -29,10 +30,13 @@
 #include <QGraphicsItem>
 #include <QGraphicsSceneMouseEvent>
 
+#include <memory>
+#include <set>
 #include <vector>
 
 class DeBruijnNode;
 class Path;
+struct AnnotationGroup;
 
 class GraphicsItemNode : public QGraphicsItem
 {
@@ -46,6 +50,7 @@ public:
     GraphicsItemNode(DeBruijnNode * deBruijnNode,
                      const adt::SmallPODVector<QPointF> &linePoints,
                      QGraphicsItem * parent = nullptr);
+    ~GraphicsItemNode() override;
 
     DeBruijnNode * m_deBruijnNode;
     adt::SmallPODVector<QPointF> m_linePoints;
@@ -78,6 +83,7 @@ public:
     QStringList getNodeText() const;
     void setWidth();
     QPainterPath makePartialPath(double startFraction, double endFraction);
+    const QPainterPath &getPartialPath(double startFraction, double endFraction);
     double getNodePathLength();
     QPointF findLocationOnPath(double fraction);
     QRectF boundingRect() const override;
@@ -87,6 +93,15 @@ public:
     double indexToFraction(int64_t pos) const;
 
 private:
+    struct PathCache;
+    std::unique_ptr<PathCache> m_pathCache;
+
+    PathCache &getPathCache();
+    std::pair<double, double> getVisibleFractionRange(const QRectF &exposedRect);
+    void drawAnnotations(QPainter * painter, const AnnotationGroup &annotationGroup,
+                         const std::set<ViewId> &viewsToShow, bool reverseComplement,
+                         double visibleStartFraction, double visibleEndFraction);
+
     static void pathHighlightNode3(QPainter * painter, QPainterPath highlightPath);
     static bool anyNodeDisplayText();
 
@@ -0,0 +1,95 @@
+// Copyright 2022 Anton Korobeynikov
+
+// This file is part of Bandage
+
+// Bandage is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// Bandage is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "graphpaths.h"
+
+GraphPaths::PathId GraphPaths::add(std::string_view name, const std::vector<DeBruijnNode *> &steps) {
+    auto id = PathId(m_names.size());
+    m_names.emplace_back(name);
+    m_idsByName.insert_ks(name.data(), name.size(), id);
+
+    m_steps.insert(m_steps.end(), steps.begin(), steps.end());
+    m_pathOffsets.push_back(m_steps.size());
+
+    m_occurrences.clear();
+    m_nodeOccurrenceRanges.clear();
+
+    return id;
+}
+
+void GraphPaths::buildNodeIndex() {
+    m_occurrences.clear();
+    m_nodeOccurrenceRanges.clear();
+
+    // First count the occurrences of every node, then turn the counts into
+    // ranges of the occurrence array and fill them in path / step order.
+    for (const auto *node : m_steps)
+        m_nodeOccurrenceRanges[node].second += 1;
+
+    size_t offset = 0;
+    for (auto &entry : m_nodeOccurrenceRanges) {
+        size_t count = entry.second.second;
+        entry.second = {offset, offset};
+        offset += count;
+    }
+
+    m_occurrences.resize(m_steps.size());
+    for (PathId path = 0; path < m_names.size(); ++path) {
+        for (size_t i = m_pathOffsets[path]; i < m_pathOffsets[path + 1]; ++i) {
+            auto &range = m_nodeOccurrenceRanges[m_steps[i]];
+            m_occurrences[range.second++] = {path, uint32_t(i - m_pathOffsets[path])};
+        }
+    }
+}
+
+void GraphPaths::clear() {
+    m_names.clear();
+    m_idsByName.clear();
+    m_steps.clear();
+    m_pathOffsets = {0};
+    m_occurrences.clear();
+    m_nodeOccurrenceRanges.clear();
+}
+
+int64_t GraphPaths::find(std::string_view name) const {
+    auto it = m_idsByName.find_ks(name.data(), name.size());
+    if (it == m_idsByName.end())
+        return -1;
+    return *it;
+}
+
+std::vector<GraphPaths::PathId> GraphPaths::findByPrefix(std::string_view prefix) const {
+    std::vector<PathId> res;
+    auto range = m_idsByName.equal_prefix_range_ks(prefix.data(), prefix.size());
+    for (auto it = range.first; it != range.second; ++it)
+        res.push_back(*it);
+    return res;
+}
+
+size_t GraphPaths::countByPrefix(std::string_view prefix) const {
+    auto range = m_idsByName.equal_prefix_range_ks(prefix.data(), prefix.size());
+    return std::distance(range.first, range.second);
+}
+
+std::vector<GraphPaths::PathId> GraphPaths::pathsThroughNode(const DeBruijnNode *node) const {
+    std::vector<PathId> res;
+    for (const auto &occurrence : occurrences(node)) {
+        if (res.empty() || res.back() != occurrence.path)
+            res.push_back(occurrence.path);
+    }
+    return res;
+}
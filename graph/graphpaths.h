@@ -0,0 +1,88 @@
+// Copyright 2022 Anton Korobeynikov
+
+// This file is part of Bandage
+
+// Bandage is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// Bandage is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "parallel_hashmap/phmap.h"
+#include "tsl/htrie_map.h"
+#include "llvm/ADT/iterator_range.h"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class DeBruijnNode;
+
+// Named paths through the graph (e.g. GFA P-lines). The steps of all paths are
+// stored back to back in a single array, each path being a slice of it. Once
+// all paths are added, buildNodeIndex() creates the inverted index from a node
+// to its (path, step) occurrences, so the paths through a node can be found
+// without scanning every path.
+class GraphPaths {
+  public:
+    using PathId = uint32_t;
+
+    struct Occurrence {
+        PathId path;
+        uint32_t step;
+    };
+
+    // Adds a new path and returns its id. Invalidates the node index.
+    PathId add(std::string_view name, const std::vector<DeBruijnNode *> &steps);
+    void buildNodeIndex();
+    void clear();
+
+    size_t size() const { return m_names.size(); }
+    bool empty() const { return m_names.empty(); }
+
+    const std::string &name(PathId path) const { return m_names[path]; }
+    auto steps(PathId path) const {
+        return llvm::make_range(m_steps.data() + m_pathOffsets[path],
+                                m_steps.data() + m_pathOffsets[path + 1]);
+    }
+    size_t stepCount(PathId path) const { return m_pathOffsets[path + 1] - m_pathOffsets[path]; }
+
+    // Returns the id of the path with the given name, or -1 if there is none.
+    int64_t find(std::string_view name) const;
+    bool contains(std::string_view name) const { return find(name) >= 0; }
+    // Ids of all paths whose names start with the given prefix.
+    std::vector<PathId> findByPrefix(std::string_view prefix) const;
+    size_t countByPrefix(std::string_view prefix) const;
+
+    // All places where the node is visited by a path, ordered by path and
+    // then by step. Requires buildNodeIndex() to have been run.
+    auto occurrences(const DeBruijnNode *node) const {
+        auto it = m_nodeOccurrenceRanges.find(node);
+        if (it == m_nodeOccurrenceRanges.end())
+            return llvm::make_range(m_occurrences.data(), m_occurrences.data());
+        return llvm::make_range(m_occurrences.data() + it->second.first,
+                                m_occurrences.data() + it->second.second);
+    }
+    // Distinct paths visiting the node, in id order.
+    std::vector<PathId> pathsThroughNode(const DeBruijnNode *node) const;
+
+  private:
+    std::vector<std::string> m_names;
+    tsl::htrie_map<char, PathId> m_idsByName;
+
+    std::vector<DeBruijnNode *> m_steps;
+    std::vector<size_t> m_pathOffsets = {0};
+
+    std::vector<Occurrence> m_occurrences;
+    phmap::flat_hash_map<const DeBruijnNode *, std::pair<size_t, size_t>> m_nodeOccurrenceRanges;
+};
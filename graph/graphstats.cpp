@@ -0,0 +1,539 @@
+// Copyright 2022 Anton Korobeynikov
+
+// This file is part of Bandage
+
+// Bandage is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// Bandage is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "graphstats.h"
+
+#include "assemblygraph.h"
+#include "debruijnedge.h"
+#include "debruijnnode.h"
+#include "fileutils.h"
+#include "gfa.h"
+
+#include "parallel_hashmap/phmap.h"
+#include "seq/nucl.hpp"
+
+#include <QTemporaryFile>
+#include <QtConcurrent>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <numeric>
+#include <queue>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+namespace {
+struct NodeInfo {
+    int length;
+    int lengthWithoutTrailingOverlap;
+    double depth;
+};
+
+// Per-chunk sums of the node sweep
+struct Partial {
+    size_t begin, end;
+    long long totalLength = 0;
+    long long totalLengthNoOverlaps = 0;
+    long long totalLengthOrphanedNodes = 0;
+    int deadEnds = 0;
+};
+
+class UnionFind {
+  public:
+    explicit UnionFind(size_t size) : m_parents(size) {
+        std::iota(m_parents.begin(), m_parents.end(), 0);
+    }
+
+    uint32_t find(uint32_t x) {
+        while (m_parents[x] != x) {
+            m_parents[x] = m_parents[m_parents[x]];
+            x = m_parents[x];
+        }
+        return x;
+    }
+
+    void unite(uint32_t a, uint32_t b) {
+        a = find(a), b = find(b);
+        if (a != b)
+            m_parents[std::max(a, b)] = std::min(a, b);
+    }
+
+  private:
+    std::vector<uint32_t> m_parents;
+};
+
+// Adds a node (pair) to the sums of its chunk and returns what is kept of it
+NodeInfo addNode(Partial &partial, int length, double depth, bool entering, bool leaving,
+                 int maxOverlap, int maxLeavingOverlap) {
+    int deadEnds = !entering && !leaving ? 2 : (entering && leaving ? 0 : 1);
+    partial.deadEnds += deadEnds;
+    partial.totalLength += length;
+    partial.totalLengthNoOverlaps += length - maxOverlap;
+    if (deadEnds == 2)
+        partial.totalLengthOrphanedNodes += length;
+
+    return {length, std::max(length - maxLeavingOverlap, 0), depth};
+}
+
+void addPartials(GraphStats &stats, const std::vector<Partial> &partials) {
+    for (const auto &partial : partials) {
+        stats.totalLength += partial.totalLength;
+        stats.totalLengthNoOverlaps += partial.totalLengthNoOverlaps;
+        stats.totalLengthOrphanedNodes += partial.totalLengthOrphanedNodes;
+        stats.deadEnds += partial.deadEnds;
+    }
+    stats.percentageDeadEnds = 100.0 * double(stats.deadEnds) / (2 * stats.nodeCount);
+}
+
+void setComponentStats(GraphStats &stats, UnionFind &components, const std::vector<NodeInfo> &nodeInfos) {
+    std::vector<long long> componentLengths(nodeInfos.size(), 0);
+    for (uint32_t i = 0; i < nodeInfos.size(); ++i) {
+        uint32_t root = components.find(i);
+        if (root == i)
+            stats.componentCount += 1;
+        componentLengths[root] += nodeInfos[i].length;
+    }
+    stats.largestComponentLength = *std::max_element(componentLengths.begin(), componentLengths.end());
+}
+
+// Node length quantiles, N50 and median depth by base, from the nodes sorted
+// by length and by depth, and then the estimated sequence length
+void setSortedStats(GraphStats &stats, const NodeRangeIndex &index, const std::vector<NodeInfo> &nodeInfos) {
+    double lastIndex = double(index.size() - 1);
+    stats.shortestNode = int(index.lengthAtFractionalIndex(0.0));
+    stats.longestNode = int(index.lengthAtFractionalIndex(lastIndex));
+    stats.firstQuartile = int(std::round(index.lengthAtFractionalIndex(lastIndex / 4.0)));
+    stats.median = int(std::round(index.lengthAtFractionalIndex(lastIndex / 2.0)));
+    stats.thirdQuartile = int(std::round(index.lengthAtFractionalIndex(lastIndex * 3.0 / 4.0)));
+    stats.n50 = index.n50();
+
+    if (stats.totalLength > 0) {
+        if (index.size() == 1)
+            stats.medianDepthByBase = index.depthAtFractionalIndexBothStrands(0.0);
+        else if (stats.totalLength % 2 == 0) {
+            double depth1 = index.depthAtBaseIndex(stats.totalLength / 2 - 1);
+            double depth2 = index.depthAtBaseIndex(stats.totalLength / 2);
+            stats.medianDepthByBase = (depth1 + depth2) / 2.0;
+        } else {
+            stats.medianDepthByBase = index.depthAtBaseIndex((stats.totalLength - 1) / 2);
+        }
+    }
+
+    // Estimated sequence length: every node's length (minus overlaps)
+    // multiplied by its depth relative to the median
+    if (stats.medianDepthByBase != 0.0) {
+        for (const auto &info : nodeInfos) {
+            double relativeDepth = info.depth / stats.medianDepthByBase;
+            stats.estimatedSequenceLength += (long long)info.lengthWithoutTrailingOverlap * std::lround(relativeDepth);
+        }
+    }
+}
+
+GraphStats GraphStats::compute(const AssemblyGraph &graph) {
+    GraphStats stats;
+
+    std::vector<DeBruijnNode *> nodes;
+    for (auto *node : graph.m_deBruijnGraphNodes) {
+        if (node->isPositiveNode())
+            nodes.push_back(node);
+    }
+    stats.nodeCount = int(nodes.size());
+    if (nodes.empty())
+        return stats;
+
+    // Per node values, gathered in parallel over chunks of nodes
+    std::vector<NodeInfo> nodeInfos(nodes.size());
+    std::vector<Partial> partials;
+    const size_t chunkSize = 16384;
+    for (size_t begin = 0; begin < nodes.size(); begin += chunkSize)
+        partials.push_back({begin, std::min(begin + chunkSize, nodes.size())});
+
+    QtConcurrent::blockingMap(partials, [&](Partial &partial) {
+        for (size_t i = partial.begin; i < partial.end; ++i) {
+            const DeBruijnNode *node = nodes[i];
+            int length = node->getLength();
+
+            bool entering = false, leaving = false;
+            int maxOverlap = 0, maxLeavingOverlap = 0;
+            for (const auto *edge : node->edges()) {
+                int overlap = edge->getOverlap();
+                maxOverlap = std::max(maxOverlap, overlap);
+                if (edge->getEndingNode() == node)
+                    entering = true;
+                if (edge->getStartingNode() == node) {
+                    leaving = true;
+                    maxLeavingOverlap = std::max(maxLeavingOverlap, overlap);
+                }
+            }
+
+            nodeInfos[i] = addNode(partial, length, node->getDepth(), entering, leaving,
+                                   maxOverlap, maxLeavingOverlap);
+        }
+    });
+    addPartials(stats, partials);
+
+    // Edges: overlap range and connected components
+    phmap::flat_hash_map<const DeBruijnNode *, uint32_t> nodeIndices;
+    nodeIndices.reserve(nodes.size());
+    for (uint32_t i = 0; i < nodes.size(); ++i)
+        nodeIndices.emplace(nodes[i], i);
+    auto positiveIndex = [&](const DeBruijnNode *node) {
+        return nodeIndices.at(node->isPositiveNode() ? node : node->getReverseComplement());
+    };
+
+    int smallestOverlap = std::numeric_limits<int>::max();
+    UnionFind components(nodes.size());
+    for (const auto &entry : graph.m_deBruijnGraphEdges) {
+        const DeBruijnEdge *edge = entry.second;
+        if (edge->isPositiveEdge())
+            stats.edgeCount += 1;
+        smallestOverlap = std::min(smallestOverlap, edge->getOverlap());
+        stats.largestOverlap = std::max(stats.largestOverlap, edge->getOverlap());
+        components.unite(positiveIndex(edge->getStartingNode()), positiveIndex(edge->getEndingNode()));
+    }
+    stats.smallestOverlap = smallestOverlap == std::numeric_limits<int>::max() ? 0 : smallestOverlap;
+
+    setComponentStats(stats, components, nodeInfos);
+    setSortedStats(stats, graph.getNodeRangeIndex(), nodeInfos);
+
+    return stats;
+}
+
+namespace {
+// Ids of the node pairs of a GFA file by name, without the sign. Names are
+// copied into large blocks, so that the map only holds views.
+class PairNames {
+  public:
+    static constexpr uint32_t NONE = UINT32_MAX;
+
+    uint32_t find(std::string_view name) const {
+        auto it = m_ids.find(name);
+        return it == m_ids.end() ? NONE : it->second;
+    }
+
+    uint32_t add(std::string_view name) {
+        uint32_t id = find(name);
+        if (id == NONE) {
+            id = uint32_t(m_ids.size());
+            m_ids.emplace(store(name), id);
+        }
+        return id;
+    }
+
+  private:
+    static constexpr size_t BLOCK_SIZE = 1 << 20;
+
+    std::string_view store(std::string_view name) {
+        if (m_blocks.empty() || m_blockUsed + name.size() > m_blockSize) {
+            m_blockSize = std::max(BLOCK_SIZE, name.size());
+            m_blocks.emplace_back(new char[m_blockSize]);
+            m_blockUsed = 0;
+        }
+        char *stored = m_blocks.back().get() + m_blockUsed;
+        std::copy(name.begin(), name.end(), stored);
+        m_blockUsed += name.size();
+        return {stored, name.size()};
+    }
+
+    std::vector<std::unique_ptr<char[]>> m_blocks;
+    size_t m_blockSize = 0, m_blockUsed = 0;
+    phmap::flat_hash_map<std::string_view, uint32_t> m_ids;
+};
+
+// An edge between oriented node pairs (2 * pair id, plus one for the negative
+// node). An edge and its reverse complement are stored the same way.
+struct Link {
+    uint32_t from, to;
+    int overlap;
+
+    static Link canonical(uint32_t from, uint32_t to, int overlap) {
+        Link link{from, to, overlap}, reverseComplement{to ^ 1, from ^ 1, overlap};
+        return reverseComplement < link ? reverseComplement : link;
+    }
+
+    bool operator<(const Link &other) const { return std::tie(from, to) < std::tie(other.from, other.to); }
+    bool operator==(const Link &other) const { return from == other.from && to == other.to; }
+};
+
+// The links of a file with duplicates removed: like the graph, the first of
+// them is kept. Up to maxInMemory links are held in memory; beyond that they
+// are sorted into runs in temporary files, which are merged at the end.
+class DistinctLinks {
+  public:
+    explicit DistinctLinks(size_t maxInMemory)
+            : m_maxInMemory(std::max(maxInMemory, size_t(1))) {}
+
+    void add(const Link &link) {
+        m_links.push_back(link);
+        if (m_links.size() >= m_maxInMemory)
+            writeRun();
+    }
+
+    // Calls f for every distinct link, in sorted order
+    template<typename F>
+    void forEach(F f) {
+        if (m_runs.empty()) {
+            sortLinks();
+            std::for_each(m_links.begin(), m_links.end(), f);
+            return;
+        }
+
+        if (!m_links.empty())
+            writeRun();
+        std::vector<Link>().swap(m_links);
+
+        // Equal links are taken from the earliest run, which is the earliest
+        // in the file
+        std::vector<RunReader> readers(m_runs.size());
+        using Head = std::pair<Link, size_t>;
+        auto later = [](const Head &a, const Head &b) {
+            return b.first < a.first || (a.first == b.first && b.second < a.second);
+        };
+        std::priority_queue<Head, std::vector<Head>, decltype(later)> heads(later);
+        for (size_t i = 0; i < m_runs.size(); ++i) {
+            readers[i].file = m_runs[i].get();
+            readers[i].file->seek(0);
+            Link link;
+            if (readers[i].next(link))
+                heads.emplace(link, i);
+        }
+
+        bool first = true;
+        Link last{};
+        while (!heads.empty()) {
+            auto [link, run] = heads.top();
+            heads.pop();
+            if (first || !(link == last))
+                f(link);
+            first = false;
+            last = link;
+
+            if (readers[run].next(link))
+                heads.emplace(link, run);
+        }
+    }
+
+  private:
+    static constexpr size_t READ_BUFFER_SIZE = 1 << 16;
+
+    struct RunReader {
+        QTemporaryFile *file = nullptr;
+        std::vector<Link> buffer;
+        size_t pos = 0;
+
+        bool next(Link &link) {
+            if (pos == buffer.size()) {
+                buffer.resize(READ_BUFFER_SIZE);
+                qint64 read = file->read(reinterpret_cast<char *>(buffer.data()),
+                                         qint64(buffer.size() * sizeof(Link)));
+                buffer.resize(read > 0 ? size_t(read) / sizeof(Link) : 0);
+                pos = 0;
+                if (buffer.empty())
+                    return false;
+            }
+            link = buffer[pos++];
+            return true;
+        }
+    };
+
+    // Sorting is stable, so the first of equal links stays first
+    void sortLinks() {
+        std::stable_sort(m_links.begin(), m_links.end());
+        m_links.erase(std::unique(m_links.begin(), m_links.end()), m_links.end());
+    }
+
+    void writeRun() {
+        sortLinks();
+        auto file = std::make_unique<QTemporaryFile>();
+        qint64 size = qint64(m_links.size() * sizeof(Link));
+        if (!file->open() || file->write(reinterpret_cast<const char *>(m_links.data()), size) != size)
+            throw AssemblyGraphError("failed to write temporary file: " + file->fileName().toStdString());
+        m_runs.push_back(std::move(file));
+        m_links.clear();
+    }
+
+    size_t m_maxInMemory;
+    std::vector<Link> m_links;
+    std::vector<std::unique_ptr<QTemporaryFile>> m_runs;
+};
+
+// What is known about a node pair while the file is read
+enum PairFlags : uint8_t {
+    HAS_SEQUENCE = 1,
+    SEQUENCE_MISSING = 2,
+    LEAVES_POSITIVE = 4,
+    LEAVES_NEGATIVE = 8,
+};
+
+bool isMissingSequence(std::string_view sequence) {
+    return std::all_of(sequence.begin(), sequence.end(), is_N);
+}
+}
+
+GraphStats GraphStats::computeFromGfa(const QString &filename, size_t maxLinksInMemory) {
+    utils::LineReader in(filename);
+    if (!in.isOpen())
+        throw AssemblyGraphError("failed to open file: " + filename.toStdString());
+
+    // Every node pair is made when it is first named, by a segment, a link or
+    // a path, just as the graph makes placeholders for nodes it hasn't seen
+    PairNames names;
+    std::vector<int> lengths;
+    std::vector<double> depths;
+    std::vector<uint8_t> flags;
+    auto pairId = [&](std::string_view pairName) {
+        uint32_t id = names.add(pairName);
+        if (id == lengths.size()) {
+            lengths.push_back(0);
+            depths.push_back(0.0);
+            flags.push_back(SEQUENCE_MISSING);
+        }
+        return id;
+    };
+    // Node names are the pair name and the sign
+    auto orientedId = [&](std::string_view pairName, bool reverseComplement) {
+        return 2 * pairId(pairName) + uint32_t(reverseComplement);
+    };
+
+    DistinctLinks links(maxLinksInMemory);
+    bool sequencesAreMissing = false;
+    std::string_view line;
+    while (in.nextLine(line)) {
+        if (line.empty())
+            continue;
+
+        auto result = gfa::parse_record(line.data(), line.size());
+        if (!result)
+            continue;
+
+        std::visit([&](const auto &record) {
+            using T = std::decay_t<decltype(record)>;
+            if constexpr (std::is_same_v<T, gfa::segment>) {
+                // The same lengths and depths as the GFA loader gives the nodes
+                std::string_view pairName = record.name;
+                if (pairName.back() == '+' || pairName.back() == '-')
+                    pairName.remove_suffix(1);
+                uint32_t id = pairId(pairName);
+                if (flags[id] & HAS_SEQUENCE)
+                    throw AssemblyGraphError("Duplicate segment named: " + std::string(record.name));
+
+                const auto &seq = record.seq;
+                size_t length = seq.size();
+                bool missing;
+                if (!length || (length == 1 && seq.front() == '*')) {
+                    if (auto lnTag = gfa::getTag<int64_t>("LN", record.tags))
+                        length = size_t(*lnTag);
+                    sequencesAreMissing = true;
+                    missing = true;
+                } else
+                    missing = isMissingSequence(seq);
+
+                double depth = 0;
+                if (auto dpTag = gfa::getTag<float>("DP", record.tags))
+                    depth = *dpTag;
+                else if (auto kcTag = gfa::getTag<int64_t>("KC", record.tags))
+                    depth = double(*kcTag) / double(length);
+                else if (auto rcTag = gfa::getTag<int64_t>("RC", record.tags))
+                    depth = double(*rcTag) / double(length);
+                else if (auto fcTag = gfa::getTag<int64_t>("FC", record.tags))
+                    depth = double(*fcTag) / double(length);
+
+                lengths[id] = int(length);
+                depths[id] = depth;
+                flags[id] = uint8_t((length > 0 ? HAS_SEQUENCE : 0) | (missing ? SEQUENCE_MISSING : 0));
+            } else if constexpr (std::is_same_v<T, gfa::link>) {
+                int overlap = 0;
+                if (record.overlap.size() == 1 && record.overlap.front().op == 'M')
+                    overlap = int(record.overlap.front().count);
+                uint32_t from = orientedId(record.lhs, record.lhs_revcomp);
+                uint32_t to = orientedId(record.rhs, record.rhs_revcomp);
+                links.add(Link::canonical(from, to, overlap));
+            } else if constexpr (std::is_same_v<T, gfa::gaplink>) {
+                int overlap = int(record.distance == std::numeric_limits<int64_t>::min() ? 0 : record.distance);
+                uint32_t from = orientedId(record.lhs, record.lhs_revcomp);
+                uint32_t to = orientedId(record.rhs, record.rhs_revcomp);
+                links.add(Link::canonical(from, to, overlap));
+            } else if constexpr (std::is_same_v<T, gfa::path>) {
+                for (auto step : record.segments)
+                    pairId(step.substr(0, step.size() - 1));
+            }
+        }, *result);
+    }
+
+    // Sequences left out of the file are looked for in a FASTA file next to
+    // it, like the GFA loader does
+    if (sequencesAreMissing) {
+        QString fastaName = utils::findFastaForGraph(filename);
+        if (!fastaName.isEmpty()) {
+            utils::readFastx(fastaName, [&](std::string_view header, std::string_view sequence) {
+                uint32_t id = names.find(header.substr(0, header.find_first_of(" \t\v\f\r")));
+                if (id == PairNames::NONE || !(flags[id] & SEQUENCE_MISSING))
+                    return;
+                lengths[id] = int(sequence.size());
+                if (!sequence.empty() && !isMissingSequence(sequence))
+                    flags[id] &= ~SEQUENCE_MISSING;
+            });
+        }
+    }
+
+    GraphStats stats;
+    stats.nodeCount = int(lengths.size());
+    if (lengths.empty())
+        return stats;
+
+    // Edges: overlap range, connected components, and for every node the
+    // largest overlap of the edges leaving it
+    std::vector<int> maxLeavingOverlaps(2 * lengths.size(), 0);
+    int smallestOverlap = std::numeric_limits<int>::max();
+    UnionFind components(lengths.size());
+    links.forEach([&](const Link &link) {
+        stats.edgeCount += 1;
+        smallestOverlap = std::min(smallestOverlap, link.overlap);
+        stats.largestOverlap = std::max(stats.largestOverlap, link.overlap);
+        // The edge leaves its starting node, and its reverse complement
+        // leaves the opposite of the ending node
+        for (uint32_t start : {link.from, link.to ^ 1}) {
+            flags[start / 2] |= start % 2 ? LEAVES_NEGATIVE : LEAVES_POSITIVE;
+            maxLeavingOverlaps[start] = std::max(maxLeavingOverlaps[start], link.overlap);
+        }
+        components.unite(link.from / 2, link.to / 2);
+    });
+    stats.smallestOverlap = smallestOverlap == std::numeric_limits<int>::max() ? 0 : smallestOverlap;
+
+    // An edge enters the positive node exactly when its reverse complement
+    // leaves the negative one
+    std::vector<NodeInfo> nodeInfos(lengths.size());
+    std::vector<Partial> partials(1);
+    for (size_t i = 0; i < lengths.size(); ++i) {
+        int maxLeavingOverlap = maxLeavingOverlaps[2 * i];
+        int maxOverlap = std::max(maxLeavingOverlap, maxLeavingOverlaps[2 * i + 1]);
+        nodeInfos[i] = addNode(partials.front(), lengths[i], depths[i],
+                               flags[i] & LEAVES_NEGATIVE, flags[i] & LEAVES_POSITIVE,
+                               maxOverlap, maxLeavingOverlap);
+    }
+    addPartials(stats, partials);
+
+    setComponentStats(stats, components, nodeInfos);
+    NodeRangeIndex index;
+    index.build(lengths, depths);
+    setSortedStats(stats, index, nodeInfos);
+
+    return stats;
+}
@@ -0,0 +1,61 @@
+// Copyright 2022 Anton Korobeynikov
+
+// This file is part of Bandage
+
+// Bandage is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// Bandage is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstddef>
+
+class AssemblyGraph;
+class QString;
+
+// Summary statistics of a graph, as reported by 'Bandage info' and the graph
+// information dialog. Only positive nodes and edges are counted, so every
+// complementary pair counts as one.
+struct GraphStats {
+    int nodeCount = 0;
+    int edgeCount = 0;
+    int smallestOverlap = 0;
+    int largestOverlap = 0;
+    long long totalLength = 0;
+    long long totalLengthNoOverlaps = 0;
+    int deadEnds = 0;
+    double percentageDeadEnds = 0.0;
+    int componentCount = 0;
+    long long largestComponentLength = 0;
+    long long totalLengthOrphanedNodes = 0;
+    int n50 = 0;
+    int shortestNode = 0;
+    int firstQuartile = 0;
+    int median = 0;
+    int thirdQuartile = 0;
+    int longestNode = 0;
+    double medianDepthByBase = 0.0;
+    long long estimatedSequenceLength = 0;
+
+    // Gathers all statistics in a single (parallel) sweep over the nodes and
+    // edges. Components are found with union-find; the quantiles, the N50
+    // and the median depth by base come from the graph's NodeRangeIndex.
+    static GraphStats compute(const AssemblyGraph &graph);
+
+    // The same statistics read straight from a GFA file in one pass, for
+    // graphs too large to load. No nodes or edges are made: every node pair
+    // takes a few compact array entries and its name. Links are only kept to
+    // remove duplicates; beyond maxLinksInMemory of them, sorted runs go to
+    // temporary files and are merged at the end. Throws AssemblyGraphError
+    // where loading the graph would fail.
+    static GraphStats computeFromGfa(const QString &filename, size_t maxLinksInMemory = 1 << 24);
+};
@@ -25,8 +25,17 @@
 #include <colormap/tinycolormap.hpp>
 #include "parallel_hashmap/phmap.h"
 
+#include <QElapsedTimer>
+#include <QLoggingCategory>
+#include <QtConcurrent>
+
+#include <algorithm>
 #include <unordered_set>
 
+// Timings of the colouring passes, enable with
+// QT_LOGGING_RULES="bandage.nodecolour.debug=true"
+Q_LOGGING_CATEGORY(lcNodeColour, "bandage.nodecolour", QtInfoMsg)
+
 INodeColorer::INodeColorer(NodeColorScheme scheme)
     : m_graph(g_assemblyGraph), m_scheme(scheme) {
 }
@@ -39,6 +48,38 @@ std::pair<QColor, QColor> INodeColorer::get(const GraphicsItemNode *node,
     return { posColor, negColor };
 }
 
+void INodeColorer::colourNodes(const std::vector<GraphicsItemNode *> &nodes) {
+    QElapsedTimer timer;
+    timer.start();
+
+    if (isThreadSafe()) {
+        QtConcurrent::blockingMap(nodes, [this](GraphicsItemNode *node) {
+            node->setNodeColour(get(node));
+        });
+    } else {
+        phmap::flat_hash_set<const GraphicsItemNode *> coloured;
+        for (auto *node : nodes) {
+            if (coloured.contains(node))
+                continue;
+
+            GraphicsItemNode *rcNode = nullptr;
+            if (auto *rc = node->m_deBruijnNode->getReverseComplement())
+                rcNode = rc->getGraphicsItemNode();
+            if (rcNode && rcNode != node) {
+                auto colPair = get(node, rcNode);
+                node->setNodeColour(colPair.first);
+                rcNode->setNodeColour(colPair.second);
+                coloured.insert(rcNode);
+            } else {
+                node->setNodeColour(get(node));
+            }
+        }
+    }
+
+    qCDebug(lcNodeColour) << name() << "coloured" << nodes.size() << "nodes in"
+                          << timer.nsecsElapsed() / 1000 << "us";
+}
+
 std::unique_ptr<INodeColorer> INodeColorer::create(NodeColorScheme scheme) {
     switch (scheme) {
         case UNIFORM_COLOURS:
@@ -180,16 +221,26 @@ QColor GCNodeColorer::get(const GraphicsItemNode *node) {
 QColor TagValueNodeColorer::get(const GraphicsItemNode *node) {
     const DeBruijnNode *deBruijnNode = node->m_deBruijnNode;
 
-    auto tags = m_graph->m_nodeTags.find(deBruijnNode);
-    if (tags != m_graph->m_nodeTags.end()) {
-        if (auto tag = gfa::getTag(m_tagName.c_str(), tags->second)) {
+    auto it = m_nodeColors.find(deBruijnNode);
+    if (it != m_nodeColors.end())
+        return it->second;
+
+    return m_graph->getCustomColourForDisplay(deBruijnNode);
+}
+
+void TagValueNodeColorer::setTagName(const std::string &tagName) {
+    m_tagName = tagName;
+
+    // Resolve the colours of all nodes with the tag once, rather than
+    // formatting the tag of every node when it is coloured.
+    m_nodeColors.clear();
+    for (const auto &entry : m_graph->m_nodeTags) {
+        if (auto tag = gfa::getTag(m_tagName.c_str(), entry.second)) {
             std::stringstream stream;
             stream << *tag;
-            return m_allTags.at(stream.str());
+            m_nodeColors.emplace(entry.first, m_allTags.at(stream.str()));
         }
     }
-
-    return m_graph->getCustomColourForDisplay(deBruijnNode);
 }
 
 void TagValueNodeColorer::reset() {
@@ -220,50 +271,55 @@ void TagValueNodeColorer::reset() {
     }
 
     if (!m_tagNames.empty())
-        m_tagName = *m_tagNames.begin();
+        setTagName(*m_tagNames.begin());
 }
 
 QColor CSVNodeColorer::get(const GraphicsItemNode *node) {
     const DeBruijnNode *deBruijnNode = node->m_deBruijnNode;
 
-    auto val = m_graph->getCsvLine(deBruijnNode, m_colIdx);
-    if (!val || m_colIdx >= m_colors.size())
+    const auto &csvData = m_graph->m_nodeCSVData;
+    auto row = csvData.row(deBruijnNode);
+    if (row < 0 || m_colIdx >= csvData.columnCount() || m_colIdx >= m_colors.size())
         return m_graph->getCustomColourForDisplay(deBruijnNode);
 
-    const auto &cols = m_colors[m_colIdx];
-    auto col = cols.find(val->toStdString());
-    if (col == cols.end())
+    const auto &column = csvData.column(m_colIdx);
+    if (!column.hasValue(row))
         return m_graph->getCustomColourForDisplay(deBruijnNode);
 
-    return *col;;
+    if (!column.isNumeric())
+        return m_colors[m_colIdx][column.category(row)];
+
+    double range = column.max() - column.min();
+    double fraction = range > 0 ? (column.number(row) - column.min()) / range : 0.5;
+    return tinycolormap::GetColor(fraction, colorMap(g_settings->colorMap)).ConvertToQColor();
 }
 
 void CSVNodeColorer::reset() {
     m_colors.clear();
 
-    size_t columns = m_graph->m_csvHeaders.size();
-    m_colors.resize(columns);
-    // Store all unique values into a map
-    for (const auto &entry : m_graph->m_nodeCSVData) {
-        const auto &row = entry.second;
-        for (size_t i = 0; i < row.size() && i < columns; ++i) {
-            const auto &cell = row[i];
-            m_colors[i].insert(cell.toStdString(), QColor(cell));
+    const auto &csvData = m_graph->m_nodeCSVData;
+    m_colors.resize(csvData.columnCount());
+    for (size_t i = 0; i < csvData.columnCount(); ++i) {
+        const auto &column = csvData.column(i);
+        if (column.isNumeric())
+            continue;
+
+        // Use the values that are colours as they are, assign all others
+        // according to colormap in the order of their names
+        const auto &categories = column.categories();
+        auto &colors = m_colors[i];
+        colors.resize(categories.size());
+        std::vector<uint32_t> invalid;
+        for (uint32_t category = 0; category < categories.size(); ++category) {
+            colors[category] = QColor(QString::fromStdString(categories[category]));
+            if (!colors[category].isValid())
+                invalid.push_back(category);
         }
-    }
 
-    // Assign all invalid colors according to colormap
-    for (auto &column : m_colors) {
-        size_t invalid = 0;
-        for (const auto &entry : column)
-            invalid += !entry.isValid();
-        size_t i = 0;
-        for (auto &entry : column) {
-            if (entry.isValid())
-                continue;
-            entry = tinycolormap::GetColor(double(i) / double(invalid),
-                                           colorMap(g_settings->colorMap)).ConvertToQColor();
-            i += 1;
-        }
+        std::sort(invalid.begin(), invalid.end(),
+                  [&](uint32_t a, uint32_t b) { return categories[a] < categories[b]; });
+        for (size_t j = 0; j < invalid.size(); ++j)
+            colors[invalid[j]] = tinycolormap::GetColor(double(j) / double(invalid.size()),
+                                                        colorMap(g_settings->colorMap)).ConvertToQColor();
     }
 }
@@ -20,6 +20,9 @@
 #include <QColor>
 #include <QSharedPointer>
 
+#include <memory>
+#include <vector>
+
 class AssemblyGraph;
 class GraphicsItemNode;
 
@@ -48,10 +51,18 @@ public:
     virtual void reset() {};
     [[nodiscard]] virtual const char* name() const = 0;
 
+    // Colours all the given nodes in a single pass. The pass is run in
+    // parallel unless the colorer has to see the nodes one by one. Nodes
+    // whose reverse complement is also drawn get their colours as a pair.
+    void colourNodes(const std::vector<GraphicsItemNode *> &nodes);
+
     static std::unique_ptr<INodeColorer> create(NodeColorScheme scheme);
 
     [[nodiscard]] NodeColorScheme scheme() const { return m_scheme; }
 protected:
+    // Whether get() may be called concurrently for different nodes
+    [[nodiscard]] virtual bool isThreadSafe() const { return true; }
+
     NodeColorScheme m_scheme;
     QSharedPointer<AssemblyGraph> m_graph;
 };
\ No newline at end of file
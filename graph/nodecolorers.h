@@ -20,9 +20,12 @@
 #include "nodecolorer.h"
 
 #include <tsl/htrie_map.h>
+#include "parallel_hashmap/phmap.h"
 #include <vector>
 #include <unordered_set>
 
+class DeBruijnNode;
+
 class DepthNodeColorer : public INodeColorer {
 public:
     using INodeColorer::INodeColorer;
@@ -47,6 +50,10 @@ public:
     [[nodiscard]] std::pair<QColor, QColor> get(const GraphicsItemNode *node,
                                                 const GraphicsItemNode *rcNode) override;
     [[nodiscard]] const char* name() const override { return "Random colors"; };
+
+protected:
+    // rand() is neither reentrant nor reproducible across threads
+    [[nodiscard]] bool isThreadSafe() const override { return false; }
 };
 
 class GrayNodeColorer : public INodeColorer {
@@ -93,7 +100,7 @@ public:
     void reset() override;
     [[nodiscard]] const char* name() const override { return "Color by tag value"; };
 
-    void setTagName(const std::string &tagName) { m_tagName = tagName; }
+    void setTagName(const std::string &tagName);
     [[nodiscard]] auto tagNames() const {
         std::vector<std::string> names(m_tagNames.begin(), m_tagNames.end());
         std::sort(names.begin(), names.end());
@@ -104,6 +111,8 @@ private:
     std::string m_tagName = "";
     tsl::htrie_map<char, QColor> m_allTags;
     std::unordered_set<std::string> m_tagNames;
+    // Colours of the nodes having the current tag
+    phmap::flat_hash_map<const DeBruijnNode *, QColor> m_nodeColors;
 };
 
 class CSVNodeColorer : public INodeColorer {
@@ -121,5 +130,7 @@ public:
 
 private:
     unsigned m_colIdx = 0;
-    std::vector<tsl::htrie_map<char, QColor>> m_colors;
+    // Colours of the categories of every category column, indexed by the
+    // category. Numeric columns are coloured through the colour map.
+    std::vector<std::vector<QColor>> m_colors;
 };
\ No newline at end of file
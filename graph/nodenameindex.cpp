@@ -0,0 +1,322 @@
+// Copyright 2022 Anton Korobeynikov
+
+// This file is part of Bandage
+
+// Bandage is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// Bandage is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "nodenameindex.h"
+
+#include "debruijnnode.h"
+
+#include <QRegularExpression>
+#include <QtConcurrent>
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+static uint32_t trigramKey(const char *str) {
+    return uint32_t(uint8_t(str[0])) << 16 | uint32_t(uint8_t(str[1])) << 8 | uint32_t(uint8_t(str[2]));
+}
+
+// Distinct trigrams of the string, in no particular order
+static void getTrigrams(std::string_view str, std::vector<uint32_t> &trigrams) {
+    trigrams.clear();
+    for (size_t i = 0; i + 3 <= str.size(); ++i)
+        trigrams.push_back(trigramKey(str.data() + i));
+    std::sort(trigrams.begin(), trigrams.end());
+    trigrams.erase(std::unique(trigrams.begin(), trigrams.end()), trigrams.end());
+}
+
+NodeNameIndex::~NodeNameIndex() {
+    waitForBuild();
+}
+
+void NodeNameIndex::build(const NodeMap &nodes) {
+    m_names.clear();
+    m_nameOffsets.assign(1, 0);
+    m_nodes.clear();
+    m_nodes.reserve(nodes.size());
+    m_nameOffsets.reserve(nodes.size() + 1);
+
+    std::string key;
+    for (auto it = nodes.begin(); it != nodes.end(); ++it) {
+        it.key(key);
+        m_names += key;
+        m_names += '\0';
+        m_nameOffsets.push_back(m_names.size());
+        m_nodes.push_back(it.value());
+    }
+
+    // Two passes over the names: count the names containing each trigram,
+    // then fill in the ids. Ids come in increasing order, so every list is
+    // sorted without further work.
+    m_trigramSlots.clear();
+    std::vector<size_t> counts;
+    std::vector<uint32_t> trigrams;
+    for (uint32_t id = 0; id < m_nodes.size(); ++id) {
+        getTrigrams(name(id), trigrams);
+        for (uint32_t trigram : trigrams) {
+            auto [it, inserted] = m_trigramSlots.try_emplace(trigram, uint32_t(counts.size()));
+            if (inserted)
+                counts.push_back(0);
+            counts[it->second] += 1;
+        }
+    }
+
+    m_postingOffsets.assign(counts.size() + 1, 0);
+    for (size_t slot = 0; slot < counts.size(); ++slot)
+        m_postingOffsets[slot + 1] = m_postingOffsets[slot] + counts[slot];
+
+    m_postings.resize(m_postingOffsets.back());
+    std::vector<size_t> fill(m_postingOffsets.begin(), m_postingOffsets.end() - 1);
+    for (uint32_t id = 0; id < m_nodes.size(); ++id) {
+        getTrigrams(name(id), trigrams);
+        for (uint32_t trigram : trigrams)
+            m_postings[fill[m_trigramSlots[trigram]]++] = id;
+    }
+
+    m_built = true;
+}
+
+void NodeNameIndex::buildInBackground(const NodeMap &nodes) {
+    clear();
+    m_build = QtConcurrent::run([this, &nodes]() { build(nodes); });
+}
+
+void NodeNameIndex::clear() {
+    waitForBuild();
+
+    m_built = false;
+    m_names.clear();
+    m_nameOffsets.clear();
+    m_nodes.clear();
+    m_trigramSlots.clear();
+    m_postingOffsets.clear();
+    m_postings.clear();
+}
+
+bool NodeNameIndex::isBuilt() const {
+    waitForBuild();
+    return m_built;
+}
+
+void NodeNameIndex::waitForBuild() const {
+    if (m_build.isValid())
+        m_build.waitForFinished();
+}
+
+std::vector<uint32_t> NodeNameIndex::candidates(std::string_view query) const {
+    std::vector<uint32_t> trigrams;
+    getTrigrams(query, trigrams);
+
+    // Intersect starting from the shortest list, and stop early once few
+    // enough candidates are left to check them directly
+    std::vector<std::pair<size_t, size_t>> lists;
+    for (uint32_t trigram : trigrams) {
+        auto slot = m_trigramSlots.find(trigram);
+        if (slot == m_trigramSlots.end())
+            return {};
+        lists.emplace_back(m_postingOffsets[slot->second], m_postingOffsets[slot->second + 1]);
+    }
+    std::sort(lists.begin(), lists.end(),
+              [](const auto &a, const auto &b) { return a.second - a.first < b.second - b.first; });
+
+    std::vector<uint32_t> result(m_postings.begin() + lists.front().first,
+                                 m_postings.begin() + lists.front().second);
+    std::vector<uint32_t> intersection;
+    for (size_t i = 1; i < lists.size() && result.size() > 16; ++i) {
+        intersection.clear();
+        std::set_intersection(result.begin(), result.end(),
+                              m_postings.begin() + lists[i].first, m_postings.begin() + lists[i].second,
+                              std::back_inserter(intersection));
+        result.swap(intersection);
+    }
+    return result;
+}
+
+std::vector<uint32_t> NodeNameIndex::scan(std::string_view query) const {
+    std::vector<uint32_t> result;
+    std::string_view names(m_names);
+    size_t pos = 0;
+    while ((pos = names.find(query, pos)) != std::string_view::npos) {
+        // Map the match back to its name and carry on after that name
+        auto next = std::upper_bound(m_nameOffsets.begin(), m_nameOffsets.end(), pos);
+        result.push_back(uint32_t(next - m_nameOffsets.begin() - 1));
+        pos = *next;
+    }
+    return result;
+}
+
+std::vector<DeBruijnNode *> NodeNameIndex::findSubstring(std::string_view query) const {
+    waitForBuild();
+
+    std::vector<DeBruijnNode *> result;
+    if (query.empty()) {
+        result = m_nodes;
+    } else if (query.size() < 3) {
+        for (uint32_t id : scan(query))
+            result.push_back(m_nodes[id]);
+    } else {
+        for (uint32_t id : candidates(query)) {
+            if (name(id).find(query) != std::string_view::npos)
+                result.push_back(m_nodes[id]);
+        }
+    }
+    return result;
+}
+
+std::vector<DeBruijnNode *> NodeNameIndex::findPrefix(std::string_view prefix) const {
+    waitForBuild();
+
+    std::vector<DeBruijnNode *> result;
+    auto check = [&](uint32_t id) {
+        if (name(id).substr(0, prefix.size()) == prefix)
+            result.push_back(m_nodes[id]);
+    };
+    if (prefix.size() < 3) {
+        for (uint32_t id = 0; id < m_nodes.size(); ++id)
+            check(id);
+    } else {
+        for (uint32_t id : candidates(prefix))
+            check(id);
+    }
+    return result;
+}
+
+std::vector<DeBruijnNode *> NodeNameIndex::findMatching(const QRegularExpression &regex) const {
+    waitForBuild();
+
+    std::vector<DeBruijnNode *> result;
+    if (!regex.isValid())
+        return result;
+
+    // A case insensitive match could differ from the literal in case
+    bool anchored = false;
+    std::string literal;
+    if (!(regex.patternOptions() & QRegularExpression::CaseInsensitiveOption))
+        literal = requiredLiteral(regex.pattern().toStdString(), &anchored);
+
+    auto check = [&](uint32_t id) {
+        std::string_view str = name(id);
+        if (regex.match(QString::fromUtf8(str.data(), qsizetype(str.size()))).hasMatch())
+            result.push_back(m_nodes[id]);
+    };
+    if (literal.size() < 3) {
+        for (uint32_t id = 0; id < m_nodes.size(); ++id)
+            check(id);
+    } else {
+        for (uint32_t id : candidates(literal)) {
+            std::string_view str = name(id);
+            if (anchored ? str.substr(0, literal.size()) == literal : str.find(literal) != std::string_view::npos)
+                check(id);
+        }
+    }
+    return result;
+}
+
+// A conservative scan of the pattern: runs of plain characters are required
+// unless a quantifier makes their last character optional. Alternation and
+// inline options give up, groups and character classes end a run, and the
+// scan stops at escapes other than escaped punctuation.
+std::string NodeNameIndex::requiredLiteral(std::string_view pattern, bool *anchored) {
+    if (anchored)
+        *anchored = false;
+    if (pattern.find('|') != std::string_view::npos || pattern.find("(?") != std::string_view::npos)
+        return {};
+
+    std::string best, current;
+    bool bestAnchored = false, currentAnchored = false;
+    auto endRun = [&]() {
+        if (current.size() > best.size()) {
+            best = current;
+            bestAnchored = currentAnchored;
+        }
+        current.clear();
+        currentAnchored = false;
+    };
+    // Drops the last (UTF-8) character of the run
+    auto dropLast = [&]() {
+        while (!current.empty() && (uint8_t(current.back()) & 0xC0) == 0x80)
+            current.pop_back();
+        if (!current.empty())
+            current.pop_back();
+    };
+
+    size_t i = 0;
+    if (!pattern.empty() && pattern[0] == '^') {
+        currentAnchored = true;
+        i = 1;
+    }
+
+    int depth = 0;
+    while (i < pattern.size()) {
+        char c = pattern[i];
+        if (c == '\\') {
+            // Escaped punctuation is a plain character. Other escapes take
+            // arguments of varying length (\x5f, \0101, \p{L}, \Q...\E), so
+            // the scan stops at them.
+            if (i + 1 < pattern.size() && !std::isalnum(uint8_t(pattern[i + 1]))) {
+                if (depth == 0)
+                    current += pattern[i + 1];
+                else
+                    endRun();
+                i += 2;
+            } else {
+                endRun();
+                break;
+            }
+        } else if (c == '(') {
+            endRun();
+            ++depth, ++i;
+        } else if (c == ')') {
+            depth = std::max(depth - 1, 0);
+            ++i;
+        } else if (c == '[') {
+            endRun();
+            // A ']' straight after the opening bracket is part of the class
+            size_t end = i + 1;
+            if (end < pattern.size() && pattern[end] == '^')
+                ++end;
+            if (end < pattern.size() && pattern[end] == ']')
+                ++end;
+            while (end < pattern.size() && pattern[end] != ']')
+                end += pattern[end] == '\\' ? 2 : 1;
+            i = end + 1;
+        } else if (c == '*' || c == '?' || c == '{') {
+            dropLast();
+            endRun();
+            if (c == '{') {
+                size_t end = pattern.find('}', i);
+                i = end == std::string_view::npos ? pattern.size() : end + 1;
+            } else {
+                ++i;
+            }
+        } else if (c == '+' || c == '.' || c == '^' || c == '$') {
+            endRun();
+            ++i;
+        } else {
+            if (depth == 0)
+                current += c;
+            else
+                endRun();
+            ++i;
+        }
+    }
+    endRun();
+
+    if (anchored)
+        *anchored = bestAnchored;
+    return best;
+}
@@ -0,0 +1,94 @@
+// Copyright 2022 Anton Korobeynikov
+
+// This file is part of Bandage
+
+// Bandage is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// Bandage is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "parallel_hashmap/phmap.h"
+#include "tsl/htrie_map.h"
+
+#include <QFuture>
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class DeBruijnNode;
+class QRegularExpression;
+
+// Index for partial node name searches. All names are stored back to back in
+// a single buffer and every distinct trigram of a name maps to the sorted ids
+// of the names containing it. A substring query intersects the lists of its
+// trigrams and only checks the names left over; queries shorter than a
+// trigram scan the name buffer directly. Results are always in the graph's
+// node iteration order.
+//
+// The index is a snapshot of the node names: it has to be cleared whenever
+// nodes are added, removed or renamed. It can be built in a background
+// thread, any query or clear() waits for that build to finish.
+class NodeNameIndex {
+  public:
+    using NodeMap = tsl::htrie_map<char, DeBruijnNode *>;
+
+    NodeNameIndex() = default;
+    ~NodeNameIndex();
+
+    NodeNameIndex(const NodeNameIndex &) = delete;
+    NodeNameIndex &operator=(const NodeNameIndex &) = delete;
+
+    void build(const NodeMap &nodes);
+    void buildInBackground(const NodeMap &nodes);
+    void clear();
+    // Waits for a background build; true if the index can be queried.
+    bool isBuilt() const;
+    size_t size() const { return m_nodes.size(); }
+
+    // Nodes whose names contain the query
+    std::vector<DeBruijnNode *> findSubstring(std::string_view query) const;
+    // Nodes whose names start with the prefix
+    std::vector<DeBruijnNode *> findPrefix(std::string_view prefix) const;
+    // Nodes whose names match the regular expression. Candidates are narrowed
+    // down with a literal that every match must contain, if there is one.
+    std::vector<DeBruijnNode *> findMatching(const QRegularExpression &regex) const;
+
+    // The longest literal that every match of the pattern must contain, and
+    // whether that literal has to be at the start of the name.
+    static std::string requiredLiteral(std::string_view pattern, bool *anchored = nullptr);
+
+  private:
+    std::string_view name(uint32_t id) const {
+        return std::string_view(m_names).substr(m_nameOffsets[id], m_nameOffsets[id + 1] - m_nameOffsets[id] - 1);
+    }
+    // Ids of the names containing every trigram of the query, sorted. Not
+    // yet checked against the query itself.
+    std::vector<uint32_t> candidates(std::string_view query) const;
+    // Ids of the names containing the query, for queries shorter than a trigram
+    std::vector<uint32_t> scan(std::string_view query) const;
+    void waitForBuild() const;
+
+    // Names separated by '\0', so that no match spans two names
+    std::string m_names;
+    std::vector<size_t> m_nameOffsets;
+    std::vector<DeBruijnNode *> m_nodes;
+
+    phmap::flat_hash_map<uint32_t, uint32_t> m_trigramSlots;
+    std::vector<size_t> m_postingOffsets;
+    std::vector<uint32_t> m_postings;
+
+    bool m_built = false;
+    mutable QFuture<void> m_build;
+};
@@ -0,0 +1,159 @@
+// Copyright 2022 Anton Korobeynikov
+
+// This file is part of Bandage
+
+// Bandage is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// Bandage is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "noderangeindex.h"
+
+#include "debruijnnode.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+
+// Sorts the nodes by the key, keeping their order for equal keys, and fills
+// in the sorted keys and the running totals of the node lengths
+template<typename T, typename Key>
+static void sortNodes(std::vector<DeBruijnNode *> &nodes, std::vector<T> &keys,
+                      std::vector<long long> &lengthSums, Key key) {
+    std::stable_sort(nodes.begin(), nodes.end(),
+                     [&](const DeBruijnNode *a, const DeBruijnNode *b) { return key(a) < key(b); });
+
+    keys.resize(nodes.size());
+    lengthSums.resize(nodes.size() + 1);
+    lengthSums[0] = 0;
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        keys[i] = key(nodes[i]);
+        lengthSums[i + 1] = lengthSums[i] + nodes[i]->getLength();
+    }
+}
+
+// The value at a fractional index, interpolating between neighbours. The
+// values are given by position, so that they need not be stored.
+template<typename F>
+static double valueAtFractionalIndex(size_t size, double index, F valueAt) {
+    if (size == 0)
+        return 0.0;
+    if (size == 1 || index < 0.0)
+        return valueAt(0);
+
+    auto wholePart = size_t(std::floor(index));
+    if (wholePart >= size - 1)
+        return valueAt(size - 1);
+
+    double fractionalPart = index - double(wholePart);
+    return valueAt(wholePart) * (1.0 - fractionalPart) + valueAt(wholePart + 1) * fractionalPart;
+}
+
+void NodeRangeIndex::build(const NodeMap &nodes) {
+    m_byDepth.clear();
+    m_byDepth.reserve(nodes.size() / 2);
+    for (auto *node : nodes) {
+        if (node->isPositiveNode())
+            m_byDepth.push_back(node);
+    }
+    m_byLength = m_byDepth;
+
+    sortNodes(m_byDepth, m_depths, m_lengthSumsByDepth,
+              [](const DeBruijnNode *node) { return node->getDepth(); });
+    sortNodes(m_byLength, m_lengths, m_lengthSumsByLength,
+              [](const DeBruijnNode *node) { return node->getLength(); });
+
+    m_built = true;
+}
+
+void NodeRangeIndex::build(const std::vector<int> &lengths, const std::vector<double> &depths) {
+    clear();
+
+    std::vector<uint32_t> order(lengths.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(),
+                     [&](uint32_t a, uint32_t b) { return depths[a] < depths[b]; });
+    m_depths.resize(order.size());
+    m_lengthSumsByDepth.resize(order.size() + 1);
+    m_lengthSumsByDepth[0] = 0;
+    for (size_t i = 0; i < order.size(); ++i) {
+        m_depths[i] = depths[order[i]];
+        m_lengthSumsByDepth[i + 1] = m_lengthSumsByDepth[i] + lengths[order[i]];
+    }
+
+    m_lengths = lengths;
+    std::sort(m_lengths.begin(), m_lengths.end());
+    m_lengthSumsByLength.resize(m_lengths.size() + 1);
+    m_lengthSumsByLength[0] = 0;
+    for (size_t i = 0; i < m_lengths.size(); ++i)
+        m_lengthSumsByLength[i + 1] = m_lengthSumsByLength[i] + m_lengths[i];
+
+    m_built = true;
+}
+
+void NodeRangeIndex::clear() {
+    m_built = false;
+    m_byDepth.clear();
+    m_depths.clear();
+    m_lengthSumsByDepth.clear();
+    m_byLength.clear();
+    m_lengths.clear();
+    m_lengthSumsByLength.clear();
+}
+
+std::pair<size_t, size_t> NodeRangeIndex::depthRange(double min, double max) const {
+    if (!(min <= max))
+        return {0, 0};
+    auto first = std::lower_bound(m_depths.begin(), m_depths.end(), min);
+    auto last = std::upper_bound(first, m_depths.end(), max);
+    return {size_t(first - m_depths.begin()), size_t(last - m_depths.begin())};
+}
+
+std::pair<size_t, size_t> NodeRangeIndex::lengthRange(int min, int max) const {
+    if (min > max)
+        return {0, 0};
+    auto first = std::lower_bound(m_lengths.begin(), m_lengths.end(), min);
+    auto last = std::upper_bound(first, m_lengths.end(), max);
+    return {size_t(first - m_lengths.begin()), size_t(last - m_lengths.begin())};
+}
+
+double NodeRangeIndex::lengthAtFractionalIndex(double index) const {
+    return valueAtFractionalIndex(m_lengths.size(), index,
+                                  [this](size_t i) { return double(m_lengths[i]); });
+}
+
+double NodeRangeIndex::depthAtFractionalIndexBothStrands(double index) const {
+    return valueAtFractionalIndex(2 * m_depths.size(), index,
+                                  [this](size_t i) { return m_depths[i / 2]; });
+}
+
+int NodeRangeIndex::n50() const {
+    long long total = totalLength();
+    if (total <= 0)
+        return 0;
+
+    // The longest nodes down to position i hold total - sums[i] bases. The
+    // N50 node is the last position where that is still at least half.
+    double limit = double(total) - total / 2.0;
+    auto it = std::upper_bound(m_lengthSumsByLength.begin(), m_lengthSumsByLength.end(), limit,
+                               [](double value, long long sum) { return value < double(sum); });
+    return m_lengths[size_t(it - m_lengthSumsByLength.begin()) - 1];
+}
+
+double NodeRangeIndex::depthAtBaseIndex(long long index) const {
+    if (index < 0 || index >= totalLength())
+        return 0.0;
+
+    // The node whose bases cover the index: sums[i] <= index < sums[i + 1]
+    auto it = std::upper_bound(m_lengthSumsByDepth.begin(), m_lengthSumsByDepth.end(), index);
+    return m_depths[size_t(it - m_lengthSumsByDepth.begin()) - 1];
+}
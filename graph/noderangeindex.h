@@ -0,0 +1,81 @@
+// Copyright 2022 Anton Korobeynikov
+
+// This file is part of Bandage
+
+// Bandage is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// Bandage is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "tsl/htrie_map.h"
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+class DeBruijnNode;
+
+// The positive nodes of a graph sorted by depth and by length, with running
+// totals of their lengths in both orders. Range queries, quantiles, the N50
+// and the depth at a given base are then binary searches. Both strands of a
+// node share its depth and length, so only positive nodes are stored. Ties
+// keep the graph's node iteration order.
+//
+// The index is a snapshot: it has to be cleared whenever nodes are added or
+// removed, or their depths or lengths change.
+class NodeRangeIndex {
+  public:
+    using NodeMap = tsl::htrie_map<char, DeBruijnNode *>;
+
+    void build(const NodeMap &nodes);
+    // Builds the index from the lengths and depths of node pairs alone, for
+    // statistics gathered without a graph. byDepth() and byLength() stay empty.
+    void build(const std::vector<int> &lengths, const std::vector<double> &depths);
+    void clear();
+    bool isBuilt() const { return m_built; }
+    size_t size() const { return m_depths.size(); }
+    long long totalLength() const { return m_lengthSumsByLength.empty() ? 0 : m_lengthSumsByLength.back(); }
+
+    const std::vector<DeBruijnNode *> &byDepth() const { return m_byDepth; }
+    const std::vector<DeBruijnNode *> &byLength() const { return m_byLength; }
+
+    // Positions [first, last) in byDepth() of the nodes with min <= depth <= max
+    std::pair<size_t, size_t> depthRange(double min, double max) const;
+    // Positions [first, last) in byLength() of the nodes with min <= length <= max
+    std::pair<size_t, size_t> lengthRange(int min, int max) const;
+
+    // The length at a fractional index into the sorted lengths, interpolating
+    // between neighbours
+    double lengthAtFractionalIndex(double index) const;
+    // The same for depths, but counting both strands of every node, as the
+    // depth quartiles of a graph always have
+    double depthAtFractionalIndexBothStrands(double index) const;
+
+    // Going from the longest node down, the length of the node at which the
+    // running total reaches half of the total length
+    int n50() const;
+    // The depth of the base at the given index when all bases are ordered by
+    // the depth of their node
+    double depthAtBaseIndex(long long index) const;
+
+  private:
+    std::vector<DeBruijnNode *> m_byDepth;
+    std::vector<double> m_depths;
+    std::vector<long long> m_lengthSumsByDepth;
+
+    std::vector<DeBruijnNode *> m_byLength;
+    std::vector<int> m_lengths;
+    std::vector<long long> m_lengthSumsByLength;
+
+    bool m_built = false;
+};
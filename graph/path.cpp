@@ -22,9 +22,11 @@
 #include "assemblygraph.h"
 #include "sequenceutils.h"
 
+#include "parallel_hashmap/phmap.h"
+
 #include <QRegularExpression>
 #include <QStringList>
-#include <QApplication>
+#include <algorithm>
 #include <limits>
 #include <utility>
 
@@ -100,8 +102,7 @@ Path Path::makeFromOrderedNodes(QList<DeBruijnNode *> nodes, bool circular)
         //the path failed.
         if (!foundEdge)
         {
-            path.m_nodes.clear();
-            path.m_edges.clear();
+            path.clearNodesAndEdges();
             return path;
         }
     }
@@ -109,6 +110,8 @@ Path Path::makeFromOrderedNodes(QList<DeBruijnNode *> nodes, bool circular)
     if (path.m_nodes.empty())
         return path;
 
+    path.recalculateFullLength();
+
     //If the code got here, then the path building was successful.
     path.m_startLocation = GraphLocation::startOfNode(path.m_nodes.front());
     path.m_endLocation = GraphLocation::endOfNode(path.m_nodes.back());
@@ -255,8 +258,7 @@ void Path::buildUnambiguousPathFromNodes(QList<DeBruijnNode *> nodes,
 
         if (!addSuccess)
         {
-            m_nodes.clear();
-            m_edges.clear();
+            clearNodesAndEdges();
             return;
         }
     }
@@ -265,8 +267,7 @@ void Path::buildUnambiguousPathFromNodes(QList<DeBruijnNode *> nodes,
     //other, then the path is ambiguous and we fail.
     if (checkForOtherEdges())
     {
-        m_nodes.clear();
-        m_edges.clear();
+        clearNodesAndEdges();
         return;
     }
 
@@ -289,7 +290,7 @@ bool Path::addNode(DeBruijnNode * newNode, bool strandSpecific, bool makeCircula
     //If the Path is empty, then this function always succeeds.
     if (m_nodes.isEmpty())
     {
-        m_nodes.push_back(newNode);
+        pushBack(nullptr, newNode);
         m_startLocation = GraphLocation::startOfNode(newNode);
         m_endLocation = GraphLocation::endOfNode(newNode);
 
@@ -299,7 +300,7 @@ bool Path::addNode(DeBruijnNode * newNode, bool strandSpecific, bool makeCircula
             //too to make a circular path.
             DeBruijnEdge * selfLoopingEdge = newNode->getSelfLoopingEdge();
             if (selfLoopingEdge != nullptr)
-                m_edges.push_back(selfLoopingEdge);
+                pushBack(selfLoopingEdge, nullptr);
         }
 
         return true;
@@ -348,18 +349,16 @@ bool Path::addNode(DeBruijnNode * newNode, bool strandSpecific, bool makeCircula
     if (edgeIntoFirst != nullptr && edgeAwayFromLast == nullptr &&
             revCompEdgeIntoFirst == nullptr && revCompEdgeAwayFromLast == nullptr)
     {
-        m_nodes.push_front(newNode);
+        pushFront(newNode, edgeIntoFirst);
         m_startLocation = GraphLocation::startOfNode(newNode);
-        m_edges.push_front(edgeIntoFirst);
         return true;
     }
 
     if (edgeIntoFirst == nullptr && edgeAwayFromLast != nullptr &&
             revCompEdgeIntoFirst == nullptr && revCompEdgeAwayFromLast == nullptr)
     {
-        m_nodes.push_back(newNode);
+        pushBack(edgeAwayFromLast, newNode);
         m_endLocation = GraphLocation::endOfNode(newNode);
-        m_edges.push_back(edgeAwayFromLast);
         return true;
     }
 
@@ -367,9 +366,8 @@ bool Path::addNode(DeBruijnNode * newNode, bool strandSpecific, bool makeCircula
             revCompEdgeIntoFirst != nullptr && revCompEdgeAwayFromLast == nullptr)
     {
         newNode = newNode->getReverseComplement();
-        m_nodes.push_front(newNode);
+        pushFront(newNode, revCompEdgeIntoFirst);
         m_startLocation = GraphLocation::startOfNode(newNode);
-        m_edges.push_front(revCompEdgeIntoFirst);
         return true;
     }
 
@@ -377,27 +375,24 @@ bool Path::addNode(DeBruijnNode * newNode, bool strandSpecific, bool makeCircula
             revCompEdgeIntoFirst == nullptr && revCompEdgeAwayFromLast != nullptr)
     {
         newNode = newNode->getReverseComplement();
-        m_nodes.push_back(newNode);
+        pushBack(revCompEdgeAwayFromLast, newNode);
         m_endLocation = GraphLocation::endOfNode(newNode);
-        m_edges.push_back(revCompEdgeAwayFromLast);
         return true;
     }
 
     if (edgeIntoFirst != nullptr && edgeAwayFromLast != nullptr &&
             revCompEdgeIntoFirst == nullptr && revCompEdgeAwayFromLast == nullptr)
     {
-        m_edges.push_back(edgeAwayFromLast);
-        m_nodes.push_back(newNode);
-        m_edges.push_back(edgeIntoFirst);
+        pushBack(edgeAwayFromLast, newNode);
+        pushBack(edgeIntoFirst, nullptr);
         return true;
     }
 
     if (edgeIntoFirst == nullptr && edgeAwayFromLast == nullptr &&
             revCompEdgeIntoFirst != nullptr && revCompEdgeAwayFromLast != nullptr)
     {
-        m_edges.push_back(revCompEdgeAwayFromLast);
-        m_nodes.push_back(newNode->getReverseComplement());
-        m_edges.push_back(revCompEdgeIntoFirst);
+        pushBack(revCompEdgeAwayFromLast, newNode->getReverseComplement());
+        pushBack(revCompEdgeIntoFirst, nullptr);
         return true;
     }
 
@@ -407,6 +402,53 @@ bool Path::addNode(DeBruijnNode * newNode, bool strandSpecific, bool makeCircula
 }
 
 
+//These functions add a node and the edge that connects it to the path (either
+//of which may be null) while keeping the cached path length up to date.
+void Path::pushBack(DeBruijnEdge * edge, DeBruijnNode * node)
+{
+    if (edge != nullptr)
+    {
+        m_edges.push_back(edge);
+        m_fullLength -= edge->getOverlap();
+    }
+    if (node != nullptr)
+    {
+        m_nodes.push_back(node);
+        m_fullLength += node->getLength();
+    }
+}
+
+void Path::pushFront(DeBruijnNode * node, DeBruijnEdge * edge)
+{
+    if (edge != nullptr)
+    {
+        m_edges.push_front(edge);
+        m_fullLength -= edge->getOverlap();
+    }
+    if (node != nullptr)
+    {
+        m_nodes.push_front(node);
+        m_fullLength += node->getLength();
+    }
+}
+
+void Path::clearNodesAndEdges()
+{
+    m_nodes.clear();
+    m_edges.clear();
+    m_fullLength = 0;
+}
+
+void Path::recalculateFullLength()
+{
+    m_fullLength = 0;
+    for (auto node : m_nodes)
+        m_fullLength += node->getLength();
+    for (auto edge : m_edges)
+        m_fullLength -= edge->getOverlap();
+}
+
+
 //This function looks to see if there are other edges connecting path nodes
 //that aren't in the list of path edges.  If so, it returns true.
 //This is used to check whether a Path is ambiguous or node.
@@ -443,36 +485,29 @@ QByteArray Path::getPathSequence() const
     if (m_nodes.empty())
         return "";
 
-    QByteArray sequence;
-    QByteArray firstNodeSequence = utils::sequenceToQByteArray(m_nodes[0]->getSequence());
+    utils::SequenceJoiner joiner;
 
     //If the path is circular, we trim the overlap from the first node.
+    const Sequence &firstNodeSequence = m_nodes[0]->getSequence();
     if (isCircular())
-    {
-        int overlap = m_edges.back()->getOverlap();
-        if (overlap != 0)
-            firstNodeSequence = modifySequenceUsingOverlap(firstNodeSequence, overlap);
-        sequence += firstNodeSequence;
-    }
+        joiner.add(firstNodeSequence, m_edges.back()->getOverlap());
 
     //If the path is linear, then we begin either with the entire first node
     //sequence or part of it.
     else
     {
-        int rightChars = firstNodeSequence.length() - m_startLocation.getPosition() + 1;
-        sequence += firstNodeSequence.right(rightChars);
+        int length = int(firstNodeSequence.size());
+        int rightChars = std::clamp(length - m_startLocation.getPosition() + 1, 0, length);
+        joiner.add(firstNodeSequence.Subseq(length - rightChars, length));
     }
 
     //The middle nodes are not affected by whether or not the path is circular
     //or has partial node ends.
     for (int i = 1; i < m_nodes.size(); ++i)
-    {
-        int overlap = m_edges[i-1]->getOverlap();
-        QByteArray nodeSequence = utils::sequenceToQByteArray(m_nodes[i]->getSequence());
-        if (overlap != 0)
-            nodeSequence = modifySequenceUsingOverlap(nodeSequence, overlap);
-        sequence += nodeSequence;
-    }
+        joiner.add(m_nodes[i]->getSequence(), m_edges[i-1]->getOverlap());
+
+    QByteArray sequence(qsizetype(joiner.size()), Qt::Uninitialized);
+    joiner.decode(sequence.data());
 
     DeBruijnNode * lastNode = m_nodes.back();
     int amountToTrimFromEnd = lastNode->getLength() - m_endLocation.getPosition();
@@ -482,32 +517,12 @@ QByteArray Path::getPathSequence() const
 }
 
 
-//This function will trim bases from the start of a sequence (in the case of
-//positive overlap) or add Ns to the start (in the case of negative overlap).
-QByteArray Path::modifySequenceUsingOverlap(QByteArray sequence, int overlap)
-{
-    if (overlap > 0)
-    {
-        int rightChars = sequence.length() - overlap;
-        if (rightChars >= 0)
-            sequence = sequence.right(rightChars);
-    }
-    else if (overlap < 0)
-        sequence = QByteArray(-overlap, 'N') + sequence;
-
-    return sequence;
-}
-
-
 int Path::getLength() const
 {
-    int length = 0;
-    for (auto m_node : m_nodes)
-        length += m_node->getLength();
-
-    for (auto m_edge : m_edges)
-        length -= m_edge->getOverlap();
+    if (m_nodes.empty())
+        return 0;
 
+    int length = m_fullLength;
     length -= m_startLocation.getPosition() - 1;
 
     DeBruijnNode * lastNode = m_nodes.back();
@@ -619,8 +634,7 @@ bool Path::canNodeFitOnEnd(DeBruijnNode * node, Path * extendedPath) const
         if (edge->getStartingNode() == lastNode && edge->getEndingNode() == node)
         {
             *extendedPath = *this;
-            extendedPath->m_edges.push_back(edge);
-            extendedPath->m_nodes.push_back(node);
+            extendedPath->pushBack(edge, node);
             extendedPath->m_endLocation = GraphLocation::endOfNode(node);
             return true;
         }
@@ -646,8 +660,7 @@ bool Path::canNodeFitAtStart(DeBruijnNode * node, Path * extendedPath) const
         if (edge->getStartingNode() == node && edge->getEndingNode() == firstNode)
         {
             *extendedPath = *this;
-            extendedPath->m_edges.push_front(edge);
-            extendedPath->m_nodes.push_front(node);
+            extendedPath->pushFront(node, edge);
             extendedPath->m_startLocation = GraphLocation::startOfNode(node);
             return true;
         }
@@ -678,8 +691,7 @@ QList<Path> Path::extendPathInAllPossibleWays() const
         DeBruijnNode * nextNode = nextEdge->getEndingNode();
 
         Path newPath(*this);
-        newPath.m_edges.push_back(nextEdge);
-        newPath.m_nodes.push_back(nextNode);
+        newPath.pushBack(nextEdge, nextNode);
         newPath.m_endLocation = GraphLocation::endOfNode(nextNode);
 
         returnList.push_back(newPath);
@@ -734,53 +746,180 @@ bool Path::hasNodeSubset(const Path& other) const
     return false;
 }
 
+//This function flags the paths which are sub-paths of another, larger path in
+//the list, i.e. element i is true if paths[i].hasNodeSubset(paths[j]) for some
+//j.  Rather than comparing every pair, each path's node sequence is hashed and
+//only looked up among the same-length windows of the longer paths.  Hash
+//matches are confirmed by comparing the nodes, so the result is exact.
+std::vector<bool> Path::findSubPaths(const std::vector<Path> &paths)
+{
+    std::vector<bool> isSubPath(paths.size(), false);
+    if (paths.size() < 2)
+        return isSubPath;
+
+    constexpr uint64_t base = 0x100000001B3ULL;
+    auto nodeHash = [](const DeBruijnNode * node) {
+        auto x = uint64_t(reinterpret_cast<uintptr_t>(node));
+        x ^= x >> 33;
+        x *= 0xFF51AFD7ED558CCDULL;
+        x ^= x >> 33;
+        return x;
+    };
+    auto signature = [](uint64_t hash, qsizetype length) {
+        return hash ^ (uint64_t(length) * 0x9E3779B97F4A7C15ULL);
+    };
+
+    //Index the paths by the signature of their whole node sequence.
+    phmap::flat_hash_map<uint64_t, std::vector<size_t>> pathsBySignature;
+    std::vector<qsizetype> lengths;
+    for (size_t i = 0; i < paths.size(); ++i)
+    {
+        const auto &nodes = paths[i].m_nodes;
+        uint64_t hash = 0;
+        for (auto node : nodes)
+            hash = hash * base + nodeHash(node);
+        pathsBySignature[signature(hash, nodes.size())].push_back(i);
+        lengths.push_back(nodes.size());
+    }
+    std::sort(lengths.begin(), lengths.end());
+    lengths.erase(std::unique(lengths.begin(), lengths.end()), lengths.end());
+
+    //Now slide a window of each candidate length along every path which is
+    //longer than it, and check whether the window matches a shorter path.
+    for (const auto &path : paths)
+    {
+        const auto &nodes = path.m_nodes;
+        for (qsizetype windowLength : lengths)
+        {
+            if (windowLength >= nodes.size())
+                break;
+            //An empty path is trivially contained in any longer path.
+            if (windowLength == 0)
+            {
+                for (size_t candidate : pathsBySignature[signature(0, 0)])
+                    isSubPath[candidate] = true;
+                continue;
+            }
+
+            uint64_t highestPower = 1;
+            for (qsizetype k = 1; k < windowLength; ++k)
+                highestPower *= base;
+
+            uint64_t hash = 0;
+            for (qsizetype k = 0; k < nodes.size(); ++k)
+            {
+                if (k >= windowLength)
+                    hash -= highestPower * nodeHash(nodes[k - windowLength]);
+                hash = hash * base + nodeHash(nodes[k]);
+                if (k + 1 < windowLength)
+                    continue;
+
+                auto it = pathsBySignature.find(signature(hash, windowLength));
+                if (it == pathsBySignature.end())
+                    continue;
+
+                auto windowStart = nodes.begin() + (k + 1 - windowLength);
+                for (size_t candidate : it->second)
+                {
+                    const auto &candidateNodes = paths[candidate].m_nodes;
+                    if (!isSubPath[candidate] &&
+                        candidateNodes.size() == windowLength &&
+                        std::equal(candidateNodes.begin(), candidateNodes.end(), windowStart))
+                        isSubPath[candidate] = true;
+                }
+            }
+        }
+    }
+
+    return isSubPath;
+}
+
+
 //This function builds all possible paths between the given start and end,
 //within the given restrictions.
+//The search doesn't copy a whole Path for each extension: every step only
+//records its node, the edge leading to it, its parent step and the length so
+//far, so extensions share their prefixes.  Full Path objects are only built
+//for the paths which are actually returned.
 QList<Path> Path::getAllPossiblePaths(GraphLocation startLocation,
                                       GraphLocation endLocation,
                                       int nodeSearchDepth,
                                       int minDistance, int maxDistance)
 {
     QList<Path> finishedPaths;
-    QList<Path> unfinishedPaths;
 
-    unfinishedPaths.emplace_back(startLocation);
+    DeBruijnNode * startNode = startLocation.getNode();
+    DeBruijnNode * endNode = endLocation.getNode();
+    if (startNode == nullptr)
+        return finishedPaths;
+
+    struct Step
+    {
+        size_t parent;
+        DeBruijnEdge * edge;
+        DeBruijnNode * node;
+        int length;
+    };
+    constexpr size_t noParent = std::numeric_limits<size_t>::max();
+
+    std::vector<Step> steps;
+    steps.push_back({noParent, nullptr, startNode,
+                     startNode->getLength() - (startLocation.getPosition() - 1)});
+
+    auto buildPath = [&steps, &startLocation, &endLocation](size_t stepIndex) {
+        std::vector<const Step *> chain;
+        for (size_t i = stepIndex; i != noParent; i = steps[i].parent)
+            chain.push_back(&steps[i]);
+
+        Path path;
+        for (auto step = chain.rbegin(); step != chain.rend(); ++step)
+            path.pushBack((*step)->edge, (*step)->node);
+        path.m_startLocation = startLocation;
+        path.m_endLocation = endLocation;
+        return path;
+    };
 
+    std::vector<size_t> unfinishedSteps = {0};
     for (int i = 0; i <= nodeSearchDepth; ++i)
     {
-        QApplication::processEvents();
-
         //Look at each of the unfinished paths to see if they end with the end
         //node.  If so, see if it has the appropriate length.
         //If it does, it will go into the final returned list.
         //If it doesn't and it's over length, then it will be removed.
-        QList<Path>::iterator j = unfinishedPaths.begin();
-        while (j != unfinishedPaths.end())
+        std::vector<size_t> keptSteps;
+        keptSteps.reserve(unfinishedSteps.size());
+        for (size_t stepIndex : unfinishedSteps)
         {
-            DeBruijnNode * lastNode = (*j).m_nodes.back();
-            if (lastNode == endLocation.getNode())
+            const Step &step = steps[stepIndex];
+            if (step.node == endNode)
             {
-                Path potentialFinishedPath = *j;
-                potentialFinishedPath.m_endLocation = endLocation;
-                int length = potentialFinishedPath.getLength();
+                int length = step.length - (endNode->getLength() - endLocation.getPosition());
                 if (length >= minDistance && length <= maxDistance)
-                    finishedPaths.push_back(potentialFinishedPath);
-                ++j;
-            }
-            else
-            {
-                if ((*j).getLength() > maxDistance)
-                    j = unfinishedPaths.erase(j);
-                else
-                    ++j;
+                    finishedPaths.push_back(buildPath(stepIndex));
+                keptSteps.push_back(stepIndex);
             }
+            else if (step.length <= maxDistance)
+                keptSteps.push_back(stepIndex);
         }
 
+        //Extensions made after the last round would never be looked at.
+        if (i == nodeSearchDepth)
+            break;
+
         //Make new unfinished paths by extending each of the paths.
-        QList<Path> newUnfinishedPaths;
-        for (auto & unfinishedPath : unfinishedPaths)
-            newUnfinishedPaths.append(unfinishedPath.extendPathInAllPossibleWays());
-        unfinishedPaths = newUnfinishedPaths;
+        unfinishedSteps.clear();
+        for (size_t stepIndex : keptSteps)
+        {
+            DeBruijnNode * lastNode = steps[stepIndex].node;
+            int length = steps[stepIndex].length;
+            for (auto nextEdge : lastNode->getLeavingEdges())
+            {
+                DeBruijnNode * nextNode = nextEdge->getEndingNode();
+                unfinishedSteps.push_back(steps.size());
+                steps.push_back({stepIndex, nextEdge, nextNode,
+                                 length + nextNode->getLength() - nextEdge->getOverlap()});
+            }
+        }
     }
 
     return finishedPaths;
@@ -84,6 +84,7 @@ public:
                                            GraphLocation endLocation,
                                            int nodeSearchDepth,
                                            int minDistance, int maxDistance);
+    static std::vector<bool> findSubPaths(const std::vector<Path> &paths);
 
 private:
     GraphLocation m_startLocation;
@@ -91,9 +92,17 @@ private:
     QList<DeBruijnNode *> m_nodes;
     QList<DeBruijnEdge *> m_edges;
 
+    //The summed length of all nodes minus all edge overlaps, i.e. the path
+    //length ignoring the start/end positions.  It is kept up to date as nodes
+    //and edges are added, so getLength() doesn't need to walk the path.
+    int m_fullLength = 0;
+
+    void pushBack(DeBruijnEdge * edge, DeBruijnNode * node);
+    void pushFront(DeBruijnNode * node, DeBruijnEdge * edge);
+    void clearNodesAndEdges();
+    void recalculateFullLength();
     void buildUnambiguousPathFromNodes(QList<DeBruijnNode *> nodes,
                                        bool strandSpecific);
-    static QByteArray modifySequenceUsingOverlap(QByteArray sequence, int overlap) ;
     bool checkForOtherEdges();
 };
 
@@ -18,51 +18,88 @@
 #include "sequenceutils.h"
 
 #include <QByteArray>
-#include <QRegularExpression>
 #include <QStringList>
 
+#include <algorithm>
+
 namespace utils {
+    void SequenceJoiner::add(const Sequence &sequence, int overlap) {
+        int length = int(sequence.size());
+        if (overlap > 0 && length - overlap >= 0)
+            m_pieces.push_back({sequence.Subseq(size_t(overlap), size_t(length)), 0});
+        else
+            m_pieces.push_back({sequence, size_t(overlap < 0 ? -overlap : 0)});
+        m_size += m_pieces.back().leadingNs + m_pieces.back().sequence.size();
+    }
+
+    char *SequenceJoiner::decode(char *out) const {
+        for (const auto &piece : m_pieces) {
+            out = std::fill_n(out, piece.leadingNs, 'N');
+            out = piece.sequence.decode(out);
+        }
+        return out;
+    }
+
     QByteArray addNewlinesToSequence(const QByteArray &sequence, int interval) {
         QByteArray output;
+        output.reserve(sequence.length() + sequence.length() / interval + 1);
 
         int charactersRemaining = sequence.length();
         int currentIndex = 0;
         while (charactersRemaining > interval) {
-            output += sequence.mid(currentIndex, interval);
-            output += "\n";
+            output.append(sequence.constData() + currentIndex, interval);
+            output.append('\n');
             charactersRemaining -= interval;
             currentIndex += interval;
         }
-        output += sequence.mid(currentIndex);
-        output += "\n";
+        output.append(sequence.constData() + currentIndex, charactersRemaining);
+        output.append('\n');
 
         return output;
     }
 
-    QStringList splitCsv(const QString &line, const QString &sep) {
-        // TODO: use libraries for parsing CSV
-        QRegularExpression rx(R"(("(?:[^"]|"")*"|[^)" + sep + "]*)(?:" + sep + "|$)");
-        QStringList list;
-
-        auto it = rx.globalMatch(line);
-        while (it.hasNext()) {
-            auto match = it.next();
-            QString field = match.captured().replace("\"\"", "\"");
-            if (field.endsWith(sep)) {
-                field.chop(sep.length());
-            }
-            if (!field.isEmpty() && field[0] == '"' && field[field.length() - 1] == '"') {
-                field = field.mid(1, field.length() - 2);
+    size_t splitCsv(std::string_view line, char sep, std::vector<std::string> &fields) {
+        size_t count = 0;
+        size_t pos = 0;
+        while (true) {
+            if (fields.size() <= count)
+                fields.emplace_back();
+            auto &field = fields[count++];
+            field.clear();
+
+            if (pos < line.size() && line[pos] == '"') {
+                // Quoted field, "" stands for a single quote
+                size_t i = pos + 1;
+                bool closed = false;
+                for (; i < line.size(); ++i) {
+                    if (line[i] != '"') {
+                        field += line[i];
+                    } else if (i + 1 < line.size() && line[i + 1] == '"') {
+                        field += '"';
+                        ++i;
+                    } else {
+                        closed = true;
+                        ++i;
+                        break;
+                    }
+                }
+                if (closed && (i == line.size() || line[i] == sep)) {
+                    if (i == line.size())
+                        break;
+                    pos = i + 1;
+                    continue;
+                }
+                // Not a well-formed quoted field, take it verbatim
+                field.clear();
             }
-            list << field;
-        }
 
-        // regexp always matches empty string at the end
-        // if string ends with separator then we need to store it
-        if (!line.endsWith(sep)) {
-            list.pop_back();
+            size_t next = line.find(sep, pos);
+            field.assign(line.substr(pos, next == std::string_view::npos ? next : next - pos));
+            if (next == std::string_view::npos)
+                break;
+            pos = next + 1;
         }
 
-        return list;
+        return count;
     }
 } // namespace utils
\ No newline at end of file
@@ -23,12 +23,39 @@
 
 #include "seq/sequence.hpp"
 
+#include <string>
+#include <string_view>
+#include <vector>
+
 namespace utils {
     static inline QByteArray sequenceToQByteArray(const Sequence &sequence) {
-        auto sequence_str = sequence.str();
-        return {sequence_str.c_str(), static_cast<qsizetype>(sequence_str.size())};
+        QByteArray res(static_cast<qsizetype>(sequence.size()), Qt::Uninitialized);
+        sequence.decode(res.data());
+        return res;
     }
 
+    // Joins the sequences of consecutive nodes, each overlapping the one
+    // before it. Positive overlaps trim bases from the start of a node's
+    // sequence (if it is long enough) and negative overlaps add Ns before it.
+    // The pieces are collected first, so the result can be allocated once and
+    // the packed nucleotides decoded straight into it.
+    class SequenceJoiner {
+      public:
+        void add(const Sequence &sequence, int overlap = 0);
+        // The length of the joined sequence
+        size_t size() const { return m_size; }
+        // Writes size() characters and returns the end of them
+        char *decode(char *out) const;
+
+      private:
+        struct Piece {
+            Sequence sequence;
+            size_t leadingNs;
+        };
+        std::vector<Piece> m_pieces;
+        size_t m_size = 0;
+    };
+
     // This function is used when making FASTA outputs - it breaks a sequence into
     // separate lines.  The default interval is 70, as that seems to be what NCBI
     // uses.
@@ -36,12 +63,14 @@ namespace utils {
     QByteArray addNewlinesToSequence(const QByteArray &sequence,
                                      int interval = 70);
 
-    // Split a QString according to CSV rules
-    // @param line  line of a csv
-    // @param sep   field separator to use
-    // @result      list of fields with escaping removed
+    // Split a line according to CSV rules
+    // @param line    line of a csv
+    // @param sep     field separator to use
+    // @param fields  receives the fields with escaping removed. The strings
+    //                are reused between calls to avoid reallocations.
+    // @result        number of fields
     //
     // Known Bugs: CSV (as per RFC4180) allows multi-line fields (\r\n between "..."), which
     //             can't be parsed line-by line, hence isn't supported.
-    QStringList splitCsv(const QString& line, const QString& sep=",");
+    size_t splitCsv(std::string_view line, char sep, std::vector<std::string> &fields);
 }
\ No newline at end of file
@@ -0,0 +1,138 @@
+// Copyright 2022 Anton Korobeynikov
+
+// This file is part of Bandage
+
+// Bandage is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// Bandage is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "unitigs.h"
+
+#include "assemblygraph.h"
+#include "debruijnedge.h"
+#include "debruijnnode.h"
+#include "sequenceutils.h"
+
+#include "parallel_hashmap/phmap.h"
+
+#include <QtConcurrent>
+
+#include <algorithm>
+#include <string>
+
+// The edge if the node has exactly one leaving edge
+static DeBruijnEdge *onlyLeavingEdge(const DeBruijnNode *node) {
+    DeBruijnEdge *result = nullptr;
+    for (auto *edge : node->edges()) {
+        if (edge->getStartingNode() != node)
+            continue;
+        if (result != nullptr)
+            return nullptr;
+        result = edge;
+    }
+    return result;
+}
+
+// The edge if the node has exactly one entering edge
+static DeBruijnEdge *onlyEnteringEdge(const DeBruijnNode *node) {
+    DeBruijnEdge *result = nullptr;
+    for (auto *edge : node->edges()) {
+        if (edge->getEndingNode() != node)
+            continue;
+        if (result != nullptr)
+            return nullptr;
+        result = edge;
+    }
+    return result;
+}
+
+std::vector<Unitig> Unitig::find(const AssemblyGraph &graph) {
+    std::vector<Unitig> unitigs;
+
+    // A node belongs to at most one unitig, and then its reverse complement
+    // is not in any
+    phmap::flat_hash_set<const DeBruijnNode *> claimed;
+    claimed.reserve(graph.m_deBruijnGraphNodes.size());
+    auto claim = [&](const DeBruijnNode *node) {
+        claimed.insert(node);
+        claimed.insert(node->getReverseComplement());
+    };
+
+    std::vector<DeBruijnNode *> backwardNodes;
+    std::vector<DeBruijnEdge *> backwardEdges;
+    for (auto *node : graph.m_deBruijnGraphNodes) {
+        if (claimed.contains(node))
+            continue;
+        claim(node);
+
+        Unitig unitig;
+        unitig.nodes.push_back(node);
+
+        // Extend forward as much as possible
+        for (DeBruijnNode *last = node; ; ) {
+            DeBruijnEdge *edge = onlyLeavingEdge(last);
+            if (edge == nullptr)
+                break;
+            DeBruijnNode *next = edge->getEndingNode();
+            if (claimed.contains(next) || onlyEnteringEdge(next) != edge)
+                break;
+            claim(next);
+            unitig.nodes.push_back(next);
+            unitig.edges.push_back(edge);
+            last = next;
+        }
+
+        // Then backward, collecting the nodes in reverse
+        backwardNodes.clear();
+        backwardEdges.clear();
+        for (DeBruijnNode *first = node; ; ) {
+            DeBruijnEdge *edge = onlyEnteringEdge(first);
+            if (edge == nullptr)
+                break;
+            DeBruijnNode *previous = edge->getStartingNode();
+            if (claimed.contains(previous) || onlyLeavingEdge(previous) != edge)
+                break;
+            claim(previous);
+            backwardNodes.push_back(previous);
+            backwardEdges.push_back(edge);
+            first = previous;
+        }
+
+        if (unitig.nodes.size() + backwardNodes.size() < 2)
+            continue;
+
+        unitig.nodes.insert(unitig.nodes.begin(), backwardNodes.rbegin(), backwardNodes.rend());
+        unitig.edges.insert(unitig.edges.begin(), backwardEdges.rbegin(), backwardEdges.rend());
+        unitigs.push_back(std::move(unitig));
+    }
+
+    return unitigs;
+}
+
+// The same sequence as a linear path along the nodes
+static Sequence buildMergedSequence(const Unitig &unitig) {
+    utils::SequenceJoiner joiner;
+    joiner.add(unitig.nodes.front()->getSequence());
+    for (size_t i = 1; i < unitig.nodes.size(); ++i)
+        joiner.add(unitig.nodes[i]->getSequence(), unitig.edges[i - 1]->getOverlap());
+
+    std::string bases(joiner.size(), 'N');
+    joiner.decode(bases.data());
+    return Sequence(bases);
+}
+
+void Unitig::buildMergedNodes(std::vector<Unitig> &unitigs) {
+    QtConcurrent::blockingMap(unitigs, [](Unitig &unitig) {
+        unitig.sequence = buildMergedSequence(unitig);
+        unitig.depth = AssemblyGraph::getMeanDepth(unitig.nodes);
+    });
+}
@@ -0,0 +1,47 @@
+// Copyright 2022 Anton Korobeynikov
+
+// This file is part of Bandage
+
+// Bandage is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// Bandage is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "seq/sequence.hpp"
+
+#include <vector>
+
+class AssemblyGraph;
+class DeBruijnEdge;
+class DeBruijnNode;
+
+// A maximal non-branching chain of nodes (a unitig), which can be merged into
+// a single node. Every node but the first has exactly one entering edge, from
+// the node before it, which is also that node's only leaving edge.
+struct Unitig {
+    std::vector<DeBruijnNode *> nodes;
+    // edges[i] joins nodes[i] and nodes[i + 1]
+    std::vector<DeBruijnEdge *> edges;
+
+    // The merged node: the sequence along the chain and the length weighted
+    // mean depth. Filled in by buildMergedNodes().
+    Sequence sequence;
+    double depth = 0.0;
+
+    // All unitigs of two or more nodes, in one linear pass over the nodes.
+    // Only one strand of each unitig is listed.
+    static std::vector<Unitig> find(const AssemblyGraph &graph);
+
+    // Builds the merged sequences and depths, with the unitigs in parallel.
+    static void buildMergedNodes(std::vector<Unitig> &unitigs);
+};
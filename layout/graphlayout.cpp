@@ -47,13 +47,12 @@ namespace layout {
     }
 
     void apply(AssemblyGraph &graph, const GraphLayout &layout) {
-        // First, determine the set of nodes to be drawn from the layout
-        graph.resetNodes();
+        // The set of nodes to be drawn is the one from the layout, the drawn
+        // edges follow from it
+        std::vector<DeBruijnNode *> nodes;
+        nodes.reserve(layout.size());
         for (auto& entry : layout)
-            entry.first->setAsDrawn();
-
-        // Then loop through each edge determining its drawn status
-        for (auto &entry : graph.m_deBruijnGraphEdges)
-            entry.second->determineIfDrawn();
+            nodes.push_back(entry.first);
+        graph.setDrawnNodes(nodes);
     }
 }
\ No newline at end of file
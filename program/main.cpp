@@ -22,9 +22,12 @@
 
 #include "command_line/load.h"
 #include "command_line/info.h"
+#include "command_line/paths.h"
+#include "command_line/contiguity.h"
 #include "command_line/image.h"
 #include "command_line/querypaths.h"
 #include "command_line/reduce.h"
+#include "command_line/filter.h"
 #include "command_line/commoncommandlinefunctions.h"
 
 #include "program/settings.h"
@@ -62,7 +65,10 @@ void printUsage(QTextStream * out, bool all)
     text << "info         Display information about a graph";
     text << "image        Generate an image file of a graph";
     text << "querypaths   Output graph paths for BLAST queries";
+    text << "paths        Output the graph paths going through nodes";
+    text << "contiguity   Output the nodes contiguous with given nodes";
     text << "reduce       Save a subgraph of a larger graph";
+    text << "filter       Remove nodes by depth or length";
     text << "";
     text << "Options:  --help       View this help message";
     text << "--helpall    View all command line settings";
@@ -161,12 +167,30 @@ int main(int argc, char *argv[])
             g_memory->commandLineCommand = BANDAGE_QUERY_PATHS;
             return bandageQueryPaths(arguments);
         }
+        else if (first.toLower() == "paths")
+        {
+            arguments.pop_front();
+            g_memory->commandLineCommand = BANDAGE_PATHS;
+            return bandagePaths(arguments);
+        }
+        else if (first.toLower() == "contiguity")
+        {
+            arguments.pop_front();
+            g_memory->commandLineCommand = BANDAGE_CONTIGUITY;
+            return bandageContiguity(arguments);
+        }
         else if (first.toLower() == "reduce")
         {
             arguments.pop_front();
             g_memory->commandLineCommand = BANDAGE_REDUCE;
             return bandageReduce(arguments);
         }
+        else if (first.toLower() == "filter")
+        {
+            arguments.pop_front();
+            g_memory->commandLineCommand = BANDAGE_FILTER;
+            return bandageFilter(arguments);
+        }
 
         //Since a recognised command was not seen, we now check to see if the user
         //was looking for help information.
@@ -20,6 +20,13 @@
 #include "graph/debruijnnode.h"
 #include "graph/debruijnedge.h"
 #include "graph/annotationsmanager.h"
+#include "graph/graphstats.h"
+#include "graph/bufferedwriter.h"
+#include "graph/coarsening.h"
+#include "graph/contiguity.h"
+#include "graph/fileutils.h"
+#include "graph/sequenceutils.h"
+#include "graph/unitigs.h"
 
 #include "layout/graphlayoutworker.h"
 #include "layout/io.h"
@@ -28,13 +35,19 @@
 #include "program/memory.h"
 #include "program/globals.h"
 #include "command_line/commoncommandlinefunctions.h"
+#include "command_line/reduce.h"
 
 #include "blast/blastsearch.h"
 
+#include "ui/mygraphicsview.h"
+#include "ui/pathspecifydialog.h"
+
 #include <QtTest/QtTest>
 #include <QDebug>
 #include <QTemporaryDir>
+#include <QBuffer>
 
+#include <clocale>
 #include <iostream>
 
 class BandageTests : public QObject
@@ -104,29 +117,48 @@ private slots:
     void loadTrinity();
     void pathFunctionsOnLastGraph();
     void pathFunctionsOnFastg();
+    void findSubPaths();
     void pathFunctionsOnGfaSequencesInGraph();
     void pathFunctionsOnGfaSequencesInFasta();
     void graphLocationFunctions();
     void loadCsvData();
     void loadCsvDataTrinity();
+    void csvDataColumns();
     void blastSearch();
     void blastSearchFilters();
     void graphScope();
+    void contiguity();
+    void nodeNameIndex();
+    void graphCoarsening();
+    void expandWithPathDialogOpen();
+    void nodeRangeIndex();
     void commandLineSettings();
     void sciNotComparisons();
     void graphEdits();
     void velvetToGfa();
     void spadesToGfa();
     void mergeNodesOnGfa();
+    void reduceMerge();
     void changeNodeNames();
     void changeNodeDepths();
     void blastQueryPaths();
     void bandageInfo();
+    void bandageInfoStreaming();
     void sequenceInit();
     void sequenceInitN();
     void sequenceAccess();
     void sequenceSubstring();
     void sequenceDoubleReverseComplement();
+    void sequenceRangeEquals();
+    void sequenceComposition();
+    void sequenceCompositionBenchmark_data();
+    void sequenceCompositionBenchmark();
+    void bufferedWriter();
+    void fastxReader();
+    void parseNumbersInCommaLocale();
+    void fastaExport();
+    void graphLoadingBenchmark_data();
+    void graphLoadingBenchmark();
 
 
 private:
@@ -155,6 +187,13 @@ void BandageTests::loadFastg()
     DeBruijnNode * node28 = g_assemblyGraph->m_deBruijnGraphNodes["28-"];
     QCOMPARE(node1->getLength(), 6070);
     QCOMPARE(node28->getLength(), 79);
+
+    //The overlaps were determined automatically: all are 77, even for the
+    //few edges where 23 would also fit.
+    for (auto &entry : g_assemblyGraph->m_deBruijnGraphEdges) {
+        QCOMPARE(entry.second->getOverlapType(), AUTO_DETERMINED_EXACT_OVERLAP);
+        QCOMPARE(entry.second->getOverlap(), 77);
+    }
 }
 
 void BandageTests::loadGFAWithPlaceholders()
@@ -188,6 +227,16 @@ void BandageTests::loadGFA12()
     QCOMPARE(g_assemblyGraph->m_deBruijnGraphNodes.size(), 12);
     QCOMPARE(g_assemblyGraph->m_deBruijnGraphEdges.size(), 16);
     QCOMPARE(g_assemblyGraph->m_deBruijnGraphPaths.size(), 5);
+
+    //Check the index of paths going through each node.
+    const auto &paths = g_assemblyGraph->m_deBruijnGraphPaths;
+    auto occurrences = paths.occurrences(g_assemblyGraph->m_deBruijnGraphNodes["966103-"]);
+    QCOMPARE(std::distance(occurrences.begin(), occurrences.end()), 2);
+    QCOMPARE(QString::fromStdString(paths.name(occurrences.begin()->path)), QString("NODE_1_length_100000_cov_216.538276_1"));
+    QCOMPARE(occurrences.begin()->step, 1u);
+    QCOMPARE((occurrences.begin() + 1)->step, 3u);
+    QCOMPARE(paths.pathsThroughNode(g_assemblyGraph->m_deBruijnGraphNodes["115+"]).size(), size_t(3));
+    QCOMPARE(paths.pathsThroughNode(g_assemblyGraph->m_deBruijnGraphNodes["115-"]).size(), size_t(0));
 }
 
 
@@ -294,6 +343,49 @@ void BandageTests::pathFunctionsOnFastg()
 }
 
 
+//The signature-based sub-path search should agree with checking every pair of
+//paths with hasNodeSubset.
+void BandageTests::findSubPaths()
+{
+    g_assemblyGraph->loadGraphFromFile(testFile("test.fastg"));
+
+    QString pathStringFailure;
+    std::vector<Path> paths;
+    paths.push_back(Path::makeFromString("6+, 26+, 23+, 26+, 24+", false, &pathStringFailure));
+    paths.push_back(Path::makeFromString("26+, 23+", false, &pathStringFailure));
+    paths.push_back(Path::makeFromString("23+, 26+, 24+", false, &pathStringFailure));
+    paths.push_back(Path::makeFromString("26+, 24+", false, &pathStringFailure));
+    paths.push_back(Path::makeFromString("6+, 26+, 23+, 26+, 24+", false, &pathStringFailure));
+    paths.push_back(Path::makeFromString("26+", false, &pathStringFailure));
+    paths.push_back(Path::makeFromString("1+", false, &pathStringFailure));
+    for (const auto &path : paths)
+        QCOMPARE(path.isEmpty(), false);
+
+    std::vector<bool> isSubPath = Path::findSubPaths(paths);
+    QCOMPARE(isSubPath.size(), paths.size());
+    for (size_t i = 0; i < paths.size(); ++i)
+    {
+        bool expected = false;
+        for (size_t j = 0; j < paths.size(); ++j)
+        {
+            if (i != j && paths[i].hasNodeSubset(paths[j]))
+                expected = true;
+        }
+        QCOMPARE(bool(isSubPath[i]), expected);
+    }
+
+    //The two copies of the longest path do not eliminate each other, and a
+    //node which is not in any longer path survives.
+    QCOMPARE(bool(isSubPath[0]), false);
+    QCOMPARE(bool(isSubPath[1]), true);
+    QCOMPARE(bool(isSubPath[2]), true);
+    QCOMPARE(bool(isSubPath[3]), true);
+    QCOMPARE(bool(isSubPath[4]), false);
+    QCOMPARE(bool(isSubPath[5]), true);
+    QCOMPARE(bool(isSubPath[6]), false);
+}
+
+
 //This function tests paths on a GFA file which keeps its sequences in the GFA
 //file.
 void BandageTests::pathFunctionsOnGfaSequencesInGraph()
@@ -441,6 +533,7 @@ void BandageTests::loadCsvData()
 
     QCOMPARE(columns.size(), 3);
     QCOMPARE(errormsg, QString("There were 2 unmatched entries in the CSV."));
+    QVERIFY(!g_assemblyGraph->m_nodeCSVData.column(0).isNumeric());
 
     QCOMPARE(g_assemblyGraph->getCsvLine(node6Plus, 0), QString("SIX_PLUS"));
     QCOMPARE(g_assemblyGraph->getCsvLine(node6Plus, 1), QString("6plus"));
@@ -513,6 +606,81 @@ void BandageTests::loadCsvDataTrinity()
     QCOMPARE(g_assemblyGraph->getCsvLine(node3940Plus, 0), QString("3940PLUS"));
 }
 
+// Switches numbers to a locale with a decimal comma, if one is installed, as
+// QCoreApplication sets the user's locale. The previous locale is restored
+// on destruction.
+class CommaDecimalLocale {
+  public:
+    CommaDecimalLocale() : m_previous(setlocale(LC_NUMERIC, nullptr)) {
+        for (const char *name : {"de_DE.UTF-8", "de_DE.utf8", "de_DE", "fr_FR.UTF-8", "fr_FR.utf8", "fr_FR"}) {
+            if (setlocale(LC_NUMERIC, name) != nullptr && localeconv()->decimal_point[0] == ',')
+                return;
+        }
+        setlocale(LC_NUMERIC, m_previous.c_str());
+        m_previous.clear();
+    }
+    ~CommaDecimalLocale() {
+        if (isSet())
+            setlocale(LC_NUMERIC, m_previous.c_str());
+    }
+
+    bool isSet() const { return !m_previous.empty(); }
+
+  private:
+    std::string m_previous;
+};
+
+void BandageTests::csvDataColumns()
+{
+    CsvData data;
+    data.setColumnCount(3);
+    data.addRow({"0.10", "1", "a"});
+    data.addRow({"1e3", "-2", "b"});
+    data.addRow({"", "", "a"});
+    data.finalize();
+
+    //Numbers are shown as they were written.
+    const CsvData::Column &numbers = data.column(0);
+    QCOMPARE(numbers.type(), CsvData::ColumnType::Double);
+    QCOMPARE(numbers.text(0), std::string("0.10"));
+    QCOMPARE(numbers.text(1), std::string("1e3"));
+    QCOMPARE(numbers.number(1), 1000.0);
+    QVERIFY(!numbers.hasValue(2));
+    QCOMPARE(numbers.min(), 0.1);
+    QCOMPARE(numbers.max(), 1000.0);
+    QCOMPARE(data.column(1).type(), CsvData::ColumnType::Integer);
+    QCOMPARE(data.column(1).text(1), std::string("-2"));
+    QCOMPARE(data.column(2).type(), CsvData::ColumnType::Category);
+
+    //A value added later that is not a number turns the column into a
+    //category column, which keeps the text of the earlier values.
+    data.addRow({"2.50", "x", "c"});
+    QCOMPARE(numbers.type(), CsvData::ColumnType::Double);
+    QCOMPARE(numbers.text(3), std::string("2.50"));
+    data.addRow({"many", "3", "c"});
+    QCOMPARE(numbers.type(), CsvData::ColumnType::Category);
+    QCOMPARE(numbers.text(0), std::string("0.10"));
+    QCOMPARE(numbers.text(4), std::string("many"));
+    QCOMPARE(data.column(1).type(), CsvData::ColumnType::Category);
+    QCOMPARE(data.column(1).text(1), std::string("-2"));
+
+    //Numbers use a decimal point whatever the locale.
+    CommaDecimalLocale locale;
+    if (!locale.isSet())
+        QSKIP("No locale with a decimal comma is installed");
+    CsvData commaData;
+    commaData.setColumnCount(1);
+    commaData.addRow({"12.5"});
+    commaData.addRow({"1,5"});
+    commaData.finalize();
+    QCOMPARE(commaData.column(0).type(), CsvData::ColumnType::Category);
+    commaData.setColumnCount(1);
+    commaData.addRow({"12.5"});
+    commaData.finalize();
+    QCOMPARE(commaData.column(0).type(), CsvData::ColumnType::Double);
+    QCOMPARE(commaData.column(0).number(0), 12.5);
+}
+
 void BandageTests::blastSearch()
 {
     g_assemblyGraph->loadGraphFromFile(testFile("test.fastg"));
@@ -826,6 +994,21 @@ void BandageTests::graphScope()
     drawnNodes = g_assemblyGraph->getDrawnNodeCount();
     QCOMPARE(drawnNodes, 9);
 
+    // Drawing a narrower scope must clear the previous one without a full
+    // reset of the graph
+    g_settings->nodeDistance = 0;
+    g_assemblyGraph->markNodesToDraw(startingNodes, g_settings->nodeDistance);
+    drawnNodes = g_assemblyGraph->getDrawnNodeCount();
+    QCOMPARE(drawnNodes, 1);
+    int fullDrawnCount = 0;
+    for (auto *node : g_assemblyGraph->m_deBruijnGraphNodes)
+        fullDrawnCount += node->isDrawn();
+    QCOMPARE(fullDrawnCount, 1);
+    size_t fullDrawnEdgeCount = 0;
+    for (auto &entry : g_assemblyGraph->m_deBruijnGraphEdges)
+        fullDrawnEdgeCount += entry.second->isDrawn();
+    QCOMPARE(fullDrawnEdgeCount, g_assemblyGraph->getDrawnEdges().size());
+
     GraphLayout layout(*g_assemblyGraph);
     layout::io::load(testFile("test.layout"), layout);
     QCOMPARE(layout.size(), 42);
@@ -834,6 +1017,174 @@ void BandageTests::graphScope()
     QCOMPARE(drawnNodes, 42);
 }
 
+void BandageTests::contiguity()
+{
+    g_assemblyGraph->loadGraphFromFile(testFile("test.fastg"));
+
+    DeBruijnNode * node1 = g_assemblyGraph->m_deBruijnGraphNodes["1+"];
+    DeBruijnNode * node4 = g_assemblyGraph->m_deBruijnGraphNodes["4-"];
+    DeBruijnNode * node6 = g_assemblyGraph->m_deBruijnGraphNodes["6+"];
+    DeBruijnNode * node12 = g_assemblyGraph->m_deBruijnGraphNodes["12-"];
+
+    //Node 1+ has a single edge in each direction, so its neighbours are on
+    //every walk from it.
+    ContiguitySearch search(1);
+    ContiguitySearch::Statuses statuses = search.run({node1});
+    QCOMPARE(statuses[node1], STARTING);
+    QCOMPARE(statuses[node4], CONTIGUOUS_STRAND_SPECIFIC);
+    QCOMPARE(statuses[node12], CONTIGUOUS_STRAND_SPECIFIC);
+    QVERIFY(!statuses.contains(node6));
+
+    //Longer walks can only find more nodes.
+    ContiguitySearch longerSearch(5);
+    ContiguitySearch::Statuses longerStatuses = longerSearch.run({node1});
+    QVERIFY(longerStatuses.size() >= statuses.size());
+    for (const auto &[node, status] : statuses)
+        QVERIFY(longerStatuses.contains(node));
+
+    ContiguitySearch::apply(statuses);
+    QCOMPARE(node12->getContiguityStatus(), CONTIGUOUS_STRAND_SPECIFIC);
+    g_assemblyGraph->resetNodeContiguityStatus();
+    QCOMPARE(node12->getContiguityStatus(), NOT_CONTIGUOUS);
+}
+
+void BandageTests::nodeNameIndex()
+{
+    //Escapes with arguments end the required literal.
+    QCOMPARE(NodeNameIndex::requiredLiteral("A\\x5fNODE12"), std::string("A"));
+    QCOMPARE(NodeNameIndex::requiredLiteral("\\0101"), std::string());
+    QCOMPARE(NodeNameIndex::requiredLiteral("NODE\\.12"), std::string("NODE.12"));
+
+    //A regular expression with a hex escape finds the same nodes as a scan.
+    g_assemblyGraph->loadGraphFromFile(testFile("test.fastg"));
+    QRegularExpression regex("^\\x341\\+");
+    std::vector<DeBruijnNode *> matches = g_assemblyGraph->getNodeNameIndex().findMatching(regex);
+    QCOMPARE(matches.size(), size_t(1));
+    QCOMPARE(matches.front(), g_assemblyGraph->m_deBruijnGraphNodes["41+"]);
+
+    //Prefix queries, both shorter and longer than the indexed n-grams,
+    //agree with checking every name.
+    for (const QString &prefix : {QString("1"), QString("41+"), QString("10-")})
+    {
+        size_t expected = 0;
+        for (auto *node : g_assemblyGraph->m_deBruijnGraphNodes)
+            if (node->getName().startsWith(prefix))
+                ++expected;
+        QCOMPARE(g_assemblyGraph->getNodeNameIndex().findPrefix(prefix.toStdString()).size(), expected);
+    }
+    QCOMPARE(g_assemblyGraph->getNodeNameIndex().findPrefix("41+").front(),
+             g_assemblyGraph->m_deBruijnGraphNodes["41+"]);
+}
+
+void BandageTests::graphCoarsening()
+{
+    g_assemblyGraph->loadGraphFromFile(testFile("test.fastg"));
+    g_assemblyGraph->determineGraphInfo();
+
+    //The overview is smaller, but holds the same amount of sequence.
+    GraphCoarsening coarsening(*g_assemblyGraph);
+    coarsening.coarsen(1);
+    QSharedPointer<AssemblyGraph> overview = coarsening.buildOverview();
+    QVERIFY(overview->m_deBruijnGraphNodes.size() < g_assemblyGraph->m_deBruijnGraphNodes.size());
+    QCOMPARE(overview->m_totalLength, g_assemblyGraph->m_totalLength);
+
+    //Expanding every super-node gives back the original graph.
+    bool expanded = true;
+    while (expanded)
+    {
+        expanded = false;
+        for (auto *node : overview->m_deBruijnGraphNodes)
+        {
+            if (node->isPositiveNode() && coarsening.isSuperNode(node))
+            {
+                coarsening.expand(node);
+                expanded = true;
+                break;
+            }
+        }
+    }
+    QCOMPARE(overview->m_deBruijnGraphNodes.size(), 88);
+    QCOMPARE(overview->m_deBruijnGraphEdges.size(), 118);
+    for (auto *node : g_assemblyGraph->m_deBruijnGraphNodes)
+        QVERIFY(overview->m_deBruijnGraphNodes.count(node->getName().toStdString()));
+}
+
+void BandageTests::expandWithPathDialogOpen()
+{
+    g_assemblyGraph->loadGraphFromFile(testFile("test.fastg"));
+    g_assemblyGraph->determineGraphInfo();
+    QSharedPointer<AssemblyGraph> graph = g_assemblyGraph;
+    GraphCoarsening coarsening(*graph);
+    coarsening.coarsen(1);
+    g_assemblyGraph = coarsening.buildOverview();
+
+    DeBruijnNode * superNode = nullptr;
+    for (auto *node : g_assemblyGraph->m_deBruijnGraphNodes)
+    {
+        if (node->isPositiveNode() && coarsening.isSuperNode(node))
+        {
+            superNode = node;
+            break;
+        }
+    }
+    QVERIFY(superNode != nullptr);
+    QString superNodeName = superNode->getName();
+
+    //Wired as in the main window: the expansion is connected first, but only
+    //queued, so the path dialog still gets a live super-node.
+    if (g_graphicsView == nullptr)
+        g_graphicsView = new MyGraphicsView();
+    QObject receiver;
+    connect(g_graphicsView, &MyGraphicsView::doubleClickedNode, &receiver, [&](DeBruijnNode *node) {
+        QMetaObject::invokeMethod(&receiver, [&coarsening, name = node->getName()]() {
+            coarsening.expand(name);
+        }, Qt::QueuedConnection);
+    });
+    auto *pathSpecifyDialog = new PathSpecifyDialog();
+    connect(g_graphicsView, &MyGraphicsView::doubleClickedNode,
+            pathSpecifyDialog, &PathSpecifyDialog::addNodeName);
+
+    //A second double-click before the first expansion ran
+    emit g_graphicsView->doubleClickedNode(superNode);
+    emit g_graphicsView->doubleClickedNode(superNode);
+    QVERIFY(g_memory->userSpecifiedPathString.contains(superNodeName));
+
+    QCoreApplication::processEvents();
+    QVERIFY(!g_assemblyGraph->m_deBruijnGraphNodes.count(superNodeName.toStdString()));
+    QVERIFY(g_assemblyGraph->m_deBruijnGraphNodes.size() > 2);
+    QVERIFY(coarsening.expand(superNodeName).empty());
+
+    delete pathSpecifyDialog;
+}
+
+void BandageTests::nodeRangeIndex()
+{
+    g_assemblyGraph->loadGraphFromFile(testFile("test.fastg"));
+
+    //The binary searches agree with checking every node.
+    const NodeRangeIndex &index = g_assemblyGraph->getNodeRangeIndex();
+    QCOMPARE(index.size() * 2, g_assemblyGraph->m_deBruijnGraphNodes.size());
+    auto [first, last] = index.depthRange(5.0, 10.0);
+    size_t inRange = 0, inLengthRange = 0;
+    for (auto *node : g_assemblyGraph->m_deBruijnGraphNodes)
+    {
+        if (!node->isPositiveNode())
+            continue;
+        if (node->isInDepthRange(5.0, 10.0))
+            ++inRange;
+        if (node->getLength() >= 100 && node->getLength() <= 1000)
+            ++inLengthRange;
+    }
+    QCOMPARE(last - first, inRange);
+    auto [firstLength, lastLength] = index.lengthRange(100, 1000);
+    QCOMPARE(lastLength - firstLength, inLengthRange);
+
+    //Changing a depth invalidates the index.
+    DeBruijnNode * node1 = g_assemblyGraph->m_deBruijnGraphNodes["1+"];
+    g_assemblyGraph->changeNodeDepth({node1}, 1000.0);
+    QCOMPARE(g_assemblyGraph->getNodeRangeIndex().byDepth().back(), node1);
+}
+
 void BandageTests::commandLineSettings()
 {
     QStringList commandLineSettings;
@@ -1241,6 +1592,36 @@ void BandageTests::graphEdits()
 
     QVERIFY(mergedNode != nullptr);
     QCOMPARE(Sequence(pathSequence), mergedNode->getSequence());
+
+    //Delete the merged node and an unrelated edge in one batch.
+    auto touchesMergedNode = [&](const DeBruijnEdge *edge) {
+        for (auto *node : {edge->getStartingNode(), edge->getEndingNode()})
+            if (node == mergedNode || node == mergedNode->getReverseComplement())
+                return true;
+        return false;
+    };
+    DeBruijnEdge * otherEdge = nullptr;
+    size_t edgesLeft = 0;
+    for (auto &entry : g_assemblyGraph->m_deBruijnGraphEdges) {
+        DeBruijnEdge * edge = entry.second;
+        if (touchesMergedNode(edge))
+            continue;
+        ++edgesLeft;
+        if (otherEdge == nullptr && edge->getReverseComplement() != edge)
+            otherEdge = edge;
+    }
+    QVERIFY(otherEdge != nullptr);
+
+    g_assemblyGraph->deleteNodesAndEdges({mergedNode}, {otherEdge});
+
+    QCOMPARE(g_assemblyGraph->m_deBruijnGraphNodes.size(), 80);
+    QCOMPARE(g_assemblyGraph->m_deBruijnGraphEdges.size(), edgesLeft - 2);
+    for (auto *node : g_assemblyGraph->m_deBruijnGraphNodes) {
+        for (auto *edge : node->edges()) {
+            auto it = g_assemblyGraph->m_deBruijnGraphEdges.find({edge->getStartingNode(), edge->getEndingNode()});
+            QVERIFY(it != g_assemblyGraph->m_deBruijnGraphEdges.end() && it->second == edge);
+        }
+    }
 }
 
 
@@ -1338,6 +1719,13 @@ void BandageTests::spadesToGfa()
     QCOMPARE(fastgLongestContig, gfaLongestContig);
     QCOMPARE(fastgTestPath1Sequence, gfaTestPath1Sequence);
     QCOMPARE(fastgTestPath2Sequence, gfaTestPath2Sequence);
+
+    //A compressed GFA must load back to the same graph.
+    QVERIFY(g_assemblyGraph->saveEntireGraphToGfa(tempFile("test_temp.gfa.gz")));
+    QVERIFY(g_assemblyGraph->loadGraphFromFile(tempFile("test_temp.gfa.gz")));
+    QCOMPARE(g_assemblyGraph->m_nodeCount, gfaNodeCount);
+    QCOMPARE(g_assemblyGraph->m_edgeCount, gfaEdgeCount);
+    QCOMPARE(g_assemblyGraph->m_totalLength, gfaTotalLength);
 }
 
 
@@ -1381,6 +1769,10 @@ void BandageTests::mergeNodesOnGfa()
     g_assemblyGraph->mergeAllPossible();
     QCOMPARE(2, g_assemblyGraph->m_deBruijnGraphNodes.size());
 
+    //The nodes formed a circle, so the merged node (and its complement) loops
+    //back to itself.
+    QCOMPARE(2, g_assemblyGraph->m_deBruijnGraphEdges.size());
+
     //That last node should have a length of its six constituent nodes, minus
     //the overlaps.
     DeBruijnNode * lastNode = *g_assemblyGraph->m_deBruijnGraphNodes.begin();
@@ -1399,6 +1791,51 @@ void BandageTests::mergeNodesOnGfa()
 
 
 
+// A linear chain of three nodes is merged by reduce into one node pair with
+// the overlaps removed and the length weighted mean depth
+void BandageTests::reduceMerge()
+{
+    QTemporaryDir dir;
+    QFile input(dir.filePath("chain.gfa"));
+    QVERIFY(input.open(QIODevice::WriteOnly));
+    input.write("S\tA\tAAAACCCCGG\tDP:f:10\n"
+                "S\tB\tCCGGTTTTAA\tDP:f:20\n"
+                "S\tC\tTTAAGGGG\tDP:f:40\n"
+                "L\tA\t+\tB\t+\t4M\n"
+                "L\tB\t+\tC\t+\t4M\n");
+    input.close();
+
+    QString output = dir.filePath("merged.gfa");
+    QCOMPARE(bandageReduce({input.fileName(), output, "--scope", "entire", "--merge"}), 0);
+    QVERIFY(g_assemblyGraph->loadGraphFromFile(output));
+    QCOMPARE(g_assemblyGraph->m_deBruijnGraphNodes.size(), size_t(2));
+    QCOMPARE(g_assemblyGraph->m_deBruijnGraphEdges.size(), size_t(0));
+
+    //Either strand of the merged pair may be the positive node.
+    Sequence expected(std::string("AAAACCCCGGTTTTAAGGGG"));
+    DeBruijnNode * merged = nullptr;
+    for (auto *node : g_assemblyGraph->m_deBruijnGraphNodes)
+    {
+        if (node->getSequence() == expected)
+            merged = node;
+    }
+    QVERIFY(merged != nullptr);
+    QVERIFY(std::abs(merged->getDepth() - (10.0 * 10 + 20.0 * 10 + 40.0 * 8) / 28) < 1e-3);
+
+    //Without any sequence the depth is the plain mean of the node depths.
+    QFile empty(dir.filePath("empty.gfa"));
+    QVERIFY(empty.open(QIODevice::WriteOnly));
+    empty.write("S\tX\t*\tDP:f:5\n"
+                "S\tY\t*\tDP:f:15\n"
+                "L\tX\t+\tY\t+\t0M\n");
+    empty.close();
+    QVERIFY(g_assemblyGraph->loadGraphFromFile(empty.fileName()));
+    std::vector<Unitig> unitigs = Unitig::find(*g_assemblyGraph);
+    QCOMPARE(unitigs.size(), size_t(1));
+    Unitig::buildMergedNodes(unitigs);
+    QCOMPARE(unitigs.front().depth, 10.0);
+}
+
 void BandageTests::changeNodeNames()
 {
     g_assemblyGraph->loadGraphFromFile(testFile("test.fastg"));
@@ -1406,6 +1843,7 @@ void BandageTests::changeNodeNames()
     DeBruijnNode * node6Plus = g_assemblyGraph->m_deBruijnGraphNodes["6+"];
     DeBruijnNode * node6Minus = g_assemblyGraph->m_deBruijnGraphNodes["6-"];
     int nodeCountBefore = g_assemblyGraph->m_deBruijnGraphNodes.size();
+    QVERIFY(!g_assemblyGraph->getNodesFromString("6", false).empty());
 
     g_assemblyGraph->changeNodeName("6", "12345");
 
@@ -1416,6 +1854,13 @@ void BandageTests::changeNodeNames()
     QCOMPARE(node6Plus, node12345Plus);
     QCOMPARE(node6Minus, node12345Minus);
     QCOMPARE(nodeCountBefore, nodeCountAfter);
+
+    // Partial name searches must see the new name
+    std::vector<DeBruijnNode *> found = g_assemblyGraph->getNodesFromString("2345", false);
+    QCOMPARE(found.size(), size_t(2));
+    found = g_assemblyGraph->getNodesFromString("/^12345[+-]$/", false);
+    QCOMPARE(found.size(), size_t(2));
+    QVERIFY(std::find(found.begin(), found.end(), node12345Plus) != found.end());
 }
 
 void BandageTests::changeNodeDepths()
@@ -1581,48 +2026,36 @@ void BandageTests::blastQueryPaths()
 
 void BandageTests::bandageInfo()
 {
-    int n50 = 0;
-    int shortestNode = 0;
-    int firstQuartile = 0;
-    int median = 0;
-    int thirdQuartile = 0;
-    int longestNode = 0;
-    int componentCount = 0;
-    int largestComponentLength = 0;
-
     g_assemblyGraph->loadGraphFromFile(testFile("test.fastg"));
-    g_assemblyGraph->getNodeStats(&n50, &shortestNode, &firstQuartile, &median, &thirdQuartile, &longestNode);
-    g_assemblyGraph->getGraphComponentCountAndLargestComponentSize(&componentCount, &largestComponentLength);
-    QCOMPARE(44, g_assemblyGraph->m_nodeCount);
-    QCOMPARE(59, g_assemblyGraph->m_edgeCount);
-    QCOMPARE(214441, g_assemblyGraph->m_totalLength);
-    QCOMPARE(0, g_assemblyGraph->getDeadEndCount());
-    QCOMPARE(35628, n50);
-    QCOMPARE(78, shortestNode);
-    QCOMPARE(52213, longestNode);
-    QCOMPARE(1, componentCount);
-    QCOMPARE(214441, largestComponentLength);
+    GraphStats stats = GraphStats::compute(*g_assemblyGraph);
+    QCOMPARE(44, stats.nodeCount);
+    QCOMPARE(59, stats.edgeCount);
+    QCOMPARE(214441, stats.totalLength);
+    QCOMPARE(0, stats.deadEnds);
+    QCOMPARE(35628, stats.n50);
+    QCOMPARE(78, stats.shortestNode);
+    QCOMPARE(52213, stats.longestNode);
+    QCOMPARE(1, stats.componentCount);
+    QCOMPARE(214441, stats.largestComponentLength);
 
     g_assemblyGraph->loadGraphFromFile(testFile("test.Trinity.fasta"));
-    g_assemblyGraph->getNodeStats(&n50, &shortestNode, &firstQuartile, &median, &thirdQuartile, &longestNode);
-    g_assemblyGraph->getGraphComponentCountAndLargestComponentSize(&componentCount, &largestComponentLength);
-    QCOMPARE(149, g_assemblyGraph->getDeadEndCount());
-    QCOMPARE(66, componentCount);
-    QCOMPARE(9398, largestComponentLength);
+    stats = GraphStats::compute(*g_assemblyGraph);
+    QCOMPARE(149, stats.deadEnds);
+    QCOMPARE(66, stats.componentCount);
+    QCOMPARE(9398, stats.largestComponentLength);
 
     QSKIP("LastGraph is deprecated. File 'test.LastGraph' contains non-reverse complement sequences.");
     g_assemblyGraph->loadGraphFromFile(testFile("test.LastGraph"));
-    g_assemblyGraph->getNodeStats(&n50, &shortestNode, &firstQuartile, &median, &thirdQuartile, &longestNode);
-    g_assemblyGraph->getGraphComponentCountAndLargestComponentSize(&componentCount, &largestComponentLength);
-    QCOMPARE(17, g_assemblyGraph->m_nodeCount);
-    QCOMPARE(16, g_assemblyGraph->m_edgeCount);
-    QCOMPARE(29939, g_assemblyGraph->m_totalLength);
-    QCOMPARE(10, g_assemblyGraph->getDeadEndCount());
-    QCOMPARE(2000, n50);
-    QCOMPARE(59, shortestNode);
-    QCOMPARE(2000, longestNode);
-    QCOMPARE(1, componentCount);
-    QCOMPARE(29939, largestComponentLength);
+    stats = GraphStats::compute(*g_assemblyGraph);
+    QCOMPARE(17, stats.nodeCount);
+    QCOMPARE(16, stats.edgeCount);
+    QCOMPARE(29939, stats.totalLength);
+    QCOMPARE(10, stats.deadEnds);
+    QCOMPARE(2000, stats.n50);
+    QCOMPARE(59, stats.shortestNode);
+    QCOMPARE(2000, stats.longestNode);
+    QCOMPARE(1, stats.componentCount);
+    QCOMPARE(29939, stats.largestComponentLength);
 }
 
 void BandageTests::sequenceInit() {
@@ -1700,6 +2133,321 @@ void BandageTests::sequenceDoubleReverseComplement() {
     QCOMPARE(sequence, sequence.GetReverseComplement().GetReverseComplement());
 }
 
+void BandageTests::sequenceRangeEquals() {
+    QByteArray bases;
+    for (int i = 0; i < 200; ++i)
+        bases += "ACGT"[(i * 7 + i / 5) % 4];
+    Sequence sequence{bases};
+    Sequence withN{bases + "N"};
+
+    // Compare every strand and word alignment against base by base
+    for (const Sequence &a : {sequence, sequence.GetReverseComplement(), sequence.Subseq(3, 170), withN}) {
+        for (const Sequence &b : {sequence, sequence.GetReverseComplement().Subseq(9), withN.GetReverseComplement()}) {
+            for (size_t from = 0; from < a.size(); from += 11) {
+                for (size_t thatFrom = 0; thatFrom < b.size(); thatFrom += 17) {
+                    size_t len = std::min(a.size() - from, b.size() - thatFrom);
+                    bool expected = true;
+                    for (size_t i = 0; i < len; ++i)
+                        expected &= a[from + i] == b[thatFrom + i];
+                    QCOMPARE(a.rangeEquals(from, b, thatFrom, len), expected);
+                }
+            }
+            QVERIFY(a.rangeEquals(0, a, 0, a.size()));
+        }
+    }
+}
+
+static Sequence::Composition countBasesOneByOne(const Sequence &sequence, size_t from, size_t len) {
+    Sequence::Composition composition;
+    for (size_t i = from; i < from + len; ++i) {
+        char c = sequence[i];
+        if (c == 'G' || c == 'C')
+            composition.gc += 1;
+        else if (c == 'N')
+            composition.n += 1;
+        else
+            composition.at += 1;
+    }
+    return composition;
+}
+
+void BandageTests::sequenceComposition() {
+    QByteArray bases;
+    for (int i = 0; i < 301; ++i)
+        bases += "ACGTN"[(i * 7 + i / 3) % 5];
+    Sequence sequence{bases};
+
+    // Check all kinds of word alignments on both strands
+    for (const Sequence &s : {sequence, sequence.GetReverseComplement(),
+                              sequence.Subseq(5, 250), sequence.Subseq(5, 250).GetReverseComplement()}) {
+        for (size_t from = 0; from < s.size(); from += 13) {
+            for (size_t len : {size_t(0), size_t(1), size_t(31), size_t(32), size_t(33), size_t(100), s.size() - from}) {
+                len = std::min(len, s.size() - from);
+                auto expected = countBasesOneByOne(s, from, len);
+                auto counted = s.composition(from, len);
+                QCOMPARE(counted.gc, expected.gc);
+                QCOMPARE(counted.at, expected.at);
+                QCOMPARE(counted.n, expected.n);
+            }
+        }
+    }
+
+    g_assemblyGraph->loadGraphFromFile(testFile("test.fastg"));
+    DeBruijnNode *node = g_assemblyGraph->m_deBruijnGraphNodes["6+"];
+    auto composition = node->getComposition();
+    size_t length = node->getSequence().size();
+    QCOMPARE(composition.gc, countBasesOneByOne(node->getSequence(), 0, length).gc);
+    QCOMPARE(node->getGC(), float(composition.gc) / float(length));
+
+    auto windows = node->getWindowComposition(1000, 500);
+    QCOMPARE(windows.size(), (length - 1000 + 499) / 500 + 1);
+    QCOMPARE(windows[1].gc, countBasesOneByOne(node->getSequence(), 500, 1000).gc);
+}
+
+void BandageTests::sequenceCompositionBenchmark_data() {
+    QTest::addColumn<bool>("packed");
+    QTest::newRow("one by one") << false;
+    QTest::newRow("packed") << true;
+}
+
+void BandageTests::sequenceCompositionBenchmark() {
+    if (!qEnvironmentVariableIsSet("BANDAGE_BENCHMARKS"))
+        QSKIP("Set BANDAGE_BENCHMARKS to run benchmarks");
+    QFETCH(bool, packed);
+
+    QByteArray bases(4000000, 'A');
+    for (int i = 0; i < bases.size(); ++i)
+        bases[i] = "ACGT"[(i * 7 + i / 5) % 4];
+    Sequence sequence{bases};
+
+    size_t gc = 0;
+    QBENCHMARK {
+        gc = packed ? sequence.composition().gc : countBasesOneByOne(sequence, 0, sequence.size()).gc;
+    }
+    QVERIFY(gc > 0);
+}
+
+void BandageTests::bufferedWriter() {
+    QByteArray bases;
+    for (int i = 0; i < 1000; ++i)
+        bases += "ACGT"[(i * 7 + i / 3) % 4];
+
+    // A small buffer, so records span several flushes
+    QBuffer device;
+    device.open(QIODevice::WriteOnly);
+    QByteArray expected;
+    {
+        utils::BufferedWriter out(&device, 100);
+        for (int len : {0, 1, 69, 70, 71, 140, 1000}) {
+            Sequence sequence{bases.left(len)};
+            for (const Sequence &s : {sequence, sequence.GetReverseComplement()}) {
+                out << '>' << QString("node_%1").arg(len) << '_' << len << '_' << 0.25 << '\n';
+                out.writeSequenceLines(s);
+                expected += ">node_" + QByteArray::number(len) + "_" + QByteArray::number(len) + "_" + QByteArray::number(0.25) + "\n";
+                expected += utils::addNewlinesToSequence(utils::sequenceToQByteArray(s));
+            }
+        }
+        QVERIFY(out.flush());
+    }
+    QCOMPARE(device.data(), expected);
+
+    // Numbers are written with a decimal point, whatever the locale
+    CommaDecimalLocale locale;
+    if (!locale.isSet())
+        QSKIP("No locale with a decimal comma is installed");
+    QBuffer numbers;
+    numbers.open(QIODevice::WriteOnly);
+    {
+        utils::BufferedWriter out(&numbers);
+        out << 1.5 << ' ' << 43.3434 << ' ' << 1e-7;
+        QVERIFY(out.flush());
+    }
+    QCOMPARE(numbers.data(), QByteArray("1.5 43.3434 1e-07"));
+}
+
+void BandageTests::fastxReader() {
+    QTemporaryDir dir;
+    auto readAll = [](const QString &filename) {
+        std::vector<std::pair<std::string, std::string>> records;
+        bool opened = utils::readFastx(filename, [&](std::string_view name, std::string_view sequence) {
+            records.emplace_back(name, sequence);
+        });
+        return opened ? records : decltype(records){};
+    };
+    auto write = [&](const QString &name, const QByteArray &contents) {
+        QFile file(dir.filePath(name));
+        file.open(QIODevice::WriteOnly);
+        file.write(contents);
+        return file.fileName();
+    };
+
+    // Sequences spread over lines, with Windows line breaks and no final one
+    auto fasta = readAll(write("test.fasta", ">a desc\r\nACGT\r\nAC GT\r\n>b\n>c\nTTTT"));
+    QCOMPARE(fasta.size(), 3);
+    QCOMPARE(fasta[0], std::make_pair(std::string("a desc"), std::string("ACGTACGT")));
+    QCOMPARE(fasta[1], std::make_pair(std::string("b"), std::string()));
+    QCOMPARE(fasta[2], std::make_pair(std::string("c"), std::string("TTTT")));
+
+    auto fastq = readAll(write("test.fastq", "@r1\nACGT\n+\nIIII\n\n@r2 x\nGG\n+\n@@\n"));
+    QCOMPARE(fastq.size(), 2);
+    QCOMPARE(fastq[0], std::make_pair(std::string("r1"), std::string("ACGT")));
+    QCOMPARE(fastq[1], std::make_pair(std::string("r2 x"), std::string("GG")));
+
+    QVERIFY(!utils::readFastx(dir.filePath("missing.fasta"), [](std::string_view, std::string_view) {}));
+}
+
+// Numbers in graph files use a decimal point, whatever the user's locale is
+void BandageTests::parseNumbersInCommaLocale() {
+    CommaDecimalLocale locale;
+    if (!locale.isSet())
+        QSKIP("No locale with a decimal comma is installed");
+
+    QCOMPARE(utils::toDouble("12.5"), 12.5);
+    QCOMPARE(utils::toDouble(" 1e-3\n"), 0.001);
+    QCOMPARE(utils::toDouble("1,5"), 0.0);
+
+    QVERIFY(g_assemblyGraph->loadGraphFromFile(testFile("test.fastg")));
+    QCOMPARE(g_assemblyGraph->m_deBruijnGraphNodes["1+"]->getDepth(), 43.3434);
+}
+
+// Node sequences written in parallel, plain and gzip-compressed, read back as
+// the records of the nodes in order
+void BandageTests::fastaExport() {
+    QVERIFY(g_assemblyGraph->loadGraphFromFile(testFile("test.fastg")));
+    std::vector<DeBruijnNode *> nodes;
+    std::vector<std::pair<std::string, std::string>> expected;
+    for (auto *node : g_assemblyGraph->m_deBruijnGraphNodes) {
+        if (!node->isPositiveNode())
+            continue;
+        nodes.push_back(node);
+        expected.emplace_back(node->getNodeNameForFasta(false).toStdString(),
+                              utils::sequenceToQByteArray(node->getSequence()).toStdString());
+    }
+
+    QTemporaryDir dir;
+    for (const char *name : {"nodes.fasta", "nodes.fasta.gz"}) {
+        QString filename = dir.filePath(name);
+        QVERIFY(AssemblyGraph::saveNodesToFasta(filename, nodes, false));
+
+        std::vector<std::pair<std::string, std::string>> records;
+        QVERIFY(utils::readFastx(filename, [&](std::string_view name, std::string_view sequence) {
+            records.emplace_back(name, sequence);
+        }));
+        QVERIFY(records == expected);
+    }
+}
+
+// The statistics computed while reading a GFA file match those of the loaded
+// graph. Links are kept in memory two at a time, so they are de-duplicated
+// through runs in temporary files.
+void BandageTests::bandageInfoStreaming()
+{
+    for (const char *filename : {"test_plasmids.gfa", "test_plasmids_separate_sequences.gfa",
+                                 "test_gfa12.gfa", "test_not_defined.gfa", "test_query_paths.gfa"}) {
+        QVERIFY(g_assemblyGraph->loadGraphFromFile(testFile(filename)));
+        GraphStats expected = GraphStats::compute(*g_assemblyGraph);
+        GraphStats stats = GraphStats::computeFromGfa(testFile(filename), 2);
+
+        QCOMPARE(stats.nodeCount, expected.nodeCount);
+        QCOMPARE(stats.edgeCount, expected.edgeCount);
+        QCOMPARE(stats.smallestOverlap, expected.smallestOverlap);
+        QCOMPARE(stats.largestOverlap, expected.largestOverlap);
+        QCOMPARE(stats.totalLength, expected.totalLength);
+        QCOMPARE(stats.totalLengthNoOverlaps, expected.totalLengthNoOverlaps);
+        QCOMPARE(stats.deadEnds, expected.deadEnds);
+        QCOMPARE(stats.percentageDeadEnds, expected.percentageDeadEnds);
+        QCOMPARE(stats.componentCount, expected.componentCount);
+        QCOMPARE(stats.largestComponentLength, expected.largestComponentLength);
+        QCOMPARE(stats.totalLengthOrphanedNodes, expected.totalLengthOrphanedNodes);
+        QCOMPARE(stats.n50, expected.n50);
+        QCOMPARE(stats.shortestNode, expected.shortestNode);
+        QCOMPARE(stats.firstQuartile, expected.firstQuartile);
+        QCOMPARE(stats.median, expected.median);
+        QCOMPARE(stats.thirdQuartile, expected.thirdQuartile);
+        QCOMPARE(stats.longestNode, expected.longestNode);
+        QCOMPARE(stats.medianDepthByBase, expected.medianDepthByBase);
+        QCOMPARE(stats.estimatedSequenceLength, expected.estimatedSequenceLength);
+    }
+}
+
+void BandageTests::graphLoadingBenchmark_data() {
+    QTest::addColumn<QString>("format");
+    for (const char *format : {"LastGraph", "FASTG", "ASQG", "Trinity"})
+        QTest::newRow(format) << QString(format);
+}
+
+// Throughput of the loaders on generated graphs of a few megabytes: a chain
+// of nodes, or pairs of nodes for Trinity
+void BandageTests::graphLoadingBenchmark() {
+    if (!qEnvironmentVariableIsSet("BANDAGE_BENCHMARKS"))
+        QSKIP("Set BANDAGE_BENCHMARKS to run benchmarks");
+    QFETCH(QString, format);
+
+    const int nodeCount = 20000, length = 300, overlap = 50;
+    auto sequenceOf = [](int i, int length) {
+        QByteArray bases(length, 'A');
+        for (int j = 0; j < length; ++j)
+            bases[j] = "ACGT"[(i * 7919 + j * j * 31 + j / 3) % 4];
+        return bases;
+    };
+    auto number = [](auto n) { return QByteArray::number(n); };
+
+    QByteArray contents;
+    size_t edgeCount = 2 * (nodeCount - 1);
+    if (format == "LastGraph") {
+        contents += number(nodeCount) + "\t" + number(nodeCount * length) + "\t31\t1\n";
+        for (int i = 1; i <= nodeCount; ++i) {
+            QByteArray bases = sequenceOf(i, length);
+            contents += "NODE\t" + number(i) + "\t" + number(length) + "\t" + number(10 * length) + "\t0\t0\t0\n";
+            contents += bases + "\n" + AssemblyGraph::getReverseComplement(bases) + "\n";
+        }
+        for (int i = 1; i < nodeCount; ++i)
+            contents += "ARC\t" + number(i) + "\t" + number(i + 1) + "\t5\n";
+    } else if (format == "FASTG") {
+        auto name = [&](int i) { return "EDGE_" + number(i) + "_length_" + number(length) + "_cov_10.5"; };
+        for (int i = 1; i <= nodeCount; ++i) {
+            contents += ">" + name(i);
+            if (i < nodeCount)
+                contents += ":" + name(i + 1);
+            contents += ";\n" + utils::addNewlinesToSequence(sequenceOf(i, length));
+        }
+    } else if (format == "ASQG") {
+        contents += "HT\tVN:i:1\n";
+        for (int i = 1; i <= nodeCount; ++i)
+            contents += "VT\tread" + number(i) + "\t" + sequenceOf(i, length) + "\n";
+        for (int i = 1; i < nodeCount; ++i)
+            contents += "ED\tread" + number(i) + " read" + number(i + 1) + " " +
+                        number(length - overlap) + " " + number(length - 1) + " " + number(length) +
+                        " 0 " + number(overlap - 1) + " " + number(length) + " 0 0\n";
+    } else {
+        for (int i = 0; i < nodeCount / 2; ++i) {
+            contents += ">TRINITY_DN" + number(i) + "_c0_g1_i1 len=" + number(2 * length) +
+                        " path=[" + number(2 * i) + ":0-" + number(length - 1) + " " +
+                        number(2 * i + 1) + ":" + number(length) + "-" + number(2 * length - 1) + "]\n";
+            contents += utils::addNewlinesToSequence(sequenceOf(i, 2 * length));
+        }
+        edgeCount = nodeCount;
+    }
+
+    QTemporaryDir dir;
+    QFile file(dir.filePath("graph." + format));
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write(contents);
+    file.close();
+
+    bool loaded = false;
+    QBENCHMARK {
+        loaded = g_assemblyGraph->loadGraphFromFile(file.fileName());
+    }
+    QVERIFY(loaded);
+    QCOMPARE(g_assemblyGraph->m_deBruijnGraphNodes.size(), size_t(2 * nodeCount));
+    QCOMPARE(g_assemblyGraph->m_deBruijnGraphEdges.size(), edgeCount);
+    if (format == "LastGraph" || format == "FASTG") {
+        for (auto *node : g_assemblyGraph->m_deBruijnGraphNodes)
+            QCOMPARE(node->getDepth(), format == "FASTG" ? 10.5 : 10.0);
+    }
+}
+
 
 
 
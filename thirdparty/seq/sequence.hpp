@@ -15,6 +15,7 @@
 #include <llvm/ADT/SparseBitVector.h>
 #include <llvm/Support/TrailingObjects.h>
 
+#include <algorithm>
 #include <vector>
 #include <string>
 #include <memory>
@@ -159,6 +160,36 @@ class Sequence {
         return static_cast<char>((bytes[idx >> STNBits] >> ((idx & (STN - size_t{1})) << size_t{1})) & size_t{3});
     }
 
+    // STN nucleotides starting at the given position of the buffer, the
+    // first one in the lowest bits.  Only words holding nucleotides of this
+    // sequence are read; past its end the word is padded with garbage.
+    ST getBufferWord(size_t idx) const {
+        const ST *bytes = data_->data();
+        size_t word = idx >> STNBits, shift = (idx & (STN - 1)) << 1;
+        ST res = bytes[word] >> shift;
+        if (shift && word < ((from_ + size_ - 1) >> STNBits))
+            res |= bytes[word + 1] << (STBits - shift);
+        return res;
+    }
+
+    // STN nucleotides of the sequence starting at index, the first one in
+    // the lowest bits.  Nucleotides past the end are garbage, Ns read as T.
+    ST getWord(size_t index) const {
+        if (!rtl_)
+            return getBufferWord(from_ + index);
+
+        // The nucleotides come from the buffer backwards and complemented.
+        // Take the word ending at the nucleotide and reverse its 2-bit groups.
+        size_t top = from_ + size_ - 1 - index;
+        ST w = top >= from_ + STN - 1 ?
+               getBufferWord(top - (STN - 1)) :
+               getBufferWord(from_) << ((from_ + STN - 1 - top) << 1);
+        w = __builtin_bswap64(w);
+        w = ((w >> 4) & 0x0F0F0F0F0F0F0F0FULL) | ((w & 0x0F0F0F0F0F0F0F0FULL) << 4);
+        w = ((w >> 2) & 0x3333333333333333ULL) | ((w & 0x3333333333333333ULL) << 2);
+        return ~w;
+    }
+
     bool emptyNuclsEqual(const Sequence &that) const {
         return data_->empty_nucls_ == that.data_->empty_nucls_
             || (data_->empty_nucls_ != nullptr
@@ -306,6 +337,39 @@ public:
 
     inline std::string str() const;
 
+    /**
+     * Decodes the sequence as ACGTN characters into the given buffer, which
+     * must have room for size() characters.  The packed words are decoded a
+     * byte (4 nucleotides) at a time.
+     *
+     * @return pointer past the last written character
+     */
+    inline char *decode(char *out) const;
+
+    /**
+     * Number of G/C, A/T and N nucleotides.
+     */
+    struct Composition {
+        size_t gc = 0;
+        size_t at = 0;
+        size_t n = 0;
+    };
+
+    /**
+     * Counts the composition of the nucleotides [from, from + len).  Works
+     * directly on the packed words: complementing keeps G/C and A/T, so for
+     * the reverse complement only the range is mirrored.
+     */
+    inline Composition composition(size_t from = 0, size_t len = size_t(-1)) const;
+
+    /**
+     * Checks whether the nucleotides [from, from + len) are equal to the
+     * nucleotides [thatFrom, thatFrom + len) of another sequence.  Compares
+     * whole packed words (STN nucleotides) at a time, unless one of the
+     * sequences has Ns.
+     */
+    inline bool rangeEquals(size_t from, const Sequence &that, size_t thatFrom, size_t len) const;
+
     inline std::string err() const;
 
     size_t size() const {
@@ -411,12 +475,147 @@ Sequence Sequence::operator+(const Sequence &s) const {
 
 std::string Sequence::str() const {
     std::string res(size_, '-');
-    for (size_t i = 0; i < size_; ++i) {
-        res[i] = nucl(this->operator[](i));
+    decode(res.data());
+    return res;
+}
+
+namespace seq_detail {
+// For every packed byte (4 nucleotides, first one in the lowest bits) holds
+// the 4 characters in forward order and the 4 characters of the reverse
+// complement of those nucleotides.
+struct ByteDecodeTable {
+    char fwd[256][4];
+    char rc[256][4];
+
+    ByteDecodeTable() {
+        for (unsigned b = 0; b < 256; ++b) {
+            for (unsigned k = 0; k < 4; ++k) {
+                char c = char((b >> (2 * k)) & 3);
+                fwd[b][k] = nucl(c);
+                rc[b][3 - k] = nucl(complement(c));
+            }
+        }
     }
+
+    static const ByteDecodeTable &get() {
+        static const ByteDecodeTable table;
+        return table;
+    }
+};
+}
+
+char *Sequence::decode(char *out) const {
+    const auto &table = seq_detail::ByteDecodeTable::get();
+    const ST *bytes = data_->data();
+    size_t lo = from_, hi = from_ + size_;
+    auto byteAt = [bytes](size_t idx) {
+        return uint8_t(bytes[idx >> STNBits] >> ((idx & (STN - size_t{1})) << size_t{1}));
+    };
+
+    char *o = out;
+    if (!rtl_) {
+        size_t i = lo;
+        for (; i < hi && (i & 3); ++i)
+            *o++ = nucl(getNuclFromBuffer(i));
+        for (; i + 4 <= hi; i += 4, o += 4)
+            memcpy(o, table.fwd[byteAt(i)], 4);
+        for (; i < hi; ++i)
+            *o++ = nucl(getNuclFromBuffer(i));
+    } else {
+        size_t i = hi;
+        for (; i > lo && (i & 3); --i)
+            *o++ = nucl(complement(getNuclFromBuffer(i - 1)));
+        for (; i >= lo + 4; i -= 4, o += 4)
+            memcpy(o, table.rc[byteAt(i - 4)], 4);
+        for (; i > lo; --i)
+            *o++ = nucl(complement(getNuclFromBuffer(i - 1)));
+    }
+
+    if (LLVM_UNLIKELY(data_->empty_nucls_ != nullptr)) {
+        for (unsigned idx : *data_->empty_nucls_) {
+            if (idx < lo)
+                continue;
+            if (idx >= hi)
+                break;
+            out[rtl_ ? hi - 1 - idx : idx - lo] = 'N';
+        }
+    }
+
+    return o;
+}
+
+Sequence::Composition Sequence::composition(size_t from, size_t len) const {
+    Composition res;
+    from = std::min(from, size_t(size_));
+    len = std::min(len, size_t(size_) - from);
+    if (len == 0)
+        return res;
+
+    size_t lo = rtl_ ? from_ + size_ - from - len : from_ + from;
+    size_t hi = lo + len;
+
+    // A nucleotide is G or C (1 or 2) when its two bits differ
+    const ST lowBits = 0x5555555555555555ULL;
+    auto gcBits = [lowBits](ST w) { return (w ^ (w >> 1)) & lowBits; };
+
+    const ST *bytes = data_->data();
+    size_t first = lo >> STNBits, last = (hi - 1) >> STNBits;
+    ST firstMask = ~ST(0) << ((lo & (STN - 1)) << 1);
+    size_t lastNucls = ((hi - 1) & (STN - 1)) + 1;
+    ST lastMask = lastNucls == STN ? ~ST(0) : (ST(1) << (lastNucls << 1)) - 1;
+
+    size_t gc = 0;
+    if (first == last) {
+        gc = __builtin_popcountll(gcBits(bytes[first]) & firstMask & lastMask);
+    } else {
+        gc = __builtin_popcountll(gcBits(bytes[first]) & firstMask);
+        for (size_t w = first + 1; w < last; ++w)
+            gc += __builtin_popcountll(gcBits(bytes[w]));
+        gc += __builtin_popcountll(gcBits(bytes[last]) & lastMask);
+    }
+
+    size_t n = 0;
+    if (LLVM_UNLIKELY(data_->empty_nucls_ != nullptr)) {
+        for (unsigned idx : *data_->empty_nucls_) {
+            if (idx < lo)
+                continue;
+            if (idx >= hi)
+                break;
+            n += 1;
+            char c = getNuclFromBuffer(idx);
+            gc -= (c == 1 || c == 2);
+        }
+    }
+
+    res.gc = gc;
+    res.n = n;
+    res.at = len - gc - n;
     return res;
 }
 
+bool Sequence::rangeEquals(size_t from, const Sequence &that, size_t thatFrom, size_t len) const {
+    VERIFY_DEV(from + len <= size_ && thatFrom + len <= that.size_);
+
+    // An N is stored as some nucleotide, so the packed words cannot tell it
+    // apart from one
+    if (LLVM_UNLIKELY(data_->empty_nucls_ != nullptr || that.data_->empty_nucls_ != nullptr)) {
+        for (size_t i = 0; i < len; ++i) {
+            if (operator[](from + i) != that[thatFrom + i])
+                return false;
+        }
+        return true;
+    }
+
+    for (size_t i = 0; i < len; i += STN) {
+        ST diff = getWord(from + i) ^ that.getWord(thatFrom + i);
+        if (len - i < STN)
+            diff &= (ST(1) << ((len - i) << 1)) - 1;
+        if (diff)
+            return false;
+    }
+    return true;
+}
+
 std::string Sequence::err() const {
     std::ostringstream oss;
     oss << "{ *data=" << data_->data() <<
@@ -4,14 +4,19 @@
 #include <QVBoxLayout>
 #include <QFileDialog>
 #include <QMessageBox>
+#include <QFutureWatcher>
+#include <QtConcurrent>
 #include <exception>
 
 #include "program/memory.h"
+#include "ui/myprogressdialog.h"
 #include "graph/bedloader.hpp"
 #include "graph/annotationsmanager.h"
 #include "graph/assemblygraph.h"
 #include "graph/debruijnnode.h"
 
+#include "parallel_hashmap/phmap.h"
+
 inline constexpr double BED_MAIN_WIDTH = 1;
 inline constexpr double BED_THICK_WIDTH = 1.3;
 inline constexpr double BED_BLOCK_WIDTH = 1.6;
@@ -28,23 +33,91 @@ BedWidget::BedWidget(QWidget *parent) : QWidget(parent) {
         g_annotationsManager->removeGroupByName(g_settings->bedAnnotationGroupName);
         QString bedFileName = QFileDialog::getOpenFileName(this, label, g_memory->rememberedPath);
         if (bedFileName.isNull()) return;
-        try {
-            auto bedLines = bed::load(bedFileName.toStdString());
-            auto &annotationGroup = g_annotationsManager->createAnnotationGroup(g_settings->bedAnnotationGroupName);
-            for (const auto &bedLine : bedLines) {
+        loadBedFile(bedFileName);
+    });
+
+    setLayout(layout);
+}
+
+// Builds the annotations of the BED file off the GUI thread. Views only
+// depend on the colour (and, for the thick part and blocks, on the feature
+// coordinates), so the common ones are shared between features.
+static std::shared_ptr<AnnotationGroup::AnnotationMap> buildBedAnnotations(const QString &bedFileName,
+                                                                           MyProgressDialog *progress) {
+    auto annotationMap = std::make_shared<AnnotationGroup::AnnotationMap>();
+
+    struct SharedViews {
+        std::shared_ptr<const IAnnotationView> main, thick, noBlocks;
+    };
+    phmap::flat_hash_map<QRgb, SharedViews> viewsByColor;
+    phmap::flat_hash_map<std::string, DeBruijnNode *> nodesByChrom;
+
+    auto onLines = [&](std::vector<bed::Line> &&bedLines) {
+        for (auto &bedLine : bedLines) {
+            auto [chromIt, inserted] = nodesByChrom.try_emplace(bedLine.chrom, nullptr);
+            if (inserted) {
                 auto nodeName = g_assemblyGraph->getNodeNameFromString(bedLine.chrom.c_str());
                 auto it = g_assemblyGraph->m_deBruijnGraphNodes.find(nodeName.toStdString());
-                if (it != g_assemblyGraph->m_deBruijnGraphNodes.end()) {
-                    DeBruijnNode *node = it.value();
-                    if (bedLine.strand == bed::Strand::REVERSE_COMPLEMENT)
-                        node = node->getReverseComplement();
-                    auto &annotation = annotationGroup.annotationMap[node].emplace_back(
-                        std::make_unique<Annotation>(bedLine.chromStart, bedLine.chromEnd, bedLine.name));
-                    annotation->addView(std::make_unique<SolidView>(BED_MAIN_WIDTH, bedLine.itemRgb.toQColor()));
-                    annotation->addView(std::make_unique<BedThickView>(BED_THICK_WIDTH, bedLine.itemRgb.toQColor(), bedLine.thickStart, bedLine.thickEnd));
-                    annotation->addView(std::make_unique<BedBlockView>(BED_BLOCK_WIDTH, bedLine.itemRgb.toQColor(), bedLine.blocks));
-                }
+                if (it != g_assemblyGraph->m_deBruijnGraphNodes.end())
+                    chromIt->second = it.value();
+            }
+
+            DeBruijnNode *node = chromIt->second;
+            if (node == nullptr)
+                continue;
+            if (bedLine.strand == bed::Strand::REVERSE_COMPLEMENT)
+                node = node->getReverseComplement();
+
+            QColor color = bedLine.itemRgb.toQColor();
+            auto &views = viewsByColor[color.rgb()];
+            if (!views.main) {
+                views.main = std::make_shared<SolidView>(BED_MAIN_WIDTH, color);
+                views.thick = std::make_shared<BedThickView>(BED_THICK_WIDTH, color);
+                views.noBlocks = std::make_shared<BedBlockView>(BED_BLOCK_WIDTH, color, std::vector<bed::Block>{});
             }
+
+            auto &annotation = (*annotationMap)[node].emplace_back(
+                    std::make_unique<Annotation>(bedLine.chromStart, bedLine.chromEnd, std::move(bedLine.name)));
+            annotation->addView(views.main);
+            if (bedLine.thickStart == bedLine.chromStart && bedLine.thickEnd == bedLine.chromEnd)
+                annotation->addView(views.thick);
+            else
+                annotation->addView(std::make_shared<BedThickView>(BED_THICK_WIDTH, color,
+                                                                   bedLine.thickStart, bedLine.thickEnd));
+            if (bedLine.blocks.empty())
+                annotation->addView(views.noBlocks);
+            else
+                annotation->addView(std::make_shared<BedBlockView>(BED_BLOCK_WIDTH, color, bedLine.blocks));
+        }
+    };
+
+    auto onProgress = [progress](uint64_t bytesRead, uint64_t totalBytes) {
+        int value = totalBytes ? int(1000 * bytesRead / totalBytes) : 1000;
+        QMetaObject::invokeMethod(progress, [progress, value]() { progress->setValue(value); },
+                                  Qt::QueuedConnection);
+    };
+
+    bed::load(bedFileName.toStdString(), onLines, onProgress);
+
+    return annotationMap;
+}
+
+void BedWidget::loadBedFile(const QString &bedFileName) {
+    auto *progress = new MyProgressDialog(this, "Loading " + bedFileName, false);
+    progress->setWindowModality(Qt::WindowModal);
+    progress->setMaxValue(1000);
+    progress->show();
+
+    using Result = std::shared_ptr<AnnotationGroup::AnnotationMap>;
+    auto *watcher = new QFutureWatcher<Result>;
+    connect(watcher, &QFutureWatcher<Result>::finished,
+            this, [=, this]() {
+        try {
+            // Note that this will rethrow the exceptions, if any
+            Result annotationMap = watcher->result();
+            auto &annotationGroup = g_annotationsManager->createAnnotationGroup(g_settings->bedAnnotationGroupName);
+            annotationGroup.annotationMap = std::move(*annotationMap);
+            annotationGroup.buildIntervalIndex();
         } catch (std::exception &err) {
             QString errorTitle = "Error loading BED file";
             QString errorMessage = "There was an error when attempting to load:\n"
@@ -54,6 +127,8 @@ BedWidget::BedWidget(QWidget *parent) : QWidget(parent) {
             QMessageBox::warning(this, errorTitle, errorMessage);
         }
     });
+    connect(watcher, SIGNAL(finished()), progress, SLOT(deleteLater()));
+    connect(watcher, SIGNAL(finished()), watcher, SLOT(deleteLater()));
 
-    setLayout(layout);
+    watcher->setFuture(QtConcurrent::run(buildBedAnnotations, bedFileName, progress));
 }
@@ -8,6 +8,9 @@
 class BedWidget : public QWidget {
 public:
     explicit BedWidget(QWidget *parent);
+
+private:
+    void loadBedFile(const QString &bedFileName);
 };
 
 
@@ -39,6 +39,8 @@
 #include "graph/path.h"
 #include "graph/sequenceutils.h"
 #include "graph/assemblygraphbuilder.h"
+#include "graph/coarsening.h"
+#include "graph/contiguity.h"
 #include "graph/nodecolorers.h"
 
 #include "layout/graphlayoutworker.h"
@@ -74,6 +76,7 @@
 #include <cstdlib>
 #include <ctime>
 #include <iostream>
+#include <map>
 
 MainWindow::MainWindow(QString fileToLoadOnStartup, bool drawGraphAfterLoad) :
     QMainWindow(nullptr),
@@ -209,6 +212,8 @@ MainWindow::MainWindow(QString fileToLoadOnStartup, bool drawGraphAfterLoad) :
     connect(ui->actionChange_node_name, SIGNAL(triggered(bool)), this, SLOT(changeNodeName()));
     connect(ui->actionChange_node_depth, SIGNAL(triggered(bool)), this, SLOT(changeNodeDepth()));
     connect(ui->moreInfoButton, SIGNAL(clicked(bool)), this, SLOT(openGraphInfoDialog()));
+    connect(ui->actionCoarsened_overview, SIGNAL(toggled(bool)), this, SLOT(toggleOverview(bool)));
+    connect(g_graphicsView, SIGNAL(doubleClickedNode(DeBruijnNode*)), this, SLOT(expandSuperNode(DeBruijnNode*)));
 
     connect(this, SIGNAL(windowLoaded()), this, SLOT(afterMainWindowShow()), Qt::ConnectionType(Qt::QueuedConnection | Qt::UniqueConnection));
 }
@@ -256,6 +261,8 @@ void MainWindow::afterMainWindowShow()
 
 MainWindow::~MainWindow()
 {
+    if (m_coarsening)
+        g_assemblyGraph = m_fullGraph;
     cleanUp();
     delete m_graphicsViewZoom;
     delete ui;
@@ -305,33 +312,39 @@ void MainWindow::loadCSV(QString fullFileName)
     if (fullFileName == "")
         return; // user clicked on cancel
 
-    QString errormsg;
-    try
-    {
-        MyProgressDialog progress(this, "Loading CSV...", false);
-        progress.setWindowModality(Qt::WindowModal);
-        progress.show();
+    // The file is read in a different thread so the UI will stay responsive.
+    auto *progress = new MyProgressDialog(this, "Loading CSV...", false);
+    progress->setWindowModality(Qt::WindowModal);
+    progress->show();
 
-        bool coloursLoaded = false;
-        QStringList columns;
-        if (g_assemblyGraph->loadCSV(fullFileName, &columns, &errormsg, &coloursLoaded)) {
-            ui->csvCheckBox->setChecked(true);
-            ui->csvComboBox->setEnabled(true);
-            ui->csvComboBox->clear();
-            ui->csvComboBox->addItems(columns);
-            g_settings->displayNodeCsvDataCol = 0;
-            switchColourScheme(coloursLoaded ? CUSTOM_COLOURS : CSV_COLUMN);
+    auto *watcher = new QFutureWatcher<CsvLoadResult>;
+    connect(watcher, &QFutureWatcher<CsvLoadResult>::finished,
+            this, [=, this]() {
+        try {
+            QString errormsg;
+            bool coloursLoaded = false;
+            QStringList columns;
+            if (g_assemblyGraph->applyCSV(watcher->future().takeResult(), &columns, &errormsg, &coloursLoaded)) {
+                ui->csvCheckBox->setChecked(true);
+                ui->csvComboBox->setEnabled(true);
+                ui->csvComboBox->clear();
+                ui->csvComboBox->addItems(columns);
+                g_settings->displayNodeCsvDataCol = 0;
+                switchColourScheme(coloursLoaded ? CUSTOM_COLOURS : CSV_COLUMN);
+            }
+        } catch (...) {
+            QString errorTitle = "Error loading CSV";
+            QString errorMessage = "There was an error when attempting to load:\n"
+                                   + fullFileName + "\n\n"
+                                   "Please verify that this file has the correct format.";
+            QMessageBox::warning(this, errorTitle, errorMessage);
         }
-    }
+    });
+    connect(watcher, SIGNAL(finished()), progress, SLOT(deleteLater()));
+    connect(watcher, SIGNAL(finished()), watcher, SLOT(deleteLater()));
 
-    catch (...)
-    {
-        QString errorTitle = "Error loading CSV";
-        QString errorMessage = "There was an error when attempting to load:\n"
-                               + fullFileName + "\n\n"
-                               "Please verify that this file has the correct format.";
-        QMessageBox::warning(this, errorTitle, errorMessage);
-    }
+    auto res = QtConcurrent::run(&AssemblyGraph::readCSV, g_assemblyGraph.data(), fullFileName);
+    watcher->setFuture(res);
 }
 
 
@@ -362,6 +375,7 @@ void MainWindow::loadGraph(QString fullFileName)
         return;
     }
 
+    leaveOverview();
     resetScene();
     cleanUp();
     ui->selectionSearchNodesLineEdit->clear();
@@ -370,6 +384,14 @@ void MainWindow::loadGraph(QString fullFileName)
     progress->setWindowModality(Qt::WindowModal);
     progress->show();
 
+    // The progress bar stays busy for the builders that don't report progress
+    builder->setProgressCallback([progress](int percent) {
+        QMetaObject::invokeMethod(progress, [progress, percent]() {
+            progress->setMaxValue(100);
+            progress->setValue(percent);
+        });
+    });
+
     auto *watcher = new QFutureWatcher<bool>;
     connect(watcher, &QFutureWatcher<bool>::finished,
             this, [=, this]() {
@@ -389,7 +411,9 @@ void MainWindow::loadGraph(QString fullFileName)
             setWindowTitle("BandageNG - " + fullFileName);
 
             g_assemblyGraph->determineGraphInfo();
+            g_assemblyGraph->buildNodeNameIndexInBackground();
             displayGraphDetails();
+            showDepthRangeNodeCount();
             g_memory->rememberedPath = QFileInfo(fullFileName).absolutePath();
             g_memory->clearGraphSpecificMemory();
 
@@ -458,6 +482,7 @@ void MainWindow::loadGraphLayout(QString fullFileName) {
         return;
     }
 
+    resetScene();
     layout::apply(*g_assemblyGraph, layout);
 
     graphLayoutFinished(layout);
@@ -514,6 +539,10 @@ void MainWindow::selectionChanged()
                 ui->selectedNodesTagLabel->setText("Tags: " + selectedNodeTagText);
             } else
                 ui->selectedNodesTagLabel->setVisible(false);
+
+            QString pathsText = getNodePathsText(selectedNodes.front());
+            ui->selectedNodesPathsLabel->setVisible(!pathsText.isEmpty());
+            ui->selectedNodesPathsLabel->setText("Paths: " + pathsText);
         }
         else
         {
@@ -521,6 +550,7 @@ void MainWindow::selectionChanged()
             ui->selectedNodesLengthLabel->setText("Total length: " + selectedNodeLengthText);
             ui->selectedNodesDepthLabel->setText("Mean depth: " + selectedNodeDepthText);
             ui->selectedNodesTagLabel->setVisible(false);
+            ui->selectedNodesPathsLabel->setVisible(false);
         }
 
         ui->selectedNodesTextEdit->setPlainText(selectedNodeListText);
@@ -546,6 +576,41 @@ void MainWindow::selectionChanged()
 }
 
 
+//Lists the paths which go through the node along with the (1-based) steps at
+//which they visit it.  In single mode, visits to the reverse complement
+//count too, as both strands are drawn as one node.
+QString MainWindow::getNodePathsText(const DeBruijnNode * node)
+{
+    const auto &paths = g_assemblyGraph->m_deBruijnGraphPaths;
+    if (paths.empty())
+        return {};
+
+    std::map<GraphPaths::PathId, QStringList> stepsByPath;
+    for (const auto &occurrence : paths.occurrences(node))
+        stepsByPath[occurrence.path] << QString::number(occurrence.step + 1);
+    if (!g_settings->doubleMode && node->getReverseComplement() != nullptr)
+    {
+        for (const auto &occurrence : paths.occurrences(node->getReverseComplement()))
+            stepsByPath[occurrence.path] << QString::number(occurrence.step + 1) + "-";
+    }
+
+    const size_t maxPathsToShow = 20;
+    QStringList pathTexts;
+    for (const auto &[pathId, steps] : stepsByPath)
+    {
+        if (size_t(pathTexts.size()) == maxPathsToShow)
+        {
+            pathTexts << "and " + formatIntForDisplay(int(stepsByPath.size() - maxPathsToShow)) + " more";
+            break;
+        }
+        pathTexts << QString::fromStdString(paths.name(pathId)) +
+                     (steps.size() == 1 ? " (step " : " (steps ") + steps.join(", ") + ")";
+    }
+
+    return pathTexts.join(", ");
+}
+
+
 void MainWindow::getSelectedNodeInfo(int & selectedNodeCount, QString & selectedNodeCountText,
                                      QString & selectedNodeListText, QString & selectedNodeLengthText, QString & selectedNodeDepthText,
                                      QString &selectNodeTagsText)
@@ -763,6 +828,8 @@ void MainWindow::graphScopeChanged()
 
         break;
     }
+
+    showDepthRangeNodeCount();
 }
 
 
@@ -813,13 +880,13 @@ void MainWindow::setupPathSelectionLineEdit(QLineEdit *lineEdit) {
             [matchedPaths](const QString &text) {
                 QStringList res;
 
-                auto prefix_range = g_assemblyGraph->m_deBruijnGraphPaths.equal_prefix_range(text.toStdString());
-                size_t sz = std::distance(prefix_range.first, prefix_range.second);
+                const auto &paths = g_assemblyGraph->m_deBruijnGraphPaths;
+                size_t sz = paths.countByPrefix(text.toStdString());
                 if (sz > 1000) {
                     res << "Too many paths to show";
                 } else {
-                    for (auto it = prefix_range.first; it != prefix_range.second; ++it)
-                        res.push_back(it.key().c_str());
+                    for (auto pathId : paths.findByPrefix(text.toStdString()))
+                        res.push_back(paths.name(pathId).c_str());
                 }
 
                 if (res.empty())
@@ -852,7 +919,6 @@ void MainWindow::drawGraph()
     }
 
     resetScene();
-    g_assemblyGraph->resetNodes();
     g_assemblyGraph->markNodesToDraw(startingNodes, g_settings->nodeDistance);
     layoutGraph();
 }
@@ -876,8 +942,9 @@ void MainWindow::resetScene()
 {
     m_scene->blockSignals(true);
 
-    g_assemblyGraph->resetEdges();
-    g_assemblyGraph->m_contiguitySearchDone = false;
+    m_scene->detachGraphicsItems();
+    if (g_assemblyGraph->m_contiguitySearchDone)
+        g_assemblyGraph->resetNodeContiguityStatus();
 
     g_graphicsView->setScene(nullptr);
     delete m_scene;
@@ -1077,12 +1144,8 @@ void MainWindow::saveSelectedSequencesToFile()
 
     if (fullFileName != "") //User did not hit cancel
     {
-        QFile file(fullFileName);
-        file.open(QIODevice::WriteOnly | QIODevice::Text);
-        QTextStream out(&file);
-
-        for (auto & selectedNode : selectedNodes)
-            out << selectedNode->getFasta(true);
+        if (!AssemblyGraph::saveNodesToFasta(fullFileName, selectedNodes, true))
+            QMessageBox::warning(this, "Error saving file", "Could not write " + fullFileName);
 
         g_memory->rememberedPath = QFileInfo(fullFileName).absolutePath();
     }
@@ -1153,13 +1216,12 @@ void MainWindow::saveSelectedPathToFile()
 
 
 void MainWindow::resetAllNodeColours() {
+    std::vector<GraphicsItemNode *> graphicsItemNodes;
     for (auto &entry : g_assemblyGraph->m_deBruijnGraphNodes) {
-        auto *graphicsItemNode = entry->getGraphicsItemNode();
-        if (!graphicsItemNode)
-            continue;
-
-        graphicsItemNode->setNodeColour(g_settings->nodeColorer->get(graphicsItemNode));
+        if (auto *graphicsItemNode = entry->getGraphicsItemNode())
+            graphicsItemNodes.push_back(graphicsItemNode);
     }
+    g_settings->nodeColorer->colourNodes(graphicsItemNodes);
 
     g_graphicsView->viewport()->update();
 }
@@ -1225,15 +1287,36 @@ void MainWindow::determineContiguityFromSelectedNode() {
         return;
     }
 
-    MyProgressDialog progress(this, "Determining contiguity...", false);
-    progress.setWindowModality(Qt::WindowModal);
-    progress.show();
+    // The search runs in a different thread so the UI will stay responsive.
+    auto *progress = new MyProgressDialog(this, "Determining contiguity...", true,
+                                          "Cancel contiguity search", "Cancelling contiguity search...",
+                                          "Clicking this button will stop the contiguity search. "
+                                          "No contiguity will be shown.<br><br>"
+                                          "The search takes longer for larger values of the "
+                                          "'Contiguity search steps' setting.");
+    progress->setWindowModality(Qt::WindowModal);
+    progress->show();
 
-    for (auto *selectedNode : selectedNodes)
-        selectedNode->determineContiguity();
+    auto *search = new ContiguitySearch(g_settings->contiguitySearchSteps);
+    connect(progress, SIGNAL(halt()), search, SLOT(cancel()));
+    connect(search, SIGNAL(setMaxValue(int)), progress, SLOT(setMaxValue(int)));
+    connect(search, SIGNAL(setValue(int)), progress, SLOT(setValue(int)));
 
-    g_assemblyGraph->m_contiguitySearchDone = true;
-    resetAllNodeColours();
+    auto *watcher = new QFutureWatcher<ContiguitySearch::Statuses>;
+    connect(watcher, &QFutureWatcher<ContiguitySearch::Statuses>::finished,
+            this, [=, this]() {
+        if (search->wasCancelled())
+            return;
+
+        ContiguitySearch::apply(watcher->result());
+        g_assemblyGraph->m_contiguitySearchDone = true;
+        resetAllNodeColours();
+    });
+    connect(watcher, SIGNAL(finished()), search, SLOT(deleteLater()));
+    connect(watcher, SIGNAL(finished()), progress, SLOT(deleteLater()));
+    connect(watcher, SIGNAL(finished()), watcher, SLOT(deleteLater()));
+
+    watcher->setFuture(QtConcurrent::run(&ContiguitySearch::run, search, selectedNodes));
 }
 
 
@@ -1637,12 +1720,12 @@ void MainWindow::selectPathNodes()
     std::vector<DeBruijnNode *> nodesToSelect;
 
     QString pathName = ui->pathSelectionLineEdit2->displayText();
-    auto nodes = g_assemblyGraph->m_deBruijnGraphPaths.find(pathName.toStdString());
-    if (nodes == g_assemblyGraph->m_deBruijnGraphPaths.end()) {
+    auto pathId = g_assemblyGraph->m_deBruijnGraphPaths.find(pathName.toStdString());
+    if (pathId < 0) {
         QMessageBox::information(this, "Path not found", "Path named \"" + pathName + "\" is not found. Maybe you wanted to select nodes instead?");
         return;
     }
-    for (auto *node : (*nodes)->getNodes())
+    for (auto *node : g_assemblyGraph->m_deBruijnGraphPaths.steps(pathId))
         nodesToSelect.push_back(node);
 
     doSelectNodes(nodesToSelect, nodesNotInGraph, ui->pathSelectionRecolorRadioButton->isChecked());
@@ -1772,11 +1855,14 @@ void MainWindow::setInfoTexts()
     ui->startingNodesMatchTypeInfoText->setInfoText("When 'Exact' match is used, the graph will only be drawn around nodes "
                                                     "that exactly match your above input.<br><br>"
                                                     "When 'Partial' match is used, the graph will be drawn around "
-                                                    "nodes where any part of their name matches your above input.");
+                                                    "nodes where any part of their name matches your above input. "
+                                                    "An input enclosed in slashes, like /^NODE_1/, is used as a "
+                                                    "regular expression.");
     ui->selectionSearchNodesMatchTypeInfoText->setInfoText("When 'Exact' match is used, nodes will only be selected if "
                                                            "their name exactly matches your input above.<br><br>"
                                                            "When 'Partial' match is used, nodes will be selected if any "
-                                                           "part of their name matches your input above.");
+                                                           "part of their name matches your input above. An input enclosed "
+                                                           "in slashes, like /^NODE_1/, is used as a regular expression.");
     ui->nodeStyleInfoText->setInfoText("'Single' mode will only one node for each positive/negative pair. "
                                        "This produces a simpler graph visualisation, but "
                                        "strand-specific sequences and directionality will be less clear.<br><br>"
@@ -1888,6 +1974,7 @@ void MainWindow::setUiState(UiState uiState)
         ui->actionLoad_CSV->setEnabled(false);
         ui->actionLoad_layout->setEnabled(false);
         ui->actionExport_layout->setEnabled(false);
+        ui->actionCoarsened_overview->setEnabled(false);
         break;
     case GRAPH_LOADED:
         ui->graphDetailsWidget->setEnabled(true);
@@ -1901,6 +1988,7 @@ void MainWindow::setUiState(UiState uiState)
         ui->actionLoad_CSV->setEnabled(true);
         ui->actionLoad_layout->setEnabled(true);
         ui->actionExport_layout->setEnabled(false);
+        ui->actionCoarsened_overview->setEnabled(true);
         break;
     case GRAPH_DRAWN:
         ui->graphDetailsWidget->setEnabled(true);
@@ -1915,6 +2003,7 @@ void MainWindow::setUiState(UiState uiState)
         ui->actionLoad_CSV->setEnabled(true);
         ui->actionLoad_layout->setEnabled(true);
         ui->actionExport_layout->setEnabled(true);
+        ui->actionCoarsened_overview->setEnabled(true);
         break;
     }
 }
@@ -2248,6 +2337,22 @@ void MainWindow::depthRangeChanged()
 {
     g_settings->minDepthRange = ui->minDepthSpinBox->value();
     g_settings->maxDepthRange = ui->maxDepthSpinBox->value();
+    showDepthRangeNodeCount();
+}
+
+//The nodes in the depth range are found with a binary search over the nodes
+//sorted by depth, so the count can follow the spin boxes as they change.
+void MainWindow::showDepthRangeNodeCount()
+{
+    if (m_uiState == NO_GRAPH_LOADED || g_settings->graphScope != DEPTH_RANGE)
+    {
+        ui->statusBar->clearMessage();
+        return;
+    }
+
+    auto [first, last] = g_assemblyGraph->getNodeRangeIndex().depthRange(g_settings->minDepthRange,
+                                                                         g_settings->maxDepthRange);
+    ui->statusBar->showMessage(formatIntForDisplay(int(last - first)) + " nodes in depth range");
 }
 
 void MainWindow::showEvent(QShowEvent *ev)
@@ -2303,6 +2408,7 @@ void MainWindow::setSelectedNodesWidgetsVisibility(bool visible)
     ui->selectedNodesLengthLabel->setVisible(visible);
     ui->selectedNodesDepthLabel->setVisible(visible);
     ui->selectedNodesTagLabel->setVisible(visible);
+    ui->selectedNodesPathsLabel->setVisible(visible);
     ui->selectedNodesSpacerWidget->setVisible(visible);
 }
 
@@ -2331,7 +2437,8 @@ void MainWindow::saveEntireGraphToFasta()
     if (fullFileName != "") //User did not hit cancel
     {
         g_memory->rememberedPath = QFileInfo(fullFileName).absolutePath();
-        g_assemblyGraph->saveEntireGraphToFasta(fullFileName);
+        if (!g_assemblyGraph->saveEntireGraphToFasta(fullFileName))
+            QMessageBox::warning(this, "Error saving file", "Could not write " + fullFileName);
     }
 }
 
@@ -2343,7 +2450,8 @@ void MainWindow::saveEntireGraphToFastaOnlyPositiveNodes()
     if (fullFileName != "") //User did not hit cancel
     {
         g_memory->rememberedPath = QFileInfo(fullFileName).absolutePath();
-        g_assemblyGraph->saveEntireGraphToFastaOnlyPositiveNodes(fullFileName);
+        if (!g_assemblyGraph->saveEntireGraphToFastaOnlyPositiveNodes(fullFileName))
+            QMessageBox::warning(this, "Error saving file", "Could not write " + fullFileName);
     }
 }
 
@@ -2351,7 +2459,7 @@ void MainWindow::saveEntireGraphToFastaOnlyPositiveNodes()
 void MainWindow::saveEntireGraphToGfa()
 {
     QString defaultFileNameAndPath = g_memory->rememberedPath + "/graph.gfa";
-    QString fullFileName = QFileDialog::getSaveFileName(this, "Save entire graph", defaultFileNameAndPath, "GFA (*.gfa)");
+    QString fullFileName = QFileDialog::getSaveFileName(this, "Save entire graph", defaultFileNameAndPath, "GFA (*.gfa);;Compressed GFA (*.gfa.gz)");
 
     if (fullFileName != "") //User did not hit cancel
     {
@@ -2365,7 +2473,7 @@ void MainWindow::saveEntireGraphToGfa()
 void MainWindow::saveVisibleGraphToGfa()
 {
     QString defaultFileNameAndPath = g_memory->rememberedPath + "/graph.gfa";
-    QString fullFileName = QFileDialog::getSaveFileName(this, "Save visible graph", defaultFileNameAndPath, "GFA (*.gfa)");
+    QString fullFileName = QFileDialog::getSaveFileName(this, "Save visible graph", defaultFileNameAndPath, "GFA (*.gfa);;Compressed GFA (*.gfa.gz)");
 
     if (fullFileName != "") //User did not hit cancel
     {
@@ -2445,11 +2553,7 @@ void MainWindow::removeSelection()
     std::vector<DeBruijnEdge *> selectedEdges = m_scene->getSelectedEdges();
     std::vector<DeBruijnNode *> selectedNodes = m_scene->getSelectedNodes();
 
-    m_scene->removeGraphicsItemEdges(selectedEdges, true);
-    m_scene->removeGraphicsItemNodes(selectedNodes, true);
-
-    g_assemblyGraph->deleteEdges(selectedEdges);
-    g_assemblyGraph->deleteNodes(selectedNodes);
+    g_assemblyGraph->deleteNodesAndEdges(selectedNodes, selectedEdges, m_scene);
 
     g_assemblyGraph->determineGraphInfo();
     displayGraphDetails();
@@ -2662,3 +2766,87 @@ void MainWindow::exportGraphLayout() {
     else
         layout::io::save(fullFileName, layout);
 }
+
+
+// Graphs with more nodes than this are coarsened for the overview
+static constexpr size_t OVERVIEW_NODE_COUNT = 5000;
+
+void MainWindow::toggleOverview(bool overview)
+{
+    if (!overview)
+    {
+        if (!m_coarsening)
+            return;
+        leaveOverview();
+        displayGraphDetails();
+        drawGraph();
+        return;
+    }
+
+    if (m_coarsening)
+        return;
+
+    // The coarsening only reads the graph, so it is done in a different thread.
+    auto *progress = new MyProgressDialog(this, "Building overview...", false);
+    progress->setWindowModality(Qt::WindowModal);
+    progress->show();
+
+    QSharedPointer<AssemblyGraph> graph = g_assemblyGraph;
+    auto *watcher = new QFutureWatcher<GraphCoarsening*>;
+    connect(watcher, &QFutureWatcher<GraphCoarsening*>::finished,
+            this, [=, this]() {
+        m_coarsening.reset(watcher->result());
+        m_fullGraph = graph;
+
+        resetScene();
+        g_assemblyGraph = m_coarsening->overview();
+        displayGraphDetails();
+        drawGraph();
+    });
+    connect(watcher, SIGNAL(finished()), progress, SLOT(deleteLater()));
+    connect(watcher, SIGNAL(finished()), watcher, SLOT(deleteLater()));
+
+    watcher->setFuture(QtConcurrent::run([graph]() {
+        auto *coarsening = new GraphCoarsening(*graph);
+        coarsening->coarsen(OVERVIEW_NODE_COUNT);
+        coarsening->buildOverview();
+        // The overview was created in the worker thread, but lives in the GUI one
+        coarsening->overview()->moveToThread(QApplication::instance()->thread());
+        return coarsening;
+    }));
+}
+
+
+void MainWindow::leaveOverview()
+{
+    if (!m_coarsening)
+        return;
+
+    resetScene();
+    g_assemblyGraph = m_fullGraph;
+    m_fullGraph.reset();
+    m_coarsening.reset();
+
+    ui->actionCoarsened_overview->blockSignals(true);
+    ui->actionCoarsened_overview->setChecked(false);
+    ui->actionCoarsened_overview->blockSignals(false);
+}
+
+
+void MainWindow::expandSuperNode(DeBruijnNode * node)
+{
+    if (!m_coarsening || !m_coarsening->isSuperNode(node))
+        return;
+
+    //Expanding deletes the super-node, but other receivers of the double-click
+    //(the path dialog) still get it after this slot. So the expansion waits
+    //for the event loop and finds the super-node again by name.
+    QMetaObject::invokeMethod(this, [this, name = node->getName()]() {
+        if (!m_coarsening || m_coarsening->expand(name, m_scene).empty())
+            return;
+
+        g_assemblyGraph->determineGraphInfo();
+        displayGraphDetails();
+        selectionChanged();
+    }, Qt::QueuedConnection);
+}
@@ -31,6 +31,9 @@
 #include <QLineEdit>
 #include <QRectF>
 #include <QThread>
+#include <QSharedPointer>
+
+#include <memory>
 
 Q_MOC_INCLUDE("graph/debruijnnode.h")
 
@@ -39,6 +42,8 @@ class MyGraphicsScene;
 class DeBruijnNode;
 class DeBruijnEdge;
 class BlastSearchDialog;
+class AssemblyGraph;
+class GraphCoarsening;
 
 namespace Ui {
 class MainWindow;
@@ -64,11 +69,16 @@ private:
     UiState m_uiState;
     BlastSearchDialog * m_blastSearchDialog;
     bool m_alreadyShown;
+    // In overview mode the coarsened graph takes the place of the full graph,
+    // which is kept here
+    QSharedPointer<AssemblyGraph> m_fullGraph;
+    std::unique_ptr<GraphCoarsening> m_coarsening;
 
     void cleanUp();
     void displayGraphDetails();
     void clearGraphDetails();
     void resetScene();
+    void leaveOverview();
     void resetAllNodeColours();
     void layoutGraph();
     void zoomToFitRect(QRectF rect);
@@ -78,6 +88,7 @@ private:
                              QString & selectedNodeListText, QString & selectedNodeLengthText, QString &selectedNodeDepthText,
                              QString &selectNodeTagText);
     QString getSelectedEdgeListText();
+    static QString getNodePathsText(const DeBruijnNode * node);
     std::vector<DeBruijnNode *> getNodesFromLineEdit(QLineEdit * lineEdit, bool exactMatch, std::vector<QString> * nodesNotInGraph = nullptr);
     void setInfoTexts();
     void setUiState(UiState uiState);
@@ -94,6 +105,7 @@ private:
     void setStartingNodesWidgetVisibility(bool visible);
     void setNodeDistanceWidgetVisibility(bool visible);
     void setDepthRangeWidgetVisibility(bool visible);
+    void showDepthRangeNodeCount();
     void setPathSelectionWidgetVisibility(bool visible);
     static QByteArray makeStringUrlSafe(QByteArray s);
     std::vector<DeBruijnNode *> addComplementaryNodes(std::vector<DeBruijnNode *> nodes);
@@ -166,6 +178,8 @@ private slots:
     void changeNodeDepth();
     void openGraphInfoDialog();
     void exportGraphLayout();
+    void toggleOverview(bool overview);
+    void expandSuperNode(DeBruijnNode * node);
 
 protected:
       void showEvent(QShowEvent *ev) override;
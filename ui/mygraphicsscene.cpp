@@ -256,6 +256,7 @@ void MyGraphicsScene::addGraphicsItemsToScene(AssemblyGraph &graph,
     double meanDrawnDepth = graph.getMeanDepth(true);
 
     // First make the GraphicsItemNode objects
+    std::vector<GraphicsItemNode *> graphicsItemNodes;
     for (auto &entry : layout) {
         DeBruijnNode *node = entry.first;
         if (!node->isDrawn())
@@ -275,27 +276,17 @@ void MyGraphicsScene::addGraphicsItemsToScene(AssemblyGraph &graph,
         node->setGraphicsItemNode(graphicsItemNode);
         graphicsItemNode->setFlag(QGraphicsItem::ItemIsSelectable);
         graphicsItemNode->setFlag(QGraphicsItem::ItemIsMovable);
+        graphicsItemNode->setFlag(QGraphicsItem::ItemUsesExtendedStyleOption);
 
-        bool colSet = false;
-        if (auto *rcNode = node->getReverseComplement()) {
-            if (auto *revCompGraphNode = rcNode->getGraphicsItemNode()) {
-                auto colPair = g_settings->nodeColorer->get(graphicsItemNode, revCompGraphNode);
-                graphicsItemNode->setNodeColour(colPair.first);
-                revCompGraphNode->setNodeColour(colPair.second);
-                colSet = true;
-            }
-        }
-        if (!colSet)
-            graphicsItemNode->setNodeColour(g_settings->nodeColorer->get(graphicsItemNode));
+        graphicsItemNodes.push_back(graphicsItemNode);
     }
 
+    // Colour all the nodes at once
+    g_settings->nodeColorer->colourNodes(graphicsItemNodes);
+
     // Then make the GraphicsItemEdge objects and add them to the scene first,
     // so they are drawn underneath
-    for (auto &entry : graph.m_deBruijnGraphEdges) {
-        DeBruijnEdge * edge = entry.second;
-        if (!edge->isDrawn())
-            continue;
-
+    for (auto *edge : graph.getDrawnEdges()) {
         auto * graphicsItemEdge = new GraphicsItemEdge(edge);
         edge->setGraphicsItemEdge(graphicsItemEdge);
         graphicsItemEdge->setFlag(QGraphicsItem::ItemIsSelectable);
@@ -304,11 +295,16 @@ void MyGraphicsScene::addGraphicsItemsToScene(AssemblyGraph &graph,
 
     // Now add the GraphicsItemNode objects to the scene, so they are drawn
     // on top
-    for (auto *node : graph.m_deBruijnGraphNodes) {
-        if (!node->hasGraphicsItem())
-            continue;
+    for (auto *graphicsItemNode : graphicsItemNodes)
+        addItem(graphicsItemNode);
+}
 
-        addItem(node->getGraphicsItemNode());
+void MyGraphicsScene::detachGraphicsItems() {
+    for (auto *item : items()) {
+        if (auto *graphicsItemNode = dynamic_cast<GraphicsItemNode *>(item))
+            graphicsItemNode->m_deBruijnNode->setGraphicsItemNode(nullptr);
+        else if (auto *graphicsItemEdge = dynamic_cast<GraphicsItemEdge *>(item))
+            graphicsItemEdge->m_deBruijnEdge->setGraphicsItemEdge(nullptr);
     }
 }
 
@@ -400,6 +396,29 @@ void MyGraphicsScene::removeGraphicsItemNodes(const std::unordered_set<GraphicsI
     blockSignals(false);
 }
 
+void MyGraphicsScene::removeGraphicsItems(const std::unordered_set<GraphicsItemNode*> &nodes,
+                                          const std::unordered_set<GraphicsItemEdge*> &edges) {
+    if (nodes.empty() && edges.empty())
+        return;
+
+    blockSignals(true);
+    for (auto *graphicsItemEdge : edges) {
+        if (graphicsItemEdge == nullptr)
+            continue;
+
+        removeItem(graphicsItemEdge);
+        delete graphicsItemEdge;
+    }
+    for (auto *graphicsItemNode : nodes) {
+        if (graphicsItemNode == nullptr)
+            continue;
+
+        removeItem(graphicsItemNode);
+        delete graphicsItemNode;
+    }
+    blockSignals(false);
+}
+
 void MyGraphicsScene::duplicateGraphicsNode(DeBruijnNode * originalNode, DeBruijnNode * newNode) {
     GraphicsItemNode * originalGraphicsItemNode = originalNode->getGraphicsItemNode();
     if (originalGraphicsItemNode == nullptr)
@@ -410,6 +429,7 @@ void MyGraphicsScene::duplicateGraphicsNode(DeBruijnNode * originalNode, DeBruij
     newNode->setGraphicsItemNode(newGraphicsItemNode);
     newGraphicsItemNode->setFlag(QGraphicsItem::ItemIsSelectable);
     newGraphicsItemNode->setFlag(QGraphicsItem::ItemIsMovable);
+    newGraphicsItemNode->setFlag(QGraphicsItem::ItemUsesExtendedStyleOption);
 
     originalGraphicsItemNode->shiftPointsLeft();
     newGraphicsItemNode->shiftPointsRight();
@@ -36,6 +36,9 @@ public:
     explicit MyGraphicsScene(QObject *parent = nullptr);
     void addGraphicsItemsToScene(AssemblyGraph &graph,
                                  const GraphLayout &layout);
+    // Clears the graphics item pointers of the nodes and edges in this
+    // scene, so it can be deleted without touching the rest of the graph.
+    void detachGraphicsItems();
 
     std::vector<DeBruijnNode *> getSelectedNodes();
     std::vector<DeBruijnNode *> getSelectedPositiveNodes();
@@ -57,6 +60,10 @@ public:
 
     void duplicateGraphicsNode(DeBruijnNode * originalNode, DeBruijnNode * newNode);
 
+    // Removes and deletes the graphics items with signals blocked once for all of them
+    void removeGraphicsItems(const std::unordered_set<GraphicsItemNode*> &nodes,
+                             const std::unordered_set<GraphicsItemEdge*> &edges);
+
 private:
     void removeGraphicsItemNodes(const std::unordered_set<GraphicsItemNode*> &nodes);
     void removeGraphicsItemEdges(const std::unordered_set<GraphicsItemEdge*> &edges);